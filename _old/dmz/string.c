@@ -20,7 +20,7 @@
 
 #include "string.h"
 
-#include "stdmem.h"
+#include <stdmem.h>
 
 
 /* Copyright (C) 1991-2018 Free Software Foundation, Inc.
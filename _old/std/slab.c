@@ -3,7 +3,7 @@
 //
 
 #include <stdlib.h>
-#include <dmz/stdmem.h>
+#include <stdmem.h>
 #include "slab.h"
 
 
@@ -76,3 +76,61 @@ pit := pit.o pit0.o pit1.o pit2.o pit3.o
 
 MODS_RULES += pit
 
+
+
+#------------ UART module ------------
+
+#The UART manager takes two arguments, the module name and the number of channels;
+uart_args := -DMODULE_NAME=uart -DNB_CHANNELS=6
+
+#Each UART channel takes its index, its name, its register area, its clock frequency, its clock gating register and bit,
+#	its status and error interrupt channels, its rx and tx eDMA channels, and its rx and tx DMA request sources;
+uartx_args = $(uart_args) -DCHANNEL_ID=$(1) -DCHANNEL_NAME=$(2) -DREG=$(3) -DCLOCK_FREQUENCY=$(4) \
+	-DSCGC_REG=$(5) -DSCGC_BIT=$(6) -DSTATUS_INT_CHANNEL=$(7) -DERROR_INT_CHANNEL=$(8) \
+	-DDMA_RX_CHANNEL=$(9) -DDMA_TX_CHANNEL=$(10) -DDMA_RX_SOURCE=$(11) -DDMA_TX_SOURCE=$(12)
+
+#Generate args sequences for each channel. UART0 and UART1 are clocked by the core clock, others by the bus clock.
+#	UART4 and UART5 share a single request source for rx and tx, and can't use DMA;
+uart0_args := $(call uartx_args,0,uart_0,0x4006A000,$(UART_CORE_CLOCK),0x40048034,10,31,32,0,1,2,3)
+uart1_args := $(call uartx_args,1,uart_1,0x4006B000,$(UART_CORE_CLOCK),0x40048034,11,33,34,2,3,4,5)
+uart2_args := $(call uartx_args,2,uart_2,0x4006C000,$(UART_BUS_CLOCK),0x40048034,12,35,36,4,5,6,7)
+uart3_args := $(call uartx_args,3,uart_3,0x4006D000,$(UART_BUS_CLOCK),0x40048034,13,37,38,6,7,8,9)
+uart4_args := $(call uartx_args,4,uart_4,0x400EA000,$(UART_BUS_CLOCK),0x40048028,10,66,67,8,9,0,0)
+uart5_args := $(call uartx_args,5,uart_5,0x400EB000,$(UART_BUS_CLOCK),0x40048028,11,68,69,10,11,0,0)
+
+#This rule will build the uart archive;
+uart:
+
+#Compile all 6 channels with their respective args;
+	@$(MKCC) -o $(MODS_D)/uart0.o -c $(K_DIR)/kx_uart_n.c $(uart0_args)
+	@$(MKCC) -o $(MODS_D)/uart1.o -c $(K_DIR)/kx_uart_n.c $(uart1_args)
+	@$(MKCC) -o $(MODS_D)/uart2.o -c $(K_DIR)/kx_uart_n.c $(uart2_args)
+	@$(MKCC) -o $(MODS_D)/uart3.o -c $(K_DIR)/kx_uart_n.c $(uart3_args)
+	@$(MKCC) -o $(MODS_D)/uart4.o -c $(K_DIR)/kx_uart_n.c $(uart4_args)
+	@$(MKCC) -o $(MODS_D)/uart5.o -c $(K_DIR)/kx_uart_n.c $(uart5_args)
+
+#Compile the uart driver and manager;
+	@$(MKCC) -o $(MODS_D)/uart.o -c $(K_DIR)/kx_uart.c $(uart_args)
+
+uart := uart.o uart0.o uart1.o uart2.o uart3.o uart4.o uart5.o
+
+MODS_RULES += uart
+
+
+
+#------------ Flash module ------------
+
+#The flash driver takes the FTFE and FMC register areas, the FlexNVM address in the memory map and for flash commands,
+#	its size used as data flash, and its sector and phrase sizes;
+flash_args := -DFTFE_REG=0x40020000 -DFMC_REG=0x4001F000 -DNVM_ADDR=0x10000000 -DNVM_CMD_ADDR=0x800000 \
+	-DNVM_SIZE=$(FLEXNVM_DATA_SIZE) -DSECTOR_SIZE=4096 -DPHRASE_SIZE=8
+
+#This rule will build the flash archive;
+flash:
+
+#Compile the flash driver;
+	@$(MKCC) -o $(MODS_D)/flash.o -c $(K_DIR)/kx_flash.c $(flash_args)
+
+flash := flash.o
+
+MODS_RULES += flash
@@ -12,3 +12,14 @@ OSC0_CRYSTAL_LOW_POWER := 1
 #What is the capacitors condiguration ? Provide an integer on 4 bits formatted like :
 #	CP16 (bit 3) | CP8 (bit 2) | CP4 (bit 1) | CP2 (bit 0)
 OSC0_CAPACITORS := 5
+
+
+#The frequency of the clock that drives UART0 and UART1 (the core clock);
+UART_CORE_CLOCK := 120000000
+
+#The frequency of the clock that drives other UARTs (the bus clock);
+UART_BUS_CLOCK := 60000000
+
+
+#The size of the FlexNVM area used as data flash. The FlexNVM of the mk64fx512 is not partitioned for the EEPROM;
+FLEXNVM_DATA_SIZE := 131072
@@ -52,3 +52,24 @@ BOPS_EXECUTABLE_TYPE := 0
 BOPS_EXECUTION_MODE := 0
 
 
+
+
+# Process memory tracking :
+#
+#   - 0 : disabled : no tracking code is compiled;
+#
+#   - 1 : enabled : each process heap allocation records its call site, and blocks still allocated when the process
+#		terminates are reported, grouped by call site. For debug builds only;
+BOPS_MEM_TRACKING := 0
+
+
+
+# Hardware CRC :
+#
+#   - 0 : disabled : frame CRCs are computed in software, with slice-by-8 tables;
+#
+#   - 1 : enabled : frame CRCs are computed by the hardware CRC unit. The khal must implement __crc_hw_compute;
+#
+#	Disabled by default : kx_crc.c is verified against software tables on the host CRC model (test/host/crc_test), not
+#	on target yet;
+BOPS_HW_CRC := 0
@@ -30,6 +30,9 @@
 //Copy @size bytes from src to dst;
 void memcpy(void *dst, const void *src, size_t size);
 
+//Copy @size bytes from src to dst; Blocks can overlap;
+void memmove(void *dst, const void *src, size_t size);
+
 //Initialise a memory block to a value;
 void memset(void *dst, uint8_t value, size_t size);
 
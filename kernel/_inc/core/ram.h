@@ -25,11 +25,54 @@
  * The ram manager manages the available RAM memory.
  *
  * 	It uses variables defined in the unified linker script to manage the whole available RAM block;
+ *
+ * 	The RAM may be split in two regions, on different buses. Each region has its own frame pool, and callers can
+ * 	express what a frame will be used for, so that it lands in the most appropriate region;
  */
 
 #include <stddef.h>
 
 
+/*
+ * The RAM regions;
+ */
+
+enum ram_region {
+
+	/*The lower region. On the code bus on Kinetis K (SRAM_L);*/
+	RAM_REGION_LOWER,
+
+	/*The upper region. On the system bus on Kinetis K (SRAM_U);*/
+	RAM_REGION_UPPER,
+
+	/*The number of regions;*/
+	NB_RAM_REGIONS,
+
+};
+
+
+/*
+ * The usage of a frame. It determines the preferred region. If the preferred region is exhausted, the other one is
+ * 	used;
+ */
+
+enum ram_attr {
+
+	/*No particular usage : upper region first, to leave the lower region to hot code and data;*/
+	RAM_ANY,
+
+	/*A stack : upper region, so that pushes and pops do not contend with instruction fetch;*/
+	RAM_STACK,
+
+	/*A DMA buffer : upper region, so that transfers do not contend with instruction fetch;*/
+	RAM_DMA,
+
+	/*Hot code or data : lower region, that the core accesses via its code bus;*/
+	RAM_HOT,
+
+};
+
+
 /*Initialise memory management values. Will invalidate all previously reserved memory;*/
 void ram_init();
 
@@ -39,6 +82,12 @@ size_t ram_frame_size();
 /*Reserve a frame;*/
 void *ram_alloc_frame();
 
+/*Reserve a frame in the region that suits the provided usage;*/
+void *ram_alloc_frame_attr(enum ram_attr attr);
+
+/*Reserve a frame in the provided region. Return 0 if the region is exhausted;*/
+void *ram_alloc_frame_region(enum ram_region region);
+
 /*Release a reserved frame;*/
 void ram_free_frame(void *frame);
 
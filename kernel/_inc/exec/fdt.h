@@ -0,0 +1,79 @@
+/*
+  fdt.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_FDT_H
+#define TRACER_FDT_H
+
+/*
+ * A file descriptor table maps the small integers a process manipulates to the files it has opened;
+ *
+ * 	Processes never see iinode references : the syscall layer translates an integer descriptor into the file system
+ * 	descriptor with a single bounds-checked array access, so that invalid descriptors are rejected cheaply.
+ *
+ * 	Each process owns a table. All files that remain in it are closed when the process is terminated;
+ */
+
+#include <stdbool.h>
+
+#include <stddef.h>
+
+
+/*--------------------------------------------------- Make Parameters --------------------------------------------------*/
+
+/*The maximal number of files a process can have opened simultaneously;*/
+#if !defined(FDT_NB_ENTRIES)
+
+#define FDT_NB_ENTRIES 8
+
+#endif
+
+
+/*The value returned to processes when no descriptor could be provided;*/
+#define FDT_INVALID ((size_t) -1)
+
+
+/*------------------------------------------------------- Table --------------------------------------------------------*/
+
+/*
+ * The descriptor table contains, for each integer descriptor, the file system descriptor of the opened file;
+ */
+
+struct fdt {
+
+	/*The file system descriptors, as returned by fs_open. Null if the entry is free;*/
+	size_t files[FDT_NB_ENTRIES];
+
+};
+
+
+/*Store an opened file in the lowest free entry, and return its index. Return FDT_INVALID if the table is full;*/
+size_t fdt_add(struct fdt *table, size_t file);
+
+/*Get the file referenced by a descriptor. Return 0 if the descriptor is invalid;*/
+size_t fdt_get(const struct fdt *table, size_t fd);
+
+/*Release a descriptor and return the file it referenced. Return 0 if the descriptor is invalid;*/
+size_t fdt_remove(struct fdt *table, size_t fd);
+
+/*Close all files referenced by the table, and release all descriptors;*/
+void fdt_close_all(struct fdt *table);
+
+
+#endif /*TRACER_FDT_H*/
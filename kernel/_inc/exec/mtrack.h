@@ -0,0 +1,112 @@
+/*
+  mtrack.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_MTRACK_H
+#define TRACER_MTRACK_H
+
+/*
+ * The memory tracker records, for each live block of a process heap, the address of the code that allocated it;
+ *
+ * 	It is a debug feature, enabled by defining KERNEL_MEM_TRACKING (see BOPS_MEM_TRACKING in build_options.mk).
+ * 	When it is not defined, this file declares nothing, and no tracking code is compiled;
+ *
+ * 	At process termination, or on demand, blocks that are still allocated are reported, grouped by call site.
+ * 	Call sites are code addresses, that can be resolved with addr2line;
+ *
+ * 	Only blocks allocated with prc_mem_malloc and prc_mem_ialloc are tracked. Code running on behalf of the current
+ * 	process gets its memory with sched_get_pmem;
+ */
+
+#ifdef KERNEL_MEM_TRACKING
+
+#include <stdbool.h>
+
+#include <stdint.h>
+
+#include <stddef.h>
+
+
+/*--------------------------------------------------- Make Parameters --------------------------------------------------*/
+
+/*The maximal number of blocks that can be tracked for a single process;*/
+#if !defined(KMT_NB_ENTRIES)
+
+#define KMT_NB_ENTRIES 64
+
+#endif
+
+
+/*------------------------------------------------------ Tracker -------------------------------------------------------*/
+
+/*
+ * A tracker entry references a live block, its size, and the address of the code that allocated it;
+ */
+
+struct mtrack_entry {
+
+	/*The block's address. Null if the entry is free;*/
+	const void *block;
+
+	/*The block's size;*/
+	size_t size;
+
+	/*The allocation call site;*/
+	const void *site;
+
+};
+
+
+/*
+ * A tracker contains a fixed number of entries, allocated in the kernel heap;
+ */
+
+struct mtrack {
+
+	/*The entries array, of size KMT_NB_ENTRIES;*/
+	struct mtrack_entry *entries;
+
+	/*The number of allocations that could not be recorded, as the array was full;*/
+	size_t nb_lost;
+
+};
+
+
+/*Allocate the entries array and reset the tracker;*/
+void mtrack_create(struct mtrack *tracker);
+
+/*Free the entries array;*/
+void mtrack_delete(struct mtrack *tracker);
+
+/*Forget all recorded blocks;*/
+void mtrack_reset(struct mtrack *tracker);
+
+/*Record an allocated block;*/
+void mtrack_add(struct mtrack *tracker, const void *block, size_t size, const void *site);
+
+/*Forget a freed block;*/
+void mtrack_remove(struct mtrack *tracker, const void *block);
+
+/*Print all recorded blocks, grouped by call site. Return the number of recorded blocks;*/
+size_t mtrack_report(const struct mtrack *tracker);
+
+
+#endif /*KERNEL_MEM_TRACKING*/
+
+#endif /*TRACER_MTRACK_H*/
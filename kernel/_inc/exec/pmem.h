@@ -38,6 +38,8 @@
 
 #include "kernel/res/coproc.h"
 
+#include "mtrack.h"
+
 
 /*------------------------------------------------- Make Parameters ----------------------------------------------------*/
 
@@ -59,9 +61,19 @@ struct pmem {
 	/*The stack references array;*/
 	struct stck stack;
 
+	/*The RAM frame that contains the stack, if it fits in one. Null if the stack is in the heap;*/
+	void *stack_frame;
+
 	/*The struct to contain coprocessors contexts;*/
 	struct coprocs_contexts contexts;
 
+#ifdef KERNEL_MEM_TRACKING
+
+	/*The heap allocations tracker;*/
+	struct mtrack tracker;
+
+#endif
+
 };
 
 
@@ -75,5 +87,18 @@ void prc_mem_reset(struct pmem *mem, size_t stacks_size);
 void prc_mem_clean(struct pmem *mem);
 
 
+/*Allocate a block in the process heap. The call site is recorded if memory tracking is enabled;*/
+void *prc_mem_malloc(struct pmem *mem, size_t size);
+
+/*Allocate and initialise a block in the process heap. The call site is recorded if memory tracking is enabled;*/
+void *prc_mem_ialloc(struct pmem *mem, size_t size, const void *init);
+
+/*Free a block of the process heap;*/
+void prc_mem_free(struct pmem *mem, void *block);
+
+/*Print blocks that are still allocated in the process heap, grouped by call site. No-op if tracking is disabled;*/
+void prc_mem_leak_report(const struct pmem *mem);
+
+
 
 #endif /*TRACER_MEMORY_H*/
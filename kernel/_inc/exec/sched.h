@@ -56,6 +56,8 @@
 
 #include "pmem.h"
 
+#include "fdt.h"
+
 #include "prc.h"
 
 #include <struct/shared_fifo.h>
@@ -97,14 +99,14 @@ void sched_dtor(struct scheduler *sched);
 void sched_add(void *task_data);
 
 /*Terminate the current task; Will be at next select call;*/
-void sched_terminate();
+void sched_terminate_prc();
 
 
 /*Set the current task in the stopped state, and return its ref;*/
-struct sched_elmt *sched_stop();
+struct sched_elmt *sched_stop_prc();
 
-/*Resume the provided task;*/
-void sched_resume(struct sched_elmt *);
+/*Resume the provided task. If its stop is still pending, it is cancelled;*/
+void sched_resume_prc(struct sched_elmt *);
 
 
 
@@ -126,4 +128,10 @@ void sched_commit();
 /*Get the current task;*/
 void *sched_get_task();
 
+/*Get the descriptor table of the current process;*/
+struct fdt *sched_get_fdt();
+
+/*Get the memory of the current process, to allocate in its heap;*/
+struct pmem *sched_get_pmem();
+
 #endif /*TRACER_SCHEDULER_H*/
@@ -21,4 +21,28 @@ void *kialloc(size_t, const void *);
 /*Free some data in the kernel heap;*/
 void kfree(void *);
 
+
+/*
+ * The kernel heap statistics. The heap grows by RAM frames when its init block is full;
+ */
+
+struct kdm_stats {
+
+	/*The number of RAM frames currently owned by the heap, and its high-water mark;*/
+	size_t nb_frames;
+	size_t peak_frames;
+
+	/*The number of allocated blocks, and its high-water mark;*/
+	size_t nb_blocks;
+	size_t peak_blocks;
+
+	/*The number of frames acquired and released since init;*/
+	size_t nb_grows;
+	size_t nb_shrinks;
+
+};
+
+/*Get the kernel heap statistics;*/
+void kdmem_get_stats(struct kdm_stats *dst);
+
 #endif /*TRACER_KMALLOC_H*/
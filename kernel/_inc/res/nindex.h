@@ -0,0 +1,102 @@
+/*
+  nindex.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_NINDEX_H
+#define TRACER_NINDEX_H
+
+/*
+ * A name index associates data pointers to names, like the nostd nlist, but resolves names in constant time;
+ *
+ * 	Entries are stored in an open-addressing table, probed linearly, whose size is a power of two. Each entry caches
+ * 	the hash of its name, so that probing compares names only when hashes match, and so that the table can be
+ * 	resized without hashing names again;
+ *
+ * 	The table is allocated in the kernel heap at the first insertion, and is doubled when it is three quarters full.
+ * 	An index can thus be statically declared, providing only its maximal name length;
+ */
+
+#include <stdbool.h>
+
+#include <stdint.h>
+
+#include <stddef.h>
+
+
+/*------------------------------------------------------- Index --------------------------------------------------------*/
+
+/*
+ * An index entry references a name, its hash, and the associated data;
+ */
+
+struct nindex_entry {
+
+	/*The hash of the name;*/
+	uint32_t hash;
+
+	/*The name, copied in the kernel heap. Null if the entry is free;*/
+	char *name;
+
+	/*The data associated to the name;*/
+	void *data;
+
+};
+
+
+/*
+ * The name index;
+ */
+
+struct nindex {
+
+	/*The number of names in the index;*/
+	size_t elements;
+
+	/*The maximal length of a name, terminating null excluded;*/
+	size_t name_max_length;
+
+	/*The number of entries of the table, a power of two. Null before the first insertion;*/
+	size_t capacity;
+
+	/*The entries table;*/
+	struct nindex_entry *entries;
+
+};
+
+
+/*Add a name to the index. Fails if the name is too long, or already present;*/
+bool nindex_add(struct nindex *index, const char *name, void *data);
+
+/*Get the data associated to a name. Return 0 if the name is not present;*/
+void *nindex_get(const struct nindex *index, const char *name);
+
+/*Update the data associated to a name. Fails if the name is not present;*/
+bool nindex_set(struct nindex *index, const char *name, void *data);
+
+/*Remove a name from the index, and return its data. Return 0 if the name is not present;*/
+void *nindex_remove(struct nindex *index, const char *name);
+
+/*Remove all names from the index, pass their data to @deleter if it is not null, and free the table;*/
+void nindex_clear(struct nindex *index, void (*deleter)(void *data));
+
+/*Print all names of the index;*/
+void nindex_list(const struct nindex *index);
+
+
+#endif /*TRACER_NINDEX_H*/
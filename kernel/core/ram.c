@@ -27,6 +27,8 @@
 
 #include <kernel/common.h>
 
+#include <kernel/core/ram.h>
+
 #include <khal/lnk.h>
 
 
@@ -38,15 +40,63 @@
 
 /*------------------------------------------------------- Globals ------------------------------------------------------*/
 
-/*The heap that will manage the ram block;*/
-static struct page_allocator ram_allocator;
+/*The heaps that will manage both ram regions;*/
+static struct page_allocator ram_allocators[NB_RAM_REGIONS];
+
+/*The bounds of both regions, to find the region of a frame;*/
+static uint8_t *region_min[NB_RAM_REGIONS];
+static uint8_t *region_max[NB_RAM_REGIONS];
+
 
+/*
+ * The region preference for each frame usage; The first region is tried first, the second if it is exhausted;
+ */
+
+static const enum ram_region preferences[][NB_RAM_REGIONS] = {
+	[RAM_ANY] = {RAM_REGION_UPPER, RAM_REGION_LOWER},
+	[RAM_STACK] = {RAM_REGION_UPPER, RAM_REGION_LOWER},
+	[RAM_DMA] = {RAM_REGION_UPPER, RAM_REGION_LOWER},
+	[RAM_HOT] = {RAM_REGION_LOWER, RAM_REGION_UPPER},
+};
 
 
 /*------------------------------------------------------- RAM mgt ------------------------------------------------------*/
 
 /**
- * ram_init : resets the heap that manages the RAM block.
+ * ram_init_region : resets the heap that manages a ram region;
+ *
+ * 	If the region can't contain a single frame, it is left empty;
+ *
+ * @param region : the index of the region;
+ * @param min : the lowest address of the region;
+ * @param max : the highest address of the region;
+ */
+
+static void ram_init_region(enum ram_region region, uint8_t *min, uint8_t *max) {
+
+	/*Save the region's bounds;*/
+	region_min[region] = min;
+	region_max[region] = max;
+
+	/*If the region is too small to contain a frame, leave it empty;*/
+	if ((max <= min) || ((size_t) (max - min) < ALIGNMENT_SIZE(FRAME_MAGNITUDE))) {
+
+		/*Empty the region;*/
+		region_max[region] = min;
+
+		/*Complete;*/
+		return;
+
+	}
+
+	/*Initialise the region allocator;*/
+	pager_ctor(ram_allocators + region, min, max - min, ALIGNMENT_SIZE(FRAME_MAGNITUDE), FRAME_MAGNITUDE);
+
+}
+
+
+/**
+ * ram_init : resets the heaps that manage the RAM regions.
  *
  * 	Executing this function will invalidate all allocated memory in the ram.
  *
@@ -55,8 +105,11 @@ static struct page_allocator ram_allocator;
 
 void ram_init() {
 
-	/*Initialise the ram allocator;*/
-    pager_ctor(&ram_allocator, &__ram_min, &__ram_max - &__ram_min,  ALIGNMENT_SIZE(FRAME_MAGNITUDE), FRAME_MAGNITUDE);
+	/*Initialise the lower region, after data and bss;*/
+	ram_init_region(RAM_REGION_LOWER, &__ram_l_min, (uint8_t *) &__ram_l_max);
+
+	/*Initialise the upper region, after DMA buffers;*/
+	ram_init_region(RAM_REGION_UPPER, &__ram_u_min, (uint8_t *) &__ram_max);
 
     __printk("RAM manager initialised\n\r");
 
@@ -64,19 +117,61 @@ void ram_init() {
 
 
 /**
- * ram_alloc_frame : allocates a RAM frame;
+ * ram_frame_size : returns the size of a RAM frame;
+ *
+ * @return the size of a RAM frame;
+ */
+
+size_t ram_frame_size() {
+
+	/*Frames are of size 2 ^ FRAME_MAGNITUDE;*/
+	return (size_t) 1 << FRAME_MAGNITUDE;
+
+}
+
+
+/**
+ * ram_alloc_frame_region : allocates a RAM frame in the provided region;
+ *
+ * @param region : the region where to allocate the frame;
+ * @return the lowest address of the allocated frame, or 0 if the region is exhausted;
+ */
+
+void *ram_alloc_frame_region(const enum ram_region region) {
+
+	/*If the region is empty, fail;*/
+	if (region_max[region] == region_min[region]) {
+		return 0;
+	}
+
+	/*Allocate a frame;*/
+	return pager_alloc_page_safe(ram_allocators + region);
+
+}
+
+
+/**
+ * ram_alloc_frame_attr : allocates a RAM frame in the region that suits the provided usage. If the preferred region
+ * 	is exhausted, the other one is used;
  *
  * Fail-safe, a kernel panic is generated in case of error;
  *
+ * @param attr : the usage of the frame;
  * @return the lowest address of the allocated frame;
  */
 
-void *ram_alloc_frame() {
+void *ram_alloc_frame_attr(const enum ram_attr attr) {
 
-    void *frame;
+	/*Cache the region preferences;*/
+	const enum ram_region *const regions = preferences[attr];
 
-	/*Allocate a frame;*/
-	frame = pager_alloc_page_safe(&ram_allocator);
+	/*Attempt to allocate in the preferred region;*/
+	void *frame = ram_alloc_frame_region(regions[0]);
+
+	/*If the preferred region is exhausted, attempt in the other one;*/
+	if (!frame) {
+		frame = ram_alloc_frame_region(regions[1]);
+	}
 
     /*If the allocation fails :*/
     if (!frame) {
@@ -92,15 +187,51 @@ void *ram_alloc_frame() {
 }
 
 
+/**
+ * ram_alloc_frame : allocates a RAM frame, with no particular usage;
+ *
+ * Fail-safe, a kernel panic is generated in case of error;
+ *
+ * @return the lowest address of the allocated frame;
+ */
+
+void *ram_alloc_frame() {
+
+	/*Allocate a frame with no particular usage;*/
+	return ram_alloc_frame_attr(RAM_ANY);
+
+}
+
+
 /**
  * ram_free_frame : frees an allocated RAM frame, referenced by its lowest address;
  *
+ * 	The region of the frame is determined by its address;
+ *
  * @param frame : the lowest address of the frame to free;
  */
 
 void ram_free_frame(void *frame) {
 
-    /*Allocate a frame;*/
-    pager_free_page_safe(&ram_allocator, frame);
+	uint8_t region;
 
-}
\ No newline at end of file
+	/*For each region :*/
+	for (region = 0; region < NB_RAM_REGIONS; region++) {
+
+		/*If the frame belongs to the region :*/
+		if (((uint8_t *) frame >= region_min[region]) && ((uint8_t *) frame < region_max[region])) {
+
+			/*Free the frame;*/
+			pager_free_page_safe(ram_allocators + region, frame);
+
+			/*Complete;*/
+			return;
+
+		}
+
+	}
+
+	/*The frame doesn't belong to any region;*/
+	__kernel_panic("ram_free_frame : frame out of RAM regions;");
+
+}
@@ -0,0 +1,362 @@
+//
+// Created by root on 10/17/18.
+//
+
+#include <stdmem.h>
+
+
+/*
+ * Copies and fills are made in three steps :
+ * 	- bytes are processed one by one until the destination is word aligned;
+ * 	- the aligned part is processed by words, or by bursts of four words on ARMv7-M (LDM / STM);
+ * 	- remaining bytes are processed one by one;
+ *
+ * 	When source and destination do not share the same alignment, aligned words are read from the source and merged
+ * 	with shifts, so that all accesses stay word aligned. No read crosses the word that contains the last source byte;
+ *
+ * 	On any other architecture, (host builds for example) the portable C word implementation is used;
+ */
+
+
+//Word accesses may alias any object;
+typedef size_t __attribute__((__may_alias__)) word_t;
+
+//The size of a word;
+#define WORD_SIZE (sizeof(word_t))
+
+//The mask to extract the misalignment of an address;
+#define WORD_MASK (WORD_SIZE - 1)
+
+//Under this size, a byte loop is faster than alignment management;
+#define SMALL_SIZE (2 * WORD_SIZE)
+
+//Is the address word aligned ?
+#define IS_ALIGNED(ptr) (!((size_t) (ptr) & WORD_MASK))
+
+
+//On ARMv7-M, bursts of four words are transferred with LDM / STM;
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+
+#define STDMEM_BURSTS
+
+//The size of a burst;
+#define BURST_SIZE (4 * sizeof(uint32_t))
+
+#endif
+
+
+//Shifts to merge two source words, depend on the byte order;
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define MERGE(w0, w1, shift) (((w0) << (shift)) | ((w1) >> (8 * WORD_SIZE - (shift))))
+#else
+#define MERGE(w0, w1, shift) (((w0) >> (shift)) | ((w1) << (8 * WORD_SIZE - (shift))))
+#endif
+
+
+//-------------------------------------------------------- Bursts -------------------------------------------------------
+
+#ifdef STDMEM_BURSTS
+
+//Copy @nb_bursts bursts from src to dst, both word aligned; Update both pointers;
+static inline void copy_bursts(uint32_t **const dst_p, const uint32_t **const src_p, size_t nb_bursts) {
+
+	//Cache both pointers;
+	uint32_t *dst = *dst_p;
+	const uint32_t *src = *src_p;
+
+	//Load four words and store them until all bursts are copied;
+	__asm__ __volatile__ (
+	"1:\n\t"
+		"ldmia %[src]!, {r3, r4, r5, r6}\n\t"
+		"stmia %[dst]!, {r3, r4, r5, r6}\n\t"
+		"subs %[nb], %[nb], #1\n\t"
+		"bne 1b\n\t"
+	: [dst] "+r" (dst), [src] "+r" (src), [nb] "+r" (nb_bursts)
+	:
+	: "r3", "r4", "r5", "r6", "cc", "memory"
+	);
+
+	//Update pointers;
+	*dst_p = dst;
+	*src_p = src;
+
+}
+
+
+//Store @nb_bursts bursts of @word in dst, word aligned; Update the pointer;
+static inline void fill_bursts(uint32_t **const dst_p, uint32_t word, size_t nb_bursts) {
+
+	//Cache the pointer;
+	uint32_t *dst = *dst_p;
+
+	//Store four copies of the word until all bursts are written;
+	__asm__ __volatile__ (
+		"mov r3, %[w]\n\t"
+		"mov r4, %[w]\n\t"
+		"mov r5, %[w]\n\t"
+		"mov r6, %[w]\n\t"
+	"1:\n\t"
+		"stmia %[dst]!, {r3, r4, r5, r6}\n\t"
+		"subs %[nb], %[nb], #1\n\t"
+		"bne 1b\n\t"
+	: [dst] "+r" (dst), [nb] "+r" (nb_bursts)
+	: [w] "r" (word)
+	: "r3", "r4", "r5", "r6", "cc", "memory"
+	);
+
+	//Update the pointer;
+	*dst_p = dst;
+
+}
+
+#endif
+
+
+//-------------------------------------------------------- Copies -------------------------------------------------------
+
+//Copy @nb_words words from src to dst, both word aligned; Update both pointers;
+static inline void copy_aligned_words(word_t **const dst_p, const word_t **const src_p, size_t nb_words) {
+
+	//Cache both pointers;
+	word_t *dst = *dst_p;
+	const word_t *src = *src_p;
+
+#ifdef STDMEM_BURSTS
+
+	//Determine the number of bursts;
+	size_t nb_bursts = (nb_words * WORD_SIZE) / BURST_SIZE;
+
+	//If there are bursts to copy :
+	if (nb_bursts) {
+
+		//Copy all bursts;
+		copy_bursts((uint32_t **) &dst, (const uint32_t **) &src, nb_bursts);
+
+		//Update the number of remaining words;
+		nb_words -= nb_bursts * (BURST_SIZE / WORD_SIZE);
+
+	}
+
+#endif
+
+	//Copy remaining words;
+	while (nb_words--) {
+		*(dst++) = *(src++);
+	}
+
+	//Update pointers;
+	*dst_p = dst;
+	*src_p = src;
+
+}
+
+
+//Copy @nb_words words to dst, word aligned, from src, not word aligned; Update both pointers;
+static inline void copy_shifted_words(word_t **const dst_p, const uint8_t **const src_p, size_t nb_words) {
+
+	//Cache the destination pointer;
+	word_t *dst = *dst_p;
+
+	//Determine the source misalignment, in bits;
+	const size_t shift = ((size_t) *src_p & WORD_MASK) << 3;
+
+	//Determine the aligned word that contains the first source byte;
+	const word_t *src = (const word_t *) (*src_p - ((size_t) *src_p & WORD_MASK));
+
+	//Read the first source word;
+	word_t w0 = *(src++), w1;
+
+	//Update the source pointer;
+	*src_p += nb_words * WORD_SIZE;
+
+	//For each word to write :
+	while (nb_words--) {
+
+		//Read the next source word;
+		w1 = *(src++);
+
+		//Merge both words and write the result;
+		*(dst++) = MERGE(w0, w1, shift);
+
+		//Shift words;
+		w0 = w1;
+
+	}
+
+	//Update the destination pointer;
+	*dst_p = dst;
+
+}
+
+
+//Copy @num bytes from src to dst;
+void memcpy(void *_dst, const void *_src, size_t num) {
+
+	//Convert;
+	uint8_t *dst = _dst;
+	const uint8_t *src = _src;
+
+	//If the block is big enough to use words :
+	if (num >= SMALL_SIZE) {
+
+		size_t nb_words;
+
+		//Copy bytes until dst is aligned;
+		while (!IS_ALIGNED(dst)) {
+			*(dst++) = *(src++);
+			num--;
+		}
+
+		//Determine the number of words to copy;
+		nb_words = num / WORD_SIZE;
+
+		//Update the number of remaining bytes;
+		num &= WORD_MASK;
+
+		//If src is aligned too, copy words directly, if not, merge them;
+		if (IS_ALIGNED(src)) {
+			copy_aligned_words((word_t **) &dst, (const word_t **) &src, nb_words);
+		} else {
+			copy_shifted_words((word_t **) &dst, &src, nb_words);
+		}
+
+	}
+
+	//For each remaining byte to copy :
+	while(num--) {
+
+		//Copy a byte from src to dst;
+		*(dst++) = *(src++);
+
+	}
+
+}
+
+
+//Copy @num bytes from src to dst; Blocks can overlap;
+void memmove(void *_dst, const void *_src, size_t num) {
+
+	//Convert;
+	uint8_t *dst = _dst;
+	const uint8_t *src = _src;
+
+	//If dst is before src, or after the end of src, a forward copy is safe;
+	if ((dst <= src) || (dst >= src + num)) {
+
+		//Copy forward;
+		memcpy(_dst, _src, num);
+
+		//Complete;
+		return;
+
+	}
+
+	//dst overlaps the end of src, a backward copy is required. Start from the end;
+	dst += num;
+	src += num;
+
+	//If both blocks share the same alignment, and the block is big enough to use words :
+	if ((num >= SMALL_SIZE) && (!(((size_t) dst ^ (size_t) src) & WORD_MASK))) {
+
+		size_t nb_words;
+
+		//Copy bytes until both ends are aligned;
+		while (!IS_ALIGNED(dst)) {
+			*(--dst) = *(--src);
+			num--;
+		}
+
+		//Determine the number of words to copy;
+		nb_words = num / WORD_SIZE;
+
+		//Update the number of remaining bytes;
+		num &= WORD_MASK;
+
+		//Copy words backward;
+		while (nb_words--) {
+			dst -= WORD_SIZE;
+			src -= WORD_SIZE;
+			*(word_t *) dst = *(const word_t *) src;
+		}
+
+	}
+
+	//Copy remaining bytes backward;
+	while (num--) {
+		*(--dst) = *(--src);
+	}
+
+}
+
+
+//-------------------------------------------------------- Fills --------------------------------------------------------
+
+//Initialise a memory block to a value;
+void memset(void *_dst, uint8_t value, size_t num) {
+
+	//Convert;
+	uint8_t *dst = _dst;
+
+	//If the block is big enough to use words :
+	if (num >= SMALL_SIZE) {
+
+		size_t nb_words;
+		word_t *wdst;
+
+		//Replicate the value in all bytes of a word;
+		word_t word = ((word_t) -1 / 0xFF) * value;
+
+		//Write bytes until dst is aligned;
+		while (!IS_ALIGNED(dst)) {
+			*(dst++) = value;
+			num--;
+		}
+
+		//Determine the number of words to write;
+		nb_words = num / WORD_SIZE;
+
+		//Update the number of remaining bytes;
+		num &= WORD_MASK;
+
+		//Cache the word pointer;
+		wdst = (word_t *) dst;
+
+#ifdef STDMEM_BURSTS
+
+		{
+			//Determine the number of bursts;
+			size_t nb_bursts = (nb_words * WORD_SIZE) / BURST_SIZE;
+
+			//If there are bursts to write :
+			if (nb_bursts) {
+
+				//Write all bursts;
+				fill_bursts((uint32_t **) &wdst, (uint32_t) word, nb_bursts);
+
+				//Update the number of remaining words;
+				nb_words -= nb_bursts * (BURST_SIZE / WORD_SIZE);
+
+			}
+		}
+
+#endif
+
+		//Write remaining words;
+		while (nb_words--) {
+			*(wdst++) = word;
+		}
+
+		//Update the byte pointer;
+		dst = (uint8_t *) wdst;
+
+	}
+
+	//For each remaining byte to write :
+	while(num--) {
+
+		//Copy a byte from src to dst;
+		*(dst++) = value;
+
+	}
+
+}
@@ -0,0 +1,127 @@
+/*
+  fdt.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "fdt.h"
+
+#include "../res/fs/iinode.h"
+
+
+/*----------------------------------------------------- Descriptors ----------------------------------------------------*/
+
+/**
+ * fdt_add : stores an opened file in the lowest free entry of the table;
+ *
+ * @param table : the process's descriptor table;
+ * @param file : the file system descriptor of the opened file;
+ * @return the integer descriptor of the file, or FDT_INVALID if the table is full;
+ */
+
+size_t fdt_add(struct fdt *const table, const size_t file) {
+
+	/*For each entry :*/
+	for (size_t fd = 0; fd < FDT_NB_ENTRIES; fd++) {
+
+		/*If the entry is free :*/
+		if (!table->files[fd]) {
+
+			/*Reference the file;*/
+			table->files[fd] = file;
+
+			/*Return the descriptor;*/
+			return fd;
+
+		}
+
+	}
+
+	/*The table is full, fail;*/
+	return FDT_INVALID;
+
+}
+
+
+/**
+ * fdt_get : validates a descriptor provided by a process and returns the file it references;
+ *
+ * @param table : the process's descriptor table;
+ * @param fd : the integer descriptor;
+ * @return the file system descriptor, or 0 if @fd is out of bounds or free;
+ */
+
+size_t fdt_get(const struct fdt *const table, const size_t fd) {
+
+	/*If the descriptor is out of bounds, fail;*/
+	if (fd >= FDT_NB_ENTRIES) {
+		return 0;
+	}
+
+	/*Return the entry, null if free;*/
+	return table->files[fd];
+
+}
+
+
+/**
+ * fdt_remove : releases a descriptor. The file is not closed;
+ *
+ * @param table : the process's descriptor table;
+ * @param fd : the integer descriptor;
+ * @return the file system descriptor that was referenced, or 0 if @fd is invalid;
+ */
+
+size_t fdt_remove(struct fdt *const table, const size_t fd) {
+
+	/*Validate the descriptor and get the file;*/
+	const size_t file = fdt_get(table, fd);
+
+	/*If the descriptor is valid, free its entry;*/
+	if (file) {
+		table->files[fd] = 0;
+	}
+
+	/*Return the file;*/
+	return file;
+
+}
+
+
+/**
+ * fdt_close_all : closes all files that remain in the table. Called when the process is terminated;
+ *
+ * @param table : the process's descriptor table;
+ */
+
+void fdt_close_all(struct fdt *const table) {
+
+	/*For each entry :*/
+	for (size_t fd = 0; fd < FDT_NB_ENTRIES; fd++) {
+
+		/*Cache the file;*/
+		const size_t file = table->files[fd];
+
+		/*If the entry is used, close the file and free the entry;*/
+		if (file) {
+			fs_close((file_descriptor) file);
+			table->files[fd] = 0;
+		}
+
+	}
+
+}
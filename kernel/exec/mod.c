@@ -22,7 +22,7 @@
 
 #include <kernel/hard/impl_defined/hard_defined.h>
 
-#include <struct/nlist.h>
+#include <kernel/res/nindex.h>
 
 #include <panic.h>
 
@@ -35,7 +35,7 @@
 
 #define MOD_NAME_MAX_LENGTH 32
 
-static struct nlist modules = {
+static struct nindex modules = {
 	.elements = 0,
 	.name_max_length = MOD_NAME_MAX_LENGTH,
 };
@@ -57,7 +57,7 @@ void mod_add(const char *name, bool (*init)()) {
 	(*init)();
 	
 	/*Add the exit function to the list;*/
-	bool success = nlist_add(&modules, name, 0);/*TODO EXIT;*/
+	bool success = nindex_add(&modules, name, 0);/*TODO EXIT;*/
 	
 	/*If the add succeeded :*/
 	if (!success) {
@@ -76,7 +76,7 @@ void mod_add(const char *name, bool (*init)()) {
 void mod_remove(const char *const name) {
 	
 	/*Remove the module from the list; TODO cache its exit function;*/
-	nlist_remove(&modules, name);
+	nindex_remove(&modules, name);
 	
 	/*
 	/*If the module was found and removed, and has a valid exit function :*/
@@ -89,7 +89,7 @@ void mod_remove(const char *const name) {
 		if (!cleanup) {
 
 			/*Reinsert the module, as it is still active;*/
-			nlist_add(&modules, name, exit);
+			nindex_add(&modules, name, exit);
 
 			/*TODO LOG;*/
 
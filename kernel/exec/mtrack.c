@@ -0,0 +1,249 @@
+/*
+  mtrack.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "mtrack.h"
+
+/*The whole translation unit is compiled out if tracking is disabled;*/
+#ifdef KERNEL_MEM_TRACKING
+
+#include <stdmem.h>
+
+#include <kernel/res/kdmem.h>
+
+#include <kernel/hard/debug/printk.h>
+
+
+/*------------------------------------------------------ Lifecycle -----------------------------------------------------*/
+
+/**
+ * mtrack_create : allocates the tracker's entries array in the kernel heap, and resets the tracker;
+ *
+ * @param tracker : the tracker to initialise;
+ */
+
+void mtrack_create(struct mtrack *const tracker) {
+
+	/*Allocate the entries array;*/
+	tracker->entries = kmalloc(KMT_NB_ENTRIES * sizeof(struct mtrack_entry));
+
+	/*Reset all entries;*/
+	mtrack_reset(tracker);
+
+}
+
+
+/**
+ * mtrack_delete : frees the tracker's entries array;
+ *
+ * @param tracker : the tracker to delete;
+ */
+
+void mtrack_delete(struct mtrack *const tracker) {
+
+	/*Free the entries array;*/
+	kfree(tracker->entries);
+
+	/*Neutralise the reference;*/
+	tracker->entries = 0;
+
+}
+
+
+/**
+ * mtrack_reset : marks all entries free. Called when the tracked heap is reset;
+ *
+ * @param tracker : the tracker to reset;
+ */
+
+void mtrack_reset(struct mtrack *const tracker) {
+
+	/*Clear all entries;*/
+	memset(tracker->entries, 0, KMT_NB_ENTRIES * sizeof(struct mtrack_entry));
+
+	/*No allocation lost;*/
+	tracker->nb_lost = 0;
+
+}
+
+
+/*------------------------------------------------------ Recording -----------------------------------------------------*/
+
+/**
+ * mtrack_add : records a block in the first free entry. If no entry is free, the allocation is counted as lost;
+ *
+ * @param tracker : the tracker to update;
+ * @param block : the allocated block. Null blocks are not recorded;
+ * @param size : the size of the block;
+ * @param site : the address of the code that allocated the block;
+ */
+
+void mtrack_add(struct mtrack *const tracker, const void *const block, const size_t size, const void *const site) {
+
+	/*Cache the first entry;*/
+	struct mtrack_entry *entry = tracker->entries;
+
+	/*Cache the entry count;*/
+	size_t count = KMT_NB_ENTRIES;
+
+	/*Failed allocations are not recorded;*/
+	if (!block) {
+		return;
+	}
+
+	/*For each entry :*/
+	while (count--) {
+
+		/*If the entry is free :*/
+		if (!entry->block) {
+
+			/*Record the block;*/
+			entry->block = block;
+			entry->size = size;
+			entry->site = site;
+
+			/*Complete;*/
+			return;
+
+		}
+
+		/*Focus on the next entry;*/
+		entry++;
+
+	}
+
+	/*The array is full, the allocation is lost for the report;*/
+	tracker->nb_lost++;
+
+}
+
+
+/**
+ * mtrack_remove : releases the entry that records @block. Unknown blocks are ignored, as they may have been lost;
+ *
+ * @param tracker : the tracker to update;
+ * @param block : the freed block;
+ */
+
+void mtrack_remove(struct mtrack *const tracker, const void *const block) {
+
+	/*Cache the first entry;*/
+	struct mtrack_entry *entry = tracker->entries;
+
+	/*Cache the entry count;*/
+	size_t count = KMT_NB_ENTRIES;
+
+	/*For each entry :*/
+	while (count--) {
+
+		/*If the entry records the block :*/
+		if (entry->block == block) {
+
+			/*Release the entry;*/
+			entry->block = 0;
+
+			/*Complete;*/
+			return;
+
+		}
+
+		/*Focus on the next entry;*/
+		entry++;
+
+	}
+
+}
+
+
+/*------------------------------------------------------- Report -------------------------------------------------------*/
+
+/**
+ * mtrack_report : prints the number of live blocks and their cumulated size for each call site;
+ *
+ * 	Entries are grouped in place without any allocation : for each entry whose site was not already reported, all
+ * 	following entries are scanned. Quadratic, but only executed in debug builds;
+ *
+ * @param tracker : the tracker to report;
+ * @return the number of live blocks that were recorded;
+ */
+
+size_t mtrack_report(const struct mtrack *const tracker) {
+
+	/*Cache the entries array;*/
+	const struct mtrack_entry *const entries = tracker->entries;
+
+	/*The total number of live blocks;*/
+	size_t nb_blocks = 0;
+
+	size_t i, j;
+
+	/*For each entry :*/
+	for (i = 0; i < KMT_NB_ENTRIES; i++) {
+
+		/*Cache the entry's site;*/
+		const void *const site = entries[i].site;
+
+		/*The number of blocks and the size allocated by the site;*/
+		size_t site_blocks = 0, site_size = 0;
+
+		/*Free entries are not reported;*/
+		if (!entries[i].block) {
+			continue;
+		}
+
+		/*Search for a previous entry of the same site;*/
+		for (j = 0; j < i; j++) {
+			if ((entries[j].block) && (entries[j].site == site)) {
+				break;
+			}
+		}
+
+		/*If the site was already reported, skip;*/
+		if (j != i) {
+			continue;
+		}
+
+		/*Accumulate all entries of the site;*/
+		for (j = i; j < KMT_NB_ENTRIES; j++) {
+			if ((entries[j].block) && (entries[j].site == site)) {
+				site_blocks++;
+				site_size += entries[j].size;
+			}
+		}
+
+		/*Log;*/
+		printkf("\tleak : site %h : %d blocks, %d bytes\n\r", site, site_blocks, site_size);
+
+		/*Update the total;*/
+		nb_blocks += site_blocks;
+
+	}
+
+	/*If some allocations could not be recorded, log;*/
+	if (tracker->nb_lost) {
+		printkf("\tleak : %d allocations not tracked\n\r", tracker->nb_lost);
+	}
+
+	/*Return the number of live blocks;*/
+	return nb_blocks;
+
+}
+
+
+#endif /*KERNEL_MEM_TRACKING*/
@@ -26,6 +26,10 @@
 
 #include <kernel/hard/ram.h>
 
+#include <kernel/core/ram.h>
+
+#include <kernel/hard/debug/printk.h>
+
 
 /*------------------------------------------------------ pmem ------------------------------------------------------*/
 
@@ -60,11 +64,21 @@ void prc_mem_create_heap(struct pmem *mem, size_t ram_size) {
 		/*Transfer the heap ownership;*/
 		.heap = heap,
 		
+		/*The stack frame will be allocated at reset;*/
+		.stack_frame = 0,
+		
 	};
 	
 	/*Initialise the program memory;*/
 	memcpy(mem, &progm_init, sizeof(struct pmem));
 	
+#ifdef KERNEL_MEM_TRACKING
+	
+	/*Create the allocations tracker;*/
+	mtrack_create(&mem->tracker);
+	
+#endif
+	
 }
 
 
@@ -87,8 +101,32 @@ void prc_mem_reset(struct pmem *mem, size_t stacks_size) {
 	/*Reset the heap;*/
 	heap_reset(mem->heap);
 	
-	/*Allocate some memory for the thread's stack_data in the heap;*/
-	void *thread_stack = heap_malloc(mem->heap, stacks_size);
+#ifdef KERNEL_MEM_TRACKING
+	
+	/*All tracked blocks have been released;*/
+	mtrack_reset(&mem->tracker);
+	
+#endif
+	
+	void *thread_stack;
+	
+	/*If the stack fits in a RAM frame :*/
+	if (stacks_size <= ram_frame_size()) {
+		
+		/*If the stack frame is not allocated yet, allocate it in the stack region;*/
+		if (!mem->stack_frame) {
+			mem->stack_frame = ram_alloc_frame_attr(RAM_STACK);
+		}
+		
+		/*The stack is located at the start of the frame;*/
+		thread_stack = mem->stack_frame;
+		
+	} else {
+		
+		/*Allocate some memory for the thread's stack_data in the heap. It is released before the leak report;*/
+		thread_stack = prc_mem_malloc(mem, stacks_size);
+		
+	}
 	
 	/*Determine the stack_data's highest address;*/
 	void *stack_reset = (void *) ((uint8_t *) thread_stack + stacks_size);
@@ -124,7 +162,137 @@ void prc_mem_reset(struct pmem *mem, size_t stacks_size) {
 
 void prc_mem_clean(struct pmem *mem) {
 	
+#ifdef KERNEL_MEM_TRACKING
+	
+	/*If the stack is in the heap, release it, it is not a leak;*/
+	if (!mem->stack_frame) {
+		prc_mem_free(mem, mem->stack.stack_limit);
+	}
+	
+	/*Report blocks that the process did not free;*/
+	prc_mem_leak_report(mem);
+	
+	/*Delete the allocations tracker;*/
+	mtrack_delete(&mem->tracker);
+	
+#endif
+	
+	/*If the stack has its own frame, free it;*/
+	if (mem->stack_frame) {
+		ram_free_frame(mem->stack_frame);
+	}
+	
 	/*Free the RAM block;*/
 	ram_free(mem->ram_start);
 	
 }
+
+
+/*------------------------------------------------- Process allocations ------------------------------------------------*/
+
+/**
+ * prc_mem_malloc : allocates a block in the process heap;
+ *
+ * 	If memory tracking is enabled, the block is recorded along with the caller's address. The memory of the current
+ * 	process is given by sched_get_pmem;
+ *
+ * @param mem : the process memory;
+ * @param size : the size of the block to allocate;
+ * @return the allocated block, or 0 if the allocation failed;
+ */
+
+void *prc_mem_malloc(struct pmem *const mem, const size_t size) {
+	
+	/*Allocate the block;*/
+	void *block = heap_malloc(mem->heap, size);
+	
+#ifdef KERNEL_MEM_TRACKING
+	
+	/*Record the block and the call site;*/
+	mtrack_add(&mem->tracker, block, size, __builtin_return_address(0));
+	
+#endif
+	
+	/*Return the block;*/
+	return block;
+	
+}
+
+
+/**
+ * prc_mem_ialloc : allocates and initialises a block in the process heap;
+ *
+ * 	If memory tracking is enabled, the block is recorded along with the caller's address;
+ *
+ * @param mem : the process memory;
+ * @param size : the size of the block to allocate;
+ * @param init : the initializer to copy in the block;
+ * @return the allocated block, or 0 if the allocation failed;
+ */
+
+void *prc_mem_ialloc(struct pmem *const mem, const size_t size, const void *const init) {
+	
+	/*Allocate and initialise the block;*/
+	void *block = heap_ialloc(mem->heap, size, init);
+	
+#ifdef KERNEL_MEM_TRACKING
+	
+	/*Record the block and the call site;*/
+	mtrack_add(&mem->tracker, block, size, __builtin_return_address(0));
+	
+#endif
+	
+	/*Return the block;*/
+	return block;
+	
+}
+
+
+/**
+ * prc_mem_free : frees a block of the process heap;
+ *
+ * @param mem : the process memory;
+ * @param block : the block to free;
+ */
+
+void prc_mem_free(struct pmem *const mem, void *const block) {
+	
+#ifdef KERNEL_MEM_TRACKING
+	
+	/*Forget the block;*/
+	mtrack_remove(&mem->tracker, block);
+	
+#endif
+	
+	/*Free the block;*/
+	heap_free(mem->heap, block);
+	
+}
+
+
+/**
+ * prc_mem_leak_report : prints all blocks that are still allocated in the process heap, grouped by call site;
+ *
+ * 	Does nothing if memory tracking is disabled;
+ *
+ * @param mem : the process memory to report;
+ */
+
+void prc_mem_leak_report(const struct pmem *const mem) {
+	
+#ifdef KERNEL_MEM_TRACKING
+	
+	/*Log;*/
+	printkf("Process memory %h : leak report\n\r", mem->ram_start);
+	
+	/*Report all live blocks;*/
+	size_t nb_blocks = mtrack_report(&mem->tracker);
+	
+	/*If no leaks were found, log;*/
+	if (!nb_blocks) {
+		printk("\tno leak\n\r");
+	}
+	
+#endif
+	
+}
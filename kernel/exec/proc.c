@@ -39,6 +39,7 @@
 #include <kernel/hard/debug/printk.h>
 #include <kernel/exec/sched.h>
 #include <kernel/exec/sysclock.h>
+#include <kernel/core/ram.h>
 
 #include <panic.h>
 
@@ -67,8 +68,16 @@ void proc_init_stack(struct stck *stack, void (*function)(), void (*end_loop)(),
 
 static void init_exception_stack() {
 	
-	/*Allocate some memory for the thread's stack in the newly created heap;*/
-	void *thread_stack = ram_alloc(KEX_STACK_SIZE);
+	/*If the exception stack doesn't fit in a frame :*/
+	if (KEX_STACK_SIZE > ram_frame_size()) {
+		
+		/*Panic, the make parameter is invalid;*/
+		kernel_panic("proc.c : exception stack bigger than a RAM frame;");
+		
+	}
+	
+	/*Allocate the exception stack in the stack region;*/
+	void *thread_stack = ram_alloc_frame_attr(RAM_STACK);
 	
 	/*Determine the stack's highest address;*/
 	void *stack_reset = (void *) ((uint8_t *) thread_stack + KEX_STACK_SIZE);
@@ -77,6 +77,12 @@ struct sched_elmt {
 	/*The program memory;*/
 	struct pmem prc_mem;
 
+	/*The descriptor table of files opened by the process;*/
+	struct fdt files;
+
+	/*The copy of the process descriptor, in the process heap;*/
+	struct prc_desc *desc_copy;
+
 	/*TODO ENABLE ONLY FOR DEBUG;*/
 	/*The activity state; Set if the element is active;*/
 	bool active;
@@ -186,10 +192,10 @@ static void sched_init_prc_mem(struct sched_elmt *elmt) {
 	prc_mem_reset(mem, elmt->req.stack_size);
 	
 	/*The process descriptor is located in the kernel heap. We must copy it in the process heap;*/
-	struct prc_desc *desc_copy = heap_ialloc(mem->heap, sizeof(struct prc_desc), &elmt->desc);
+	elmt->desc_copy = prc_mem_ialloc(mem, sizeof(struct prc_desc), &elmt->desc);
 	
 	/*Initialise the stack and pass the execution environment;*/
-	proc_init_stack(&mem->stack, &run_exec, &run_exit, desc_copy);
+	proc_init_stack(&mem->stack, &run_exec, &run_exit, elmt->desc_copy);
 	
 }
 
@@ -236,6 +242,12 @@ void sched_init() {
 		/*Program memory not initialised for instance;*/
 		.prc_mem = {0},
 		
+		/*No files opened;*/
+		.files = {0},
+		
+		/*Descriptor not copied yet;*/
+		.desc_copy = 0,
+		
 		/*First process not active;*/
 		.active = false,
 		
@@ -302,6 +314,12 @@ void sched_create_prc(struct prc_desc *desc, struct prc_req *req) {
 		/*Program memory not initialised for instance;*/
 		.prc_mem = {0},
 		
+		/*No files opened;*/
+		.files = {0},
+		
+		/*Descriptor not copied yet;*/
+		.desc_copy = 0,
+		
 		/*Process active;*/
 		.active = true,
 		
@@ -350,6 +368,14 @@ static void sched_delete_element(struct sched_elmt *element) {
 	/*Access to the process list is critical;*/
 	critical_section_leave();
 	
+	/*Close all files the process left opened;*/
+	fdt_close_all(&element->files);
+	
+	/*Release the descriptor copy, so that only blocks allocated by the process are reported as leaks;*/
+	if (element->desc_copy) {
+		prc_mem_free(&element->prc_mem, element->desc_copy);
+	}
+	
 	/*Delete the process;*/
 	prc_mem_clean(&element->prc_mem);
 	
@@ -387,6 +413,17 @@ struct sched_elmt *sched_stop_prc() {
 
 void sched_resume_prc(struct sched_elmt *const element) {
 	
+	/*If the element is the current one, and its stop has not been committed yet :*/
+	if ((element->active) && (sched.stop_required) && (sched.active_list == element)) {
+		
+		/*Cancel the stop, the element remains active; The resume is not lost;*/
+		sched.stop_required = false;
+		
+		/*Complete;*/
+		return;
+		
+	}
+	
 	/*If the element is active :*/
 	if (element->active) {
 		
@@ -493,19 +530,28 @@ void sched_commit() {
 		/*Cleanup;*/
 		sched.termination_required = false;
 
-	} else if (sched.stop_required) {
+	} else {
+		
+		/*A resume can cancel a pending stop, the stop must be committed atomically;*/
+		critical_section_enter();
 		
 		/*If the current process must be stopped :*/
-
-		/*Remove the first element of the active list;*/
-		remove_process(current);
-
-		/*Mark the element inactive;*/
-		current->active = false;
+		if (sched.stop_required) {
+			
+			/*Remove the first element of the active list;*/
+			remove_process(current);
+			
+			/*Mark the element inactive;*/
+			current->active = false;
+			
+			/*Cleanup;*/
+			sched.stop_required = false;
+			
+		}
+		
+		/*Leave the critical section;*/
+		critical_section_leave();
 		
-		/*Cleanup;*/
-		sched.stop_required = false;
-
 	}
 	
 }
@@ -531,4 +577,12 @@ struct pmem *sched_get_pmem() {
 }
 
 
+/*Get the descriptor table of the current process;*/
+struct fdt *sched_get_fdt() {
+	
+	/*Return the first process descriptor table;*/
+	return &sched.active_list->files;
+	
+}
+
 
@@ -16,6 +16,16 @@ KRNL_CORE_BDIR := $(KRNL_OBJS_BDIR)/core
 #Compilation flags proper to the khal;
 KRNL_FLAGS :=
 
+#If process memory tracking is enabled, define its macro;
+ifeq ($(BOPS_MEM_TRACKING),1)
+KRNL_FLAGS += -DKERNEL_MEM_TRACKING
+endif
+
+#If the hardware CRC is enabled, define its macro;
+ifeq ($(BOPS_HW_CRC),1)
+KRNL_FLAGS += -DKERNEL_HW_CRC
+endif
+
 #The kernel compilation shortcut; The kernel has access to nostd;
 KRNL_CC = $(TC_CC) -Iinclude/ -I$(BOPS_NOSTD_INC) $(TC_CFLAGS) $(KRNL_FLAGS)
 
@@ -33,6 +43,11 @@ kernel_core :
 	$(KRNL_CC) -c $(KRNL_CORE_SDIR)/fault.c -o $(KRNL_CORE_BDIR)/fault.o
 	$(KRNL_CC) -c $(KRNL_CORE_SDIR)/ram.c -o $(KRNL_CORE_BDIR)/ram.o
 
+#Memory functions are built with the kernel, and replace those of nostd. The compiler must not turn their loops into
+#calls to themselves;
+	$(KRNL_CC) -fno-builtin -fno-tree-loop-distribute-patterns -c $(KRNL_CORE_SDIR)/stdmem.c \
+	-o $(KRNL_CORE_BDIR)/stdmem.o
+
 
 kernel_res :
 
@@ -18,7 +18,7 @@
 
 */
 
-#include <struct/nlist.h>
+#include <kernel/res/nindex.h>
 #include <panic.h>
 #include <kernel/hard/debug/printk.h>
 
@@ -38,7 +38,7 @@ static void (*clock_auto_tuner)(uint32_t);
  * The clocks list;
  */
 
-struct nlist clocks_list = {
+struct nindex clocks_list = {
 	.name_max_length = 20,
 	.elements = 0,
 };
@@ -149,7 +149,7 @@ void clock_auto_tune(uint32_t target_frequency) {
 bool clock_register(const char *const name, const uint32_t value) {
 	
 	/*Add the clock;*/
-	return nlist_add(&clocks_list, name, (void *) value);
+	return nindex_add(&clocks_list, name, (void *) value);
 	
 }
 
@@ -158,7 +158,7 @@ bool clock_register(const char *const name, const uint32_t value) {
 void clock_set(const char *name, uint32_t value) {
 	
 	/*Set the clock;*/
-	nlist_set(&clocks_list, name, (void *) value);
+	nindex_set(&clocks_list, name, (void *) value);
 	
 }
 
@@ -167,7 +167,7 @@ void clock_set(const char *name, uint32_t value) {
 uint32_t clock_get(const char *name) {
 	
 	/*Get the clock frequency;*/
-	return (uint32_t) nlist_get(&clocks_list, name);
+	return (uint32_t) nindex_get(&clocks_list, name);
 	
 }
 
@@ -176,7 +176,7 @@ uint32_t clock_get(const char *name) {
 void clock_remove(const char *name) {
 	
 	/*Remove the clock;*/
-	nlist_remove(&clocks_list, name);
+	nindex_remove(&clocks_list, name);
 	
 }
 
@@ -40,44 +40,65 @@
 typedef void FILE;
 
 
+/**
+ * vfs_register_fs : registers a file system type, so that it can be mounted by name;
+ * @param type : the file system type; Must remain valid until unregistered;
+ * @return true if the type was registered, false if its name is already used;
+ */
+
+bool vfs_register_fs(struct fs_type *type);
+
+
+/**
+ * vfs_unregister_fs : unregisters a file system type. Mounted file systems of this type are not affected;
+ * @param fs_name : the name of the file system type;
+ */
+
+void vfs_unregister_fs(const char *fs_name);
+
+
 /**
  * vfs_mount : mounts a file system.
  * @param path : the absolute path of the directory where to mount the file system;
  * @param fs_name : the name of the file system, used to determine its type (ex : ext2);
  * @param dev_name : the absolute path of the device where the file system is located; Can be null;
+ * @return true if the file system was mounted;
  */
 
-void vfs_mount(const char *path, const char *fs_name, const char *dev_name);
+bool vfs_mount(const char *path, const char *fs_name, const char *dev_name);
 
 
 /**
  * vfs_unmount : unmounts a file system;
  * @param path : the absolute path of the mount point directory.
+ * @return true if the file system was unmounted, false if it is not mounted or busy;
  */
 
-void vfs_unmount(const char *path);
+bool vfs_unmount(const char *path);
 
 
 /**
  * vfs_create : creates a generic resource by its path;
  * @param path : the absolute path where to create the resource. Must not be slash-ended;
+ * @return true if the resource was created, false if it already exists or can't be created;
  */
 
-void vfs_create(const char *path);
+bool vfs_create(const char *path);
 
 
 /**
  * vfs_delete : searched for the given resource and attempts to delete it;
  * @param path : the absolute path of the resource;
+ * @return true if the resource was deleted, false if it doesn't exist, is opened, or can't be deleted;
  */
 
-void vfs_delete(const char *path);
+bool vfs_delete(const char *path);
 
 
 /**
  * vfs_open : opens a resource and returns its descriptor;
  * @param path : the absolute path of the resource;
- * @return the descriptor of the resource for future manipulations;
+ * @return the descriptor of the resource for future manipulations, or 0 if it can't be opened;
  */
 
 struct resrc *vfs_open(const char *path);
@@ -91,5 +112,37 @@ struct resrc *vfs_open(const char *path);
 void vfs_close(struct resrc *rd);
 
 
+/**
+ * vfs_read : reads from an opened resource, at its current position;
+ * @param rd : the resource descriptor of the opened resource;
+ * @param dst : the buffer where to copy data;
+ * @param size : the maximal number of bytes to read;
+ * @return the number of bytes read;
+ */
+
+size_t vfs_read(struct resrc *rd, void *dst, size_t size);
+
+
+/**
+ * vfs_write : writes in an opened resource, at its current position;
+ * @param rd : the resource descriptor of the opened resource;
+ * @param src : the data to write;
+ * @param size : the number of bytes to write;
+ * @return the number of bytes written;
+ */
+
+size_t vfs_write(struct resrc *rd, const void *src, size_t size);
+
+
+/**
+ * vfs_seek : moves the current position of an opened resource;
+ * @param rd : the resource descriptor of the opened resource;
+ * @param offset : the new position, from the start of the resource;
+ * @return true if the position was updated;
+ */
+
+bool vfs_seek(struct resrc *rd, size_t offset);
+
+
 
 #endif /*TRACER_VFS_H*/
@@ -0,0 +1,385 @@
+/*
+  devfs.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "api.h"
+
+#include "devfs.h"
+
+#include <string.h>
+
+#include <kernel/res/kdmem.h>
+
+#include <kernel/exec/mod_hook>
+
+
+/*
+ * The devfs is a view of the iinode index : it stores no file, and resolves names in the index at each lookup;
+ *
+ * 	The root contains files without class, and a directory per class that has files. Class directories exist as
+ * 	long as files of their class are registered. A name with a class is not visible at the root;
+ *
+ * 	Nodes only keep the name of their file, that is opened by name : a file removed after its lookup fails to open.
+ * 	Nodes are created at lookup, cached by the vfs in dentries, and deleted at unmount. Files registered after a
+ * 	failed lookup of their path stay hidden by its negative dentry until it is evicted : drivers register their files
+ * 	at startup, before /dev is mounted;
+ *
+ * 	Opening a file opens its iinode. The resource provides the descriptor, to initialise and interface the device;
+ */
+
+
+/*-------------------------------------------------------- Types -------------------------------------------------------*/
+
+/*
+ * A devfs node is an inode, with the name of its file, or the class of its directory;
+ */
+
+struct devfs_node {
+
+	/*The vfs inode;*/
+	struct inode inode;
+
+	/*The link in the list of nodes of the superblock;*/
+	struct list_head link;
+
+	/*The name of the file, or the class of the directory. Empty for the root;*/
+	char name[VFS_NAME_MAX_LENGTH + 1];
+
+};
+
+
+/*
+ * A devfs superblock contains the root node, and the list of other nodes;
+ */
+
+struct devfs_sb {
+
+	/*The vfs superblock;*/
+	struct superblock sb;
+
+	/*The root node;*/
+	struct devfs_node root;
+
+	/*Nodes created by lookups;*/
+	struct list_head nodes;
+
+};
+
+
+/*
+ * A devfs resource references an opened file;
+ */
+
+struct devfs_resrc {
+
+	/*The vfs resource;*/
+	struct resrc res;
+
+	/*The descriptor of the file;*/
+	file_descriptor fd;
+
+};
+
+
+static const struct inode_operations devfs_dir_ops;
+
+static const struct inode_operations devfs_file_ops;
+
+
+/*------------------------------------------------------ Resources -----------------------------------------------------*/
+
+/*Close a file and delete its resource;*/
+static void devfs_close(struct resrc *const rd) {
+
+	/*Close the file;*/
+	fs_close(((struct devfs_resrc *) rd)->fd);
+
+	/*Delete the resource;*/
+	kfree(rd);
+
+}
+
+
+/*The resource operations. Devices are accessed through their descriptor;*/
+static const struct resrc_ops devfs_resrc_ops = {
+	.read = 0,
+	.write = 0,
+	.seek = 0,
+	.close = &devfs_close,
+};
+
+
+/*Get the descriptor of an opened device file;*/
+file_descriptor devfs_descriptor(const struct resrc *const rd) {
+
+	/*If the resource is not a device file, fail;*/
+	if (rd->res_ops != &devfs_resrc_ops) {
+		return 0;
+	}
+
+	/*Return the descriptor;*/
+	return ((const struct devfs_resrc *) rd)->fd;
+
+}
+
+
+/*-------------------------------------------------------- Nodes -------------------------------------------------------*/
+
+/**
+ * devfs_node_create : creates a node and links it to its superblock;
+ *
+ * @param sb : the superblock;
+ * @param name : the name of the file or of the class, at most VFS_NAME_MAX_LENGTH long;
+ * @param ops : the operations of a file or of a directory;
+ * @return the node's inode, or 0 if the heap is full;
+ */
+
+static struct inode *devfs_node_create(struct devfs_sb *const sb, const char *const name,
+									   const struct inode_operations *const ops) {
+
+	/*Allocate the node;*/
+	struct devfs_node *const node = kmalloc(sizeof(struct devfs_node));
+
+	/*If the allocation failed, fail;*/
+	if (!node) {
+		return 0;
+	}
+
+	/*Initialise the inode;*/
+	node->inode.i_mode = 0;
+	node->inode.i_dentry = 0;
+	node->inode.i_sb = &sb->sb;
+	node->inode.i_ops = ops;
+
+	/*Copy the name;*/
+	strcpy(node->name, name);
+
+	/*Link the node to its superblock;*/
+	list_init(&node->link);
+	list_concat(&sb->nodes, &node->link);
+
+	/*Return the inode;*/
+	return &node->inode;
+
+}
+
+
+/*Search for a file or a class directory;*/
+static struct inode *devfs_lookup(struct inode *const dir, const char *const name) {
+
+	/*Cache the directory and the superblock;*/
+	const struct devfs_node *const parent = (const struct devfs_node *) dir;
+	struct devfs_sb *const sb = (struct devfs_sb *) dir->i_sb;
+
+	/*The name of the file in the index;*/
+	char file[VFS_NAME_MAX_LENGTH + 1];
+
+	/*Cache the length of the name and of the class. The root has no class;*/
+	const size_t length = strlen(name), class_length = strlen(parent->name);
+
+	/*At the root :*/
+	if (!class_length) {
+
+		/*Names with a class are in their class directory;*/
+		if (strchr(name, '_')) {
+			return 0;
+		}
+
+		/*If files of the class exist, the name is a directory;*/
+		if (fs_class_exists(name)) {
+			return devfs_node_create(sb, name, &devfs_dir_ops);
+		}
+
+		/*Otherwise, the name is a file without class;*/
+		memcpy(file, name, length + 1);
+
+	} else {
+
+		/*In a class directory, the file is named <class>_<name>. If it is too long, it doesn't exist;*/
+		if (class_length + 1 + length > VFS_NAME_MAX_LENGTH) {
+			return 0;
+		}
+
+		/*Build the name of the file;*/
+		memcpy(file, parent->name, class_length);
+		file[class_length] = '_';
+		memcpy(file + class_length + 1, name, length + 1);
+
+	}
+
+	/*If the file is registered, create its node;*/
+	return (fs_get(file)) ? devfs_node_create(sb, file, &devfs_file_ops) : 0;
+
+}
+
+
+/*Open a file;*/
+static struct resrc *devfs_open(struct inode *const inode) {
+
+	/*Open the file by name. If it was removed, or is already opened, fail;*/
+	const file_descriptor fd = fs_open(((struct devfs_node *) inode)->name);
+	if (!fd) {
+		return 0;
+	}
+
+	/*Create the initializer;*/
+	const struct devfs_resrc init = {
+		.res = {
+			.res_dentry = 0,
+			.res_ops = &devfs_resrc_ops,
+		},
+		.fd = fd,
+	};
+
+	/*Allocate and initialise the resource;*/
+	struct resrc *const rd = kialloc(sizeof(struct devfs_resrc), &init);
+
+	/*If the allocation failed, close the file;*/
+	if (!rd) {
+		fs_close(fd);
+	}
+
+	/*Return the resource;*/
+	return rd;
+
+}
+
+
+/*Directories are only searched. Files are not created nor deleted through the vfs;*/
+static const struct inode_operations devfs_dir_ops = {
+	.lookup = &devfs_lookup,
+	.create = 0,
+	.unlink = 0,
+	.open = 0,
+};
+
+
+/*Files are only opened;*/
+static const struct inode_operations devfs_file_ops = {
+	.lookup = 0,
+	.create = 0,
+	.unlink = 0,
+	.open = &devfs_open,
+};
+
+
+/*----------------------------------------------------- Superblock -----------------------------------------------------*/
+
+/**
+ * devfs_get_sb : creates a devfs, with its root only. No device is used;
+ */
+
+static struct superblock *devfs_get_sb(struct fs_type *const type, const char *const dev_name) {
+
+	/*Allocate the superblock;*/
+	struct devfs_sb *const sb = kcalloc(sizeof(struct devfs_sb));
+
+	/*If the allocation failed, fail;*/
+	if (!sb) {
+		return 0;
+	}
+
+	/*Initialise the root, that has no class;*/
+	sb->root.inode.i_sb = &sb->sb;
+	sb->root.inode.i_ops = &devfs_dir_ops;
+	list_init(&sb->root.link);
+
+	/*No other node exists;*/
+	list_init(&sb->nodes);
+
+	/*Reference the root inode;*/
+	sb->sb.sb_inode = &sb->root.inode;
+
+	/*Return the superblock;*/
+	return &sb->sb;
+
+}
+
+
+/**
+ * devfs_release_sb : deletes all nodes. Files are not affected;
+ */
+
+static bool devfs_release_sb(struct superblock *const sb) {
+
+	/*Cache the list of nodes;*/
+	struct list_head *const nodes = &((struct devfs_sb *) sb)->nodes;
+
+	/*While nodes remain, delete the first one;*/
+	while (nodes->next != nodes) {
+
+		/*Cache the link, and unlink it;*/
+		struct list_head *const link = nodes->next;
+		list_remove(link);
+
+		/*Delete the node;*/
+		kfree((uint8_t *) link - offsetof(struct devfs_node, link));
+
+	}
+
+	/*Free the superblock;*/
+	kfree(sb);
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/*The devfs type;*/
+static struct fs_type devfs_type = {
+	.name = "devfs",
+	.get_sb = &devfs_get_sb,
+	.release_sb = &devfs_release_sb,
+};
+
+
+/*Register the devfs type;*/
+static bool devfs_init() {
+
+	/*Register the type in the vfs;*/
+	return vfs_register_fs(&devfs_type);
+
+}
+
+
+/**
+ * devfs_mount_dev : mounts the devfs on /dev, once drivers registered their files. If no file system is mounted on
+ * 	the root, a tmpfs is;
+ */
+
+static bool devfs_mount_dev() {
+
+	/*Mount a tmpfs on the root. Fails if a file system is already mounted;*/
+	vfs_mount("/", "tmpfs", 0);
+
+	/*Create the mount point. Fails if it already exists;*/
+	vfs_create("/dev");
+
+	/*Mount the devfs;*/
+	return vfs_mount("/dev", "devfs", 0);
+
+}
+
+
+/*Embed the devfs in the executable;*/
+KERNEL_HOOK_MODULE(SYSTEM_MODULE, devfs, &devfs_init)
+
+/*Mount it after peripheral modules;*/
+KERNEL_HOOK_MODULE(KERNEL_MODULE, dev_mount, &devfs_mount_dev)
@@ -0,0 +1,42 @@
+/*
+  devfs.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_DEVFS_H
+#define TRACER_DEVFS_H
+
+
+#include "fs.h"
+
+#include "iinode.h"
+
+
+/*
+ * The devfs presents device files of the iinode index in the vfs tree, mounted on /dev;
+ *
+ * 	A device file named <class>_<index>, as module channels are, is presented as /dev/<class>/<index>. A file without
+ * 	class is presented as /dev/<name>;
+ */
+
+
+/*Get the descriptor of an opened device file. Return 0 if the resource is not a device file;*/
+file_descriptor devfs_descriptor(const struct resrc *rd);
+
+
+#endif /*TRACER_DEVFS_H*/
@@ -23,8 +23,16 @@
 #define TRACER_FS_H
 
 
+#include <stdbool.h>
+
+#include <stdint.h>
+
+#include <stddef.h>
+
 #include <list.h>
 
+#include <kernel/res/nindex.h>
+
 struct fs_type;
 struct superblock;
 struct super_operations;
@@ -36,6 +44,24 @@ struct resrc;
 struct resrc_ops;
 
 
+/*--------------------------------------------------- Make Parameters --------------------------------------------------*/
+
+/*The maximal length of a path component, terminating null excluded;*/
+#if !defined(VFS_NAME_MAX_LENGTH)
+
+#define VFS_NAME_MAX_LENGTH 32
+
+#endif
+
+
+/*The maximal number of negative dentries cached by the vfs. The least recently used one is deleted beyond;*/
+#if !defined(VFS_NEGATIVE_DENTRIES_MAX)
+
+#define VFS_NEGATIVE_DENTRIES_MAX 64
+
+#endif
+
+
 /*-------------------------------------------------- File system type --------------------------------------------------*/
 
 /**
@@ -50,11 +76,12 @@ struct fs_type {
 	/*The name of the file system type;*/
 	const char *name;
 	
-	/*Provide a superblock from an existing file system; 0 is returned in case of failure;*/
-	struct superblock *(*get_sb);/*TODO ARGS*/
+	/*Provide a superblock from an existing file system, located on a device that can be null; 0 is returned in case
+	 * of failure;*/
+	struct superblock *(*get_sb)(struct fs_type *type, const char *dev_name);
 	
-	/*Properly cleanup a superblock; 0 is returned in case of failure;*/
-	bool (*release_sb)(struct superblock *);/*TODO ARGS*/
+	/*Properly cleanup a superblock and all its inodes; false is returned in case of failure;*/
+	bool (*release_sb)(struct superblock *);
 	
 };
 
@@ -65,11 +92,8 @@ struct fs_type {
 
 struct fs_mnt {
 	
-	/*A list head, for fs_mnt storage;*/
-	struct list_head mnt_head;
-	
-	/*The mount point name;*/
-	const char *mnt_name;
+	/*The mount point dentry, in the parent file system;*/
+	struct dentry *mnt_point;
 	
 	/*The mounted fs's superblock;*/
 	struct superblock *mnt_sb;
@@ -81,7 +105,10 @@ struct fs_mnt {
 
 struct superblock {
 	
-	/*The first dentry of the superblock;*/
+	/*The root inode, provided by the file system;*/
+	struct inode *sb_inode;
+	
+	/*The first dentry of the superblock, created by the vfs at mount;*/
 	struct dentry *sb_root;
 	
 	/*The file system type the superblock relates to;*/
@@ -91,7 +118,10 @@ struct superblock {
 	struct fs_mnt *sb_mnt;
 	
 	/*The superblock operations table;*/
-	struct super_operations *sb_ops;
+	const struct super_operations *sb_ops;
+	
+	/*The number of opened resources and of file systems mounted in the superblock. Unmount fails if not null;*/
+	size_t sb_busy;
 	
 };
 
@@ -108,32 +138,44 @@ struct super_operations {
  *
  * 	It associates a name with an inode, and contains links to :
  * 	- its unique parent dentry, via d_parent, direct reference;
- * 	- the first (historically) of its children, via d_child, direct reference;
- * 	- its siblings (dentries that share the same parent), via d_siblings, a doubly linked list head;
+ * 	- its children, via d_children, a name index, so that a path component is resolved with a single hash probe;
+ * 	- the root dentry of the file system mounted on it, if any, via d_mount;
+ *
+ * 	A dentry without inode is negative : it records that the name does not exist in its parent, so that failed
+ * 	lookups do not reach the file system again. It becomes positive when the name is created;
+ *
+ * 	Negative dentries are also linked in the vfs's list of negative dentries, ordered by last use, so that their
+ * 	number stays bounded;
  */
 
 struct dentry {
 	
+	/*The link in the list of negative dentries. Single element list if the dentry is positive;*/
+	struct list_head d_lru;
+	
 	/*The name of the dentry;*/
 	const char *d_name;
 	
-	/*The inode associated with the dentry;*/
+	/*The inode associated with the dentry. Null if the dentry is negative;*/
 	struct inode *d_inode;
 	
 	/*The parent of the dentry;*/
 	struct dentry *d_parent;
 	
-	/*The first child of the dentry;*/
-	struct dentry *d_child;
+	/*The cached children of the dentry, indexed by name;*/
+	struct nindex d_children;
+	
+	/*The root dentry of the file system mounted on the dentry. Null if not a mount point;*/
+	struct dentry *d_mount;
 	
-	/*The list of the dentry's siblings;*/
-	struct list_head *d_siblings;
+	/*The number of opened resources of the dentry;*/
+	size_t d_count;
 	
 	/*The superblock the dentry related to;*/
 	struct superblock *d_sb;
 	
 	/*The set of dentry operations;*/
-	struct dentry_operations *d_ops;
+	const struct dentry_operations *d_ops;
 	
 };
 
@@ -158,13 +200,29 @@ struct inode {
 	struct superblock *i_sb;
 	
 	/*The set of inode operations;*/
-	struct inode_operations *i_ops;
+	const struct inode_operations *i_ops;
 	
 };
 
 
-struct inode_operations {
+/*
+ * Inode operations are called by the vfs only. All of them can be null;
+ */
 
+struct inode_operations {
+	
+	/*Search for a child of a directory inode, and return it. 0 is returned if it does not exist;*/
+	struct inode *(*lookup)(struct inode *dir, const char *name);
+	
+	/*Create a child in a directory inode, and return it. 0 is returned in case of failure;*/
+	struct inode *(*create)(struct inode *dir, const char *name);
+	
+	/*Remove and delete a child of a directory inode. false is returned in case of failure;*/
+	bool (*unlink)(struct inode *dir, const char *name, struct inode *node);
+	
+	/*Create a resource to access the inode. 0 is returned in case of failure;*/
+	struct resrc *(*open)(struct inode *node);
+	
 };
 
 
@@ -175,14 +233,26 @@ struct resrc {
 	/*The dentry associated to the resource;*/
 	struct dentry *res_dentry;
 	
-	/*The set of inode operations;*/
-	struct resrc_ops *i_ops;
+	/*The set of resource operations;*/
+	const struct resrc_ops *res_ops;
 	
 };
 
 
 struct resrc_ops {
-
+	
+	/*Read at most @size bytes at the current position, advance it, and return the number of bytes read;*/
+	size_t (*read)(struct resrc *, void *dst, size_t size);
+	
+	/*Write at most @size bytes at the current position, advance it, and return the number of bytes written;*/
+	size_t (*write)(struct resrc *, const void *src, size_t size);
+	
+	/*Move the current position. false is returned if the position is invalid;*/
+	bool (*seek)(struct resrc *, size_t offset);
+	
+	/*Close the resource and delete it;*/
+	void (*close)(struct resrc *);
+	
 };
 
 
@@ -22,7 +22,7 @@
 
 #include <panic.h>
 
-#include <struct/nlist.h>
+#include <kernel/res/nindex.h>
 
 #include "iinode.h"
 
@@ -31,7 +31,13 @@
 
 /*--------------------------------------------------- Global variable --------------------------------------------------*/
 
-static struct nlist files = {
+static struct nindex files = {
+	.elements = 0,
+	.name_max_length = 32,
+};
+
+/*Device classes, the prefixes of file names before their first '_', associated to their number of files;*/
+static struct nindex classes = {
 	.elements = 0,
 	.name_max_length = 32,
 };
@@ -145,12 +151,53 @@ void iop_reset(file_descriptor fd) {
 
 /*---------------------------------------------------- File system -----------------------------------------------------*/
 
+/**
+ * fs_class_count : adds or removes a file in the count of its class, if its name has one;
+ *
+ * 	Channels of a module are named <class>_<index> : the class is the prefix of the name before its first '_';
+ *
+ * @param name : the name of the file;
+ * @param added : set if the file was added, clear if it was removed;
+ */
+
+static void fs_class_count(const char *const name, const bool added) {
+
+	/*Find the end of the class. If the name has none, nothing to do;*/
+	const char *const separator = strchr(name, '_');
+	if ((!separator) || (separator == name)) {
+		return;
+	}
+
+	/*Copy the class. Names are at most as long as classes;*/
+	char class[33];
+	const size_t length = (size_t) (separator - name);
+	memcpy(class, name, length);
+	class[length] = 0;
+
+	/*Get the count of the class, null if it has no file;*/
+	const size_t count = (size_t) nindex_get(&classes, class);
+
+	/*Update the count. The class is removed with its last file;*/
+	if ((added) && (count)) {
+		nindex_set(&classes, class, (void *) (count + 1));
+	} else if (added) {
+		nindex_add(&classes, class, (void *) 1);
+	} else if (count > 1) {
+		nindex_set(&classes, class, (void *) (count - 1));
+	} else {
+		nindex_remove(&classes, class);
+	}
+
+}
+
 
 /*Add a file in the file system;*/
 void fs_create(const char *name, struct iinode *const node) {
 
-	/*Add to the files list;*/
-	nlist_add(&files, name, node);
+	/*Add to the files list, and count the file in its class;*/
+	if (nindex_add(&files, name, node)) {
+		fs_class_count(name, true);
+	}
 
 }
 
@@ -163,7 +210,10 @@ static void fs_delete(struct iinode *node, const char *name) {
 	 * Now delete the file;
 	 */
 
-	nlist_remove(&files, name);
+	nindex_remove(&files, name);
+
+	/*Remove the file from its class;*/
+	fs_class_count(name, false);
 
 }
 
@@ -172,7 +222,7 @@ static void fs_delete(struct iinode *node, const char *name) {
 bool fs_remove(const char *name) {
 
 	/*Search for the required file;*/
-	struct iinode *file = nlist_get(&files, name);
+	struct iinode *file = nindex_get(&files, name);
 
 	/*If the file doesn't exist, stop here;*/
 	if (!file) return true;
@@ -193,9 +243,25 @@ bool fs_remove(const char *name) {
 }
 
 
+/*Get a file without opening it;*/
+struct iinode *fs_get(const char *const name) {
+
+	return nindex_get(&files, name);
+
+}
+
+
+/*Assert if files of a class exist;*/
+bool fs_class_exists(const char *const class) {
+
+	return nindex_get(&classes, class) != 0;
+
+}
+
+
 file_descriptor fs_open(const char *name) {
 
-	struct iinode *node = nlist_get(&files, name);
+	struct iinode *node = nindex_get(&files, name);
 
 	if (!node) {
 		return 0;
@@ -249,7 +315,7 @@ void fs_close(file_descriptor fd) {
 /*List all files;*/
 void fs_list() {
 
-	nlist_list(&files);
+	nindex_list(&files);
 
 }
 
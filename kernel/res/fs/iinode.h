@@ -113,6 +113,12 @@ void fs_create(const char *name, struct iinode *node);
 /*Remove a node; Will be deleted if node closed;*/
 bool fs_remove(const char *name);
 
+/*Get a node without opening it. Return 0 if it does not exist;*/
+struct iinode *fs_get(const char *name);
+
+/*Assert if nodes are named with a class, the prefix of their name before its first '_';*/
+bool fs_class_exists(const char *class);
+
 /*Open a node;*/
 file_descriptor fs_open(const char *name);
 
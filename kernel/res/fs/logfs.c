@@ -0,0 +1,2574 @@
+/*
+  logfs.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "api.h"
+
+#include "iinode.h"
+
+#include "../if/flash.h"
+
+#include <string.h>
+
+#include <stdmem.h>
+
+#include <kernel/res/kdmem.h>
+
+#include <kernel/exec/mod_hook>
+
+#include <kernel/exec/sched.h>
+
+#include <kernel/core/except.h>
+
+#include <khal/prmpt.h>
+
+
+/*
+ * The logfs is a log-structured file system for data flash, designed for sustained data logging;
+ *
+ * 	Each flash sector is a segment. Segments are written in append-only mode, and ordered by a sequence number
+ * 	assigned when they are activated. A segment contains a header, followed by records :
+ * 	- CREATE records associate a file id to a name;
+ * 	- DATA records contain a part of a file's data, and its offset in the file;
+ * 	- DELETE records mark a file id deleted;
+ *
+ * 	The header of a record is programmed after its payload, so that an interrupted program never produces a valid
+ * 	record. At mount, all segments are scanned, and a RAM index is rebuilt, referencing for each file the location
+ * 	of all its data records;
+ *
+ * 	Files can only be appended. Writes are staged in RAM buffers, and programmed phrase by phrase by an engine that
+ * 	launches at most one flash command at each step, and never waits for a command. The engine is driven by a kernel
+ * 	task, that pumps all mounted file systems, and stops itself when none has work left. File operations that queue
+ * 	work resume it. File operations are executed by the kernel, and are never interrupted by the task, that pumps in
+ * 	critical sections;
+ *
+ * 	A write that finds all staging buffers full pumps the engine itself, but only waits for phrase programs : if a
+ * 	sector erase is in progress, it returns a short count instead. Reads copy staged data from RAM, and only wait for
+ * 	a phrase program to read programmed data : during an erase, they return a short count too. Closing a file doesn't
+ * 	wait, its data is programmed by the task. Namespace operations only wait for a staging buffer;
+ *
+ * 	Garbage collection is incremental : when less than LOGFS_RESERVE segments are free, the oldest segment's live
+ * 	records are copied one per step to the active segment, and the segment is then erased in the background. Full
+ * 	segments whose records are all dead are erased directly. As segments are reclaimed in activation order, static
+ * 	data moves too, and all sectors are erased in turn. Erase counts are kept in segment headers, and the free
+ * 	segment with the lowest count is activated first;
+ */
+
+
+/*--------------------------------------------------- Make Parameters --------------------------------------------------*/
+
+/*
+ * The number of free segments under which garbage collection starts. The last free segment is reserved to the
+ * 	collection, and the previous one to DELETE records, so that files can be deleted when the flash is full;
+ */
+#if !defined(LOGFS_RESERVE)
+
+#define LOGFS_RESERVE 3
+
+#endif
+
+#if (LOGFS_RESERVE < 3)
+#error "logfs : at least three segments must be reserved"
+#endif
+
+
+/*The maximal size of a record, header included. Must be a multiple of 8;*/
+#if !defined(LOGFS_RECORD_SIZE)
+
+#define LOGFS_RECORD_SIZE 256
+
+#endif
+
+
+/*The RAM size, the stack size, and the activity time in milliseconds, of the pump task;*/
+#if !defined(LOGFS_TASK_RAM_SIZE)
+
+#define LOGFS_TASK_RAM_SIZE 512
+
+#endif
+
+#if !defined(LOGFS_TASK_STACK_SIZE)
+
+#define LOGFS_TASK_STACK_SIZE 512
+
+#endif
+
+#if !defined(LOGFS_TASK_ACTIVITY_TIME)
+
+#define LOGFS_TASK_ACTIVITY_TIME 1
+
+#endif
+
+
+/*-------------------------------------------------------- Flash -------------------------------------------------------*/
+
+/*The segment header magic number, "LGFS";*/
+#define LOGFS_MAGIC ((uint32_t) 0x5346474C)
+
+/*The value of an erased word;*/
+#define ERASED ((uint32_t) 0xFFFFFFFF)
+
+/*The alignment of all flash structures;*/
+#define LOGFS_ALIGN 8
+
+/*Align a size;*/
+#define ALIGN(size) (((size) + (LOGFS_ALIGN - 1)) & ~((size_t) (LOGFS_ALIGN - 1)))
+
+/*The size of a record, from the size of its payload;*/
+#define RECORD_SIZE(length) ALIGN(sizeof(struct logfs_record_header) + (length))
+
+/*An invalid segment index;*/
+#define NO_SEGMENT ((uint16_t) 0xFFFF)
+
+
+/*
+ * The segment header. The first half is programmed after the erase, the second half at activation;
+ */
+
+struct logfs_segment_header {
+
+	/*The magic number;*/
+	uint32_t magic;
+
+	/*The number of times the segment was erased;*/
+	uint32_t erase_count;
+
+	/*The sequence number of the segment. Erased if the segment is free;*/
+	uint32_t sequence;
+
+	/*Reserved, erased;*/
+	uint32_t reserved;
+
+};
+
+
+/*
+ * Record types;
+ */
+
+enum logfs_record_type {
+
+	LOGFS_CREATE = 1,
+
+	LOGFS_DATA = 2,
+
+	LOGFS_DELETE = 3,
+
+};
+
+
+/*
+ * The record header. Its first half is programmed last, and validates the record;
+ */
+
+struct logfs_record_header {
+
+	/*The id of the file;*/
+	uint16_t id;
+
+	/*The type of the record, and its complement;*/
+	uint8_t type;
+	uint8_t check;
+
+	/*The size of the payload;*/
+	uint16_t length;
+
+	/*Reserved, erased;*/
+	uint16_t reserved;
+
+	/*The offset of the payload in the file, for data records;*/
+	uint32_t offset;
+
+	/*Reserved, erased;*/
+	uint32_t reserved2;
+
+};
+
+/*The maximal size of a record's payload;*/
+#define LOGFS_PAYLOAD_SIZE (LOGFS_RECORD_SIZE - sizeof(struct logfs_record_header))
+
+
+/*--------------------------------------------------------- RAM --------------------------------------------------------*/
+
+/*
+ * Segment states;
+ */
+
+enum logfs_segment_state {
+
+	/*Erased, the first half of the header must be programmed;*/
+	SEG_ERASED,
+
+	/*Free, can be activated;*/
+	SEG_FREE,
+
+	/*Records are being appended;*/
+	SEG_ACTIVE,
+
+	/*No more records can be appended;*/
+	SEG_FULL,
+
+	/*Must be erased;*/
+	SEG_DIRTY,
+
+	/*The erase failed, the segment is not used anymore;*/
+	SEG_BAD,
+
+};
+
+
+/*
+ * A segment descriptor;
+ */
+
+struct logfs_segment {
+
+	/*The sequence number;*/
+	uint32_t sequence;
+
+	/*The erase count;*/
+	uint32_t erase_count;
+
+	/*The position of the first free byte, or the end of records for a full segment;*/
+	uint16_t fill;
+
+	/*The number of bytes of live records;*/
+	uint16_t live;
+
+	/*The state;*/
+	uint8_t state;
+
+	/*Set if the segment contains DELETE records. They hide older records, so the segment can't be erased before;*/
+	bool deletes;
+
+};
+
+
+/*
+ * A chunk references a data record of a file;
+ */
+
+struct logfs_chunk {
+
+	/*The offset of the record's data in the file;*/
+	uint32_t offset;
+
+	/*The size of the record's data;*/
+	uint16_t length;
+
+	/*The location of the record;*/
+	uint16_t segment;
+	uint16_t position;
+
+};
+
+
+/*
+ * A file is an inode, with the index of its data records, sorted by offset;
+ */
+
+struct logfs_file {
+
+	/*The vfs inode;*/
+	struct inode inode;
+
+	/*The next file of the superblock;*/
+	struct logfs_file *next;
+
+	/*The id of the file;*/
+	uint16_t id;
+
+	/*The location of the file's CREATE record. NO_SEGMENT until it is programmed;*/
+	uint16_t create_segment;
+	uint16_t create_position;
+
+	/*The size of the file's CREATE record;*/
+	uint16_t create_size;
+
+	/*The size of the file, staged data included;*/
+	size_t size;
+
+	/*The chunks array, its number of chunks, and its capacity;*/
+	struct logfs_chunk *chunks;
+	size_t nb_chunks;
+	size_t max_chunks;
+
+};
+
+
+/*
+ * Job states;
+ */
+
+enum logfs_job_state {
+
+	/*Not used;*/
+	JOB_EMPTY,
+
+	/*A staging buffer receiving data;*/
+	JOB_FILLING,
+
+	/*Waiting to be programmed;*/
+	JOB_READY,
+
+	/*Being programmed;*/
+	JOB_PROGRAMMING,
+
+};
+
+
+/*
+ * Job types;
+ */
+
+enum logfs_job_type {
+
+	/*A record;*/
+	JOB_RECORD,
+
+	/*The first half of a segment header;*/
+	JOB_FORMAT,
+
+	/*The second half of a segment header;*/
+	JOB_ACTIVATE,
+
+};
+
+
+/*
+ * A job programs a buffer at a location of the flash;
+ */
+
+struct logfs_job {
+
+	/*The state and type of the job;*/
+	uint8_t state;
+	uint8_t type;
+
+	/*The file of a record job. Null if the file was deleted;*/
+	struct logfs_file *file;
+
+	/*The buffer to program, its padded size, and the number of programmed bytes;*/
+	uint8_t *buffer;
+	size_t size;
+	size_t done;
+
+	/*The location where to program the buffer;*/
+	uint16_t segment;
+	uint16_t position;
+
+	/*The order of the job. Ready jobs are programmed in ticket order;*/
+	uint32_t ticket;
+
+};
+
+/*The number of staging jobs;*/
+#define NB_STAGES 2
+
+
+/*
+ * The logfs superblock;
+ */
+
+struct logfs_sb {
+
+	/*The vfs superblock;*/
+	struct superblock sb;
+
+	/*The next mounted superblock, pumped by the task;*/
+	struct logfs_sb *next;
+
+	/*The root directory inode;*/
+	struct inode root;
+
+	/*The flash device and its if;*/
+	file_descriptor device;
+	struct flash_if flash;
+
+	/*The segments array, and the active segment;*/
+	struct logfs_segment *segments;
+	uint16_t active;
+
+	/*The number of free segments;*/
+	size_t nb_free;
+
+	/*The sequence number of the next activated segment;*/
+	uint32_t sequence;
+
+	/*Files, listed and indexed by name;*/
+	struct logfs_file *files;
+	struct nindex names;
+
+	/*The id of the next created file;*/
+	uint16_t next_id;
+
+	/*Staging jobs, the garbage collection job, and the header job;*/
+	struct logfs_job stages[NB_STAGES];
+	struct logfs_job gc;
+	struct logfs_job header;
+
+	/*The buffer of the header job;*/
+	uint8_t header_buffer[LOGFS_ALIGN];
+
+	/*The job being programmed. Null if none;*/
+	struct logfs_job *current;
+
+	/*The segment being erased. NO_SEGMENT if none;*/
+	uint16_t erasing;
+
+	/*The ticket of the next ready job;*/
+	uint32_t ticket;
+
+	/*The segment being collected, and the position of its next record. NO_SEGMENT if none;*/
+	uint16_t victim;
+	uint16_t victim_position;
+
+};
+
+
+/*
+ * A logfs resource reads a file at a position, and appends data to it;
+ */
+
+struct logfs_resrc {
+
+	/*The vfs resource;*/
+	struct resrc res;
+
+	/*The file;*/
+	struct logfs_file *file;
+
+	/*The read position;*/
+	size_t offset;
+
+};
+
+
+/*------------------------------------------------------- Flash access ---------------------------------------------------*/
+
+/**
+ * logfs_address : determines the address of a location in the memory mapped flash;
+ */
+
+static inline const volatile uint8_t *logfs_address(const struct logfs_sb *const sb, const size_t segment,
+													const size_t position) {
+
+	return sb->flash.memory + segment * sb->flash.sector_size + position;
+
+}
+
+
+/**
+ * logfs_read : copies data from the flash. The flash must not be busy;
+ */
+
+static void logfs_read(const struct logfs_sb *const sb, void *const dst, const size_t segment, const size_t position,
+					   const size_t size) {
+
+	/*Cache the source;*/
+	const volatile uint8_t *const src = logfs_address(sb, segment, position);
+
+	/*Copy byte by byte, the area is volatile;*/
+	for (size_t i = 0; i < size; i++) {
+		((uint8_t *) dst)[i] = src[i];
+	}
+
+}
+
+
+/**
+ * logfs_erased : checks that a flash area is erased. The flash must not be busy;
+ */
+
+static bool logfs_erased(const struct logfs_sb *const sb, const size_t segment, size_t position) {
+
+	/*Cache the source;*/
+	const volatile uint8_t *src = logfs_address(sb, segment, position);
+
+	/*For each remaining byte of the segment, if it is not erased, fail;*/
+	for (; position < sb->flash.sector_size; position++) {
+		if (*(src++) != 0xFF) {
+			return false;
+		}
+	}
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * logfs_record_valid : checks a record header read at a position of a segment;
+ */
+
+static bool logfs_record_valid(const struct logfs_sb *const sb, const struct logfs_record_header *const header,
+							   const size_t position) {
+
+	/*The type and its complement must match, and the type must exist;*/
+	if (((uint8_t) (header->check ^ header->type) != 0xFF) || (!header->type) || (header->type > LOGFS_DELETE)) {
+		return false;
+	}
+
+	/*The record must fit in the segment and in a job buffer;*/
+	return (header->length <= LOGFS_PAYLOAD_SIZE) &&
+		   (position + RECORD_SIZE(header->length) <= sb->flash.sector_size);
+
+}
+
+
+/*-------------------------------------------------------- Files -------------------------------------------------------*/
+
+/**
+ * logfs_find : searches a file by id;
+ */
+
+static struct logfs_file *logfs_find(const struct logfs_sb *const sb, const uint16_t id) {
+
+	/*For each file, if the id matches, return it;*/
+	for (struct logfs_file *file = sb->files; file; file = file->next) {
+		if (file->id == id) {
+			return file;
+		}
+	}
+
+	/*Not found;*/
+	return 0;
+
+}
+
+
+/**
+ * logfs_chunk_search : searches the index of the first chunk whose offset is greater than @offset;
+ */
+
+static size_t logfs_chunk_search(const struct logfs_file *const file, const size_t offset) {
+
+	/*Binary search bounds;*/
+	size_t low = 0, high = file->nb_chunks;
+
+	/*While the interval is not empty :*/
+	while (low < high) {
+
+		/*Determine the middle;*/
+		const size_t middle = (low + high) >> 1;
+
+		/*Keep the half that contains the first greater offset;*/
+		if (file->chunks[middle].offset <= offset) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+
+	}
+
+	/*Return the index;*/
+	return low;
+
+}
+
+
+/**
+ * logfs_chunk_find : searches the chunk that starts at @offset;
+ *
+ * @return the chunk, or 0 if not found;
+ */
+
+static struct logfs_chunk *logfs_chunk_find(const struct logfs_file *const file, const size_t offset) {
+
+	/*Find the first chunk after the offset;*/
+	const size_t index = logfs_chunk_search(file, offset);
+
+	/*If the previous chunk starts at the offset, return it;*/
+	if ((index) && (file->chunks[index - 1].offset == offset)) {
+		return file->chunks + index - 1;
+	}
+
+	/*Not found;*/
+	return 0;
+
+}
+
+
+/**
+ * logfs_chunk_insert : inserts a chunk, keeping the array sorted. Chunks already indexed are ignored;
+ *
+ * 	At runtime, chunks are appended. At mount, records of a file may be found in any order;
+ *
+ * @return false if the kernel heap is full;
+ */
+
+static bool logfs_chunk_insert(struct logfs_file *const file, const struct logfs_chunk *const chunk) {
+
+	/*If the chunk is already indexed (copied by an interrupted collection), ignore it;*/
+	if (logfs_chunk_find(file, chunk->offset)) {
+		return true;
+	}
+
+	/*If the array is full :*/
+	if (file->nb_chunks == file->max_chunks) {
+
+		/*Double its capacity;*/
+		const size_t capacity = (file->max_chunks) ? (file->max_chunks << 1) : 8;
+
+		/*Allocate the new array;*/
+		struct logfs_chunk *const chunks = kmalloc(capacity * sizeof(struct logfs_chunk));
+
+		/*If the allocation failed, fail;*/
+		if (!chunks) {
+			return false;
+		}
+
+		/*Copy chunks and free the old array;*/
+		if (file->chunks) {
+			memcpy(chunks, file->chunks, file->nb_chunks * sizeof(struct logfs_chunk));
+			kfree(file->chunks);
+		}
+
+		/*Update the array;*/
+		file->chunks = chunks;
+		file->max_chunks = capacity;
+
+	}
+
+	/*Determine the insertion index;*/
+	const size_t index = logfs_chunk_search(file, chunk->offset);
+
+	/*Shift following chunks;*/
+	memmove(file->chunks + index + 1, file->chunks + index, (file->nb_chunks - index) * sizeof(struct logfs_chunk));
+
+	/*Insert the chunk;*/
+	file->chunks[index] = *chunk;
+	file->nb_chunks++;
+
+	/*Update the size;*/
+	if (chunk->offset + chunk->length > file->size) {
+		file->size = chunk->offset + chunk->length;
+	}
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * logfs_file_create : creates a file in RAM, and indexes its name;
+ *
+ * @return the file, or 0 if the name is already used, or if the kernel heap is full;
+ */
+
+static const struct inode_operations logfs_file_ops;
+
+static struct logfs_file *logfs_file_create(struct logfs_sb *const sb, const char *const name, const uint16_t id) {
+
+	/*Create the initializer;*/
+	const struct logfs_file init = {
+		.inode = {
+			.i_mode = 0,
+			.i_dentry = 0,
+			.i_sb = &sb->sb,
+			.i_ops = &logfs_file_ops,
+		},
+		.next = sb->files,
+		.id = id,
+		.create_segment = NO_SEGMENT,
+		.create_position = 0,
+		.create_size = (uint16_t) RECORD_SIZE(strlen(name)),
+		.size = 0,
+		.chunks = 0,
+		.nb_chunks = 0,
+		.max_chunks = 0,
+	};
+
+	/*Allocate and initialise the file;*/
+	struct logfs_file *const file = kialloc(sizeof(struct logfs_file), &init);
+
+	/*If the allocation failed, fail;*/
+	if (!file) {
+		return 0;
+	}
+
+	/*Index the name. If it fails, delete the file;*/
+	if (!nindex_add(&sb->names, name, file)) {
+		kfree(file);
+		return 0;
+	}
+
+	/*List the file;*/
+	sb->files = file;
+
+	/*Return the file;*/
+	return file;
+
+}
+
+
+/**
+ * logfs_file_delete : removes a file from the list, and frees it. Its name must have been removed from the index;
+ */
+
+static void logfs_file_delete(struct logfs_sb *const sb, struct logfs_file *const file) {
+
+	/*Unlink the file from the list;*/
+	for (struct logfs_file **ref = &sb->files; *ref; ref = &(*ref)->next) {
+		if (*ref == file) {
+			*ref = file->next;
+			break;
+		}
+	}
+
+	/*Free the chunks array and the file;*/
+	if (file->chunks) {
+		kfree(file->chunks);
+	}
+	kfree(file);
+
+}
+
+
+/**
+ * logfs_file_revive : accounts all programmed records of a file as live;
+ */
+
+static void logfs_file_revive(struct logfs_sb *const sb, const struct logfs_file *const file) {
+
+	/*Account the CREATE record;*/
+	if (file->create_segment != NO_SEGMENT) {
+		sb->segments[file->create_segment].live += file->create_size;
+	}
+
+	/*Account all DATA records;*/
+	for (size_t i = 0; i < file->nb_chunks; i++) {
+		sb->segments[file->chunks[i].segment].live += RECORD_SIZE(file->chunks[i].length);
+	}
+
+}
+
+
+/**
+ * logfs_file_kill : accounts all programmed records of a file as dead;
+ */
+
+static void logfs_file_kill(struct logfs_sb *const sb, const struct logfs_file *const file) {
+
+	/*Discount the CREATE record;*/
+	if (file->create_segment != NO_SEGMENT) {
+		sb->segments[file->create_segment].live -= file->create_size;
+	}
+
+	/*Discount all DATA records;*/
+	for (size_t i = 0; i < file->nb_chunks; i++) {
+		sb->segments[file->chunks[i].segment].live -= RECORD_SIZE(file->chunks[i].length);
+	}
+
+}
+
+
+/*-------------------------------------------------------- Jobs --------------------------------------------------------*/
+
+/**
+ * logfs_job_init : initialises an empty job with its buffer;
+ */
+
+static void logfs_job_init(struct logfs_job *const job, uint8_t *const buffer) {
+
+	/*Reset all fields;*/
+	memset(job, 0, sizeof(struct logfs_job));
+
+	/*Save the buffer;*/
+	job->buffer = buffer;
+
+}
+
+
+/**
+ * logfs_record_start : initialises the header of a record job, and marks it filling;
+ */
+
+static void logfs_record_start(struct logfs_job *const job, struct logfs_file *const file, const uint8_t type,
+							   const uint32_t offset) {
+
+	/*Cache the header;*/
+	struct logfs_record_header *const header = (struct logfs_record_header *) job->buffer;
+
+	/*Erase the buffer, padding bytes must not be programmed;*/
+	memset(job->buffer, 0xFF, LOGFS_RECORD_SIZE);
+
+	/*Initialise the header;*/
+	header->id = file->id;
+	header->type = type;
+	header->check = (uint8_t) ~type;
+	header->length = 0;
+	header->offset = offset;
+
+	/*Initialise the job;*/
+	job->type = JOB_RECORD;
+	job->file = file;
+	job->segment = NO_SEGMENT;
+	job->state = JOB_FILLING;
+
+}
+
+
+/**
+ * logfs_job_seal : marks a job ready to be programmed;
+ */
+
+static void logfs_job_seal(struct logfs_sb *const sb, struct logfs_job *const job) {
+
+	/*Determine the size of the record;*/
+	job->size = RECORD_SIZE(((struct logfs_record_header *) job->buffer)->length);
+	job->done = 0;
+
+	/*Take a ticket;*/
+	job->ticket = sb->ticket++;
+
+	/*Mark the job ready;*/
+	job->state = JOB_READY;
+
+}
+
+
+/**
+ * logfs_stage_get : finds the staging job that receives a file's data;
+ *
+ * @return the filling job of the file, or 0 if none;
+ */
+
+static struct logfs_job *logfs_stage_get(struct logfs_sb *const sb, const struct logfs_file *const file) {
+
+	/*For each stage, if it is filling for the file, return it;*/
+	for (size_t i = 0; i < NB_STAGES; i++) {
+		if ((sb->stages[i].state == JOB_FILLING) && (sb->stages[i].file == file)) {
+			return sb->stages + i;
+		}
+	}
+
+	/*Not found;*/
+	return 0;
+
+}
+
+
+/**
+ * logfs_stage_seal_all : seals all filling stages;
+ */
+
+static void logfs_stage_seal_all(struct logfs_sb *const sb) {
+
+	/*For each filling stage, seal it;*/
+	for (size_t i = 0; i < NB_STAGES; i++) {
+		if (sb->stages[i].state == JOB_FILLING) {
+			logfs_job_seal(sb, sb->stages + i);
+		}
+	}
+
+}
+
+
+/**
+ * logfs_stage_admit : determines if a new staging job can be programmed, with all pending jobs;
+ *
+ * 	Space is estimated conservatively : a record may not fit at the end of a segment, and the collection loses such
+ * 	a tail in each segment it fills. Data records can't use the reserved segments;
+ */
+
+static bool logfs_stage_admit(const struct logfs_sb *const sb) {
+
+	/*Cache the capacity of a segment;*/
+	const size_t capacity = sb->flash.sector_size - sizeof(struct logfs_segment_header);
+
+	size_t space = 0, pending = LOGFS_RECORD_SIZE, dead = 0;
+
+	/*Count the space at the end of the active segment;*/
+	if ((sb->active != NO_SEGMENT) && (sb->flash.sector_size - sb->segments[sb->active].fill > LOGFS_RECORD_SIZE)) {
+		space += sb->flash.sector_size - sb->segments[sb->active].fill - LOGFS_RECORD_SIZE;
+	}
+
+	/*Count free segments that are not reserved;*/
+	if (sb->nb_free > 2) {
+		space += (sb->nb_free - 2) * (capacity - LOGFS_RECORD_SIZE);
+	}
+
+	/*Count dead records of full segments. Only a segment of dead records can be reclaimed;*/
+	for (size_t i = 0; i < sb->flash.nb_sectors; i++) {
+		if (sb->segments[i].state == SEG_FULL) {
+			dead += sb->segments[i].fill - sizeof(struct logfs_segment_header) - sb->segments[i].live;
+		}
+	}
+	if (dead > capacity) {
+		space += dead - capacity;
+	}
+
+	/*Count pending jobs;*/
+	for (size_t i = 0; i < NB_STAGES; i++) {
+		if (sb->stages[i].state != JOB_EMPTY) {
+			pending += LOGFS_RECORD_SIZE;
+		}
+	}
+
+	/*Compare;*/
+	return space >= pending;
+
+}
+
+
+/**
+ * logfs_stage_empty : finds an empty staging job;
+ *
+ * @return the job, or 0 if all are used;
+ */
+
+static struct logfs_job *logfs_stage_empty(struct logfs_sb *const sb) {
+
+	/*For each stage, if it is empty, return it;*/
+	for (size_t i = 0; i < NB_STAGES; i++) {
+		if (sb->stages[i].state == JOB_EMPTY) {
+			return sb->stages + i;
+		}
+	}
+
+	/*Not found;*/
+	return 0;
+
+}
+
+
+/**
+ * logfs_job_commit : updates the index when a record job has been programmed;
+ */
+
+static void logfs_job_commit(struct logfs_sb *const sb, struct logfs_job *const job) {
+
+	/*Cache the file and the header;*/
+	struct logfs_file *const file = job->file;
+	const struct logfs_record_header *const header = (const struct logfs_record_header *) job->buffer;
+
+	/*If the record is a DELETE, mark its segment;*/
+	if (header->type == LOGFS_DELETE) {
+		sb->segments[job->segment].deletes = true;
+		return;
+	}
+
+	/*If the file was deleted, nothing to index;*/
+	if (!file) {
+		return;
+	}
+
+	/*The record is live;*/
+	sb->segments[job->segment].live += job->size;
+
+	/*If the record is a CREATE, update the file's create location. A copy kills the previous record;*/
+	if (header->type == LOGFS_CREATE) {
+		if (file->create_segment != NO_SEGMENT) {
+			sb->segments[file->create_segment].live -= job->size;
+		}
+		file->create_segment = job->segment;
+		file->create_position = job->position;
+		return;
+	}
+
+	/*Search for the chunk, if it has been copied by the collection;*/
+	struct logfs_chunk *const chunk = logfs_chunk_find(file, header->offset);
+
+	/*If found, relocate it. The previous record is dead;*/
+	if (chunk) {
+		sb->segments[chunk->segment].live -= job->size;
+		chunk->segment = job->segment;
+		chunk->position = job->position;
+		return;
+	}
+
+	/*Create the chunk;*/
+	const struct logfs_chunk new_chunk = {
+		.offset = header->offset,
+		.length = header->length,
+		.segment = job->segment,
+		.position = job->position,
+	};
+
+	/*Index it. The size already includes the data. If the heap is full, the record will only be found at next mount;*/
+	if (!logfs_chunk_insert(file, &new_chunk)) {
+		sb->segments[job->segment].live -= job->size;
+	}
+
+}
+
+
+/*------------------------------------------------------- Engine -------------------------------------------------------*/
+
+/**
+ * logfs_program_fail : handles the failure of a phrase program of the current job, rejected or failed;
+ *
+ * 	A header job is dropped, and its segment must be erased again. A record job is programmed again in another
+ * 	segment, and its segment is closed, as the phrases already programmed can't be programmed again;
+ */
+
+static void logfs_program_fail(struct logfs_sb *const sb) {
+
+	/*Cache the job;*/
+	struct logfs_job *const job = sb->current;
+
+	/*Cache the segment;*/
+	struct logfs_segment *const segment = sb->segments + job->segment;
+
+	/*The job is not programmed anymore;*/
+	sb->current = 0;
+
+	/*If the job was programming a header, the segment must be erased again;*/
+	if (job->type != JOB_RECORD) {
+		segment->state = SEG_DIRTY;
+		job->state = JOB_EMPTY;
+		return;
+	}
+
+	/*The record is invalid. Close the segment, the record will be programmed again in another one;*/
+	segment->state = SEG_FULL;
+	sb->active = NO_SEGMENT;
+	job->state = JOB_READY;
+	job->segment = NO_SEGMENT;
+	job->done = 0;
+
+}
+
+
+/**
+ * logfs_program_step : launches the program of the next phrase of the current job;
+ *
+ * 	The first phrase is programmed last, so that a record is valid only once completely programmed. If the flash
+ * 	rejects the command, the job fails as if the program failed;
+ */
+
+static void logfs_program_step(struct logfs_sb *const sb) {
+
+	/*Cache the job and the phrase size;*/
+	struct logfs_job *const job = sb->current;
+	const size_t phrase = sb->flash.phrase_size;
+
+	/*Determine the position of the phrase in the buffer : all phrases after the first, then the first;*/
+	const size_t index = (job->done + phrase) % job->size;
+
+	/*Launch the program. If the flash rejected it, fail the job;*/
+	if (!(*(sb->flash.program))(job->segment * sb->flash.sector_size + job->position + index,
+								job->buffer + index)) {
+		logfs_program_fail(sb);
+	}
+
+}
+
+
+/**
+ * logfs_program_complete : handles the completion of a phrase program;
+ */
+
+static void logfs_program_complete(struct logfs_sb *const sb) {
+
+	/*Cache the job;*/
+	struct logfs_job *const job = sb->current;
+
+	/*Cache the segment;*/
+	struct logfs_segment *const segment = sb->segments + job->segment;
+
+	/*If the program failed, handle the failure;*/
+	if ((*(sb->flash.failed))()) {
+		logfs_program_fail(sb);
+		return;
+	}
+
+	/*Update the number of programmed bytes;*/
+	job->done += sb->flash.phrase_size;
+
+	/*If the job is not complete, stop here;*/
+	if (job->done != job->size) {
+		return;
+	}
+
+	/*The job is complete;*/
+	sb->current = 0;
+	job->state = JOB_EMPTY;
+
+	/*Update the segment or the index;*/
+	switch (job->type) {
+
+		case JOB_FORMAT:
+			segment->state = SEG_FREE;
+			sb->nb_free++;
+			break;
+
+		case JOB_ACTIVATE:
+			segment->state = SEG_ACTIVE;
+			segment->fill = sizeof(struct logfs_segment_header);
+			sb->active = job->segment;
+			break;
+
+		default:
+			logfs_job_commit(sb, job);
+			break;
+
+	}
+
+}
+
+
+/**
+ * logfs_header_start : starts the program of a half of a segment header;
+ */
+
+static void logfs_header_start(struct logfs_sb *const sb, const uint16_t segment, const uint8_t type,
+							   const uint32_t first, const uint32_t second) {
+
+	/*Cache the header job;*/
+	struct logfs_job *const job = &sb->header;
+
+	/*Fill the buffer;*/
+	((uint32_t *) sb->header_buffer)[0] = first;
+	((uint32_t *) sb->header_buffer)[1] = second;
+
+	/*Initialise the job, at the appropriate half of the header;*/
+	job->type = type;
+	job->state = JOB_PROGRAMMING;
+	job->size = LOGFS_ALIGN;
+	job->done = 0;
+	job->segment = segment;
+	job->position = (uint16_t) ((type == JOB_FORMAT) ? 0 : LOGFS_ALIGN);
+
+	/*Program the job;*/
+	sb->current = job;
+	logfs_program_step(sb);
+
+}
+
+
+/**
+ * logfs_activate : closes the active segment, and activates the free segment with the lowest erase count;
+ *
+ * 	The last free segment can only be used by the collection, and the previous one by DELETE records;
+ *
+ * @param sb : the superblock;
+ * @param job : the job that requires the activation;
+ * @return true if a segment is being activated;
+ */
+
+static bool logfs_activate(struct logfs_sb *const sb, const struct logfs_job *const job) {
+
+	uint16_t best = NO_SEGMENT;
+
+	/*Determine the number of free segments that the job can't use;*/
+	size_t reserved = 2;
+	if (job == &sb->gc) {
+		reserved = 0;
+	} else if (((const struct logfs_record_header *) job->buffer)->type == LOGFS_DELETE) {
+		reserved = 1;
+	}
+
+	/*If all free segments are reserved, fail;*/
+	if (sb->nb_free <= reserved) {
+		return false;
+	}
+
+	/*Find the free segment with the lowest erase count;*/
+	for (uint16_t i = 0; i < sb->flash.nb_sectors; i++) {
+		if ((sb->segments[i].state == SEG_FREE) &&
+			((best == NO_SEGMENT) || (sb->segments[i].erase_count < sb->segments[best].erase_count))) {
+			best = i;
+		}
+	}
+
+	/*Close the active segment;*/
+	if (sb->active != NO_SEGMENT) {
+		sb->segments[sb->active].state = SEG_FULL;
+		sb->active = NO_SEGMENT;
+	}
+
+	/*Assign the sequence number;*/
+	sb->segments[best].sequence = sb->sequence++;
+	sb->nb_free--;
+
+	/*Program the second half of the header;*/
+	logfs_header_start(sb, best, JOB_ACTIVATE, sb->segments[best].sequence, ERASED);
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * logfs_gc_needed : determines if the collection can progress;
+ *
+ * 	A collection is worth starting only if dead records of full segments fill at least a segment. Otherwise, live
+ * 	records would be copied indefinitely without reclaiming space;
+ */
+
+static bool logfs_gc_needed(const struct logfs_sb *const sb) {
+
+	/*If a segment is being collected, it must be completed;*/
+	if (sb->victim != NO_SEGMENT) {
+		return true;
+	}
+
+	/*Sum dead bytes of full segments;*/
+	size_t dead = 0;
+	for (size_t i = 0; i < sb->flash.nb_sectors; i++) {
+		if (sb->segments[i].state == SEG_FULL) {
+			dead += sb->segments[i].fill - sizeof(struct logfs_segment_header) - sb->segments[i].live;
+		}
+	}
+
+	/*Compare with the capacity of a segment;*/
+	return dead >= sb->flash.sector_size - sizeof(struct logfs_segment_header);
+
+}
+
+
+/**
+ * logfs_gc_prepare : searches the next live record of the collected segment, and copies it in the collection job;
+ *
+ * 	When no live record remains, the segment is marked dirty;
+ */
+
+static void logfs_gc_prepare(struct logfs_sb *const sb) {
+
+	/*If no segment is being collected :*/
+	if (sb->victim == NO_SEGMENT) {
+
+		/*Find the full segment with the lowest sequence number;*/
+		for (uint16_t i = 0; i < sb->flash.nb_sectors; i++) {
+			if ((sb->segments[i].state == SEG_FULL) &&
+				((sb->victim == NO_SEGMENT) || (sb->segments[i].sequence < sb->segments[sb->victim].sequence))) {
+				sb->victim = i;
+			}
+		}
+
+		/*If there is nothing to collect, stop;*/
+		if (sb->victim == NO_SEGMENT) {
+			return;
+		}
+
+		/*Start after the segment header;*/
+		sb->victim_position = sizeof(struct logfs_segment_header);
+
+	}
+
+	/*Cache the victim;*/
+	const uint16_t victim = sb->victim;
+
+	struct logfs_record_header header;
+
+	/*While records remain :*/
+	while (sb->victim_position + sizeof(struct logfs_record_header) <= sb->flash.sector_size) {
+
+		/*Cache the position;*/
+		const uint16_t position = sb->victim_position;
+
+		/*Read the header;*/
+		logfs_read(sb, &header, victim, position, sizeof(struct logfs_record_header));
+
+		/*If the record is invalid, the end of the segment is reached;*/
+		if (!logfs_record_valid(sb, &header, position)) {
+			break;
+		}
+
+		/*Update the position;*/
+		sb->victim_position += RECORD_SIZE(header.length);
+
+		/*Search for the file;*/
+		struct logfs_file *const file = logfs_find(sb, header.id);
+
+		/*If the file was deleted, the record is dead;*/
+		if (!file) {
+			continue;
+		}
+
+		/*Determine if the record is live;*/
+		bool live = false;
+		if (header.type == LOGFS_CREATE) {
+			live = (file->create_segment == victim) && (file->create_position == position);
+		} else if (header.type == LOGFS_DATA) {
+			const struct logfs_chunk *const chunk = logfs_chunk_find(file, header.offset);
+			live = (chunk) && (chunk->segment == victim) && (chunk->position == position);
+		}
+
+		/*If the record is live :*/
+		if (live) {
+
+			/*Copy it in the collection job;*/
+			logfs_read(sb, sb->gc.buffer, victim, position, RECORD_SIZE(header.length));
+
+			/*Initialise the job and seal it;*/
+			sb->gc.type = JOB_RECORD;
+			sb->gc.file = file;
+			sb->gc.segment = NO_SEGMENT;
+			logfs_job_seal(sb, &sb->gc);
+
+			/*One record per step;*/
+			return;
+
+		}
+
+	}
+
+	/*All live records have been copied and programmed. The segment can be erased;*/
+	sb->segments[victim].state = SEG_DIRTY;
+	sb->victim = NO_SEGMENT;
+
+}
+
+
+/**
+ * logfs_next_job : selects the next job to program : the collection job if free segments are missing, or the
+ * 	oldest ready job;
+ */
+
+static struct logfs_job *logfs_next_job(struct logfs_sb *const sb) {
+
+	struct logfs_job *next = 0;
+
+	/*If the collection job is ready, it has the priority;*/
+	if (sb->gc.state == JOB_READY) {
+		return &sb->gc;
+	}
+
+	/*If the collection has used the reserved segment, it must complete before other records are programmed;*/
+	if (!sb->nb_free) {
+		return 0;
+	}
+
+	/*Find the ready stage with the lowest ticket. DELETE records go first, as data may be stuck on a full flash;*/
+	for (size_t i = 0; i < NB_STAGES; i++) {
+
+		/*Cache the job;*/
+		struct logfs_job *const job = sb->stages + i;
+
+		/*If the job is not ready, skip;*/
+		if (job->state != JOB_READY) {
+			continue;
+		}
+
+		/*If the job is a DELETE record, select it;*/
+		if (((const struct logfs_record_header *) job->buffer)->type == LOGFS_DELETE) {
+			return job;
+		}
+
+		/*Keep the job with the lowest ticket;*/
+		if ((!next) || ((int32_t) (job->ticket - next->ticket) < 0)) {
+			next = job;
+		}
+
+	}
+
+	/*Return the job;*/
+	return next;
+
+}
+
+
+/**
+ * logfs_dirty : searches the next segment to erase : a dirty segment, or a full segment without live records, that
+ * 	doesn't need the collection;
+ *
+ * 	Segments are erased in log order, so that a DELETE record is never erased before an older record of its file;
+ *
+ * @return the index of the segment, or NO_SEGMENT if none;
+ */
+
+static uint16_t logfs_dirty(const struct logfs_sb *const sb) {
+
+	uint16_t dirty = NO_SEGMENT;
+
+	/*For each segment :*/
+	for (uint16_t i = 0; i < sb->flash.nb_sectors; i++) {
+
+		/*Cache the segment;*/
+		const struct logfs_segment *const segment = sb->segments + i;
+
+		/*If the segment is neither dirty nor a full segment of dead records, skip;*/
+		if ((segment->state != SEG_DIRTY) &&
+			((segment->state != SEG_FULL) || (segment->live) || (segment->deletes) || (i == sb->victim))) {
+			continue;
+		}
+
+		/*Keep the oldest segment;*/
+		if ((dirty == NO_SEGMENT) || ((int32_t) (segment->sequence - sb->segments[dirty].sequence) < 0)) {
+			dirty = i;
+		}
+
+	}
+
+	/*Return the segment;*/
+	return dirty;
+
+}
+
+
+/**
+ * logfs_pump : makes the file system progress by at most one flash command. Never waits;
+ *
+ * @return true if progress was made or if the flash is busy, false if nothing can be done;
+ */
+
+static bool logfs_pump(struct logfs_sb *const sb) {
+
+	/*If the flash is executing a command, nothing to do;*/
+	if ((*(sb->flash.busy))()) {
+		return true;
+	}
+
+	/*If an erase has completed :*/
+	if (sb->erasing != NO_SEGMENT) {
+
+		/*Cache the segment;*/
+		struct logfs_segment *const segment = sb->segments + sb->erasing;
+
+		/*Update its state, the first half of its header must be programmed;*/
+		if ((*(sb->flash.failed))()) {
+			segment->state = SEG_BAD;
+		} else {
+			segment->state = SEG_ERASED;
+			segment->erase_count++;
+			segment->deletes = false;
+		}
+
+		/*No more erase;*/
+		sb->erasing = NO_SEGMENT;
+
+	}
+
+	/*If a phrase program has completed, handle it;*/
+	if (sb->current) {
+		logfs_program_complete(sb);
+	}
+
+	/*If a job is being programmed, program its next phrase;*/
+	if (sb->current) {
+		logfs_program_step(sb);
+		return true;
+	}
+
+	/*If a segment has been erased, program the first half of its header;*/
+	for (uint16_t i = 0; i < sb->flash.nb_sectors; i++) {
+		if (sb->segments[i].state == SEG_ERASED) {
+			logfs_header_start(sb, i, JOB_FORMAT, LOGFS_MAGIC, sb->segments[i].erase_count);
+			return true;
+		}
+	}
+
+	/*If free segments are missing, no copy is pending, and the collection can reclaim a segment, search for the next
+	 * live record to copy;*/
+	if ((sb->nb_free < LOGFS_RESERVE) && (sb->gc.state == JOB_EMPTY) && (logfs_gc_needed(sb))) {
+		logfs_gc_prepare(sb);
+	}
+
+	/*Select the next job;*/
+	struct logfs_job *const job = logfs_next_job(sb);
+
+	/*If a job is ready :*/
+	if (job) {
+
+		/*Cache the active segment;*/
+		struct logfs_segment *const active = (sb->active != NO_SEGMENT) ? sb->segments + sb->active : 0;
+
+		/*If the record fits in the active segment :*/
+		if ((active) && (active->fill + job->size <= sb->flash.sector_size)) {
+
+			/*Place the record;*/
+			job->segment = sb->active;
+			job->position = active->fill;
+			active->fill += job->size;
+
+			/*Program its first phrase;*/
+			job->state = JOB_PROGRAMMING;
+			sb->current = job;
+			logfs_program_step(sb);
+			return true;
+
+		}
+
+		/*If a new segment can be activated, do it;*/
+		if (logfs_activate(sb, job)) {
+			return true;
+		}
+
+	}
+
+	/*Search for the segment to erase;*/
+	const uint16_t dirty = logfs_dirty(sb);
+
+	/*If found, launch its erase;*/
+	if ((dirty != NO_SEGMENT) && ((*(sb->flash.erase))(dirty))) {
+		sb->segments[dirty].state = SEG_DIRTY;
+		sb->erasing = dirty;
+		return true;
+	}
+
+	/*Nothing to do;*/
+	return false;
+
+}
+
+
+/**
+ * logfs_flush : seals all stages, and programs all jobs. Waits for all commands, including erases;
+ *
+ * @return true if all jobs were programmed, false if the file system is full;
+ */
+
+static bool logfs_flush(struct logfs_sb *const sb) {
+
+	/*Seal all stages;*/
+	logfs_stage_seal_all(sb);
+
+	/*While the engine progresses;*/
+	while (logfs_pump(sb));
+
+	/*Check that no job remains;*/
+	for (size_t i = 0; i < NB_STAGES; i++) {
+		if (sb->stages[i].state != JOB_EMPTY) {
+			return false;
+		}
+	}
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * logfs_record_queue : stages a CREATE or DELETE record, whose payload is @name or nothing;
+ *
+ * 	Waits for a stage to be available;
+ *
+ * @return true if the record was staged;
+ */
+
+static bool logfs_record_queue(struct logfs_sb *const sb, struct logfs_file *const file, const uint8_t type,
+							   const char *const name) {
+
+	struct logfs_job *job;
+
+	/*Seal all stages, so that the record is programmed after all staged data;*/
+	logfs_stage_seal_all(sb);
+
+	/*While no stage is empty, pump. If the engine is stuck, fail;*/
+	while (!(job = logfs_stage_empty(sb))) {
+		if (!logfs_pump(sb)) {
+			return false;
+		}
+	}
+
+	/*Initialise the record;*/
+	logfs_record_start(job, file, type, 0);
+
+	/*If a name is provided, copy it as the payload;*/
+	if (name) {
+		const size_t length = strlen(name);
+		memcpy(job->buffer + sizeof(struct logfs_record_header), name, length);
+		((struct logfs_record_header *) job->buffer)->length = (uint16_t) length;
+	}
+
+	/*Seal the record;*/
+	logfs_job_seal(sb, job);
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/*-------------------------------------------------------- Task --------------------------------------------------------*/
+
+/*Mounted superblocks;*/
+static struct logfs_sb *logfs_mounts = 0;
+
+/*The pump task, when it is stopped. Null if it runs, or if it has not been created;*/
+static struct sched_elmt *logfs_pumper = 0;
+
+/*Set once the pump task has been created;*/
+static bool logfs_task_created = false;
+
+
+/**
+ * logfs_task : pumps all mounted file systems, one step each in turn. When none can progress, the task stops
+ * 	itself, and will be resumed by the next file operation that queues work;
+ *
+ * 	The flash signals the completion of commands by its busy state only : while a command executes, the task polls;
+ */
+
+static void logfs_task(void *const args, const size_t args_size) {
+
+	/*The task has no arguments;*/
+	(void) args, (void) args_size;
+
+	/*Forever :*/
+	while (1) {
+
+		bool progress = false;
+
+		/*A step must not be interrupted by a file operation, and mounts must not change;*/
+		critical_section_enter();
+
+		/*Pump each mounted file system;*/
+		for (struct logfs_sb *sb = logfs_mounts; sb; sb = sb->next) {
+			progress |= logfs_pump(sb);
+		}
+
+		/*If no file system can progress, stop the task and register it, to be resumed;*/
+		if (!progress) {
+			logfs_pumper = sched_stop_prc();
+		}
+
+		/*Leave the critical section;*/
+		critical_section_leave();
+
+		/*If the task was stopped, require a context switch;*/
+		if (!progress) {
+			__prmpt_trigger();
+		}
+
+	}
+
+}
+
+
+/**
+ * logfs_wake : resumes the pump task if it is stopped;
+ */
+
+static void logfs_wake() {
+
+	/*The task must not stop itself concurrently;*/
+	critical_section_enter();
+
+	/*If the task is stopped, resume it;*/
+	if (logfs_pumper) {
+		sched_resume_prc(logfs_pumper);
+		logfs_pumper = 0;
+	}
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+}
+
+
+/**
+ * logfs_attach : adds a superblock to the pumped ones, and creates the pump task at the first mount;
+ */
+
+static void logfs_attach(struct logfs_sb *const sb) {
+
+	/*The pump task's descriptor and requirements. Both are copied by the scheduler;*/
+	struct prc_desc desc = {
+		.function = &logfs_task,
+		.args = 0,
+		.args_size = 0,
+	};
+	struct prc_req req = {
+		.ram_size = LOGFS_TASK_RAM_SIZE,
+		.stack_size = LOGFS_TASK_STACK_SIZE,
+		.activity_time = LOGFS_TASK_ACTIVITY_TIME,
+	};
+
+	/*The task must not walk mounts concurrently;*/
+	critical_section_enter();
+
+	/*Insert the superblock at the head of mounts;*/
+	sb->next = logfs_mounts;
+	logfs_mounts = sb;
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+	/*If the task exists, resume it, unformatted segments may have to be formatted;*/
+	if (logfs_task_created) {
+		logfs_wake();
+		return;
+	}
+
+	/*Create the task;*/
+	sched_create_prc(&desc, &req);
+	logfs_task_created = true;
+
+}
+
+
+/**
+ * logfs_detach : removes a superblock from the pumped ones. The task is kept, stopped when it has nothing to do;
+ */
+
+static void logfs_detach(struct logfs_sb *const sb) {
+
+	/*The task must not walk mounts concurrently;*/
+	critical_section_enter();
+
+	/*Find the reference of the superblock, and unlink it;*/
+	for (struct logfs_sb **ref = &logfs_mounts; *ref; ref = &(*ref)->next) {
+		if (*ref == sb) {
+			*ref = sb->next;
+			break;
+		}
+	}
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+}
+
+
+/*------------------------------------------------------ Resources -----------------------------------------------------*/
+
+/**
+ * logfs_staged : searches the staged data of a file that contains an offset. Staged data is not indexed until its
+ * 	record is programmed;
+ *
+ * @return the pending data job that contains the offset, or 0 if none;
+ */
+
+static const struct logfs_job *logfs_staged(const struct logfs_sb *const sb, const struct logfs_file *const file,
+											const size_t offset) {
+
+	/*For each stage :*/
+	for (size_t i = 0; i < NB_STAGES; i++) {
+
+		/*Cache the job and its header;*/
+		const struct logfs_job *const job = sb->stages + i;
+		const struct logfs_record_header *const header = (const struct logfs_record_header *) job->buffer;
+
+		/*If the job is a pending data record of the file, that contains the offset, return it;*/
+		if ((job->state != JOB_EMPTY) && (job->file == file) && (header->type == LOGFS_DATA) &&
+			(header->offset <= offset) && (offset - header->offset < header->length)) {
+			return job;
+		}
+
+	}
+
+	/*Not found;*/
+	return 0;
+
+}
+
+
+/**
+ * logfs_res_read : reads the file at the current position. Programmed data is read from the flash, after the phrase
+ * 	program in progress, if any, completes. Staged data is copied from its job, without waiting;
+ *
+ * @return the number of bytes read. Lower than @size if programmed data must be read during a sector erase;
+ */
+
+static size_t logfs_res_read(struct resrc *const res, void *const dst, const size_t size) {
+
+	/*Cast the resource;*/
+	struct logfs_resrc *const rd = (struct logfs_resrc *) res;
+
+	/*Cache the file and the superblock;*/
+	struct logfs_file *const file = rd->file;
+	struct logfs_sb *const sb = (struct logfs_sb *) file->inode.i_sb;
+
+	uint8_t *dst_ptr = dst;
+	size_t remaining = size;
+
+	/*Set once the flash is idle. No command is launched during the read;*/
+	bool idle = false;
+
+	/*While data remains to be read :*/
+	while (remaining) {
+
+		/*Find the last chunk that starts before the position;*/
+		const size_t index = logfs_chunk_search(file, rd->offset);
+		const struct logfs_chunk *const chunk = (index) ? file->chunks + index - 1 : 0;
+
+		size_t count;
+
+		/*If the chunk contains the position :*/
+		if ((chunk) && (rd->offset - chunk->offset < chunk->length)) {
+
+			/*Cache the position in the chunk;*/
+			const size_t chunk_offset = rd->offset - chunk->offset;
+
+			/*If a sector is being erased, the flash can't be read before long, stop;*/
+			if (sb->erasing != NO_SEGMENT) {
+				break;
+			}
+
+			/*Wait for the phrase program in progress, the flash can't be read during a command;*/
+			if (!idle) {
+				while ((*(sb->flash.busy))());
+				idle = true;
+			}
+
+			/*Determine the number of bytes to copy;*/
+			count = chunk->length - chunk_offset;
+			if (count > remaining) {
+				count = remaining;
+			}
+
+			/*Copy from the flash;*/
+			logfs_read(sb, dst_ptr, chunk->segment,
+					   chunk->position + sizeof(struct logfs_record_header) + chunk_offset, count);
+
+		} else {
+
+			/*Search the position in staged data;*/
+			const struct logfs_job *const job = logfs_staged(sb, file, rd->offset);
+
+			/*If it is not staged (data that could not be indexed), stop;*/
+			if (!job) {
+				break;
+			}
+
+			/*Cache the header and the position in the record;*/
+			const struct logfs_record_header *const header = (const struct logfs_record_header *) job->buffer;
+			const size_t job_offset = rd->offset - header->offset;
+
+			/*Determine the number of bytes to copy;*/
+			count = header->length - job_offset;
+			if (count > remaining) {
+				count = remaining;
+			}
+
+			/*Copy from the job;*/
+			memcpy(dst_ptr, job->buffer + sizeof(struct logfs_record_header) + job_offset, count);
+
+		}
+
+		/*Update positions;*/
+		dst_ptr += count;
+		rd->offset += count;
+		remaining -= count;
+
+	}
+
+	/*Return the number of bytes read;*/
+	return size - remaining;
+
+}
+
+
+/**
+ * logfs_res_write : appends data to the file. Never waits for a sector erase;
+ *
+ * @return the number of bytes appended. Lower than @size if staging buffers are full during an erase, or if the file
+ * 	system is full;
+ */
+
+static size_t logfs_res_write(struct resrc *const res, const void *const src, const size_t size) {
+
+	/*Cast the resource;*/
+	struct logfs_resrc *const rd = (struct logfs_resrc *) res;
+
+	/*Cache the file and the superblock;*/
+	struct logfs_file *const file = rd->file;
+	struct logfs_sb *const sb = (struct logfs_sb *) file->inode.i_sb;
+
+	const uint8_t *src_ptr = src;
+	size_t remaining = size;
+
+	/*While data remains to be written :*/
+	while (remaining) {
+
+		/*Get the file's stage;*/
+		struct logfs_job *job = logfs_stage_get(sb, file);
+
+		/*If the file has no stage :*/
+		if (!job) {
+
+			/*Get an empty one;*/
+			job = logfs_stage_empty(sb);
+
+			/*If all are used :*/
+			if (!job) {
+
+				/*Seal stages of other files, so that they get programmed;*/
+				logfs_stage_seal_all(sb);
+
+				/*If a sector is being erased, or if the engine is stuck, stop;*/
+				if ((sb->erasing != NO_SEGMENT) || (!logfs_pump(sb))) {
+					break;
+				}
+
+				/*Retry;*/
+				continue;
+
+			}
+
+			/*If the flash is full, stop;*/
+			if (!logfs_stage_admit(sb)) {
+				break;
+			}
+
+			/*Start a data record at the end of the file;*/
+			logfs_record_start(job, file, LOGFS_DATA, (uint32_t) file->size);
+
+		}
+
+		/*Cache the header;*/
+		struct logfs_record_header *const header = (struct logfs_record_header *) job->buffer;
+
+		/*Determine the number of bytes to stage;*/
+		size_t count = LOGFS_PAYLOAD_SIZE - header->length;
+		if (count > remaining) {
+			count = remaining;
+		}
+
+		/*Copy;*/
+		memcpy(job->buffer + sizeof(struct logfs_record_header) + header->length, src_ptr, count);
+
+		/*Update sizes and positions;*/
+		header->length += count;
+		file->size += count;
+		src_ptr += count;
+		remaining -= count;
+
+		/*If the stage is full, seal it;*/
+		if (header->length == LOGFS_PAYLOAD_SIZE) {
+			logfs_job_seal(sb, job);
+		}
+
+	}
+
+	/*If data was staged, it must be programmed, resume the pump task. A failed write leaves it stopped;*/
+	if (remaining != size) {
+		logfs_wake();
+	}
+
+	/*Return the number of bytes written;*/
+	return size - remaining;
+
+}
+
+
+/**
+ * logfs_res_seek : moves the read position;
+ */
+
+static bool logfs_res_seek(struct resrc *const res, const size_t offset) {
+
+	/*Cast the resource;*/
+	struct logfs_resrc *const rd = (struct logfs_resrc *) res;
+
+	/*If the position is after the end of the file, fail;*/
+	if (offset > rd->file->size) {
+		return false;
+	}
+
+	/*Update the position;*/
+	rd->offset = offset;
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * logfs_res_close : seals the file's staged data, so that the pump task programs it, and deletes the resource;
+ */
+
+static void logfs_res_close(struct resrc *const res) {
+
+	/*Cache the file and the superblock;*/
+	struct logfs_file *const file = ((struct logfs_resrc *) res)->file;
+	struct logfs_sb *const sb = (struct logfs_sb *) file->inode.i_sb;
+
+	/*Cache the file's stage;*/
+	struct logfs_job *const job = logfs_stage_get(sb, file);
+
+	/*If the file has staged data, seal it, and resume the pump task;*/
+	if (job) {
+		logfs_job_seal(sb, job);
+		logfs_wake();
+	}
+
+	/*Free the resource;*/
+	kfree(res);
+
+}
+
+
+/*The resource operations;*/
+static const struct resrc_ops logfs_resrc_ops = {
+	.read = &logfs_res_read,
+	.write = &logfs_res_write,
+	.seek = &logfs_res_seek,
+	.close = &logfs_res_close,
+};
+
+
+/*------------------------------------------------------- Inodes -------------------------------------------------------*/
+
+/*Open a file;*/
+static struct resrc *logfs_open(struct inode *const inode) {
+
+	/*Create the initializer, positioned at the start of the file;*/
+	const struct logfs_resrc init = {
+		.res = {
+			.res_dentry = 0,
+			.res_ops = &logfs_resrc_ops,
+		},
+		.file = (struct logfs_file *) inode,
+		.offset = 0,
+	};
+
+	/*Allocate and initialise the resource;*/
+	return kialloc(sizeof(struct logfs_resrc), &init);
+
+}
+
+
+/*Search for a file in the root;*/
+static struct inode *logfs_lookup(struct inode *const dir, const char *const name) {
+
+	/*Search in the names index;*/
+	return nindex_get(&((struct logfs_sb *) dir->i_sb)->names, name);
+
+}
+
+
+/*Create a file in the root;*/
+static struct inode *logfs_create(struct inode *const dir, const char *const name) {
+
+	/*Cache the superblock;*/
+	struct logfs_sb *const sb = (struct logfs_sb *) dir->i_sb;
+
+	/*Create the file;*/
+	struct logfs_file *const file = logfs_file_create(sb, name, sb->next_id);
+
+	/*If it failed, fail;*/
+	if (!file) {
+		return 0;
+	}
+
+	/*Stage its CREATE record. If it fails, delete the file;*/
+	if (!logfs_record_queue(sb, file, LOGFS_CREATE, name)) {
+		nindex_remove(&sb->names, name);
+		logfs_file_delete(sb, file);
+		return 0;
+	}
+
+	/*Update the id of the next file;*/
+	sb->next_id++;
+
+	/*The record must be programmed, resume the pump task;*/
+	logfs_wake();
+
+	/*Return the file;*/
+	return &file->inode;
+
+}
+
+
+/*Delete a file of the root;*/
+static bool logfs_unlink(struct inode *const dir, const char *const name, struct inode *const inode) {
+
+	/*Cache the superblock and the file;*/
+	struct logfs_sb *const sb = (struct logfs_sb *) dir->i_sb;
+	struct logfs_file *const file = (struct logfs_file *) inode;
+
+	/*Drop all jobs of the file that are not being programmed, their records would be dead;*/
+	for (size_t i = 0; i < NB_STAGES + 1; i++) {
+
+		/*Cache the job;*/
+		struct logfs_job *const job = (i < NB_STAGES) ? sb->stages + i : &sb->gc;
+
+		/*If the job is related to the file, and is not being programmed, drop it;*/
+		if ((job->state != JOB_EMPTY) && (job->file == file) && (job != sb->current)) {
+			job->state = JOB_EMPTY;
+		}
+
+	}
+
+	/*Stage the DELETE record. If it fails, the file is only truncated to its programmed data;*/
+	if (!logfs_record_queue(sb, file, LOGFS_DELETE, 0)) {
+		file->size = (file->nb_chunks) ? file->chunks[file->nb_chunks - 1].offset +
+										 file->chunks[file->nb_chunks - 1].length : 0;
+		return false;
+	}
+
+	/*The DELETE record and the record being programmed must not update the file anymore;*/
+	for (size_t i = 0; i < NB_STAGES; i++) {
+		if (sb->stages[i].file == file) {
+			sb->stages[i].file = 0;
+		}
+	}
+	if ((sb->current) && (sb->current->file == file)) {
+		sb->current->file = 0;
+	}
+
+	/*All records of the file are dead;*/
+	logfs_file_kill(sb, file);
+
+	/*Remove the name and delete the file;*/
+	nindex_remove(&sb->names, name);
+	logfs_file_delete(sb, file);
+
+	/*The record must be programmed, resume the pump task;*/
+	logfs_wake();
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/*The root operations;*/
+static const struct inode_operations logfs_root_ops = {
+	.lookup = &logfs_lookup,
+	.create = &logfs_create,
+	.unlink = &logfs_unlink,
+};
+
+/*The file operations;*/
+static const struct inode_operations logfs_file_ops = {
+	.open = &logfs_open,
+};
+
+
+/*-------------------------------------------------------- Mount -------------------------------------------------------*/
+
+/**
+ * logfs_scan_segment : determines the state of a segment from its content;
+ */
+
+static void logfs_scan_segment(struct logfs_sb *const sb, const uint16_t index) {
+
+	/*Cache the segment;*/
+	struct logfs_segment *const segment = sb->segments + index;
+
+	struct logfs_segment_header header;
+	struct logfs_record_header record;
+
+	/*Read the header;*/
+	logfs_read(sb, &header, index, 0, sizeof(struct logfs_segment_header));
+
+	/*If the segment is not formatted, it must be formatted if erased, or erased if not;*/
+	if (header.magic != LOGFS_MAGIC) {
+		segment->erase_count = 0;
+		segment->state = (logfs_erased(sb, index, 0)) ? SEG_ERASED : SEG_DIRTY;
+		return;
+	}
+
+	/*Save the erase count;*/
+	segment->erase_count = header.erase_count;
+
+	/*If the segment is not activated, it is free if erased, or must be erased if not;*/
+	if (header.sequence == ERASED) {
+		if (logfs_erased(sb, index, sizeof(struct logfs_segment_header))) {
+			segment->state = SEG_FREE;
+			sb->nb_free++;
+		} else {
+			segment->state = SEG_DIRTY;
+		}
+		return;
+	}
+
+	/*The segment is used;*/
+	segment->sequence = header.sequence;
+	segment->state = SEG_FULL;
+
+	/*Update the sequence number of the next activated segment;*/
+	if ((int32_t) (header.sequence - sb->sequence) >= 0) {
+		sb->sequence = header.sequence + 1;
+	}
+
+	/*Start after the header;*/
+	size_t position = sizeof(struct logfs_segment_header);
+
+	/*While records remain :*/
+	while (position + sizeof(struct logfs_record_header) <= sb->flash.sector_size) {
+
+		/*Read the record header;*/
+		logfs_read(sb, &record, index, position, sizeof(struct logfs_record_header));
+
+		/*If the record is invalid, the end of the log is reached;*/
+		if (!logfs_record_valid(sb, &record, position)) {
+			break;
+		}
+
+		/*Mark DELETE records;*/
+		if (record.type == LOGFS_DELETE) {
+			segment->deletes = true;
+		}
+
+		/*Skip the record;*/
+		position += RECORD_SIZE(record.length);
+
+	}
+
+	/*Records can be appended only if the rest of the segment is erased;*/
+	segment->fill = (uint16_t) ((logfs_erased(sb, index, position)) ? position : sb->flash.sector_size);
+
+}
+
+
+/**
+ * logfs_read_name : reads the name of a file in its CREATE record;
+ *
+ * @return false if the name is too long;
+ */
+
+static bool logfs_read_name(const struct logfs_sb *const sb, char *const name, const uint16_t segment,
+							const uint16_t position) {
+
+	struct logfs_record_header header;
+
+	/*Read the header;*/
+	logfs_read(sb, &header, segment, position, sizeof(struct logfs_record_header));
+
+	/*If the name is too long, fail;*/
+	if (header.length > VFS_NAME_MAX_LENGTH) {
+		return false;
+	}
+
+	/*Read the name and terminate it;*/
+	logfs_read(sb, name, segment, position + sizeof(struct logfs_record_header), header.length);
+	name[header.length] = 0;
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * logfs_replay : processes all records of the given types, in log order;
+ *
+ * @param sb : the superblock;
+ * @param order : segment indices, sorted by sequence number;
+ * @param nb_used : the number of used segments;
+ * @param data : set to index data records, cleared to process CREATE and DELETE records;
+ * @return false if the kernel heap is full;
+ */
+
+static bool logfs_replay(struct logfs_sb *const sb, const uint16_t *const order, const size_t nb_used,
+						 const bool data) {
+
+	struct logfs_record_header header;
+
+	/*A name buffer;*/
+	char name[VFS_NAME_MAX_LENGTH + 1];
+
+	/*For each used segment in log order :*/
+	for (size_t i = 0; i < nb_used; i++) {
+
+		/*Cache the segment index;*/
+		const uint16_t segment = order[i];
+
+		/*For each valid record :*/
+		for (size_t position = sizeof(struct logfs_segment_header);
+			 position + sizeof(struct logfs_record_header) <= sb->flash.sector_size;
+			 position += RECORD_SIZE(header.length)) {
+
+			/*Read the header. If invalid, stop;*/
+			logfs_read(sb, &header, segment, position, sizeof(struct logfs_record_header));
+			if (!logfs_record_valid(sb, &header, position)) {
+				break;
+			}
+
+			/*Search for the file;*/
+			struct logfs_file *file = logfs_find(sb, header.id);
+
+			/*If data records are processed :*/
+			if (data) {
+
+				/*Index the record, if its file exists. Copies made by an interrupted collection are ignored;*/
+				if ((header.type == LOGFS_DATA) && (file)) {
+
+					/*Create the chunk;*/
+					const struct logfs_chunk chunk = {
+						.offset = header.offset,
+						.length = header.length,
+						.segment = segment,
+						.position = (uint16_t) position,
+					};
+
+					/*Index it. If it fails, fail;*/
+					if (!logfs_chunk_insert(file, &chunk)) {
+						return false;
+					}
+
+				}
+
+				continue;
+
+			}
+
+			/*Update the id of the next file;*/
+			if ((uint16_t) (header.id + 1) > sb->next_id) {
+				sb->next_id = (uint16_t) (header.id + 1);
+			}
+
+			/*If the record creates a file that doesn't exist yet (a second CREATE is a copy made by an interrupted
+			 * collection, the original is kept) :*/
+			if ((header.type == LOGFS_CREATE) && (!file)) {
+
+				/*Read the name. If invalid, ignore the record;*/
+				if (!logfs_read_name(sb, name, segment, position)) {
+					continue;
+				}
+
+				/*Create the file;*/
+				if (!(file = logfs_file_create(sb, name, header.id))) {
+					return false;
+				}
+
+				/*Save its create location;*/
+				file->create_segment = segment;
+				file->create_position = (uint16_t) position;
+
+			} else if ((header.type == LOGFS_DELETE) && (file)) {
+
+				/*Remove the name, read in the CREATE record, and delete the file;*/
+				if (logfs_read_name(sb, name, file->create_segment, file->create_position)) {
+					nindex_remove(&sb->names, name);
+				}
+				logfs_file_delete(sb, file);
+
+			}
+
+		}
+
+	}
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * logfs_mount_scan : scans all segments and rebuilds the index;
+ *
+ * @return false if the kernel heap is full;
+ */
+
+static bool logfs_mount_scan(struct logfs_sb *const sb) {
+
+	/*Cache the number of segments;*/
+	const uint16_t nb_segments = (uint16_t) sb->flash.nb_sectors;
+
+	/*Allocate the array of used segments;*/
+	uint16_t *const order = kmalloc(nb_segments * sizeof(uint16_t));
+	size_t nb_used = 0;
+
+	/*If the allocation failed, fail;*/
+	if (!order) {
+		return false;
+	}
+
+	/*Scan all segments;*/
+	for (uint16_t i = 0; i < nb_segments; i++) {
+		logfs_scan_segment(sb, i);
+	}
+
+	/*Insert used segments in the order array, sorted by sequence number;*/
+	for (uint16_t i = 0; i < nb_segments; i++) {
+
+		/*If the segment is not used, skip;*/
+		if (sb->segments[i].state != SEG_FULL) {
+			continue;
+		}
+
+		/*Insert it;*/
+		size_t j = nb_used++;
+		for (; (j) && ((int32_t) (sb->segments[order[j - 1]].sequence - sb->segments[i].sequence) > 0); j--) {
+			order[j] = order[j - 1];
+		}
+		order[j] = i;
+
+	}
+
+	/*If the most recent segment can receive records, it is the active one;*/
+	if (nb_used) {
+		const uint16_t last = order[nb_used - 1];
+		if (sb->segments[last].fill < sb->flash.sector_size) {
+			sb->segments[last].state = SEG_ACTIVE;
+			sb->active = last;
+		}
+	}
+
+	/*Replay namespace records, then index data records;*/
+	const bool success = (logfs_replay(sb, order, nb_used, false)) && (logfs_replay(sb, order, nb_used, true));
+
+	/*Account live records;*/
+	for (const struct logfs_file *file = sb->files; file; file = file->next) {
+		logfs_file_revive(sb, file);
+	}
+
+	/*Free the order array;*/
+	kfree(order);
+
+	/*Complete;*/
+	return success;
+
+}
+
+
+/**
+ * logfs_release_sb : programs staged data, deletes all files, and releases the flash device;
+ */
+
+static bool logfs_release_sb(struct superblock *const superblock) {
+
+	/*Cast the superblock;*/
+	struct logfs_sb *const sb = (struct logfs_sb *) superblock;
+
+	/*The pump task must not access the superblock anymore;*/
+	logfs_detach(sb);
+
+	/*If the flash is interfaced, program staged data;*/
+	if (sb->segments) {
+		logfs_flush(sb);
+	}
+
+	/*Delete all files;*/
+	nindex_clear(&sb->names, 0);
+	while (sb->files) {
+		logfs_file_delete(sb, sb->files);
+	}
+
+	/*Free job buffers and segments, if allocated;*/
+	for (size_t i = 0; i < NB_STAGES; i++) {
+		if (sb->stages[i].buffer) {
+			kfree(sb->stages[i].buffer);
+		}
+	}
+	if (sb->gc.buffer) {
+		kfree(sb->gc.buffer);
+	}
+	if (sb->segments) {
+		kfree(sb->segments);
+	}
+
+	/*Close the device, its if is neutralised;*/
+	fs_close(sb->device);
+
+	/*Free the superblock;*/
+	kfree(sb);
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * logfs_get_sb : opens the flash device, and mounts the file system it contains. Unformatted sectors are formatted
+ * 	in the background;
+ *
+ * @param type : the logfs type;
+ * @param dev_name : the name of the flash device file;
+ * @return the superblock, or 0 if the device can't be used;
+ */
+
+static struct superblock *logfs_get_sb(struct fs_type *const type, const char *const dev_name) {
+
+	/*Open the device;*/
+	const file_descriptor device = (dev_name) ? fs_open(dev_name) : 0;
+
+	/*If it failed, fail;*/
+	if (!device) {
+		return 0;
+	}
+
+	/*Allocate the superblock;*/
+	struct logfs_sb *const sb = kcalloc(sizeof(struct logfs_sb));
+
+	/*If the allocation failed, close the device and fail;*/
+	if (!sb) {
+		fs_close(device);
+		return 0;
+	}
+
+	/*Initialise the root and the superblock;*/
+	sb->root.i_sb = &sb->sb;
+	sb->root.i_ops = &logfs_root_ops;
+	sb->sb.sb_inode = &sb->root;
+	sb->device = device;
+	sb->active = sb->erasing = sb->victim = NO_SEGMENT;
+	sb->names.name_max_length = VFS_NAME_MAX_LENGTH;
+
+	/*Initialise jobs, and allocate their buffers;*/
+	logfs_job_init(&sb->gc, kmalloc(LOGFS_RECORD_SIZE));
+	logfs_job_init(&sb->header, sb->header_buffer);
+	bool allocated = (sb->gc.buffer != 0);
+	for (size_t i = 0; i < NB_STAGES; i++) {
+		logfs_job_init(sb->stages + i, kmalloc(LOGFS_RECORD_SIZE));
+		allocated &= (sb->stages[i].buffer != 0);
+	}
+
+	/*If the flash can't be interfaced, fail;*/
+	if (!iop_interface(device, &sb->flash, sizeof(struct flash_if))) {
+		logfs_release_sb(&sb->sb);
+		return 0;
+	}
+
+	/*Cache the geometry;*/
+	const size_t phrase = sb->flash.phrase_size, sector = sb->flash.sector_size, nb_sectors = sb->flash.nb_sectors;
+
+	/*If the geometry is not supported, or if a buffer could not be allocated, fail;*/
+	if ((!phrase) || (LOGFS_ALIGN % phrase) || (sector % LOGFS_ALIGN) || (sector > 0xFFFF) ||
+		(sector < sizeof(struct logfs_segment_header) + LOGFS_RECORD_SIZE) ||
+		(nb_sectors <= LOGFS_RESERVE) || (nb_sectors >= NO_SEGMENT) ||
+		(!allocated)) {
+		logfs_release_sb(&sb->sb);
+		return 0;
+	}
+
+	/*Allocate the segments array;*/
+	sb->segments = kcalloc(nb_sectors * sizeof(struct logfs_segment));
+
+	/*Wait for the completion of any command, the flash can't be read during a command;*/
+	while ((*(sb->flash.busy))());
+
+	/*Scan the flash and rebuild the index. If it fails, fail;*/
+	if ((!sb->segments) || (!logfs_mount_scan(sb))) {
+		logfs_release_sb(&sb->sb);
+		return 0;
+	}
+
+	/*The pump task can now format and collect segments in the background;*/
+	logfs_attach(sb);
+
+	/*Return the superblock;*/
+	return &sb->sb;
+
+}
+
+
+/*The logfs type;*/
+static struct fs_type logfs_type = {
+	.name = "logfs",
+	.get_sb = &logfs_get_sb,
+	.release_sb = &logfs_release_sb,
+};
+
+
+/*Register the logfs type;*/
+static bool logfs_init() {
+
+	/*Register the type in the vfs;*/
+	return vfs_register_fs(&logfs_type);
+
+}
+
+
+/*Embed the logfs in the executable;*/
+KERNEL_HOOK_MODULE(SYSTEM_MODULE, logfs, &logfs_init)
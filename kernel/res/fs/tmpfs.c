@@ -0,0 +1,676 @@
+/*
+  tmpfs.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "api.h"
+
+#include <stdmem.h>
+
+#include <kernel/core/ram.h>
+
+#include <kernel/res/kdmem.h>
+
+#include <kernel/exec/mod_hook>
+
+
+/*
+ * The tmpfs stores files in RAM frames, so that processes can exchange data through files without using the flash;
+ *
+ * 	Each node can contain data and children. Its data is stored in frames, referenced by a list of extents : each
+ * 	extent references up to TMPFS_EXTENT_FRAMES frames, and the node references its last extent, so that appending
+ * 	a frame never walks the list;
+ *
+ * 	Each opened resource keeps a cursor on the extent of its position, so that sequential accesses never walk the
+ * 	list either. Random accesses walk it from the cursor, or from the first extent when moving backward;
+ *
+ * 	The number of frames a mount can use is limited to TMPFS_MAX_FRAMES. Frames are released when files are deleted,
+ * 	or when the file system is unmounted;
+ */
+
+
+/*--------------------------------------------------- Make Parameters --------------------------------------------------*/
+
+/*The maximal number of frames a tmpfs mount can use;*/
+#if !defined(TMPFS_MAX_FRAMES)
+
+#define TMPFS_MAX_FRAMES 16
+
+#endif
+
+
+/*The number of frames an extent references;*/
+#if !defined(TMPFS_EXTENT_FRAMES)
+
+#define TMPFS_EXTENT_FRAMES 8
+
+#endif
+
+
+/*-------------------------------------------------------- Types -------------------------------------------------------*/
+
+/*
+ * An extent references a set of frames of a node's data;
+ */
+
+struct tmpfs_extent {
+
+	/*The next extent. Null for the last one;*/
+	struct tmpfs_extent *next;
+
+	/*The number of frames referenced;*/
+	size_t nb_frames;
+
+	/*Frames, in data order;*/
+	uint8_t *frames[TMPFS_EXTENT_FRAMES];
+
+};
+
+
+/*
+ * A tmpfs node is an inode, with its children and its data;
+ */
+
+struct tmpfs_node {
+
+	/*The vfs inode;*/
+	struct inode inode;
+
+	/*Children, indexed by name;*/
+	struct nindex children;
+
+	/*The first and last extents of the data. Null if no frame is used;*/
+	struct tmpfs_extent *first;
+	struct tmpfs_extent *last;
+
+	/*The number of frames used by the data;*/
+	size_t nb_frames;
+
+	/*The size of the data;*/
+	size_t size;
+
+};
+
+
+/*
+ * A tmpfs superblock contains the root node, and the frames accounting of the mount;
+ */
+
+struct tmpfs_sb {
+
+	/*The vfs superblock;*/
+	struct superblock sb;
+
+	/*The root node;*/
+	struct tmpfs_node root;
+
+	/*The size of a frame;*/
+	size_t frame_size;
+
+	/*The number of frames used by all nodes;*/
+	size_t nb_frames;
+
+};
+
+
+/*
+ * A tmpfs resource accesses a node's data at a position;
+ */
+
+struct tmpfs_resrc {
+
+	/*The vfs resource;*/
+	struct resrc res;
+
+	/*The node;*/
+	struct tmpfs_node *node;
+
+	/*The current position;*/
+	size_t offset;
+
+	/*The cursor : an extent of the node, and its index in the list. Null if not positioned;*/
+	struct tmpfs_extent *extent;
+	size_t extent_index;
+
+};
+
+
+static const struct inode_operations tmpfs_inode_ops;
+
+
+/*--------------------------------------------------------- Data -------------------------------------------------------*/
+
+/**
+ * tmpfs_append : adds a frame at the end of a node's data, if the mount's limit and the RAM allow it;
+ *
+ * @param sb : the node's superblock;
+ * @param node : the node to grow;
+ * @return true if the frame was added, false if the mount's limit is reached, or if the RAM or the heap is exhausted;
+ */
+
+static bool tmpfs_append(struct tmpfs_sb *const sb, struct tmpfs_node *const node) {
+
+	/*Cache the last extent;*/
+	struct tmpfs_extent *last = node->last;
+
+	/*If the mount uses all its frames, fail;*/
+	if (sb->nb_frames == TMPFS_MAX_FRAMES) {
+		return false;
+	}
+
+	/*If there is no extent, or if the last one is full :*/
+	if ((!last) || (last->nb_frames == TMPFS_EXTENT_FRAMES)) {
+
+		/*Allocate an extent;*/
+		struct tmpfs_extent *const extent = kmalloc(sizeof(struct tmpfs_extent));
+
+		/*If the allocation failed, fail;*/
+		if (!extent) {
+			return false;
+		}
+
+		/*The extent is empty and ends the list;*/
+		extent->next = 0;
+		extent->nb_frames = 0;
+
+		/*Link the extent at the end of the list;*/
+		if (last) {
+			last->next = extent;
+		} else {
+			node->first = extent;
+		}
+
+		/*Update the last extent;*/
+		node->last = last = extent;
+
+	}
+
+	/*Allocate a frame in the upper region, as RAM_ANY frames. ram_alloc_frame would panic if the RAM is exhausted;*/
+	uint8_t *frame = ram_alloc_frame_region(RAM_REGION_UPPER);
+
+	/*If the upper region is exhausted, attempt in the lower one;*/
+	if (!frame) {
+		frame = ram_alloc_frame_region(RAM_REGION_LOWER);
+	}
+
+	/*If the RAM is exhausted, fail, so that the write is short. The empty extent will be used by the next append;*/
+	if (!frame) {
+		return false;
+	}
+
+	/*Reference the frame;*/
+	last->frames[last->nb_frames++] = frame;
+
+	/*Update frames counters;*/
+	node->nb_frames++;
+	sb->nb_frames++;
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * tmpfs_free_data : releases all frames and extents of a node;
+ *
+ * @param sb : the node's superblock;
+ * @param node : the node whose data must be released;
+ */
+
+static void tmpfs_free_data(struct tmpfs_sb *const sb, struct tmpfs_node *const node) {
+
+	/*Cache the first extent;*/
+	struct tmpfs_extent *extent = node->first;
+
+	/*For each extent :*/
+	while (extent) {
+
+		/*Cache the next extent;*/
+		struct tmpfs_extent *const next = extent->next;
+
+		/*Release all frames;*/
+		for (size_t i = 0; i < extent->nb_frames; i++) {
+			ram_free_frame(extent->frames[i]);
+		}
+
+		/*Free the extent;*/
+		kfree(extent);
+
+		/*Focus on the next extent;*/
+		extent = next;
+
+	}
+
+	/*Update the mount's counter;*/
+	sb->nb_frames -= node->nb_frames;
+
+	/*The node is empty;*/
+	node->first = node->last = 0;
+	node->nb_frames = 0;
+	node->size = 0;
+
+}
+
+
+/**
+ * tmpfs_frame : finds the frame that contains a position of the resource's node, and updates the cursor;
+ *
+ * @param rd : the resource;
+ * @param frame_index : the index of the frame in the node's data. Must be lower than the node's number of frames;
+ * @return the frame;
+ */
+
+static uint8_t *tmpfs_frame(struct tmpfs_resrc *const rd, const size_t frame_index) {
+
+	/*Determine the index of the frame's extent;*/
+	const size_t extent_index = frame_index / TMPFS_EXTENT_FRAMES;
+
+	/*If the cursor is not positioned, or after the extent, restart from the first extent;*/
+	if ((!rd->extent) || (rd->extent_index > extent_index)) {
+		rd->extent = rd->node->first;
+		rd->extent_index = 0;
+	}
+
+	/*Walk to the extent;*/
+	while (rd->extent_index < extent_index) {
+		rd->extent = rd->extent->next;
+		rd->extent_index++;
+	}
+
+	/*Return the frame;*/
+	return rd->extent->frames[frame_index % TMPFS_EXTENT_FRAMES];
+
+}
+
+
+/*------------------------------------------------------ Resources -----------------------------------------------------*/
+
+/**
+ * tmpfs_read : copies data from the current position, until the end of the node's data;
+ */
+
+static size_t tmpfs_read(struct resrc *const res, void *const dst, const size_t size) {
+
+	/*Cast the resource;*/
+	struct tmpfs_resrc *const rd = (struct tmpfs_resrc *) res;
+
+	/*Cache the frame size;*/
+	const size_t frame_size = ((struct tmpfs_sb *) rd->node->inode.i_sb)->frame_size;
+
+	/*Cache the number of available bytes;*/
+	const size_t available = rd->node->size - rd->offset;
+
+	/*Determine the number of bytes to read;*/
+	const size_t total = (size < available) ? size : available;
+
+	uint8_t *dst_ptr = dst;
+	size_t remaining = total;
+
+	/*While bytes remain to be read :*/
+	while (remaining) {
+
+		/*Determine the position in the frame, and the number of bytes to copy from it;*/
+		const size_t frame_offset = rd->offset % frame_size;
+		size_t chunk = frame_size - frame_offset;
+		if (chunk > remaining) {
+			chunk = remaining;
+		}
+
+		/*Copy;*/
+		memcpy(dst_ptr, tmpfs_frame(rd, rd->offset / frame_size) + frame_offset, chunk);
+
+		/*Update positions;*/
+		dst_ptr += chunk;
+		rd->offset += chunk;
+		remaining -= chunk;
+
+	}
+
+	/*Return the number of bytes read;*/
+	return total;
+
+}
+
+
+/**
+ * tmpfs_write : copies data at the current position, and appends frames as required;
+ *
+ * 	Stops when the mount's limit is reached;
+ */
+
+static size_t tmpfs_write(struct resrc *const res, const void *const src, const size_t size) {
+
+	/*Cast the resource;*/
+	struct tmpfs_resrc *const rd = (struct tmpfs_resrc *) res;
+
+	/*Cache the node and its superblock;*/
+	struct tmpfs_node *const node = rd->node;
+	struct tmpfs_sb *const sb = (struct tmpfs_sb *) node->inode.i_sb;
+
+	/*Cache the frame size;*/
+	const size_t frame_size = sb->frame_size;
+
+	const uint8_t *src_ptr = src;
+	size_t remaining = size;
+
+	/*While bytes remain to be written :*/
+	while (remaining) {
+
+		/*Determine the index of the frame;*/
+		const size_t frame_index = rd->offset / frame_size;
+
+		/*If the position is after the last frame, append one. If it fails, stop;*/
+		if ((frame_index == node->nb_frames) && (!tmpfs_append(sb, node))) {
+			break;
+		}
+
+		/*Determine the position in the frame, and the number of bytes to copy in it;*/
+		const size_t frame_offset = rd->offset % frame_size;
+		size_t chunk = frame_size - frame_offset;
+		if (chunk > remaining) {
+			chunk = remaining;
+		}
+
+		/*Copy;*/
+		memcpy(tmpfs_frame(rd, frame_index) + frame_offset, src_ptr, chunk);
+
+		/*Update positions;*/
+		src_ptr += chunk;
+		rd->offset += chunk;
+		remaining -= chunk;
+
+		/*If the data grew, update its size;*/
+		if (rd->offset > node->size) {
+			node->size = rd->offset;
+		}
+
+	}
+
+	/*Return the number of bytes written;*/
+	return size - remaining;
+
+}
+
+
+/**
+ * tmpfs_seek : moves the current position. Positions after the end of the data are invalid;
+ */
+
+static bool tmpfs_seek(struct resrc *const res, const size_t offset) {
+
+	/*Cast the resource;*/
+	struct tmpfs_resrc *const rd = (struct tmpfs_resrc *) res;
+
+	/*If the position is after the end of the data, fail;*/
+	if (offset > rd->node->size) {
+		return false;
+	}
+
+	/*Update the position. The cursor will be updated at the next access;*/
+	rd->offset = offset;
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * tmpfs_close : deletes the resource;
+ */
+
+static void tmpfs_close(struct resrc *const res) {
+
+	/*Free the resource;*/
+	kfree(res);
+
+}
+
+
+/*The resource operations;*/
+static const struct resrc_ops tmpfs_resrc_ops = {
+	.read = &tmpfs_read,
+	.write = &tmpfs_write,
+	.seek = &tmpfs_seek,
+	.close = &tmpfs_close,
+};
+
+
+/*-------------------------------------------------------- Nodes -------------------------------------------------------*/
+
+/**
+ * tmpfs_node_init : initialises an empty node;
+ *
+ * @param node : the node to initialise;
+ * @param sb : the superblock of the node;
+ */
+
+static void tmpfs_node_init(struct tmpfs_node *const node, struct superblock *const sb) {
+
+	/*Create the initializer;*/
+	const struct tmpfs_node init = {
+		.inode = {
+			.i_mode = 0,
+			.i_dentry = 0,
+			.i_sb = sb,
+			.i_ops = &tmpfs_inode_ops,
+		},
+		.children = {
+			.elements = 0,
+			.name_max_length = VFS_NAME_MAX_LENGTH,
+		},
+		.first = 0,
+		.last = 0,
+		.nb_frames = 0,
+		.size = 0,
+	};
+
+	/*Initialise the node;*/
+	memcpy(node, &init, sizeof(struct tmpfs_node));
+
+}
+
+
+static void tmpfs_node_delete(void *data);
+
+
+/**
+ * tmpfs_node_clear : releases the data of a node, and deletes all its children;
+ *
+ * @param node : the node to clear;
+ */
+
+static void tmpfs_node_clear(struct tmpfs_node *const node) {
+
+	/*Delete all children;*/
+	nindex_clear(&node->children, &tmpfs_node_delete);
+
+	/*Release the data;*/
+	tmpfs_free_data((struct tmpfs_sb *) node->inode.i_sb, node);
+
+}
+
+
+/**
+ * tmpfs_node_delete : clears a node and frees it;
+ *
+ * @param data : the node, passed as the data of its parent's index;
+ */
+
+static void tmpfs_node_delete(void *const data) {
+
+	/*Clear the node;*/
+	tmpfs_node_clear(data);
+
+	/*Free it;*/
+	kfree(data);
+
+}
+
+
+/*Search for a child;*/
+static struct inode *tmpfs_lookup(struct inode *const dir, const char *const name) {
+
+	/*Search in the node's children;*/
+	return nindex_get(&((struct tmpfs_node *) dir)->children, name);
+
+}
+
+
+/*Create a child;*/
+static struct inode *tmpfs_create(struct inode *const dir, const char *const name) {
+
+	/*Allocate the node;*/
+	struct tmpfs_node *const node = kmalloc(sizeof(struct tmpfs_node));
+
+	/*If the allocation failed, fail;*/
+	if (!node) {
+		return 0;
+	}
+
+	/*Initialise the node;*/
+	tmpfs_node_init(node, dir->i_sb);
+
+	/*Add the node to its parent. If it fails, delete it;*/
+	if (!nindex_add(&((struct tmpfs_node *) dir)->children, name, node)) {
+		kfree(node);
+		return 0;
+	}
+
+	/*Return the node;*/
+	return &node->inode;
+
+}
+
+
+/*Delete a child that has no children;*/
+static bool tmpfs_unlink(struct inode *const dir, const char *const name, struct inode *const inode) {
+
+	/*If the node has children, fail;*/
+	if (((struct tmpfs_node *) inode)->children.elements) {
+		return false;
+	}
+
+	/*Remove the node from its parent, and delete it;*/
+	tmpfs_node_delete(nindex_remove(&((struct tmpfs_node *) dir)->children, name));
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/*Open a node;*/
+static struct resrc *tmpfs_open(struct inode *const inode) {
+
+	/*Create the initializer, positioned at the start of the data;*/
+	const struct tmpfs_resrc init = {
+		.res = {
+			.res_dentry = 0,
+			.res_ops = &tmpfs_resrc_ops,
+		},
+		.node = (struct tmpfs_node *) inode,
+		.offset = 0,
+		.extent = 0,
+		.extent_index = 0,
+	};
+
+	/*Allocate and initialise the resource;*/
+	return kialloc(sizeof(struct tmpfs_resrc), &init);
+
+}
+
+
+/*The inode operations;*/
+static const struct inode_operations tmpfs_inode_ops = {
+	.lookup = &tmpfs_lookup,
+	.create = &tmpfs_create,
+	.unlink = &tmpfs_unlink,
+	.open = &tmpfs_open,
+};
+
+
+/*----------------------------------------------------- Superblock -----------------------------------------------------*/
+
+/**
+ * tmpfs_get_sb : creates an empty tmpfs. No device is used;
+ */
+
+static struct superblock *tmpfs_get_sb(struct fs_type *const type, const char *const dev_name) {
+
+	/*Allocate the superblock;*/
+	struct tmpfs_sb *const sb = kcalloc(sizeof(struct tmpfs_sb));
+
+	/*If the allocation failed, fail;*/
+	if (!sb) {
+		return 0;
+	}
+
+	/*Initialise the root node;*/
+	tmpfs_node_init(&sb->root, &sb->sb);
+
+	/*Reference the root inode;*/
+	sb->sb.sb_inode = &sb->root.inode;
+
+	/*Cache the frame size;*/
+	sb->frame_size = ram_frame_size();
+
+	/*Return the superblock;*/
+	return &sb->sb;
+
+}
+
+
+/**
+ * tmpfs_release_sb : deletes all nodes and releases all frames;
+ */
+
+static bool tmpfs_release_sb(struct superblock *const sb) {
+
+	/*Clear the root;*/
+	tmpfs_node_clear(&((struct tmpfs_sb *) sb)->root);
+
+	/*Free the superblock;*/
+	kfree(sb);
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/*The tmpfs type;*/
+static struct fs_type tmpfs_type = {
+	.name = "tmpfs",
+	.get_sb = &tmpfs_get_sb,
+	.release_sb = &tmpfs_release_sb,
+};
+
+
+/*Register the tmpfs type;*/
+static bool tmpfs_init() {
+
+	/*Register the type in the vfs;*/
+	return vfs_register_fs(&tmpfs_type);
+
+}
+
+
+/*Embed the tmpfs in the executable;*/
+KERNEL_HOOK_MODULE(SYSTEM_MODULE, tmpfs, &tmpfs_init)
@@ -0,0 +1,809 @@
+/*
+  vfs.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "api.h"
+
+#include <string.h>
+
+#include <stdmem.h>
+
+#include <kernel/res/kdmem.h>
+
+
+/*
+ * The vfs resolves absolute paths component by component, from the root dentry;
+ *
+ * 	Each dentry caches its children in a name index. Once a path has been resolved, all its components, including
+ * 	names that were not found, are cached, and resolving it again costs one hash probe per component, without
+ * 	calling any file system;
+ *
+ * 	When a dentry is a mount point, the walk continues in the root dentry of the mounted file system. The root of the
+ * 	tree has no inode : a file system must be mounted on "/" before any path can be resolved;
+ *
+ * 	Negative dentries are only a cache of failures, that any walk of a non existent path grows. They are kept in a
+ * 	list ordered by last use, and the least recently used one is deleted when there are more than
+ * 	VFS_NEGATIVE_DENTRIES_MAX. Negative dentries have no cached children, are not opened and are not mount points :
+ * 	they can always be deleted;
+ */
+
+
+/*--------------------------------------------------- Global variables -------------------------------------------------*/
+
+/*Registered file system types, indexed by name;*/
+static struct nindex fs_types = {
+	.elements = 0,
+	.name_max_length = VFS_NAME_MAX_LENGTH,
+};
+
+
+/*Negative dentries, from the least to the most recently used;*/
+static struct list_head vfs_negatives = {
+	.next = &vfs_negatives,
+	.prev = &vfs_negatives,
+};
+
+/*The number of negative dentries;*/
+static size_t vfs_nb_negatives = 0;
+
+
+/*The root of the tree;*/
+static struct dentry vfs_root = {
+	.d_lru = {
+		.next = &vfs_root.d_lru,
+		.prev = &vfs_root.d_lru,
+	},
+	.d_name = "/",
+	.d_inode = 0,
+	.d_parent = &vfs_root,
+	.d_children = {
+		.elements = 0,
+		.name_max_length = VFS_NAME_MAX_LENGTH,
+	},
+	.d_mount = 0,
+	.d_count = 0,
+	.d_sb = 0,
+	.d_ops = 0,
+};
+
+
+/*---------------------------------------------------- Dentry cache ----------------------------------------------------*/
+
+/**
+ * d_create : allocates a dentry and copies its name. The dentry is not referenced by its parent;
+ *
+ * @param parent : the parent dentry;
+ * @param name : the name of the dentry;
+ * @param inode : the inode of the dentry. Null for a negative dentry;
+ * @param sb : the superblock of the dentry;
+ * @return the dentry, or 0 if the kernel heap is full;
+ */
+
+static struct dentry *d_create(struct dentry *const parent, const char *const name, struct inode *const inode,
+							   struct superblock *const sb) {
+
+	/*Determine the size of the name, terminating null included;*/
+	const size_t name_size = strlen(name) + 1;
+
+	/*Allocate the dentry and its name in the same block;*/
+	struct dentry *const dentry = kmalloc(sizeof(struct dentry) + name_size);
+
+	/*If the allocation failed, fail;*/
+	if (!dentry) {
+		return 0;
+	}
+
+	/*Copy the name after the dentry;*/
+	char *const name_copy = (char *) (dentry + 1);
+	memcpy(name_copy, name, name_size);
+
+	/*Create the dentry initializer. The dentry is not in the negative list yet;*/
+	const struct dentry init = {
+		.d_lru = {
+			.next = &dentry->d_lru,
+			.prev = &dentry->d_lru,
+		},
+		.d_name = name_copy,
+		.d_inode = inode,
+		.d_parent = parent,
+		.d_children = {
+			.elements = 0,
+			.name_max_length = VFS_NAME_MAX_LENGTH,
+		},
+		.d_mount = 0,
+		.d_count = 0,
+		.d_sb = sb,
+		.d_ops = 0,
+	};
+
+	/*Initialise the dentry;*/
+	memcpy(dentry, &init, sizeof(struct dentry));
+
+	/*If the dentry is positive, link the inode to it;*/
+	if (inode) {
+		inode->i_dentry = dentry;
+	}
+
+	/*Return the dentry;*/
+	return dentry;
+
+}
+
+
+/**
+ * d_negative_unlink : removes a dentry from the negative list, if it is in;
+ *
+ * @param dentry : the dentry to unlink;
+ */
+
+static void d_negative_unlink(struct dentry *const dentry) {
+
+	/*If the dentry is not in the negative list, nothing to do;*/
+	if (dentry->d_lru.next == &dentry->d_lru) {
+		return;
+	}
+
+	/*Remove the dentry from the list, and make it a single element list;*/
+	list_remove(&dentry->d_lru);
+	list_init(&dentry->d_lru);
+
+	/*Update the count;*/
+	vfs_nb_negatives--;
+
+}
+
+
+/**
+ * d_negative_use : moves a negative dentry at the end of the negative list, as the most recently used;
+ *
+ * @param dentry : the negative dentry, in the list or not;
+ */
+
+static void d_negative_use(struct dentry *const dentry) {
+
+	/*Unlink the dentry if it is in the list;*/
+	d_negative_unlink(dentry);
+
+	/*Append it at the end of the list;*/
+	list_concat(&vfs_negatives, &dentry->d_lru);
+
+	/*Update the count;*/
+	vfs_nb_negatives++;
+
+}
+
+
+static void d_prune(void *data);
+
+/**
+ * d_negative_evict : deletes least recently used negative dentries, until their number is bounded;
+ *
+ * @param keep : a negative dentry that must not be deleted, as the caller returns it;
+ */
+
+static void d_negative_evict(const struct dentry *const keep) {
+
+	/*While there are too many negative dentries :*/
+	while (vfs_nb_negatives > VFS_NEGATIVE_DENTRIES_MAX) {
+
+		/*Cache the least recently used one. The link is the first field of the dentry;*/
+		struct dentry *const victim = (struct dentry *) vfs_negatives.next;
+
+		/*If it is the kept one, stop;*/
+		if (victim == keep) {
+			return;
+		}
+
+		/*Remove it from its parent's index, and delete it;*/
+		nindex_remove(&victim->d_parent->d_children, victim->d_name);
+		d_prune(victim);
+
+	}
+
+}
+
+
+/**
+ * d_prune : deletes a dentry and all its cached children. Inodes are not affected;
+ *
+ * @param data : the dentry to delete, passed as the data of its parent's index;
+ */
+
+static void d_prune(void *const data) {
+
+	/*Cast the dentry;*/
+	struct dentry *const dentry = data;
+
+	/*If the dentry is negative, remove it from the negative list;*/
+	d_negative_unlink(dentry);
+
+	/*Delete all children and free the index;*/
+	nindex_clear(&dentry->d_children, &d_prune);
+
+	/*Free the dentry and its name;*/
+	kfree(dentry);
+
+}
+
+
+/**
+ * d_follow : if the dentry is a mount point, returns the root dentry of the file system mounted on it;
+ *
+ * @param dentry : the dentry to follow;
+ * @return the dentry where the walk must continue;
+ */
+
+static struct dentry *d_follow(struct dentry *dentry) {
+
+	/*While the dentry is a mount point, focus on the mounted root;*/
+	while (dentry->d_mount) {
+		dentry = dentry->d_mount;
+	}
+
+	/*Return the last dentry;*/
+	return dentry;
+
+}
+
+
+/**
+ * d_lookup : resolves a child of a positive directory dentry;
+ *
+ * 	The cache is searched first. If the name is not cached, the file system is asked, and the result is cached as a
+ * 	positive or as a negative dentry. A negative dentry becomes the most recently used, and the least recently used
+ * 	ones are deleted if there are too many;
+ *
+ * @param dir : the directory dentry, already followed;
+ * @param name : the name of the child;
+ * @return the child dentry, that can be negative, or 0 if the kernel heap is full;
+ */
+
+static struct dentry *d_lookup(struct dentry *const dir, const char *const name) {
+
+	/*Search the child in the cache;*/
+	struct dentry *dentry = nindex_get(&dir->d_children, name);
+
+	/*If it is cached, positive or negative, return it;*/
+	if (dentry) {
+
+		/*If it is negative, it becomes the most recently used;*/
+		if (!dentry->d_inode) {
+			d_negative_use(dentry);
+		}
+
+		return dentry;
+
+	}
+
+	/*Cache the lookup operation;*/
+	struct inode *(*const lookup)(struct inode *, const char *) = dir->d_inode->i_ops->lookup;
+
+	/*Ask the file system, if the inode is a directory;*/
+	struct inode *const inode = (lookup) ? (*lookup)(dir->d_inode, name) : 0;
+
+	/*Create the dentry, negative if the inode was not found;*/
+	dentry = d_create(dir, name, inode, dir->d_sb);
+
+	/*If the allocation failed, fail;*/
+	if (!dentry) {
+		return 0;
+	}
+
+	/*Cache the dentry. If it fails, delete it;*/
+	if (!nindex_add(&dir->d_children, name, dentry)) {
+		kfree(dentry);
+		return 0;
+	}
+
+	/*If the dentry is negative, link it as the most recently used, and bound the number of negative dentries;*/
+	if (!inode) {
+		d_negative_use(dentry);
+		d_negative_evict(dentry);
+	}
+
+	/*Return the dentry;*/
+	return dentry;
+
+}
+
+
+/*----------------------------------------------------- Path walk ------------------------------------------------------*/
+
+/**
+ * vfs_component : extracts the next component of a path;
+ *
+ * @param path : the path, positioned anywhere before the component;
+ * @param name : the buffer where to copy the component, of size VFS_NAME_MAX_LENGTH + 1. Empty if no component remains;
+ * @return the position after the component, or 0 if the component is too long;
+ */
+
+static const char *vfs_component(const char *path, char *const name) {
+
+	size_t length = 0;
+
+	/*Skip all separators;*/
+	while (*path == '/') {
+		path++;
+	}
+
+	/*Copy all characters until the next separator or the end of the path;*/
+	while ((*path) && (*path != '/')) {
+
+		/*If the component is too long, fail;*/
+		if (length == VFS_NAME_MAX_LENGTH) {
+			return 0;
+		}
+
+		/*Copy the character;*/
+		name[length++] = *(path++);
+
+	}
+
+	/*Terminate the component;*/
+	name[length] = 0;
+
+	/*Return the position after the component;*/
+	return path;
+
+}
+
+
+/**
+ * vfs_walk_parent : resolves all components of an absolute path but the last one;
+ *
+ * @param path : the absolute path to resolve;
+ * @param name : the buffer where to copy the last component, of size VFS_NAME_MAX_LENGTH + 1;
+ * @return the positive dentry, already followed, of the last component's directory, or 0 if it can't be resolved, or
+ * 	if the path has no component;
+ */
+
+static struct dentry *vfs_walk_parent(const char *path, char *const name) {
+
+	/*The buffer where to extract the next component;*/
+	char next[VFS_NAME_MAX_LENGTH + 1];
+
+	/*Start from the root;*/
+	struct dentry *dir = &vfs_root;
+
+	/*If the path is not absolute, fail;*/
+	if (*path != '/') {
+		return 0;
+	}
+
+	/*Extract the first component. If it is too long or absent, fail;*/
+	if ((!(path = vfs_component(path, name))) || (!*name)) {
+		return 0;
+	}
+
+	/*For each component :*/
+	while (1) {
+
+		/*Follow mounts;*/
+		dir = d_follow(dir);
+
+		/*If the directory is negative, fail;*/
+		if (!dir->d_inode) {
+			return 0;
+		}
+
+		/*Extract the next component. If it is too long, fail;*/
+		if (!(path = vfs_component(path, next))) {
+			return 0;
+		}
+
+		/*If the current component is the last one, @dir is its directory;*/
+		if (!*next) {
+			return dir;
+		}
+
+		/*Resolve the current component. If the heap is full, fail;*/
+		if (!(dir = d_lookup(dir, name))) {
+			return 0;
+		}
+
+		/*The next component becomes the current one;*/
+		memcpy(name, next, VFS_NAME_MAX_LENGTH + 1);
+
+	}
+
+}
+
+
+/**
+ * vfs_walk : resolves an absolute path. The last dentry is not followed, if it is a mount point;
+ *
+ * @param path : the absolute path to resolve;
+ * @return the dentry of the path, that can be negative, or 0 if the path can't be resolved;
+ */
+
+static struct dentry *vfs_walk(const char *const path) {
+
+	/*The buffer where to extract the last component;*/
+	char name[VFS_NAME_MAX_LENGTH + 1];
+
+	/*Cache the position after the first component;*/
+	const char *const end = vfs_component(path, name);
+
+	/*If the path is absolute and contains no component, it is the root;*/
+	if ((*path == '/') && (end) && (!*name)) {
+		return &vfs_root;
+	}
+
+	/*Resolve the last component's directory;*/
+	struct dentry *const dir = vfs_walk_parent(path, name);
+
+	/*If it can't be resolved, fail;*/
+	if (!dir) {
+		return 0;
+	}
+
+	/*Resolve the last component;*/
+	return d_lookup(dir, name);
+
+}
+
+
+/*------------------------------------------------- File system types --------------------------------------------------*/
+
+/*Register a file system type;*/
+bool vfs_register_fs(struct fs_type *const type) {
+
+	/*Add the type to the index;*/
+	return nindex_add(&fs_types, type->name, type);
+
+}
+
+
+/*Unregister a file system type;*/
+void vfs_unregister_fs(const char *const fs_name) {
+
+	/*Remove the type from the index;*/
+	nindex_remove(&fs_types, fs_name);
+
+}
+
+
+/*------------------------------------------------------- Mounts -------------------------------------------------------*/
+
+/**
+ * vfs_mount : creates a superblock of the required type, and mounts its root on the required directory;
+ *
+ * @param path : the absolute path of the mount point;
+ * @param fs_name : the name of the file system type;
+ * @param dev_name : the device, transmitted to the file system; Can be null;
+ * @return true if the file system was mounted;
+ */
+
+bool vfs_mount(const char *const path, const char *const fs_name, const char *const dev_name) {
+
+	/*Search for the file system type;*/
+	struct fs_type *const type = nindex_get(&fs_types, fs_name);
+
+	/*Resolve the mount point;*/
+	struct dentry *const point = vfs_walk(path);
+
+	/*If the type doesn't exist, if the mount point doesn't exist, or is already used, fail;*/
+	if ((!type) || (!point) || ((point != &vfs_root) && (!point->d_inode)) || (point->d_mount)) {
+		return false;
+	}
+
+	/*Allocate the mount struct;*/
+	struct fs_mnt *const mnt = kmalloc(sizeof(struct fs_mnt));
+
+	/*If the allocation failed, fail;*/
+	if (!mnt) {
+		return false;
+	}
+
+	/*Get the superblock;*/
+	struct superblock *const sb = (*(type->get_sb))(type, dev_name);
+
+	/*If the file system could not provide it, fail;*/
+	if (!sb) {
+		kfree(mnt);
+		return false;
+	}
+
+	/*Create the root dentry of the superblock, named as the mount point;*/
+	struct dentry *const root = d_create(point, point->d_name, sb->sb_inode, sb);
+
+	/*If the allocation failed, release the superblock and fail;*/
+	if (!root) {
+		(*(type->release_sb))(sb);
+		kfree(mnt);
+		return false;
+	}
+
+	/*Initialise the mount struct;*/
+	mnt->mnt_point = point;
+	mnt->mnt_sb = sb;
+
+	/*Complete the superblock;*/
+	sb->sb_root = root;
+	sb->sb_type = type;
+	sb->sb_mnt = mnt;
+	sb->sb_busy = 0;
+
+	/*The parent superblock can't be unmounted anymore;*/
+	if (point->d_sb) {
+		point->d_sb->sb_busy++;
+	}
+
+	/*Mount the root on the mount point;*/
+	point->d_mount = root;
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * vfs_unmount : releases the superblock mounted on a directory, and deletes its cached dentries;
+ *
+ * @param path : the absolute path of the mount point;
+ * @return true if the file system was unmounted, false if nothing is mounted, or if the file system is busy;
+ */
+
+bool vfs_unmount(const char *const path) {
+
+	/*Resolve the mount point, without following it;*/
+	struct dentry *const point = vfs_walk(path);
+
+	/*If nothing is mounted, fail;*/
+	if ((!point) || (!point->d_mount)) {
+		return false;
+	}
+
+	/*Cache the mounted root and its superblock;*/
+	struct dentry *const root = point->d_mount;
+	struct superblock *const sb = root->d_sb;
+
+	/*If resources are opened in the file system, or if file systems are mounted in it, fail;*/
+	if (sb->sb_busy) {
+		return false;
+	}
+
+	/*Cache the mount struct;*/
+	struct fs_mnt *const mnt = sb->sb_mnt;
+
+	/*Release the superblock. If the file system fails, stay mounted;*/
+	if (!(*(sb->sb_type->release_sb))(sb)) {
+		return false;
+	}
+
+	/*Unmount;*/
+	point->d_mount = 0;
+
+	/*The parent superblock is not used by the mount anymore;*/
+	if (point->d_sb) {
+		point->d_sb->sb_busy--;
+	}
+
+	/*Delete all dentries of the file system;*/
+	d_prune(root);
+
+	/*Delete the mount struct;*/
+	kfree(mnt);
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/*------------------------------------------------------ Resources -----------------------------------------------------*/
+
+/**
+ * vfs_create : creates a resource in an existing directory;
+ *
+ * @param path : the absolute path of the resource;
+ * @return true if the resource was created;
+ */
+
+bool vfs_create(const char *const path) {
+
+	/*The buffer where to extract the resource name;*/
+	char name[VFS_NAME_MAX_LENGTH + 1];
+
+	/*Resolve the directory;*/
+	struct dentry *const dir = vfs_walk_parent(path, name);
+
+	/*If the directory can't be resolved, or doesn't support creation, fail;*/
+	if ((!dir) || (!dir->d_inode->i_ops->create)) {
+		return false;
+	}
+
+	/*Resolve the resource;*/
+	struct dentry *const dentry = d_lookup(dir, name);
+
+	/*If the heap is full, or if the resource already exists, fail;*/
+	if ((!dentry) || (dentry->d_inode)) {
+		return false;
+	}
+
+	/*Create the inode;*/
+	struct inode *const inode = (*(dir->d_inode->i_ops->create))(dir->d_inode, name);
+
+	/*If the file system failed, fail;*/
+	if (!inode) {
+		return false;
+	}
+
+	/*The dentry becomes positive, and leaves the negative list;*/
+	d_negative_unlink(dentry);
+	dentry->d_inode = inode;
+	inode->i_dentry = dentry;
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * vfs_delete : deletes a resource, if it is not opened and not a mount point;
+ *
+ * @param path : the absolute path of the resource;
+ * @return true if the resource was deleted;
+ */
+
+bool vfs_delete(const char *const path) {
+
+	/*The buffer where to extract the resource name;*/
+	char name[VFS_NAME_MAX_LENGTH + 1];
+
+	/*Resolve the directory;*/
+	struct dentry *const dir = vfs_walk_parent(path, name);
+
+	/*If the directory can't be resolved, or doesn't support deletion, fail;*/
+	if ((!dir) || (!dir->d_inode->i_ops->unlink)) {
+		return false;
+	}
+
+	/*Resolve the resource;*/
+	struct dentry *const dentry = d_lookup(dir, name);
+
+	/*If the resource doesn't exist, is opened, or is a mount point, fail;*/
+	if ((!dentry) || (!dentry->d_inode) || (dentry->d_count) || (dentry->d_mount)) {
+		return false;
+	}
+
+	/*Delete the inode. If the file system fails, (non empty directory for ex) fail;*/
+	if (!(*(dir->d_inode->i_ops->unlink))(dir->d_inode, name, dentry->d_inode)) {
+		return false;
+	}
+
+	/*The file system accepted the deletion, so cached children are negative. Delete them;*/
+	nindex_clear(&dentry->d_children, &d_prune);
+
+	/*The dentry becomes negative, and the most recently used one. Bound the number of negative dentries;*/
+	dentry->d_inode = 0;
+	d_negative_use(dentry);
+	d_negative_evict(dentry);
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * vfs_open : resolves a resource, and asks its file system to open it;
+ *
+ * @param path : the absolute path of the resource;
+ * @return the opened resource, or 0 if it doesn't exist or can't be opened;
+ */
+
+struct resrc *vfs_open(const char *const path) {
+
+	/*Resolve the resource;*/
+	struct dentry *dentry = vfs_walk(path);
+
+	/*If the path can't be resolved, fail;*/
+	if (!dentry) {
+		return 0;
+	}
+
+	/*If the resource is a mount point, open the mounted root;*/
+	dentry = d_follow(dentry);
+
+	/*If the resource doesn't exist or can't be opened, fail;*/
+	if ((!dentry->d_inode) || (!dentry->d_inode->i_ops->open)) {
+		return 0;
+	}
+
+	/*Open the resource;*/
+	struct resrc *const rd = (*(dentry->d_inode->i_ops->open))(dentry->d_inode);
+
+	/*If the file system failed, fail;*/
+	if (!rd) {
+		return 0;
+	}
+
+	/*Link the resource to its dentry;*/
+	rd->res_dentry = dentry;
+
+	/*The dentry and its file system are now busy;*/
+	dentry->d_count++;
+	dentry->d_sb->sb_busy++;
+
+	/*Return the resource;*/
+	return rd;
+
+}
+
+
+/**
+ * vfs_close : closes a resource opened by vfs_open;
+ *
+ * @param rd : the resource to close;
+ */
+
+void vfs_close(struct resrc *const rd) {
+
+	/*Cache the dentry;*/
+	struct dentry *const dentry = rd->res_dentry;
+
+	/*Close the resource. The file system deletes it;*/
+	if (rd->res_ops->close) {
+		(*(rd->res_ops->close))(rd);
+	}
+
+	/*The dentry and its file system are released;*/
+	dentry->d_count--;
+	dentry->d_sb->sb_busy--;
+
+}
+
+
+/*Read from a resource;*/
+size_t vfs_read(struct resrc *const rd, void *const dst, const size_t size) {
+
+	/*Cache the operation;*/
+	size_t (*const read)(struct resrc *, void *, size_t) = rd->res_ops->read;
+
+	/*Read if the resource supports it;*/
+	return (read) ? (*read)(rd, dst, size) : 0;
+
+}
+
+
+/*Write in a resource;*/
+size_t vfs_write(struct resrc *const rd, const void *const src, const size_t size) {
+
+	/*Cache the operation;*/
+	size_t (*const write)(struct resrc *, const void *, size_t) = rd->res_ops->write;
+
+	/*Write if the resource supports it;*/
+	return (write) ? (*write)(rd, src, size) : 0;
+
+}
+
+
+/*Move the position in a resource;*/
+bool vfs_seek(struct resrc *const rd, const size_t offset) {
+
+	/*Cache the operation;*/
+	bool (*const seek)(struct resrc *, size_t) = rd->res_ops->seek;
+
+	/*Seek if the resource supports it;*/
+	return (seek) && ((*seek)(rd, offset));
+
+}
@@ -0,0 +1,50 @@
+/*
+  flash.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "flash.h"
+
+
+/*----------------------------------------------- Neutral flash if ----------------------------------------------*/
+
+
+/*Dumb functions;*/
+static bool n_b() {return false;}
+static bool n_f() {return true;}
+static bool n_e(size_t s) {return false;}
+static bool n_p(size_t o, const uint8_t *p) {return false;}
+
+
+/*
+ * The neutral flash if can be written safely on any flash if. It will prevent access to previous
+ * 	functions, without causing null pointer access. Commands always fail;
+ */
+
+const struct flash_if neutral_flash_if = {
+	.memory = 0,
+	.sector_size = 0,
+	.phrase_size = 0,
+	.nb_sectors = 0,
+
+	.busy = n_b,
+	.failed = n_f,
+	.erase = n_e,
+	.program = n_p,
+
+};
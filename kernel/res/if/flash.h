@@ -0,0 +1,88 @@
+/*
+  flash.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef TRACER_FLASH_H
+#define TRACER_FLASH_H
+
+#include "stdint.h"
+
+#include "stdbool.h"
+
+#include "stddef.h"
+
+#include "iface.h"
+
+
+/*--------------------------------------------------- Flash if ---------------------------------------------------*/
+
+/*
+ * A flash if gives access to a flash memory area, memory mapped for reads;
+ *
+ * 	Erase and program commands are only launched : they complete in the background, while the caller can keep on
+ * 	working. A single command can be executed at a time, and the flash area must not be read while a command is
+ * 	executing;
+ *
+ * 	An erased flash reads 0xFF. A phrase can only be programmed once between two erases of its sector;
+ */
+
+struct flash_if {
+
+	/*
+	 * Data
+	 */
+
+	/*The memory mapped flash area;*/
+	const volatile uint8_t *const memory;
+
+	/*The size of a sector, the erase unit;*/
+	const size_t sector_size;
+
+	/*The size of a phrase, the program unit;*/
+	const size_t phrase_size;
+
+	/*The number of sectors of the area;*/
+	const size_t nb_sectors;
+
+
+	/*
+	 * Functions
+	 */
+
+	/*Is a command executing ?*/
+	bool (*const busy)();
+
+	/*Did the last command fail ?*/
+	bool (*const failed)();
+
+	/*Launch the erase of a sector. Fails if a command is executing;*/
+	bool (*const erase)(size_t sector);
+
+	/*Launch the program of a phrase, at a phrase aligned offset. Fails if a command is executing;*/
+	bool (*const program)(size_t offset, const uint8_t *phrase);
+
+};
+
+
+/*The flash lib includes a neutral flash if, so that flash drivers can prevent access to their functions;*/
+extern const struct flash_if neutral_flash_if;
+
+
+#endif /*TRACER_FLASH_H*/
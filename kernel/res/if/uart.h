@@ -104,6 +104,21 @@ struct UART_config_t {
 	/*The maximal number of frames stored by the if;*/
 	size_t nb_frames;
 
+	/*The number of free rx frames under which reception is paused; Requires rts_enabled. 0 disables it;*/
+	size_t rx_watermark;
+
+	/*Set if frames are drawn from the shared frame pool, instead of being allocated for the if only;*/
+	bool shared_frames;
+
+	/*The number of frames reserved per direction if frames are shared. nb_frames is then the cap;*/
+	size_t min_frames;
+
+	/*Set if data is transferred by DMA instead of by interrupts. The start fails if the hardware does not support it;*/
+	bool dma_enabled;
+
+	/*Set if the rx FIFO watermark adapts to traffic, the idle line flushing the end of frames. Ignored with DMA;*/
+	bool adaptive_watermark;
+
 };
 
 
@@ -119,6 +134,11 @@ struct UART_config_t {
 			.framer = (_framer),\
 			.max_frame_size = 100, \
 			.nb_frames = 5,\
+			.rx_watermark = 0,\
+			.shared_frames = false,\
+			.min_frames = 0,\
+			.dma_enabled = false,\
+			.adaptive_watermark = false,\
     	}
 
 
@@ -7,6 +7,8 @@
 
 
 #include <kernel/hard/ram.h>
+#include <kernel/core/ram.h>
+#include <stdmem.h>
 #include <panic.h>
 #include <kernel/hard/debug/printk.h>
 
@@ -26,14 +28,53 @@
 #endif
 
 
-/*---------------------------------------------------- Kernel heap -----------------------------------------------------*/
+/*The number of fully free frames the heap keeps before returning frames to the RAM manager;*/
+#if !defined(KDM_SPARE_FRAMES)
+
+#define KDM_SPARE_FRAMES 1
+
+#endif
+
+
+/*------------------------------------------------------- Arenas -------------------------------------------------------*/
+
+/*
+ * The kernel heap is composed of arenas. The first one is the KDM_SIZE block allocated at init, and is never
+ * 	released. When all arenas are full, a RAM frame is allocated, and a new arena is created inside it.
+ *
+ * 	A frame arena's descriptor is stored at the start of the frame, its heap using the rest of the frame;
+ *
+ * 	When a frame arena contains no more blocks, it is returned to the RAM manager, unless the heap already keeps
+ * 	KDM_SPARE_FRAMES empty frames, to avoid allocating and freeing the same frame repeatedly;
+ */
+
+struct kdm_arena {
+
+	/*The next arena; Null for the last one;*/
+	struct kdm_arena *next;
 
-/*The kernel heap head;*/
-static struct heap_head *kernel_heap;
+	/*The arena's heap;*/
+	struct heap_head *heap;
+
+	/*The bounds of the arena, to find the arena of a block;*/
+	const uint8_t *min;
+	const uint8_t *max;
+
+	/*The number of blocks allocated in the arena;*/
+	size_t nb_blocks;
+
+};
 
 
 /*---------------------------------------------------- Kernel heap -----------------------------------------------------*/
 
+/*The first arena, that owns the init block;*/
+static struct kdm_arena first_arena;
+
+/*The kernel heap statistics;*/
+static struct kdm_stats stats;
+
+
 /**
  * kernel_memory_init : initialises the kernel heap;
  *
@@ -45,8 +86,15 @@ void kdmem_init() {
 	/*Allocate some memory in the RAM to contain the heap;*/
 	void *ram_block = ram_alloc(KDM_SIZE);
 	
-	/*Create a heap owning the whole RAM block;*/
-	kernel_heap = heap_create(ram_block, KDM_SIZE, &heap_fifo_insertion);/*TODO SORTED INSERTION;*/
+	/*Initialise the first arena, owning the whole RAM block;*/
+	first_arena.next = 0;
+	first_arena.heap = heap_create(ram_block, KDM_SIZE, &heap_fifo_insertion);/*TODO SORTED INSERTION;*/
+	first_arena.min = ram_block;
+	first_arena.max = (uint8_t *) ram_block + KDM_SIZE;
+	first_arena.nb_blocks = 0;
+	
+	/*Reset statistics;*/
+	memset(&stats, 0, sizeof(struct kdm_stats));
 	
 	/*Log;*/
 	printk("kernel dynamic memory initialised\n\r");
@@ -54,18 +102,173 @@ void kdmem_init() {
 }
 
 
+/**
+ * kdmem_grow : allocates a RAM frame, and creates an arena in it, appended to the arena list;
+ *
+ * 	The upper RAM region is used first, to leave the lower one to hot code and data;
+ *
+ * @return the new arena, or 0 if no frame is available;
+ */
+
+static struct kdm_arena *kdmem_grow() {
+	
+	/*Cache the frame size;*/
+	const size_t frame_size = ram_frame_size();
+	
+	struct kdm_arena *arena, *last;
+	
+	/*Attempt to allocate a frame in both regions;*/
+	uint8_t *frame = ram_alloc_frame_region(RAM_REGION_UPPER);
+	if (!frame) {
+		frame = ram_alloc_frame_region(RAM_REGION_LOWER);
+	}
+	
+	/*If no frame is available, fail;*/
+	if (!frame) {
+		return 0;
+	}
+	
+	/*The descriptor is located at the start of the frame;*/
+	arena = (struct kdm_arena *) frame;
+	
+	/*Initialise the arena, its heap owning the rest of the frame;*/
+	arena->next = 0;
+	arena->heap = heap_create(arena + 1, frame_size - sizeof(struct kdm_arena), &heap_fifo_insertion);
+	arena->min = frame;
+	arena->max = frame + frame_size;
+	arena->nb_blocks = 0;
+	
+	/*Append the arena to the list;*/
+	for (last = &first_arena; last->next; last = last->next);
+	last->next = arena;
+	
+	/*Update statistics;*/
+	stats.nb_frames++;
+	stats.nb_grows++;
+	if (stats.nb_frames > stats.peak_frames) {
+		stats.peak_frames = stats.nb_frames;
+	}
+	
+	/*Return the new arena;*/
+	return arena;
+	
+}
+
+
+/**
+ * kdmem_shrink : removes an empty frame arena from the list and returns its frame, if the heap already keeps enough
+ * 	empty frames;
+ *
+ * @param arena : the empty arena;
+ */
+
+static void kdmem_shrink(struct kdm_arena *const arena) {
+	
+	struct kdm_arena *prev, *tmp;
+	
+	/*The number of empty frames, the provided one included;*/
+	size_t nb_empty = 0;
+	
+	/*Count empty frame arenas;*/
+	for (tmp = first_arena.next; tmp; tmp = tmp->next) {
+		if (!tmp->nb_blocks) {
+			nb_empty++;
+		}
+	}
+	
+	/*If the heap doesn't keep enough spare frames, keep this one;*/
+	if (nb_empty <= KDM_SPARE_FRAMES) {
+		return;
+	}
+	
+	/*Find the arena's predecessor;*/
+	for (prev = &first_arena; prev->next != arena; prev = prev->next);
+	
+	/*Remove the arena from the list;*/
+	prev->next = arena->next;
+	
+	/*Return the frame;*/
+	ram_free_frame((void *) arena->min);
+	
+	/*Update statistics;*/
+	stats.nb_frames--;
+	stats.nb_shrinks++;
+	
+}
+
+
+/**
+ * kdmem_register : updates the arena and the statistics after a successful allocation;
+ *
+ * @param arena : the arena where the block was allocated;
+ * @param block : the allocated block;
+ * @return the block;
+ */
+
+static void *kdmem_register(struct kdm_arena *const arena, void *const block) {
+	
+	/*Update the arena's block count;*/
+	arena->nb_blocks++;
+	
+	/*Update statistics;*/
+	stats.nb_blocks++;
+	if (stats.nb_blocks > stats.peak_blocks) {
+		stats.peak_blocks = stats.nb_blocks;
+	}
+	
+	/*Return the block;*/
+	return block;
+	
+}
+
+
 /*--------------------------------------------------- Dynamic memory ---------------------------------------------------*/
 
 /**
  * kmalloc : allocates and return a block of memory in the kernel heap;
  *
- * @return the lowest address of the allocated block;
+ * 	Arenas are tried in order; If all are full, the heap grows by one frame;
+ *
+ * @return the lowest address of the allocated block, or 0 if the allocation failed;
  */
 
 void *kmalloc(size_t size) {
 	
-	/*If the kernel heap is not initialised*/
-	return heap_malloc(kernel_heap, size);
+	struct kdm_arena *arena;
+	void *block;
+	
+	/*For each arena :*/
+	for (arena = &first_arena; arena; arena = arena->next) {
+		
+		/*Attempt to allocate in the arena;*/
+		block = heap_malloc(arena->heap, size);
+		
+		/*If the allocation succeeded, register and return the block;*/
+		if (block) {
+			return kdmem_register(arena, block);
+		}
+		
+	}
+	
+	/*All arenas are full; Grow the heap;*/
+	arena = kdmem_grow();
+	
+	/*If the heap can't grow, fail;*/
+	if (!arena) {
+		return 0;
+	}
+	
+	/*Attempt to allocate in the new arena;*/
+	block = heap_malloc(arena->heap, size);
+	
+	/*If the block doesn't fit in a frame, release the frame and fail;*/
+	if (!block) {
+		kdmem_shrink(arena);
+		return 0;
+	}
+	
+	/*Register and return the block;*/
+	return kdmem_register(arena, block);
 	
 }
 
@@ -78,8 +281,16 @@ void *kmalloc(size_t size) {
 
 void *kcalloc(size_t size) {
 	
-	/*If the kernel heap is not initialise*/
-	return heap_malloc(kernel_heap, size);
+	/*Allocate the block;*/
+	void *block = kmalloc(size);
+	
+	/*If the allocation succeeded, zero the block;*/
+	if (block) {
+		memset(block, 0, size);
+	}
+	
+	/*Return the block;*/
+	return block;
 	
 }
 
@@ -92,8 +303,16 @@ void *kcalloc(size_t size) {
 
 void *kialloc(size_t size, const void *init) {
 	
-	/*If the kernel heap is not initialise*/
-	return heap_ialloc(kernel_heap, size, init);
+	/*Allocate the block;*/
+	void *block = kmalloc(size);
+	
+	/*If the allocation succeeded, initialise the block;*/
+	if (block) {
+		memcpy(block, init, size);
+	}
+	
+	/*Return the block;*/
+	return block;
 	
 }
 
@@ -101,12 +320,61 @@ void *kialloc(size_t size, const void *init) {
 /**
  * kfree : frees the block of memory referenced by @ptr in the kernel heap;
  *
- * @param ptr : the lowest address of the block's data part;
+ * 	If the block was the last one of a frame arena, the frame may be returned to the RAM manager;
+ *
+ * @param ptr : the lowest address of the block's data part. Null pointers are ignored;
  */
 
 void kfree(void *ptr) {
 	
-	/*If the kernel heap is not initialise*/
-	heap_free(kernel_heap, ptr);
+	struct kdm_arena *arena;
+	
+	/*If the pointer is null, nothing to free;*/
+	if (!ptr) {
+		return;
+	}
+	
+	/*Find the arena that contains the block;*/
+	for (arena = &first_arena; arena; arena = arena->next) {
+		if (((uint8_t *) ptr >= arena->min) && ((uint8_t *) ptr < arena->max)) {
+			break;
+		}
+	}
+	
+	/*If no arena contains the block :*/
+	if (!arena) {
+		
+		/*Panic, the block was not allocated in the kernel heap;*/
+		kernel_panic("kdmem.c : kfree : block out of the kernel heap;");
+		
+	}
+	
+	/*Free the block in its arena;*/
+	heap_free(arena->heap, ptr);
+	
+	/*Update the arena's block count and statistics;*/
+	arena->nb_blocks--;
+	stats.nb_blocks--;
+	
+	/*If the arena is a frame arena, and is now empty, attempt to return its frame;*/
+	if ((arena != &first_arena) && (!arena->nb_blocks)) {
+		kdmem_shrink(arena);
+	}
 	
-}
\ No newline at end of file
+}
+
+
+/*----------------------------------------------------- Statistics -----------------------------------------------------*/
+
+/**
+ * kdmem_get_stats : copies the kernel heap statistics in @dst;
+ *
+ * @param dst : the location where to copy statistics;
+ */
+
+void kdmem_get_stats(struct kdm_stats *const dst) {
+	
+	/*Copy statistics;*/
+	memcpy(dst, &stats, sizeof(struct kdm_stats));
+	
+}
@@ -24,7 +24,10 @@
 
 #include <std/syscall.h>
 
+#include "fs/iinode.h"
+
 #include <kernel/exec/sched.h>
+#include <kernel/exec/fdt.h>
 #include <kernel/debug/printk.h>
 #include <kernel/debug/debug.h>
 
@@ -36,12 +39,42 @@
 
 static size_t sysh_open(const char *pathname) {
 	
-	return 0;/*TODO*/
+	/*Open the file;*/
+	const file_descriptor file = fs_open(pathname);
+	
+	/*If the file doesn't exist or is already opened, fail;*/
+	if (!file) {
+		return FDT_INVALID;
+	}
+	
+	/*Reference the file in the process's descriptor table;*/
+	const size_t fd = fdt_add(sched_get_fdt(), file);
+	
+	/*If the table is full, close the file;*/
+	if (fd == FDT_INVALID) {
+		fs_close(file);
+	}
+	
+	/*Return the descriptor;*/
+	return fd;
+	
 }
 
 size_t sysh_close(size_t fd) {
 	
-	return 0;/*TODO*/
+	/*Release the descriptor;*/
+	const file_descriptor file = fdt_remove(sched_get_fdt(), fd);
+	
+	/*If the descriptor is invalid, fail;*/
+	if (!file) {
+		return FDT_INVALID;
+	}
+	
+	/*Close the file;*/
+	fs_close(file);
+	
+	/*Complete;*/
+	return 0;
 	
 }
 
@@ -66,8 +99,16 @@ size_t sysh_write(size_t fd, const void *buffer, size_t size){
 
 size_t sysh_interface(size_t fd, void *if_struct, size_t struct_size) {
 	
-	return 0;/*TODO*/
+	/*Validate the descriptor and get the file;*/
+	const file_descriptor file = fdt_get(sched_get_fdt(), fd);
+	
+	/*If the descriptor is invalid, fail;*/
+	if (!file) {
+		return false;
+	}
 	
+	/*Interface with the file;*/
+	return iop_interface(file, if_struct, struct_size);
 	
 }
 
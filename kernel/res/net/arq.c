@@ -0,0 +1,632 @@
+/*
+  arq.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "arq.h"
+
+#include <string.h>
+
+#include "std/syscall.h"
+
+#include <kernel/exec/sysclock.h>
+
+
+/*Frame types;*/
+#define ARQ_DATA 0
+#define ARQ_ACK 1
+
+
+/*------------------------------------------------- Creation - Deletion ------------------------------------------------*/
+
+/**
+ * arq_create_slots : allocates a slot array, and a payload block per slot;
+ *
+ * @param window : the number of slots;
+ * @param max_payload : the size of each block;
+ * @return the slot array;
+ */
+
+static struct arq_slot *arq_create_slots(const uint8_t window, const size_t max_payload) {
+
+	/*Allocate the array;*/
+	struct arq_slot *const slots = kernel_malloc(window * sizeof(struct arq_slot));
+
+	/*Initialise each slot;*/
+	for (uint8_t i = 0; i < window; i++) {
+		slots[i].block = data_block_create(max_payload);
+		slots[i].used = false;
+		slots[i].acked = false;
+		slots[i].sent_time = 0;
+		slots[i].retransmitted = false;
+		slots[i].unsent = false;
+	}
+
+	/*Return the array;*/
+	return slots;
+
+}
+
+
+/**
+ * arq_delete_slots : deletes the payload blocks of a slot array, and the array;
+ *
+ * @param slots : the slot array;
+ * @param window : the number of slots;
+ */
+
+static void arq_delete_slots(struct arq_slot *const slots, const uint8_t window) {
+
+	/*Delete each block;*/
+	for (uint8_t i = 0; i < window; i++) {
+		data_block_delete(slots[i].block);
+	}
+
+	/*Free the array;*/
+	kernel_free(slots);
+
+}
+
+
+/**
+ * arq_create : creates an ARQ over @iface;
+ *
+ * 	The window must be a power of two, so that slots can be indexed by sequence numbers, and can't exceed
+ * 	ARQ_MAX_WINDOW. Both ends must use the same window;
+ *
+ * 	Interface frames must contain the header and the maximal payload, besides the trailer the framer reserves;
+ *
+ * @param iface : the interface to exchange frames on. No protocol must be attached;
+ * @param window : the window size;
+ * @param max_payload : the maximal size of a payload;
+ * @return the created ARQ;
+ */
+
+struct arq *arq_create(struct netf2 *const iface, const uint8_t window, const size_t max_payload) {
+
+	/*If the window is invalid :*/
+	if ((!window) || (window > ARQ_MAX_WINDOW) || (window & (window - 1))) {
+
+		/*Error;*/
+		kernel_error("arq.c : arq_create : the window must be a power of two, lesser than ARQ_MAX_WINDOW;");
+
+	}
+
+	/*If a protocol already consumes received frames :*/
+	if (iface->protocol) {
+
+		/*Error;*/
+		kernel_error("arq.c : arq_create : a protocol is attached to the interface;");
+
+	}
+
+	/*If interface frames can't contain the header and the maximal payload :*/
+	if (netf2_tx_capacity(iface) < ARQ_HEADER_SIZE + max_payload) {
+
+		/*Error;*/
+		kernel_error("arq.c : arq_create : interface frames are too small;");
+
+	}
+
+	/*Create the initializer;*/
+	struct arq init = {
+
+		/*Save the interface and the window;*/
+		.iface = iface,
+		.window = window,
+
+		/*Nothing sent;*/
+		.tx_base = 0,
+		.tx_next = 0,
+		.tx_slots = arq_create_slots(window, max_payload),
+
+		/*Nothing received;*/
+		.rx_base = 0,
+		.rx_slots = arq_create_slots(window, max_payload),
+		.ack_pending = false,
+
+		/*No round trip measured;*/
+		.srtt_8 = 0,
+		.rttvar_4 = 0,
+		.rtt_valid = false,
+		.rto = ARQ_INITIAL_RTO,
+
+		/*No traffic;*/
+		.nb_sent = 0,
+		.nb_retransmitted = 0,
+		.nb_delivered = 0,
+		.nb_duplicates = 0,
+
+	};
+
+	/*Allocate, initialise and return the ARQ;*/
+	return kernel_malloc_copy(sizeof(struct arq), &init);
+
+}
+
+
+/**
+ * arq_delete : deletes an ARQ and its payloads. The interface is not deleted;
+ *
+ * @param arq : the ARQ to delete;
+ */
+
+void arq_delete(struct arq *const arq) {
+
+	/*Delete both slot arrays;*/
+	arq_delete_slots(arq->tx_slots, arq->window);
+	arq_delete_slots(arq->rx_slots, arq->window);
+
+	/*Free the ARQ;*/
+	kernel_free(arq);
+
+}
+
+
+/*------------------------------------------------------- Frames -------------------------------------------------------*/
+
+/**
+ * arq_slot : returns the slot of a sequence number;
+ *
+ * @param arq : the ARQ;
+ * @param slots : the slot array;
+ * @param seq : the sequence number;
+ * @return the slot;
+ */
+
+static inline struct arq_slot *arq_slot(const struct arq *const arq, struct arq_slot *const slots, const uint8_t seq) {
+
+	/*The window is a power of two;*/
+	return slots + (seq & (arq->window - 1));
+
+}
+
+
+/**
+ * arq_rx_bitmap : determines the selective acknowledgement bitmap : bit i is set if the frame rx_base + i was
+ * 	received and not delivered yet;
+ *
+ * @param arq : the ARQ;
+ * @return the bitmap;
+ */
+
+static uint16_t arq_rx_bitmap(const struct arq *const arq) {
+
+	uint16_t bitmap = 0;
+
+	/*For each frame in the receiver window, set its bit if it was received;*/
+	for (uint8_t i = 0; i < arq->window; i++) {
+		if (arq_slot(arq, arq->rx_slots, (uint8_t) (arq->rx_base + i))->used) {
+			bitmap |= (uint16_t) (1 << i);
+		}
+	}
+
+	/*Return the bitmap;*/
+	return bitmap;
+
+}
+
+
+/**
+ * arq_transmit : borrows an interface frame, writes the header and the payload, and commits it. The receiver state
+ * 	is sent with the frame, no acknowledgement is pending anymore;
+ *
+ * @param arq : the ARQ;
+ * @param type : the frame type;
+ * @param seq : the sequence number of a data frame;
+ * @param payload : the payload of a data frame, 0 for an acknowledgement;
+ * @return true if the frame was committed, false if no interface frame was available;
+ */
+
+static bool arq_transmit(struct arq *const arq, const uint8_t type, const uint8_t seq,
+						 const struct data_block *const payload) {
+
+	/*Borrow a frame;*/
+	struct data_block *const frame = netf2_borrow_tx_frame(arq->iface);
+
+	/*If none is available, fail;*/
+	if (!frame) {
+		return false;
+	}
+
+	/*Determine the payload size. arq_create verified that frames can contain the header and any payload;*/
+	const size_t size = (payload) ? payload->size : 0;
+
+	/*Cache the header and the bitmap;*/
+	uint8_t *const header = frame->address;
+	const uint16_t bitmap = arq_rx_bitmap(arq);
+
+	/*Write the header;*/
+	header[0] = type;
+	header[1] = seq;
+	header[2] = arq->rx_base;
+	header[3] = (uint8_t) bitmap;
+	header[4] = (uint8_t) (bitmap >> 8);
+
+	/*Copy the payload;*/
+	if (size) {
+		memcpy(header + ARQ_HEADER_SIZE, payload->address, size);
+	}
+
+	/*Update the frame size;*/
+	frame->size = ARQ_HEADER_SIZE + size;
+
+	/*Commit the frame. If it leaves no space for the framer's trailer, it is cancelled, fail;*/
+	if (!netf2_commit_tx_frame(arq->iface, frame)) {
+		return false;
+	}
+
+	/*The peer knows the receiver state;*/
+	arq->ack_pending = false;
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/*-------------------------------------------------- Round trip time ---------------------------------------------------*/
+
+/**
+ * arq_sample_rtt : updates the round trip estimation with a sample, and recomputes the timeout;
+ *
+ * 	Jacobson / Karels : rto = srtt + 4 * rttvar, with srtt and rttvar smoothed with gains 1/8 and 1/4;
+ *
+ * @param arq : the ARQ;
+ * @param rtt : the measured round trip time;
+ */
+
+static void arq_sample_rtt(struct arq *const arq, const uint32_t rtt) {
+
+	/*If no sample was taken yet :*/
+	if (!arq->rtt_valid) {
+
+		/*Initialise, rttvar is half of the first sample;*/
+		arq->srtt_8 = rtt << 3;
+		arq->rttvar_4 = rtt << 1;
+		arq->rtt_valid = true;
+
+	} else {
+
+		/*Update the smoothed round trip time;*/
+		int32_t delta = (int32_t) rtt - (int32_t) (arq->srtt_8 >> 3);
+		arq->srtt_8 += delta;
+
+		/*Update the variation;*/
+		if (delta < 0) {
+			delta = -delta;
+		}
+		delta -= (int32_t) (arq->rttvar_4 >> 2);
+		arq->rttvar_4 += delta;
+
+	}
+
+	/*Determine the timeout;*/
+	uint32_t rto = (arq->srtt_8 >> 3) + arq->rttvar_4;
+
+	/*Bound the timeout;*/
+	if (rto < ARQ_MIN_RTO) {
+		rto = ARQ_MIN_RTO;
+	} else if (rto > ARQ_MAX_RTO) {
+		rto = ARQ_MAX_RTO;
+	}
+
+	/*Save the timeout;*/
+	arq->rto = rto;
+
+}
+
+
+/*------------------------------------------------------- Sender -------------------------------------------------------*/
+
+/**
+ * arq_send : copies a payload in the next sender slot and transmits it. If no interface frame is available, the
+ * 	payload is marked unsent, and the next poll transmits it for the first time;
+ *
+ * @param arq : the ARQ;
+ * @param data : the payload;
+ * @param size : the payload size;
+ * @return false if the window is full;
+ */
+
+bool arq_send(struct arq *const arq, const void *const data, const size_t size) {
+
+	/*If the window is full, fail;*/
+	if (arq_window_full(arq)) {
+		return false;
+	}
+
+	/*Cache the slot;*/
+	struct arq_slot *const slot = arq_slot(arq, arq->tx_slots, arq->tx_next);
+
+	/*If the payload is too big :*/
+	if (size > slot->block->max_size) {
+
+		/*Error;*/
+		kernel_error("arq.c : arq_send : payload too big;");
+
+	}
+
+	/*Copy the payload;*/
+	memcpy(slot->block->address, data, size);
+	slot->block->size = size;
+
+	/*The slot is used, not acknowledged, and not retransmitted;*/
+	slot->used = true;
+	slot->acked = false;
+	slot->retransmitted = false;
+
+	/*Transmit the payload. If it fails, the next poll will send it;*/
+	slot->unsent = !arq_transmit(arq, ARQ_DATA, arq->tx_next, slot->block);
+	slot->sent_time = sysclock_milliseconds();
+
+	/*Update the sequence number and the counter;*/
+	arq->tx_next++;
+	arq->nb_sent++;
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * arq_release : marks a sender slot acknowledged. A round trip is sampled if the payload was not retransmitted;
+ *
+ * @param arq : the ARQ;
+ * @param seq : the acknowledged sequence number;
+ * @param now : the current time;
+ */
+
+static void arq_release(struct arq *const arq, const uint8_t seq, const uint32_t now) {
+
+	/*Cache the slot;*/
+	struct arq_slot *const slot = arq_slot(arq, arq->tx_slots, seq);
+
+	/*If the slot was already acknowledged, nothing to do;*/
+	if (slot->acked) {
+		return;
+	}
+
+	/*Karn : retransmitted payloads give ambiguous samples;*/
+	if (!slot->retransmitted) {
+		arq_sample_rtt(arq, now - slot->sent_time);
+	}
+
+	/*The slot is acknowledged;*/
+	slot->acked = true;
+
+}
+
+
+/**
+ * arq_acknowledge : processes the receiver state of the peer : frames before @ack are released, and the window
+ * 	slides. Frames selectively acknowledged are not retransmitted anymore, but the window can't slide over them
+ * 	before the peer delivers them;
+ *
+ * @param arq : the ARQ;
+ * @param ack : the next sequence number the peer will deliver;
+ * @param bitmap : the selective acknowledgement bitmap;
+ * @param now : the current time;
+ */
+
+static void arq_acknowledge(struct arq *const arq, const uint8_t ack, const uint16_t bitmap, const uint32_t now) {
+
+	/*Cache the number of frames in flight;*/
+	const uint8_t in_flight = (uint8_t) (arq->tx_next - arq->tx_base);
+
+	/*If the acknowledgement is outside of the window, it is stale, ignore it;*/
+	if ((uint8_t) (ack - arq->tx_base) > in_flight) {
+		return;
+	}
+
+	/*Release all frames before @ack, and slide the window;*/
+	while (arq->tx_base != ack) {
+		arq_release(arq, arq->tx_base, now);
+		arq_slot(arq, arq->tx_slots, arq->tx_base++)->used = false;
+	}
+
+	/*Mark selectively acknowledged frames in flight;*/
+	for (uint8_t i = 0; i < arq->window; i++) {
+
+		/*Cache the sequence number;*/
+		const uint8_t seq = (uint8_t) (ack + i);
+
+		/*If the frame is acknowledged and in flight, mark it;*/
+		if ((bitmap & (1 << i)) && ((uint8_t) (seq - arq->tx_base) < (uint8_t) (arq->tx_next - arq->tx_base))) {
+			arq_release(arq, seq, now);
+		}
+
+	}
+
+}
+
+
+/*------------------------------------------------------ Receiver ------------------------------------------------------*/
+
+/**
+ * arq_receive : processes a received frame : its receiver state, and its payload if it is a data frame;
+ *
+ * @param arq : the ARQ;
+ * @param frame : the received frame;
+ * @param now : the current time;
+ */
+
+static void arq_receive(struct arq *const arq, const struct data_block *const frame, const uint32_t now) {
+
+	/*Cache the header;*/
+	const uint8_t *const header = frame->address;
+
+	/*Frames without header are ignored;*/
+	if (frame->size < ARQ_HEADER_SIZE) {
+		return;
+	}
+
+	/*Process the peer's receiver state;*/
+	arq_acknowledge(arq, header[2], (uint16_t) (header[3] | (header[4] << 8)), now);
+
+	/*Acknowledgements carry no payload;*/
+	if (header[0] != ARQ_DATA) {
+		return;
+	}
+
+	/*Cache the sequence number and the payload size;*/
+	const uint8_t seq = header[1];
+	const size_t size = frame->size - ARQ_HEADER_SIZE;
+
+	/*The peer must be informed of the new receiver state;*/
+	arq->ack_pending = true;
+
+	/*Cache the slot;*/
+	struct arq_slot *const slot = arq_slot(arq, arq->rx_slots, seq);
+
+	/*If the frame is outside of the window, or already received, it is a duplicate;*/
+	if (((uint8_t) (seq - arq->rx_base) >= arq->window) || (slot->used)) {
+		arq->nb_duplicates++;
+		return;
+	}
+
+	/*Oversized payloads are ignored, and will be retransmitted in vain;*/
+	if (size > slot->block->max_size) {
+		return;
+	}
+
+	/*Copy the payload, the slot is used;*/
+	memcpy(slot->block->address, header + ARQ_HEADER_SIZE, size);
+	slot->block->size = size;
+	slot->used = true;
+
+}
+
+
+/**
+ * arq_read : copies the next payload in order in @dst, and slides the receiver window;
+ *
+ * @param arq : the ARQ;
+ * @param dst : the block where to copy the payload;
+ * @return true if a payload was copied;
+ */
+
+bool arq_read(struct arq *const arq, struct data_block *const dst) {
+
+	/*Cache the slot of the next frame to deliver;*/
+	struct arq_slot *const slot = arq_slot(arq, arq->rx_slots, arq->rx_base);
+
+	/*If it was not received, fail;*/
+	if (!slot->used) {
+		return false;
+	}
+
+	/*Copy the payload;*/
+	data_block_copy(slot->block, dst);
+
+	/*Release the slot, and slide the window;*/
+	slot->used = false;
+	arq->rx_base++;
+	arq->nb_delivered++;
+
+	/*The window slid, the peer must be informed;*/
+	arq->ack_pending = true;
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/*------------------------------------------------------- Polling ------------------------------------------------------*/
+
+/**
+ * arq_poll : processes all received frames, sends unsent frames, retransmits expired frames, and sends an
+ * 	acknowledgement if the peer was not informed of the receiver state by a data frame;
+ *
+ * 	If a frame expired, the timeout is doubled, until a new round trip is sampled. Sending an unsent frame is its
+ * 	first transmission : it does not back off;
+ *
+ * @param arq : the ARQ;
+ */
+
+void arq_poll(struct arq *const arq) {
+
+	/*Cache the interface and the current time;*/
+	struct netf2 *const iface = arq->iface;
+	const uint32_t now = sysclock_milliseconds();
+
+	struct data_block *frame;
+
+	/*Process all received frames, in place;*/
+	while ((frame = netf2_borrow_rx_frame(iface))) {
+		arq_receive(arq, frame, now);
+		netf2_return_rx_frame(iface, frame);
+	}
+
+	/*Has a frame expired ?*/
+	bool expired = false;
+
+	/*For each frame in flight :*/
+	for (uint8_t seq = arq->tx_base; seq != arq->tx_next; seq++) {
+
+		/*Cache the slot;*/
+		struct arq_slot *const slot = arq_slot(arq, arq->tx_slots, seq);
+
+		/*If the frame was never sent :*/
+		if (slot->unsent) {
+
+			/*Send it. If no interface frame is available, stop;*/
+			if (!arq_transmit(arq, ARQ_DATA, seq, slot->block)) {
+				break;
+			}
+
+			/*Its timeout starts now;*/
+			slot->unsent = false;
+			slot->sent_time = now;
+			continue;
+
+		}
+
+		/*Recent frames, and acknowledged frames other than the probe, are not retransmitted;*/
+		if ((slot->acked && (seq != arq->tx_base)) || (now - slot->sent_time < arq->rto)) {
+			continue;
+		}
+
+		/*Retransmit the frame. If no interface frame is available, stop;*/
+		if (!arq_transmit(arq, ARQ_DATA, seq, slot->block)) {
+			break;
+		}
+
+		/*Update the slot;*/
+		slot->sent_time = now;
+		slot->retransmitted = true;
+
+		/*Update the counter;*/
+		arq->nb_retransmitted++;
+		expired = true;
+
+	}
+
+	/*If a frame expired, back off;*/
+	if (expired) {
+		arq->rto = (arq->rto << 1 > ARQ_MAX_RTO) ? ARQ_MAX_RTO : arq->rto << 1;
+	}
+
+	/*If the peer must be informed of the receiver state, send an acknowledgement;*/
+	if (arq->ack_pending) {
+		arq_transmit(arq, ARQ_ACK, 0, 0);
+	}
+
+}
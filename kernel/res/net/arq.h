@@ -0,0 +1,185 @@
+/*
+  arq.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_ARQ_H
+#define TRACER_ARQ_H
+
+#include <stdbool.h>
+
+#include <stdint.h>
+
+#include <stddef.h>
+
+#include <kernel/res/net/netf.h>
+
+
+/*--------------------------------------------------- Make Parameters --------------------------------------------------*/
+
+/*The initial retransmission timeout, in milliseconds, before any round trip was measured;*/
+#if !defined(ARQ_INITIAL_RTO)
+
+#define ARQ_INITIAL_RTO 100
+
+#endif
+
+
+/*Bounds of the retransmission timeout, in milliseconds;*/
+#if !defined(ARQ_MIN_RTO)
+
+#define ARQ_MIN_RTO 2
+
+#endif
+
+#if !defined(ARQ_MAX_RTO)
+
+#define ARQ_MAX_RTO 2000
+
+#endif
+
+
+/*The maximal window size. Limited by the size of the selective acknowledgement bitmap;*/
+#define ARQ_MAX_WINDOW 16
+
+/*The size of the transport header, at the start of each frame;*/
+#define ARQ_HEADER_SIZE 5
+
+
+/*--------------------------------------------------------- ARQ --------------------------------------------------------*/
+
+/*
+ * The ARQ is a selective repeat reliable transport over a netf2. Payloads sent on one end are delivered in order, once
+ * 	and only once, on the other end;
+ *
+ * 	Each frame starts with a header : its type (data or acknowledgement), its sequence number, and the receiver's
+ * 	state : the cumulative acknowledgement, that is the next sequence number to deliver, and a bitmap of frames
+ * 	already received after it. Acknowledgements are piggybacked on data frames when possible;
+ *
+ * 	The sender keeps a copy of each unacknowledged payload, and retransmits only frames that were neither
+ * 	acknowledged nor selectively acknowledged when their timeout expires. The timeout adapts to the measured round
+ * 	trip time (Jacobson / Karels, Karn's rule for retransmitted frames) and doubles on each expiry;
+ *
+ * 	The oldest frame of the window is retransmitted on expiry even if it was selectively acknowledged : it probes the
+ * 	receiver, whose window update may have been lost;
+ *
+ * 	The receiver keeps frames received out of order until missing ones arrive. The window of the sender is the
+ * 	receiver's window : both ends must use the same window size;
+ *
+ * 	The ARQ owns the interface's rx side : no protocol must be attached to the interface. All ARQ functions must be
+ * 	called by a single context, that calls arq_poll regularly. Interface frames must be sized for the header and the
+ * 	maximal payload, which arq_create verifies;
+ */
+
+struct arq_slot {
+
+	/*The payload, copied;*/
+	struct data_block *block;
+
+	/*Is the slot used ? For the sender, the payload is in the window, for the receiver, it is not delivered;*/
+	bool used;
+
+	/*Sender only : has the payload been selectively acknowledged ?*/
+	bool acked;
+
+	/*Sender only : the last transmission time;*/
+	uint32_t sent_time;
+
+	/*Sender only : has the payload been retransmitted ?*/
+	bool retransmitted;
+
+	/*Sender only : is the payload waiting for its first transmission, as no interface frame was available ?*/
+	bool unsent;
+
+};
+
+
+struct arq {
+
+	/*The interface frames are exchanged on;*/
+	struct netf2 *iface;
+
+	/*The window size;*/
+	uint8_t window;
+
+
+	/*The oldest unacknowledged sequence number, and the next one to send;*/
+	uint8_t tx_base, tx_next;
+
+	/*Sent payloads, indexed by sequence number modulo the window;*/
+	struct arq_slot *tx_slots;
+
+
+	/*The next sequence number to deliver;*/
+	uint8_t rx_base;
+
+	/*Received payloads, indexed by sequence number modulo the window;*/
+	struct arq_slot *rx_slots;
+
+	/*Set when the peer must be informed of the receiver state;*/
+	bool ack_pending;
+
+
+	/*The smoothed round trip time, scaled by 8, and its variation, scaled by 4;*/
+	uint32_t srtt_8, rttvar_4;
+
+	/*Has a round trip been sampled ? A null round trip is a valid sample;*/
+	bool rtt_valid;
+
+	/*The current retransmission timeout;*/
+	uint32_t rto;
+
+
+	/*Counters;*/
+	size_t nb_sent, nb_retransmitted, nb_delivered, nb_duplicates;
+
+};
+
+
+/*Create an ARQ over @iface, with a window of @window frames, for payloads up to @max_payload bytes;*/
+struct arq *arq_create(struct netf2 *iface, uint8_t window, size_t max_payload);
+
+/*Delete an ARQ. The interface is not deleted;*/
+void arq_delete(struct arq *arq);
+
+/*Queue a payload for reliable delivery. Returns false if the window is full;*/
+bool arq_send(struct arq *arq, const void *data, size_t size);
+
+/*Copy the next payload in @dst. Returns false if none is available in order;*/
+bool arq_read(struct arq *arq, struct data_block *dst);
+
+/*Process received frames, retransmit expired frames, and send acknowledgements;*/
+void arq_poll(struct arq *arq);
+
+
+/**
+ * arq_window_full : asserts if no payload can be sent before acknowledgements are received;
+ *
+ * @param arq : the ARQ to examine;
+ * @return true if the window is full;
+ */
+
+static inline bool arq_window_full(const struct arq *const arq) {
+
+	/*Compare the number of unacknowledged frames with the window;*/
+	return (uint8_t) (arq->tx_next - arq->tx_base) >= arq->window;
+
+}
+
+
+#endif /*TRACER_ARQ_H*/
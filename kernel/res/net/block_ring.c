@@ -0,0 +1,77 @@
+/*
+  block_ring.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "block_ring.h"
+
+#include "std/syscall.h"
+
+
+/**
+ * block_ring_create : allocates the slots of a ring that can contain at least @min_capacity blocks;
+ *
+ * 	The capacity is rounded up to a power of two;
+ *
+ * @param min_capacity : the minimal number of blocks the ring must contain;
+ * @return the initialised ring;
+ */
+
+struct block_ring block_ring_create(const size_t min_capacity) {
+
+	/*The ring's capacity;*/
+	size_t capacity = 1;
+
+	/*Round the capacity to the next power of two;*/
+	while (capacity < min_capacity) {
+		capacity <<= 1;
+	}
+
+	/*Create the ring initializer;*/
+	struct block_ring ring = {
+
+		/*Allocate slots;*/
+		.slots = kernel_malloc(capacity * sizeof(struct data_block *)),
+
+		/*Save the mask;*/
+		.mask = capacity - 1,
+
+		/*The ring is empty;*/
+		.head = 0,
+		.tail = 0,
+
+	};
+
+	/*Return the initialised ring;*/
+	return ring;
+
+}
+
+
+/**
+ * block_ring_delete : frees the slots of @ring. Blocks it contains are not deleted;
+ *
+ * @param ring : the ring to delete;
+ */
+
+void block_ring_delete(struct block_ring *const ring) {
+
+	/*Free the slots array;*/
+	kernel_free(ring->slots);
+
+}
@@ -0,0 +1,172 @@
+/*
+  block_ring.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_BLOCK_RING_H
+#define TRACER_BLOCK_RING_H
+
+#include <stdbool.h>
+
+#include <stdint.h>
+
+#include <stddef.h>
+
+
+struct data_block;
+
+
+/*
+ * A block ring is a single-producer single-consumer queue of data block pointers;
+ *
+ * 	It transmits blocks between an interrupt handler and a process without any critical section : the producer only
+ * 	writes the head index, the consumer only writes the tail index. Indices run freely, and are masked to access slots;
+ *
+ * 	A ring must only be pushed by one context and pulled by another one. Any other use requires external locking;
+ *
+ * 	The capacity is a power of two, at least the number of blocks that can be simultaneously stored;
+ */
+
+struct block_ring {
+
+	/*The slots array;*/
+	struct data_block **const slots;
+
+	/*The index mask, capacity - 1;*/
+	const size_t mask;
+
+	/*The index of the next slot to write. Written by the producer only;*/
+	volatile size_t head;
+
+	/*The index of the next slot to read. Written by the consumer only;*/
+	volatile size_t tail;
+
+};
+
+
+/*
+ * The ring only requires slot accesses not to be reordered with index updates. On a single-core Cortex-M, where the
+ * 	producer and the consumer are an interrupt and a thread of the same core, a compiler barrier is enough;
+ */
+
+#define BLOCK_RING_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+
+/*Create a ring that can contain at least @min_capacity blocks;*/
+struct block_ring block_ring_create(size_t min_capacity);
+
+/*Delete the ring's slots. Blocks it contains are not deleted;*/
+void block_ring_delete(struct block_ring *ring);
+
+
+/**
+ * block_ring_push : pushes @block in @ring. Must only be called by the producer;
+ *
+ * @param ring : the ring to push in;
+ * @param block : the block to push;
+ * @return true if the block was pushed, false if the ring is full;
+ */
+
+static inline bool block_ring_push(struct block_ring *const ring, struct data_block *const block) {
+
+	/*Cache the head index;*/
+	const size_t head = ring->head;
+
+	/*If the ring is full, fail;*/
+	if (head - ring->tail > ring->mask) {
+		return false;
+	}
+
+	/*Write the block in its slot;*/
+	ring->slots[head & ring->mask] = block;
+
+	/*The slot must be written before it is published;*/
+	BLOCK_RING_BARRIER();
+
+	/*Publish the slot;*/
+	ring->head = head + 1;
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * block_ring_pull : pulls a block from @ring. Must only be called by the consumer;
+ *
+ * @param ring : the ring to pull from;
+ * @return the pulled block, or 0 if the ring is empty;
+ */
+
+static inline struct data_block *block_ring_pull(struct block_ring *const ring) {
+
+	/*Cache the tail index;*/
+	const size_t tail = ring->tail;
+
+	/*If the ring is empty, fail;*/
+	if (tail == ring->head) {
+		return 0;
+	}
+
+	/*Read the block in its slot;*/
+	struct data_block *const block = ring->slots[tail & ring->mask];
+
+	/*The slot must be read before it is released;*/
+	BLOCK_RING_BARRIER();
+
+	/*Release the slot;*/
+	ring->tail = tail + 1;
+
+	/*Return the block;*/
+	return block;
+
+}
+
+
+/**
+ * block_ring_empty : asserts if @ring contains no block;
+ *
+ * @param ring : the ring to examine;
+ * @return true if the ring is empty;
+ */
+
+static inline bool block_ring_empty(const struct block_ring *const ring) {
+
+	/*Empty when both indices are equal;*/
+	return ring->head == ring->tail;
+
+}
+
+
+/**
+ * block_ring_count : returns the number of blocks in @ring;
+ *
+ * @param ring : the ring to examine;
+ * @return the number of blocks;
+ */
+
+static inline size_t block_ring_count(const struct block_ring *const ring) {
+
+	/*Indices run freely, their difference is the count;*/
+	return ring->head - ring->tail;
+
+}
+
+
+#endif /*TRACER_BLOCK_RING_H*/
@@ -0,0 +1,325 @@
+/*
+  crc.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "crc.h"
+
+
+#ifdef KERNEL_HW_CRC
+
+#include <khal/crc.h>
+
+#include <kernel/core/except.h>
+
+#endif
+
+
+/*------------------------------------------------------ Parameters ----------------------------------------------------*/
+
+/*CRC-16/CCITT-FALSE;*/
+#define CRC16_POLYNOMIAL ((uint16_t) 0x1021)
+#define CRC16_SEED ((uint16_t) 0xFFFF)
+
+/*CRC-32, normal and reversed forms of the polynomial;*/
+#define CRC32_POLYNOMIAL ((uint32_t) 0x04C11DB7)
+#define CRC32_REVERSED ((uint32_t) 0xEDB88320)
+#define CRC32_SEED ((uint32_t) 0xFFFFFFFF)
+
+
+/**
+ * crc_size : returns the size of a CRC of the provided type, in bytes;
+ *
+ * @param type : the CRC type;
+ * @return the size of the CRC;
+ */
+
+size_t crc_size(const enum crc_type type) {
+
+	/*16 or 32 bits;*/
+	return (type == CRC_16) ? 2 : 4;
+
+}
+
+
+#ifdef KERNEL_HW_CRC
+
+/*------------------------------------------------------- Hardware -----------------------------------------------------*/
+
+/**
+ * crc_hw_compute : computes the CRC of a byte span with the hardware CRC unit, from the provided seed;
+ *
+ * 	The unit is shared by all contexts, the computation is executed in a critical section;
+ *
+ * @param type : the CRC type;
+ * @param seed : the initial value, before the final complement;
+ * @param data : the bytes to process;
+ * @param size : the number of bytes to process;
+ * @return the CRC;
+ */
+
+static uint32_t crc_hw_compute(const enum crc_type type, const uint32_t seed, const uint8_t *const data,
+							   const size_t size) {
+
+	uint32_t crc;
+
+	/*Enter a critical section, the unit can't be shared;*/
+	critical_section_enter();
+
+	/*Compute the CRC;*/
+	if (type == CRC_16) {
+		crc = __crc_hw_compute(16, CRC16_POLYNOMIAL, seed, false, 0, data, size);
+	} else {
+		crc = __crc_hw_compute(32, CRC32_POLYNOMIAL, seed, true, 0xFFFFFFFF, data, size);
+	}
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+	/*Return the CRC;*/
+	return crc;
+
+}
+
+
+/**
+ * crc_compute : computes the CRC of a byte span with the hardware CRC unit;
+ *
+ * @param type : the CRC type;
+ * @param data : the bytes to process;
+ * @param size : the number of bytes to process;
+ * @return the CRC;
+ */
+
+uint32_t crc_compute(const enum crc_type type, const uint8_t *const data, const size_t size) {
+
+	/*Start from the standard seed;*/
+	return crc_hw_compute(type, (type == CRC_16) ? CRC16_SEED : CRC32_SEED, data, size);
+
+}
+
+
+/**
+ * crc_continue : continues a CRC over a following byte span with the hardware CRC unit;
+ *
+ * 	The CRC-32 is complemented at the end, its complement is the state to resume from;
+ *
+ * @param type : the CRC type;
+ * @param crc : the CRC of previous spans;
+ * @param data : the bytes to process;
+ * @param size : the number of bytes to process;
+ * @return the CRC of all spans;
+ */
+
+uint32_t crc_continue(const enum crc_type type, const uint32_t crc, const uint8_t *const data, const size_t size) {
+
+	/*Resume from the previous state;*/
+	return crc_hw_compute(type, (type == CRC_16) ? crc : ~crc, data, size);
+
+}
+
+
+#else
+
+/*------------------------------------------------------- Software -----------------------------------------------------*/
+
+/*
+ * Slice-by-8 : table k gives the CRC contribution of a byte followed by k null bytes. Eight bytes are processed per
+ * 	iteration, with eight independent table lookups;
+ *
+ * 	Tables are generated at the first use;
+ */
+
+/*CRC-16 tables, not reflected;*/
+static uint16_t crc16_tables[8][256];
+
+/*CRC-32 tables, reflected;*/
+static uint32_t crc32_tables[8][256];
+
+/*Have tables been generated ?*/
+static bool tables_generated = false;
+
+
+/**
+ * crc_generate_tables : generates slice-by-8 tables of both CRCs;
+ */
+
+static void crc_generate_tables() {
+
+	size_t value, bit, slice;
+
+	/*For each byte value :*/
+	for (value = 0; value < 256; value++) {
+
+		/*Compute the contribution of the byte alone, bit by bit;*/
+		uint16_t crc16 = (uint16_t) (value << 8);
+		uint32_t crc32 = (uint32_t) value;
+
+		for (bit = 0; bit < 8; bit++) {
+			crc16 = (uint16_t) ((crc16 & 0x8000) ? ((crc16 << 1) ^ CRC16_POLYNOMIAL) : (crc16 << 1));
+			crc32 = (crc32 & 1) ? ((crc32 >> 1) ^ CRC32_REVERSED) : (crc32 >> 1);
+		}
+
+		/*Save the first slice;*/
+		crc16_tables[0][value] = crc16;
+		crc32_tables[0][value] = crc32;
+
+	}
+
+	/*For each other slice, append a null byte to the previous slice's contribution;*/
+	for (slice = 1; slice < 8; slice++) {
+		for (value = 0; value < 256; value++) {
+
+			/*Cache previous contributions;*/
+			const uint16_t crc16 = crc16_tables[slice - 1][value];
+			const uint32_t crc32 = crc32_tables[slice - 1][value];
+
+			/*Process a null byte;*/
+			crc16_tables[slice][value] = (uint16_t) ((crc16 << 8) ^ crc16_tables[0][crc16 >> 8]);
+			crc32_tables[slice][value] = (crc32 >> 8) ^ crc32_tables[0][crc32 & 0xFF];
+
+		}
+	}
+
+	/*Tables are generated;*/
+	tables_generated = true;
+
+}
+
+
+/**
+ * crc16_compute : computes the CRC-16/CCITT-FALSE of a byte span, eight bytes at a time;
+ *
+ * @param crc : the initial value;
+ * @param data : the bytes to process;
+ * @param size : the number of bytes to process;
+ * @return the CRC;
+ */
+
+static uint16_t crc16_compute(uint16_t crc, const uint8_t *data, size_t size) {
+
+	/*Process eight bytes at a time. The CRC only affects the two first ones;*/
+	while (size >= 8) {
+
+		crc = (uint16_t) (crc16_tables[7][(crc >> 8) ^ data[0]] ^ crc16_tables[6][(crc & 0xFF) ^ data[1]] ^
+						  crc16_tables[5][data[2]] ^ crc16_tables[4][data[3]] ^
+						  crc16_tables[3][data[4]] ^ crc16_tables[2][data[5]] ^
+						  crc16_tables[1][data[6]] ^ crc16_tables[0][data[7]]);
+
+		data += 8;
+		size -= 8;
+
+	}
+
+	/*Process remaining bytes one by one;*/
+	while (size--) {
+		crc = (uint16_t) ((crc << 8) ^ crc16_tables[0][(crc >> 8) ^ *(data++)]);
+	}
+
+	/*Return the CRC;*/
+	return crc;
+
+}
+
+
+/**
+ * crc32_compute : computes the CRC-32 of a byte span, eight bytes at a time;
+ *
+ * @param crc : the initial value, before the final complement;
+ * @param data : the bytes to process;
+ * @param size : the number of bytes to process;
+ * @return the CRC;
+ */
+
+static uint32_t crc32_compute(uint32_t crc, const uint8_t *data, size_t size) {
+
+	/*Process eight bytes at a time. The CRC only affects the four first ones;*/
+	while (size >= 8) {
+
+		/*Merge the CRC with the four first bytes, in the little endian order;*/
+		const uint32_t low = crc ^ ((uint32_t) data[0] | ((uint32_t) data[1] << 8) |
+									((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24));
+
+		crc = crc32_tables[7][low & 0xFF] ^ crc32_tables[6][(low >> 8) & 0xFF] ^
+			  crc32_tables[5][(low >> 16) & 0xFF] ^ crc32_tables[4][low >> 24] ^
+			  crc32_tables[3][data[4]] ^ crc32_tables[2][data[5]] ^
+			  crc32_tables[1][data[6]] ^ crc32_tables[0][data[7]];
+
+		data += 8;
+		size -= 8;
+
+	}
+
+	/*Process remaining bytes one by one;*/
+	while (size--) {
+		crc = (crc >> 8) ^ crc32_tables[0][(crc ^ *(data++)) & 0xFF];
+	}
+
+	/*Complement and return the CRC;*/
+	return ~crc;
+
+}
+
+
+/**
+ * crc_compute : computes the CRC of a byte span in software;
+ *
+ * @param type : the CRC type;
+ * @param data : the bytes to process;
+ * @param size : the number of bytes to process;
+ * @return the CRC;
+ */
+
+uint32_t crc_compute(const enum crc_type type, const uint8_t *const data, const size_t size) {
+
+	/*Generate tables at the first use;*/
+	if (!tables_generated) {
+		crc_generate_tables();
+	}
+
+	/*Compute the CRC from the standard seed;*/
+	return (type == CRC_16) ? crc16_compute(CRC16_SEED, data, size) : crc32_compute(CRC32_SEED, data, size);
+
+}
+
+
+/**
+ * crc_continue : continues a CRC over a following byte span in software;
+ *
+ * 	The CRC-32 is complemented at the end, its complement is the state to resume from;
+ *
+ * @param type : the CRC type;
+ * @param crc : the CRC of previous spans;
+ * @param data : the bytes to process;
+ * @param size : the number of bytes to process;
+ * @return the CRC of all spans;
+ */
+
+uint32_t crc_continue(const enum crc_type type, const uint32_t crc, const uint8_t *const data, const size_t size) {
+
+	/*Generate tables at the first use;*/
+	if (!tables_generated) {
+		crc_generate_tables();
+	}
+
+	/*Resume from the previous state;*/
+	return (type == CRC_16) ? crc16_compute((uint16_t) crc, data, size) : crc32_compute(~crc, data, size);
+
+}
+
+#endif
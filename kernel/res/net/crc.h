@@ -0,0 +1,59 @@
+/*
+  crc.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_CRC_H
+#define TRACER_CRC_H
+
+#include <stdbool.h>
+
+#include <stdint.h>
+
+#include <stddef.h>
+
+
+/*
+ * Two CRCs are supported :
+ * 	- CRC_16 : CRC-16/CCITT-FALSE, polynomial 0x1021, seed 0xFFFF, not reflected;
+ * 	- CRC_32 : CRC-32 (IEEE 802.3), polynomial 0x04C11DB7, seed 0xFFFFFFFF, reflected, complemented;
+ *
+ * 	If KERNEL_HW_CRC is defined (see BOPS_HW_CRC in build_options.mk), the hardware CRC unit is used. If not,
+ * 	(host builds for example) a slice-by-8 table-driven software implementation is used;
+ */
+
+enum crc_type {
+
+	CRC_16,
+
+	CRC_32,
+
+};
+
+
+/*Get the size of a CRC, in bytes;*/
+size_t crc_size(enum crc_type type);
+
+/*Compute the CRC of a byte span;*/
+uint32_t crc_compute(enum crc_type type, const uint8_t *data, size_t size);
+
+/*Continue @crc, computed on previous spans, over a following byte span. Allows computing the CRC of a chain;*/
+uint32_t crc_continue(enum crc_type type, uint32_t crc, const uint8_t *data, size_t size);
+
+
+#endif /*TRACER_CRC_H*/
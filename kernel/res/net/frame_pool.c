@@ -0,0 +1,427 @@
+/*
+  frame_pool.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "frame_pool.h"
+
+#include "netf.h"
+
+#include "std/syscall.h"
+
+#include <kernel/core/except.h>
+
+
+/*
+ * A size class contains free blocks of the same size, chained;
+ */
+
+struct frame_pool_class {
+
+	/*The chain of free blocks. Null if there is none;*/
+	struct data_block *free;
+
+	/*The number of free blocks;*/
+	size_t nb_free;
+
+	/*The number of blocks of the class, free or held;*/
+	size_t nb_blocks;
+
+	/*The number of blocks withdrawn while held, to delete or to reuse;*/
+	size_t surplus;
+
+};
+
+
+/*The pool's classes;*/
+static struct frame_pool_class classes[FRAME_POOL_NB_CLASSES];
+
+
+/**
+ * frame_pool_class_size : returns the block size of a class;
+ *
+ * @param index : the index of the class;
+ * @return the size of its blocks;
+ */
+
+static inline size_t frame_pool_class_size(const uint8_t index) {
+
+	/*Each class doubles the previous one;*/
+	return (size_t) FRAME_POOL_MIN_SIZE << index;
+
+}
+
+
+/**
+ * frame_pool_class_index : returns the index of the smallest class that fits @size;
+ *
+ * @param size : the size to fit;
+ * @return the index of the class, FRAME_POOL_NB_CLASSES if none fits;
+ */
+
+static uint8_t frame_pool_class_index(const size_t size) {
+
+	uint8_t index = 0;
+
+	/*Find the first class that fits;*/
+	while ((index < FRAME_POOL_NB_CLASSES) && (frame_pool_class_size(index) < size)) {
+		index++;
+	}
+
+	/*Return the index;*/
+	return index;
+
+}
+
+
+/**
+ * frame_pool_push : adds a block to the free chain of a class;
+ *
+ * @param class : the class;
+ * @param block : the free block;
+ */
+
+static void frame_pool_push(struct frame_pool_class *const class, struct data_block *const block) {
+
+	/*The block is empty;*/
+	block->size = 0;
+
+	/*Append the block to the free chain, or start it;*/
+	if (class->free) {
+		data_block_chain(class->free, block);
+	} else {
+		class->free = block;
+	}
+
+	/*Update the counter;*/
+	class->nb_free++;
+
+}
+
+
+/**
+ * frame_pool_block_size : returns the size of the blocks of the class that fits @size;
+ *
+ * @param size : the size to fit;
+ * @return the block size, 0 if no class fits;
+ */
+
+size_t frame_pool_block_size(const size_t size) {
+
+	/*Find the class;*/
+	const uint8_t index = frame_pool_class_index(size);
+
+	/*Return its size, if it exists;*/
+	return (index == FRAME_POOL_NB_CLASSES) ? 0 : frame_pool_class_size(index);
+
+}
+
+
+/**
+ * frame_pool_fitting_class : returns the class that fits @size, and fails if none does;
+ *
+ * @param size : the size to fit;
+ * @return the class;
+ */
+
+static struct frame_pool_class *frame_pool_fitting_class(const size_t size) {
+
+	/*Find the class;*/
+	const uint8_t index = frame_pool_class_index(size);
+
+	/*If no class fits :*/
+	if (index == FRAME_POOL_NB_CLASSES) {
+
+		/*Error;*/
+		kernel_error("frame_pool.c : frame_pool_fitting_class : size too big for all classes;");
+
+	}
+
+	/*Return the class;*/
+	return classes + index;
+
+}
+
+
+/*----------------------------------------------------- Provision ------------------------------------------------------*/
+
+/**
+ * frame_pool_provision : adds @count blocks to the class that fits @size. The surplus of the class is consumed first,
+ * 	other blocks are allocated;
+ *
+ * 	Blocks are allocated in the kernel heap, this function must not be called in interrupts;
+ *
+ * @param size : the minimal size of blocks;
+ * @param count : the number of blocks to add;
+ */
+
+void frame_pool_provision(const size_t size, size_t count) {
+
+	/*Cache the class and its size;*/
+	struct frame_pool_class *const class = frame_pool_fitting_class(size);
+	const size_t class_size = frame_pool_block_size(size);
+
+	/*Enter a critical section;*/
+	critical_section_enter();
+
+	/*Withdrawn blocks are kept;*/
+	const size_t kept = (class->surplus < count) ? class->surplus : count;
+	class->surplus -= kept;
+	count -= kept;
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+	/*For each block to add :*/
+	while (count--) {
+
+		/*Allocate the block out of the critical section;*/
+		struct data_block *const block = data_block_create(class_size);
+
+		/*Enter a critical section;*/
+		critical_section_enter();
+
+		/*Add the block;*/
+		frame_pool_push(class, block);
+		class->nb_blocks++;
+
+		/*Leave the critical section;*/
+		critical_section_leave();
+
+	}
+
+}
+
+
+/**
+ * frame_pool_allocate : allocates a block of the class that fits @size, held by the caller. A withdrawn free block
+ * 	is used first;
+ *
+ * 	The block is allocated in the kernel heap, this function must not be called in interrupts;
+ *
+ * @param size : the minimal size of the block;
+ * @return the block;
+ */
+
+struct data_block *frame_pool_allocate(const size_t size) {
+
+	/*Cache the class;*/
+	struct frame_pool_class *const class = frame_pool_fitting_class(size);
+
+	struct data_block *block = 0;
+
+	/*Enter a critical section;*/
+	critical_section_enter();
+
+	/*If a withdrawn block is free, keep it;*/
+	if ((class->surplus) && (class->free)) {
+		class->surplus--;
+		block = frame_pool_take(size);
+	}
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+	/*If no block was kept, allocate one;*/
+	if (!block) {
+
+		/*Allocate the block out of the critical section;*/
+		block = data_block_create(frame_pool_block_size(size));
+
+		/*Enter a critical section;*/
+		critical_section_enter();
+
+		/*Count the block;*/
+		class->nb_blocks++;
+
+		/*Leave the critical section;*/
+		critical_section_leave();
+
+	}
+
+	/*Return the block;*/
+	return block;
+
+}
+
+
+/**
+ * frame_pool_withdraw : removes @count blocks from the class that fits @size. Free blocks are deleted, held ones are
+ * 	added to the surplus;
+ *
+ * 	Blocks are freed in the kernel heap, this function must not be called in interrupts;
+ *
+ * @param size : the minimal size of blocks;
+ * @param count : the number of blocks to remove;
+ */
+
+void frame_pool_withdraw(const size_t size, size_t count) {
+
+	/*Cache the class;*/
+	struct frame_pool_class *const class = frame_pool_fitting_class(size);
+
+	/*Enter a critical section;*/
+	critical_section_enter();
+
+	/*Delete the surplus and withdrawn blocks while they are free;*/
+	count += class->surplus;
+	class->surplus = 0;
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+	/*For each block to remove :*/
+	for (; count; count--) {
+
+		/*Enter a critical section;*/
+		critical_section_enter();
+
+		/*Take a free block of the class. Larger classes are not searched, the class is the first that fits;*/
+		struct data_block *const block = (class->free) ? frame_pool_take(size) : 0;
+
+		/*If one was taken, it leaves the class;*/
+		if (block) {
+			class->nb_blocks--;
+		}
+
+		/*Leave the critical section;*/
+		critical_section_leave();
+
+		/*If no block is free, stop;*/
+		if (!block) {
+			break;
+		}
+
+		/*Delete the block out of the critical section;*/
+		data_block_delete(block);
+
+	}
+
+	/*Enter a critical section;*/
+	critical_section_enter();
+
+	/*Held blocks are the surplus;*/
+	class->surplus += count;
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+}
+
+
+/*--------------------------------------------------- Take - Give ------------------------------------------------------*/
+
+/**
+ * frame_pool_take : takes a free block from the smallest class that fits @size and has free blocks;
+ *
+ * @param size : the minimal size of the block;
+ * @return the block, or 0 if none is free;
+ */
+
+struct data_block *frame_pool_take(const size_t size) {
+
+	struct data_block *block = 0;
+
+	/*Enter a critical section, the pool is shared with interrupts;*/
+	critical_section_enter();
+
+	/*For each class that fits :*/
+	for (uint8_t index = frame_pool_class_index(size); index < FRAME_POOL_NB_CLASSES; index++) {
+
+		/*Cache the class;*/
+		struct frame_pool_class *const class = classes + index;
+
+		/*If it has no free block, try the next one;*/
+		if (!(block = class->free)) {
+			continue;
+		}
+
+		/*The next free block becomes the first one;*/
+		class->free = data_block_next_segment(block, block);
+
+		/*Remove the block from the chain;*/
+		data_block_unchain(block);
+
+		/*Update the counter;*/
+		class->nb_free--;
+
+		/*Complete;*/
+		break;
+
+	}
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+	/*Return the block;*/
+	return block;
+
+}
+
+
+/**
+ * frame_pool_give : gives back a block taken from the pool;
+ *
+ * @param block : the block to give back. Must not be chained;
+ */
+
+void frame_pool_give(struct data_block *const block) {
+
+	/*Find the block's class;*/
+	const uint8_t index = frame_pool_class_index(block->max_size);
+
+	/*If the block doesn't come from the pool :*/
+	if ((index == FRAME_POOL_NB_CLASSES) || (frame_pool_class_size(index) != block->max_size)) {
+
+		/*Error;*/
+		kernel_error("frame_pool.c : frame_pool_give : the block doesn't belong to the pool;");
+
+	}
+
+	/*Enter a critical section, the pool is shared with interrupts;*/
+	critical_section_enter();
+
+	/*Add the block to its class;*/
+	frame_pool_push(classes + index, block);
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+}
+
+
+/**
+ * frame_pool_available : returns the number of free blocks of at least @size bytes;
+ *
+ * @param size : the minimal size of blocks;
+ * @return the number of free blocks;
+ */
+
+size_t frame_pool_available(const size_t size) {
+
+	size_t count = 0;
+
+	/*Sum free blocks of all classes that fit. Counters are sampled, no critical section required;*/
+	for (uint8_t index = frame_pool_class_index(size); index < FRAME_POOL_NB_CLASSES; index++) {
+		count += classes[index].nb_free;
+	}
+
+	/*Return the count;*/
+	return count;
+
+}
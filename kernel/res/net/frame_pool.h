@@ -0,0 +1,91 @@
+/*
+  frame_pool.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_FRAME_POOL_H
+#define TRACER_FRAME_POOL_H
+
+#include <stdbool.h>
+
+#include <stdint.h>
+
+#include <stddef.h>
+
+
+struct data_block;
+
+
+/*--------------------------------------------------- Make Parameters --------------------------------------------------*/
+
+/*The number of size classes;*/
+#if !defined(FRAME_POOL_NB_CLASSES)
+
+#define FRAME_POOL_NB_CLASSES 5
+
+#endif
+
+
+/*The block size of the smallest class. Each class doubles the size of the previous one;*/
+#if !defined(FRAME_POOL_MIN_SIZE)
+
+#define FRAME_POOL_MIN_SIZE 32
+
+#endif
+
+
+/*----------------------------------------------------- Frame pool -----------------------------------------------------*/
+
+/*
+ * The frame pool is a reservoir of data blocks shared by all network interfaces, so that frame memory is not pinned
+ * 	by idle interfaces;
+ *
+ * 	Blocks are sorted in size classes, that double from FRAME_POOL_MIN_SIZE. They are allocated when the pool is
+ * 	provisioned, out of interrupts, and are then only moved between the pool and interfaces : taking and giving
+ * 	blocks is constant time, and can be done in interrupts;
+ *
+ * 	A request is served by the smallest class that fits and has a free block;
+ *
+ * 	Interfaces provision the pool when they are initialised, and withdraw their share when they are deleted. Blocks
+ * 	of a withdrawn share that are held by other interfaces can't be deleted : they stay in the pool as a surplus,
+ * 	that the next provision of their class consumes instead of allocating;
+ */
+
+/*Get the size of the blocks that serve @size, 0 if no class fits;*/
+size_t frame_pool_block_size(size_t size);
+
+/*Allocate @count blocks in the class that fits @size;*/
+void frame_pool_provision(size_t size, size_t count);
+
+/*Allocate a block of the class that fits @size, held by the caller, that joins the pool when it is given;*/
+struct data_block *frame_pool_allocate(size_t size);
+
+/*Remove @count blocks from the class that fits @size, deleting free ones;*/
+void frame_pool_withdraw(size_t size, size_t count);
+
+/*Take a free block of at least @size bytes. Returns 0 if none is free;*/
+struct data_block *frame_pool_take(size_t size);
+
+/*Give back a block taken from the pool;*/
+void frame_pool_give(struct data_block *block);
+
+/*Get the number of free blocks of at least @size bytes;*/
+size_t frame_pool_available(size_t size);
+
+
+#endif /*TRACER_FRAME_POOL_H*/
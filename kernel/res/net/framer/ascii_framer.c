@@ -22,6 +22,8 @@
 #include "std/syscall.h"
 #include "framer.h"
 
+#include <string.h>
+
 /*
  * The ascii framer is composed of a data framer, and TODO
  */
@@ -39,7 +41,10 @@ struct ascii_framer {
 	bool decoding_unsafe;
 
 
-	/*The index where to read bytes to encode;*/
+	/*The segment of the encoding chain where bytes are read. Null between frames;*/
+	struct data_block *read_segment;
+
+	/*The index where to read bytes to encode, in the read segment;*/
 	size_t read_index;
 
 	/*Has the EOF line feed and carriage return been sent ?*/
@@ -56,6 +61,10 @@ bool ascii_framer_decode(struct ascii_framer *framer, uint8_t data);
 
 bool ascii_framer_get_encoded_byte(struct ascii_framer *framer, uint8_t *data);
 
+size_t ascii_framer_decode_block(struct ascii_framer *framer, const uint8_t *data, size_t size, bool *frame_complete);
+
+size_t ascii_framer_encode_block(struct ascii_framer *framer, uint8_t *data, size_t size, bool *frame_complete);
+
 
 /**
  * ascii_framer_create : creates and initialises an ascii framer, and return its framer casted version;
@@ -74,7 +83,14 @@ struct data_framer *ascii_framer_create() {
 
 			.encode = (bool (*)(struct data_framer *, uint8_t *)) &ascii_framer_get_encoded_byte,
 			.decode = (bool (*)(struct data_framer *, uint8_t)) &ascii_framer_decode,
+			.decode_block =
+				(size_t (*)(struct data_framer *, const uint8_t *, size_t, bool *)) &ascii_framer_decode_block,
+			.encode_block =
+				(size_t (*)(struct data_framer *, uint8_t *, size_t, bool *)) &ascii_framer_encode_block,
 			.deleter = &ascii_framer_deleter,
+			.trailer_size = 0,
+			.nb_drops = 0,
+			.nb_truncations = 0,
 		},
 
 		/*Decoding safe;*/
@@ -82,6 +98,7 @@ struct data_framer *ascii_framer_create() {
 		.decoding_unsafe = false,
 
 		/*Encoding safe;*/
+		.read_segment = 0,
 		.read_index = 0,
 		.EOF_lf_sent = false,
 
@@ -158,6 +175,9 @@ bool ascii_framer_decode(struct ascii_framer *const framer, const uint8_t data)
 			/*Go in the unsafe state. No data will be inserted until the next EOF;*/
 			framer->decoding_unsafe = true;
 
+			/*The frame will be truncated and delivered, count it apart from drops;*/
+			framer->framer.nb_truncations++;
+
 		} else {
 
 			/*The byte can be inserted;*/
@@ -179,6 +199,36 @@ bool ascii_framer_decode(struct ascii_framer *const framer, const uint8_t data)
 }
 
 
+/**
+ * ascii_encoder_segment : returns the segment where the next frame character is read. Entirely read segments are
+ * 	skipped; If the returned segment is entirely read, the whole frame is;
+ *
+ * @param framer : the framer that encodes;
+ * @return the segment to read;
+ */
+
+static struct data_block *ascii_encoder_segment(struct ascii_framer *const framer) {
+
+	/*Cache the frame;*/
+	const struct data_block *const frame = framer->framer.encoding_block;
+
+	/*Cache the read segment. At the start of a frame, its first block is read;*/
+	struct data_block *segment = (framer->read_segment) ? framer->read_segment : framer->framer.encoding_block;
+
+	struct data_block *next;
+
+	/*While the segment is entirely read and another one follows, read the next one;*/
+	while ((framer->read_index == segment->size) && (next = data_block_next_segment(frame, segment))) {
+		segment = next;
+		framer->read_index = 0;
+	}
+
+	/*Save and return the read segment;*/
+	return framer->read_segment = segment;
+
+}
+
+
 /**
  * ascii_framer_get_encoded_byte : encodes @framer's and store one byte of the resulting stream in @data;
  *
@@ -193,14 +243,14 @@ bool ascii_framer_decode(struct ascii_framer *const framer, const uint8_t data)
 
 bool ascii_framer_get_encoded_byte(struct ascii_framer *const framer, uint8_t *const data) {
 
+	/*Cache the segment to read;*/
+	struct data_block *segment = ascii_encoder_segment(framer);
+
 	/*Cache the reading index;*/
 	size_t read_index = framer->read_index;
 
-	/*Cache the encoding block;*/
-	struct data_block *encoding_block = framer->framer.encoding_block;
-
-	/*If we reached the end of the encoding block :*/
-	if (read_index == encoding_block->size) {
+	/*If we reached the end of the frame :*/
+	if (read_index == segment->size) {
 
 		/*If the EOF line feed has not been sent :*/
 		if (!framer->EOF_lf_sent) {
@@ -219,7 +269,8 @@ bool ascii_framer_get_encoded_byte(struct ascii_framer *const framer, uint8_t *c
 			/*Send a carriage return;*/
 			*data = '\r';
 
-			/*Reset the read index, and the EOF flag;*/
+			/*Reset the read position, and the EOF flag;*/
+			framer->read_segment = 0;
 			framer->read_index = 0;
 			framer->EOF_lf_sent = false;
 
@@ -232,15 +283,258 @@ bool ascii_framer_get_encoded_byte(struct ascii_framer *const framer, uint8_t *c
 
 	}
 
-	/*Block still contains data to be sent;*/
+	/*Segment still contains data to be sent;*/
 
 	/*Send the byte at the reading position;*/
-	*data = *((uint8_t *) encoding_block->address + read_index);
+	*data = *((uint8_t *) segment->address + read_index);
 
 	/*Update the read index;*/
 	framer->read_index = read_index + 1;
 
-	/*Block end not reached for instance, no block update required;*/
+	/*Frame end not reached for instance, no block update required;*/
 	return false;
 
 }
+
+
+/*--------------------------------------------------- Block operations -------------------------------------------------*/
+
+/*Words are read with a type that may alias the byte buffer;*/
+typedef uint32_t __attribute__((__may_alias__)) ascii_word_t;
+
+/*A word with all bytes set to 1;*/
+#define ONES ((ascii_word_t) 0x01010101)
+
+/*A word with all most significant bits set;*/
+#define HIGHS ((ascii_word_t) 0x80808080)
+
+/*Is the byte an end of frame ?*/
+#define IS_DELIMITER(c) (((c) > '~') || ((c) < ' '))
+
+/*
+ * Does the word contain an end of frame ? A byte is an end of frame if it is under ' ' or over '~';
+ *
+ * 	- (w - ONES * ' ') & ~w & HIGHS is non null if and only if a byte is under ' ';
+ * 	- ((w + ONES * (127 - '~')) | w) & HIGHS is non null if and only if a byte is over '~';
+ *
+ * 	Both tests only tell if such a byte exists, the byte is then located with a byte loop;
+ */
+#define HAS_DELIMITER(w) ((((w) - ONES * ' ') & ~(w) & HIGHS) | ((((w) + ONES * (127 - '~')) | (w)) & HIGHS))
+
+
+/**
+ * ascii_find_delimiter : finds the first end of frame in [@data, @end[, four bytes at a time;
+ *
+ * @param data : the first byte to examine;
+ * @param end : the address after the last byte to examine;
+ * @return the address of the first end of frame, or @end if there is none;
+ */
+
+static const uint8_t *ascii_find_delimiter(const uint8_t *data, const uint8_t *const end) {
+
+	/*Examine bytes one by one until data is word aligned;*/
+	while ((data < end) && ((size_t) data & (sizeof(ascii_word_t) - 1))) {
+
+		/*If the byte is an end of frame, return it;*/
+		if (IS_DELIMITER(*data)) {
+			return data;
+		}
+
+		data++;
+
+	}
+
+	/*Skip words that contain no end of frame;*/
+	while (((size_t) (end - data) >= sizeof(ascii_word_t)) && (!HAS_DELIMITER(*(const ascii_word_t *) data))) {
+		data += sizeof(ascii_word_t);
+	}
+
+	/*Locate the end of frame in remaining bytes;*/
+	while (data < end) {
+
+		/*If the byte is an end of frame, return it;*/
+		if (IS_DELIMITER(*data)) {
+			return data;
+		}
+
+		data++;
+
+	}
+
+	/*No end of frame found;*/
+	return end;
+
+}
+
+
+/**
+ * ascii_framer_decode_block : transmits up to @size bytes to @framer for decoding. Stops right after the first end
+ * 	of frame that completes a non-empty frame;
+ *
+ * 	Behaves as successive calls to ascii_framer_decode, but copies frame characters by runs;
+ *
+ * @param framer : the framer that must receive data bytes;
+ * @param data : the bytes to transmit;
+ * @param size : the number of bytes to transmit;
+ * @param frame_complete : set if a block update is required;
+ * @return the number of bytes consumed;
+ */
+
+size_t ascii_framer_decode_block(struct ascii_framer *const framer, const uint8_t *const data, const size_t size,
+								 bool *const frame_complete) {
+
+	/*Cache the decoding block;*/
+	struct data_block *decoding_block = framer->framer.decoding_block;
+
+	/*Cache the insertion index;*/
+	size_t insertion_index = framer->insertion_index;
+
+	/*Cache bounds;*/
+	const uint8_t *current = data, *const end = data + size;
+
+	/*While bytes remain :*/
+	while (current < end) {
+
+		/*Find the end of the current run of frame characters;*/
+		const uint8_t *const run_end = ascii_find_delimiter(current, end);
+
+		/*Determine the size of the run;*/
+		size_t run_size = (size_t) (run_end - current);
+
+		/*If the run is not empty, and we are in a safe state :*/
+		if (run_size && (!framer->decoding_unsafe)) {
+
+			/*Determine the space remaining in the block;*/
+			const size_t space = decoding_block->max_size - insertion_index;
+
+			/*If the run would overflow the data block :*/
+			if (run_size > space) {
+
+				/*Insert what fits, and go in the unsafe state until the next EOF;*/
+				run_size = space;
+				framer->decoding_unsafe = true;
+
+				/*The frame will be truncated and delivered, count it apart from drops;*/
+				framer->framer.nb_truncations++;
+
+			}
+
+			/*Insert the run;*/
+			memcpy((uint8_t *) decoding_block->address + insertion_index, current, run_size);
+
+			/*Update the insertion index;*/
+			insertion_index += run_size;
+
+		}
+
+		/*If no end of frame was found, all bytes are consumed;*/
+		if (run_end == end) {
+			break;
+		}
+
+		/*Consume the end of frame;*/
+		current = run_end + 1;
+
+		/*An end of frame as been received. We can go back in safe state;*/
+		framer->decoding_unsafe = false;
+
+		/*If the frame is not empty :*/
+		if (insertion_index) {
+
+			/*Update the data block;*/
+			decoding_block->size = insertion_index;
+
+			/*Reset the insertion index for future insertion;*/
+			framer->insertion_index = 0;
+
+			/*The frame is complete, a block update is required;*/
+			*frame_complete = true;
+
+			/*Return the number of consumed bytes;*/
+			return (size_t) (current - data);
+
+		}
+
+	}
+
+	/*Save the insertion index;*/
+	framer->insertion_index = insertion_index;
+
+	/*No block update required;*/
+	*frame_complete = false;
+
+	/*All bytes were consumed;*/
+	return size;
+
+}
+
+
+/**
+ * ascii_framer_encode_block : encodes @framer's frame and stores up to @size bytes of the resulting stream in @data;
+ * 	Stops right after the EOF that completes the frame;
+ *
+ * 	Behaves as successive calls to ascii_framer_get_encoded_byte, but copies frame characters at once, segment per
+ * 	segment;
+ *
+ * @param framer : the framer that must provide encoded bytes;
+ * @param data : the location where bytes must be stored;
+ * @param size : the maximal number of bytes to store;
+ * @param frame_complete : set if the frame must be updated;
+ * @return the number of bytes stored;
+ */
+
+size_t ascii_framer_encode_block(struct ascii_framer *const framer, uint8_t *const data, const size_t size,
+								 bool *const frame_complete) {
+
+	/*The number of bytes stored;*/
+	size_t count = 0;
+
+	/*No block update required for instance;*/
+	*frame_complete = false;
+
+	/*While there is space :*/
+	while (count < size) {
+
+		/*Cache the segment to read;*/
+		struct data_block *segment = ascii_encoder_segment(framer);
+
+		/*Determine the number of frame characters to copy;*/
+		size_t run_size = segment->size - framer->read_index;
+
+		/*If the frame is entirely read :*/
+		if (!run_size) {
+
+			/*Send the next EOF byte. If the frame is complete :*/
+			if (ascii_framer_get_encoded_byte(framer, data + count++)) {
+
+				/*A block update is required;*/
+				*frame_complete = true;
+
+				/*Stop after the frame boundary;*/
+				break;
+
+			}
+
+			/*Continue, space may be exhausted;*/
+			continue;
+
+		}
+
+		/*Limit to the provided space;*/
+		if (run_size > size - count) {
+			run_size = size - count;
+		}
+
+		/*Copy frame characters;*/
+		memcpy(data + count, (uint8_t *) segment->address + framer->read_index, run_size);
+
+		/*Update indices;*/
+		framer->read_index += run_size;
+		count += run_size;
+
+	}
+
+	/*Return the number of stored bytes;*/
+	return count;
+
+}
@@ -0,0 +1,608 @@
+/*
+  cobs_framer.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <kernel/res/net/netf.h>
+#include "std/syscall.h"
+#include "cobs_framer.h"
+
+#include <string.h>
+
+
+/*The maximal code byte value, for a group of 254 non-zero bytes not followed by a zero;*/
+#define COBS_MAX_CODE 0xFF
+
+/*
+ * The encoder alternates code bytes and group data, and terminates with the delimiter;
+ */
+
+enum cobs_encoding_state {
+
+	/*The next byte is a code byte;*/
+	COBS_ENCODE_CODE,
+
+	/*The next byte is a group data byte;*/
+	COBS_ENCODE_DATA,
+
+	/*The next byte is the frame delimiter;*/
+	COBS_ENCODE_DELIMITER,
+
+};
+
+
+/*
+ * The COBS framer is composed of a data framer, the decoder state and the encoder state;
+ */
+
+struct cobs_framer {
+
+	/*The data framer base;*/
+	struct data_framer framer;
+
+
+	/*The index of the current insertion position in the decoding buffer;*/
+	size_t insertion_index;
+
+	/*The number of data bytes remaining in the current group. If null, the next byte is a code byte;*/
+	uint8_t decoding_remaining;
+
+	/*The code of the previous group. A zero is inserted between groups if it is not COBS_MAX_CODE;*/
+	uint8_t decoding_code;
+
+	/*A flag, set when the current frame is malformed or too long for the buffer;*/
+	bool decoding_unsafe;
+
+
+	/*The segment of the encoding chain where bytes are read. Null between frames;*/
+	struct data_block *read_segment;
+
+	/*The index where to read bytes to encode, in the read segment;*/
+	size_t read_index;
+
+	/*The number of data bytes of the current group that remain to be sent;*/
+	size_t group_remaining;
+
+	/*The code of the current group;*/
+	uint8_t encoding_code;
+
+	/*The encoder state;*/
+	enum cobs_encoding_state encoding_state;
+
+};
+
+
+/*Private headers;*/
+void cobs_framer_deleter(struct data_framer *framer) {};
+
+bool cobs_framer_decode(struct cobs_framer *framer, uint8_t data);
+
+bool cobs_framer_get_encoded_byte(struct cobs_framer *framer, uint8_t *data);
+
+size_t cobs_framer_decode_block(struct cobs_framer *framer, const uint8_t *data, size_t size, bool *frame_complete);
+
+size_t cobs_framer_encode_block(struct cobs_framer *framer, uint8_t *data, size_t size, bool *frame_complete);
+
+
+/**
+ * cobs_framer_create : creates and initialises a COBS framer, and return its framer casted version;
+ * @return the casted version of the framer;
+ */
+
+struct data_framer *cobs_framer_create() {
+
+	struct cobs_framer init = {
+
+		.framer = {
+
+			/*Blocks not initialised for instance;*/
+			.encoding_block = 0,
+			.decoding_block = 0,
+
+			.encode = (bool (*)(struct data_framer *, uint8_t *)) &cobs_framer_get_encoded_byte,
+			.decode = (bool (*)(struct data_framer *, uint8_t)) &cobs_framer_decode,
+			.decode_block =
+				(size_t (*)(struct data_framer *, const uint8_t *, size_t, bool *)) &cobs_framer_decode_block,
+			.encode_block =
+				(size_t (*)(struct data_framer *, uint8_t *, size_t, bool *)) &cobs_framer_encode_block,
+			.deleter = &cobs_framer_deleter,
+			.trailer_size = 0,
+			.nb_drops = 0,
+			.nb_truncations = 0,
+		},
+
+		/*Decoding safe, waiting for the first code byte;*/
+		.insertion_index = 0,
+		.decoding_remaining = 0,
+		.decoding_code = COBS_MAX_CODE,
+		.decoding_unsafe = false,
+
+		/*Encoding starts with a code byte;*/
+		.read_segment = 0,
+		.read_index = 0,
+		.group_remaining = 0,
+		.encoding_code = 0,
+		.encoding_state = COBS_ENCODE_CODE,
+
+	};
+
+	/*Allocate, initialise and return the up-casted COBS framer;*/
+	return (struct data_framer *) kernel_malloc_copy(sizeof(struct cobs_framer), &init);
+
+}
+
+
+/*------------------------------------------------------ Decoding ------------------------------------------------------*/
+
+/**
+ * cobs_decoder_insert : inserts @data in the decoding block, or goes in the unsafe state if the block is full;
+ *
+ * @param framer : the framer that decodes;
+ * @param data : the byte to insert;
+ */
+
+static inline void cobs_decoder_insert(struct cobs_framer *const framer, const uint8_t data) {
+
+	/*Cache the decoding block;*/
+	struct data_block *decoding_block = framer->framer.decoding_block;
+
+	/*If the insertion would overflow the data block :*/
+	if (framer->insertion_index >= decoding_block->max_size) {
+
+		/*Go in the unsafe state. The frame will be discarded;*/
+		framer->decoding_unsafe = true;
+
+		/*Complete;*/
+		return;
+
+	}
+
+	/*Insert the byte, and increment the insertion index;*/
+	*((uint8_t *) decoding_block->address + framer->insertion_index++) = data;
+
+}
+
+
+/**
+ * cobs_framer_decode : transmits @data to @framer for decoding;
+ *
+ * 	If @data is a delimiter, the frame is complete if it is well formed, not empty, and was entirely stored;
+ *
+ * 	If @data is a code byte, the zero that ended the previous group is inserted, and the new group starts;
+ *
+ * 	If @data is a group byte, it is inserted;
+ *
+ * @param framer : the framer that must receive the data byte;
+ * @param data : the data byte to transmit;
+ * @return true if a block update is required;
+ */
+
+bool cobs_framer_decode(struct cobs_framer *const framer, const uint8_t data) {
+
+	/*If the byte is a delimiter :*/
+	if (!data) {
+
+		/*The frame is valid if it is safe, non empty, and its last group is complete;*/
+		bool valid = (!framer->decoding_unsafe) && (framer->insertion_index) && (!framer->decoding_remaining);
+
+		/*If the frame is valid, update the data block;*/
+		if (valid) {
+			framer->framer.decoding_block->size = framer->insertion_index;
+		} else if ((framer->insertion_index) || (framer->decoding_unsafe) || (framer->decoding_remaining)) {
+			framer->framer.nb_drops++;
+		}
+
+		/*Reset the decoder for the next frame;*/
+		framer->insertion_index = 0;
+		framer->decoding_remaining = 0;
+		framer->decoding_code = COBS_MAX_CODE;
+		framer->decoding_unsafe = false;
+
+		/*A block update is required if the frame is valid;*/
+		return valid;
+
+	}
+
+	/*If we are in an unsafe state, discard until the next delimiter;*/
+	if (framer->decoding_unsafe) {
+		return false;
+	}
+
+	/*If the byte is a code byte :*/
+	if (!framer->decoding_remaining) {
+
+		/*If the previous group was ended by a zero, insert it;*/
+		if (framer->decoding_code != COBS_MAX_CODE) {
+			cobs_decoder_insert(framer, 0);
+		}
+
+		/*Start the new group;*/
+		framer->decoding_code = data;
+		framer->decoding_remaining = (uint8_t) (data - 1);
+
+	} else {
+
+		/*The byte is a group byte, insert it;*/
+		cobs_decoder_insert(framer, data);
+
+		/*Update the group counter;*/
+		framer->decoding_remaining--;
+
+	}
+
+	/*No block update is required;*/
+	return false;
+
+}
+
+
+/**
+ * cobs_framer_decode_block : transmits up to @size bytes to @framer for decoding. Stops right after the first
+ * 	delimiter that completes a valid frame;
+ *
+ * 	Behaves as successive calls to cobs_framer_decode, but copies group bytes by runs;
+ *
+ * @param framer : the framer that must receive data bytes;
+ * @param data : the bytes to transmit;
+ * @param size : the number of bytes to transmit;
+ * @param frame_complete : set if a block update is required;
+ * @return the number of bytes consumed;
+ */
+
+size_t cobs_framer_decode_block(struct cobs_framer *const framer, const uint8_t *const data, const size_t size,
+								bool *const frame_complete) {
+
+	/*Cache the decoding block;*/
+	struct data_block *decoding_block = framer->framer.decoding_block;
+
+	/*Cache bounds;*/
+	const uint8_t *current = data, *const end = data + size;
+
+	/*While bytes remain :*/
+	while (current < end) {
+
+		/*If group bytes are expected in a safe state :*/
+		if ((framer->decoding_remaining) && (!framer->decoding_unsafe)) {
+
+			/*Determine the maximal run size;*/
+			size_t run_size = (size_t) (end - current);
+			if (run_size > framer->decoding_remaining) {
+				run_size = framer->decoding_remaining;
+			}
+
+			/*Stop the run at the first delimiter;*/
+			size_t count = 0;
+			while ((count < run_size) && (current[count])) {
+				count++;
+			}
+
+			/*If the run fits in the block :*/
+			if (count <= decoding_block->max_size - framer->insertion_index) {
+
+				/*Insert the run;*/
+				memcpy((uint8_t *) decoding_block->address + framer->insertion_index, current, count);
+
+				/*Update indices;*/
+				framer->insertion_index += count;
+				framer->decoding_remaining -= (uint8_t) count;
+				current += count;
+
+			} else {
+
+				/*The frame doesn't fit, discard it;*/
+				framer->decoding_unsafe = true;
+
+			}
+
+			/*If the whole span is consumed, stop;*/
+			if (current == end) {
+				break;
+			}
+
+		}
+
+		/*Decode the next byte (code, delimiter, or discarded byte); If the frame is complete :*/
+		if (cobs_framer_decode(framer, *(current++))) {
+
+			/*A block update is required;*/
+			*frame_complete = true;
+
+			/*Return the number of consumed bytes;*/
+			return (size_t) (current - data);
+
+		}
+
+	}
+
+	/*No block update required;*/
+	*frame_complete = false;
+
+	/*All bytes were consumed;*/
+	return size;
+
+}
+
+
+/*------------------------------------------------------ Encoding ------------------------------------------------------*/
+
+/**
+ * cobs_encoder_segment : returns the segment where the next frame byte is read. Entirely read segments are skipped;
+ * 	If the returned segment is entirely read, the whole frame is;
+ *
+ * @param framer : the framer that encodes;
+ * @return the segment to read;
+ */
+
+static struct data_block *cobs_encoder_segment(struct cobs_framer *const framer) {
+
+	/*Cache the frame;*/
+	const struct data_block *const frame = framer->framer.encoding_block;
+
+	/*Cache the read segment. At the start of a frame, its first block is read;*/
+	struct data_block *segment = (framer->read_segment) ? framer->read_segment : framer->framer.encoding_block;
+
+	struct data_block *next;
+
+	/*While the segment is entirely read and another one follows, read the next one;*/
+	while ((framer->read_index == segment->size) && (next = data_block_next_segment(frame, segment))) {
+		segment = next;
+		framer->read_index = 0;
+	}
+
+	/*Save and return the read segment;*/
+	return framer->read_segment = segment;
+
+}
+
+
+/**
+ * cobs_encoder_start_group : determines the extent of the group that starts at the read position, and returns its
+ * 	code; The group may span several segments;
+ *
+ * @param framer : the framer that encodes;
+ * @return the group's code byte;
+ */
+
+static uint8_t cobs_encoder_start_group(struct cobs_framer *const framer) {
+
+	/*Cache the frame;*/
+	const struct data_block *const frame = framer->framer.encoding_block;
+
+	/*Start at the read position;*/
+	const struct data_block *segment = cobs_encoder_segment(framer);
+	size_t index = framer->read_index;
+
+	/*The number of bytes in the group;*/
+	size_t group_size = 0;
+
+	/*Find the next zero, in at most 254 bytes :*/
+	while (group_size < COBS_MAX_CODE - 1) {
+
+		/*If the segment is entirely scanned, scan the next one, or stop at the frame end;*/
+		if (index == segment->size) {
+
+			/*Stop at the frame end;*/
+			if (!(segment = data_block_next_segment(frame, segment))) {
+				break;
+			}
+
+			/*Scan the next segment from its start;*/
+			index = 0;
+			continue;
+
+		}
+
+		/*Stop at a zero;*/
+		if (!*((const uint8_t *) segment->address + index)) {
+			break;
+		}
+
+		/*The byte belongs to the group;*/
+		group_size++;
+		index++;
+
+	}
+
+	/*Save the group size and its code;*/
+	framer->group_remaining = group_size;
+	framer->encoding_code = (uint8_t) (group_size + 1);
+
+	/*Group data come next;*/
+	framer->encoding_state = COBS_ENCODE_DATA;
+
+	/*Return the code;*/
+	return framer->encoding_code;
+
+}
+
+
+/**
+ * cobs_encoder_end_group : determines what follows the current group, once its data has been sent;
+ *
+ * 	If the frame is entirely read, the delimiter follows;
+ * 	If the group was full, no zero is implied, a new group follows;
+ * 	Otherwise, the group was ended by a zero, the zero is skipped, and a new group follows, possibly empty;
+ *
+ * @param framer : the framer that encodes;
+ */
+
+static void cobs_encoder_end_group(struct cobs_framer *const framer) {
+
+	/*Cache the read segment;*/
+	const struct data_block *const segment = cobs_encoder_segment(framer);
+
+	/*If the frame is entirely read :*/
+	if (framer->read_index == segment->size) {
+
+		/*The frame is encoded, send the delimiter;*/
+		framer->encoding_state = COBS_ENCODE_DELIMITER;
+
+	} else if (framer->encoding_code == COBS_MAX_CODE) {
+
+		/*The group was full, start a new group at its end;*/
+		framer->encoding_state = COBS_ENCODE_CODE;
+
+	} else {
+
+		/*The group was ended by a zero of the frame. Skip the zero, and start a new group;*/
+		framer->read_index++;
+		framer->encoding_state = COBS_ENCODE_CODE;
+
+	}
+
+}
+
+
+/**
+ * cobs_framer_get_encoded_byte : encodes @framer's frame and store one byte of the resulting stream in @data;
+ *
+ * 	If the provided byte completes the encoding, true is returned, for a block update;
+ *
+ * @param framer : the framer that must provide the encoded byte;
+ * @param data : the location where the byte must be stored;
+ * @return true if the frame must be updated;
+ */
+
+bool cobs_framer_get_encoded_byte(struct cobs_framer *const framer, uint8_t *const data) {
+
+	struct data_block *segment;
+
+	switch (framer->encoding_state) {
+
+		case COBS_ENCODE_CODE:
+
+			/*Start a new group and send its code;*/
+			*data = cobs_encoder_start_group(framer);
+
+			/*If the group is empty, end it immediately;*/
+			if (!framer->group_remaining) {
+				cobs_encoder_end_group(framer);
+			}
+
+			/*No block update required;*/
+			return false;
+
+		case COBS_ENCODE_DATA:
+
+			/*Cache the read segment;*/
+			segment = cobs_encoder_segment(framer);
+
+			/*Send the byte at the reading position;*/
+			*data = *((const uint8_t *) segment->address + framer->read_index++);
+
+			/*If the group is entirely sent, end it;*/
+			if (!--framer->group_remaining) {
+				cobs_encoder_end_group(framer);
+			}
+
+			/*No block update required;*/
+			return false;
+
+		default:
+
+			/*Send the delimiter;*/
+			*data = 0;
+
+			/*Reset the encoder for the next frame;*/
+			framer->read_segment = 0;
+			framer->read_index = 0;
+			framer->encoding_state = COBS_ENCODE_CODE;
+
+			/*Require an encoding block update;*/
+			return true;
+
+	}
+
+}
+
+
+/**
+ * cobs_framer_encode_block : encodes @framer's frame and stores up to @size bytes of the resulting stream in @data;
+ * 	Stops right after the delimiter that completes the frame;
+ *
+ * 	Behaves as successive calls to cobs_framer_get_encoded_byte, but copies group data at once, segment per segment;
+ *
+ * @param framer : the framer that must provide encoded bytes;
+ * @param data : the location where bytes must be stored;
+ * @param size : the maximal number of bytes to store;
+ * @param frame_complete : set if the frame must be updated;
+ * @return the number of bytes stored;
+ */
+
+size_t cobs_framer_encode_block(struct cobs_framer *const framer, uint8_t *const data, const size_t size,
+								bool *const frame_complete) {
+
+	/*The number of bytes stored;*/
+	size_t count = 0;
+
+	/*No block update required for instance;*/
+	*frame_complete = false;
+
+	/*While there is space :*/
+	while (count < size) {
+
+		/*If group data must be sent :*/
+		if (framer->encoding_state == COBS_ENCODE_DATA) {
+
+			/*Cache the read segment;*/
+			const struct data_block *const segment = cobs_encoder_segment(framer);
+
+			/*Determine the number of bytes to copy, in the group, the segment, and the provided space;*/
+			size_t run_size = framer->group_remaining;
+			if (run_size > segment->size - framer->read_index) {
+				run_size = segment->size - framer->read_index;
+			}
+			if (run_size > size - count) {
+				run_size = size - count;
+			}
+
+			/*Copy group data;*/
+			memcpy(data + count, (const uint8_t *) segment->address + framer->read_index, run_size);
+
+			/*Update indices;*/
+			framer->read_index += run_size;
+			framer->group_remaining -= run_size;
+			count += run_size;
+
+			/*If the group is entirely sent, end it;*/
+			if (!framer->group_remaining) {
+				cobs_encoder_end_group(framer);
+			}
+
+			/*Continue, space may be exhausted;*/
+			continue;
+
+		}
+
+		/*Send a code byte or the delimiter; If the frame is complete :*/
+		if (cobs_framer_get_encoded_byte(framer, data + count++)) {
+
+			/*A block update is required;*/
+			*frame_complete = true;
+
+			/*Stop after the frame boundary;*/
+			break;
+
+		}
+
+	}
+
+	/*Return the number of stored bytes;*/
+	return count;
+
+}
@@ -0,0 +1,52 @@
+/*
+  cobs_framer.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef TRACER_COBS_FRAMER
+#define TRACER_COBS_FRAMER
+
+
+#include "framer.h"
+
+
+/*
+ * The COBS framer delimits binary messages with Consistent Overhead Byte Stuffing.
+ *
+ * 	Any byte value can be carried. Zero is the frame delimiter, and never appears in an encoded frame : the frame is
+ * 	split in groups of at most 254 non-zero bytes, each one preceded by a code byte, that gives the distance to the
+ * 	next zero;
+ *
+ * 	The overhead is bounded : one code byte per started group of 254 bytes, plus the delimiter;
+ *
+ * 	Decoding :
+ *
+ * 	Bytes are decoded as they arrive, in the decoding block. A malformed frame (delimiter in the middle of a group) or
+ * 	a frame that doesn't fit in the block is discarded entirely; The decoder resynchronises on the next delimiter;
+ *
+ * 	Encoding :
+ *
+ * 	The frame is encoded as it is sent, no extra buffer is required. The frame is terminated by a zero;
+ */
+
+/*Create and initialise a COBS framer;*/
+struct data_framer *cobs_framer_create();
+
+
+#endif /*TRACER_COBS_FRAMER*/
@@ -0,0 +1,432 @@
+/*
+  crc_framer.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <kernel/res/net/netf.h>
+#include "std/syscall.h"
+#include "crc_framer.h"
+
+
+/*
+ * The CRC framer is composed of a data framer, its inner framer, and the state of the check;
+ */
+
+struct crc_framer {
+
+	/*The data framer base;*/
+	struct data_framer framer;
+
+	/*The framer that delimits frames;*/
+	struct data_framer *const inner;
+
+	/*The CRC type;*/
+	const enum crc_type type;
+
+	/*The size of the trailer;*/
+	const size_t trailer_size;
+
+
+	/*Has the trailer been appended to the current encoding block ?*/
+	bool encoding_sealed;
+
+
+	/*The number of frames dropped for a bad CRC;*/
+	size_t nb_errors;
+
+};
+
+
+/*Private headers;*/
+void crc_framer_deleter(struct crc_framer *framer);
+
+bool crc_framer_decode(struct crc_framer *framer, uint8_t data);
+
+bool crc_framer_get_encoded_byte(struct crc_framer *framer, uint8_t *data);
+
+size_t crc_framer_decode_block(struct crc_framer *framer, const uint8_t *data, size_t size, bool *frame_complete);
+
+size_t crc_framer_encode_block(struct crc_framer *framer, uint8_t *data, size_t size, bool *frame_complete);
+
+
+/**
+ * crc_framer_create : creates and initialises a CRC stage over @inner, and return its framer casted version;
+ *
+ * @param inner : the framer that delimits frames. Owned by the stage, deleted with it;
+ * @param type : the CRC type;
+ * @return the casted version of the framer;
+ */
+
+struct data_framer *crc_framer_create(struct data_framer *const inner, const enum crc_type type) {
+
+	struct crc_framer init = {
+
+		.framer = {
+
+			/*Blocks not initialised for instance;*/
+			.encoding_block = 0,
+			.decoding_block = 0,
+
+			.encode = (bool (*)(struct data_framer *, uint8_t *)) &crc_framer_get_encoded_byte,
+			.decode = (bool (*)(struct data_framer *, uint8_t)) &crc_framer_decode,
+			.decode_block =
+				(size_t (*)(struct data_framer *, const uint8_t *, size_t, bool *)) &crc_framer_decode_block,
+			.encode_block =
+				(size_t (*)(struct data_framer *, uint8_t *, size_t, bool *)) &crc_framer_encode_block,
+			.deleter = (void (*)(struct data_framer *)) &crc_framer_deleter,
+			.trailer_size = crc_size(type) + inner->trailer_size,
+			.nb_drops = 0,
+			.nb_truncations = 0,
+		},
+
+		/*Save the inner framer and the CRC type;*/
+		.inner = inner,
+		.type = type,
+		.trailer_size = crc_size(type),
+
+		/*No frame sealed;*/
+		.encoding_sealed = false,
+
+		/*No error;*/
+		.nb_errors = 0,
+
+	};
+
+	/*Allocate, initialise and return the up-casted CRC framer;*/
+	return (struct data_framer *) kernel_malloc_copy(sizeof(struct crc_framer), &init);
+
+}
+
+
+/**
+ * crc_framer_deleter : deletes the inner framer and the stage;
+ *
+ * @param framer : the stage to delete;
+ */
+
+void crc_framer_deleter(struct crc_framer *const framer) {
+
+	/*Cache the inner framer;*/
+	struct data_framer *const inner = framer->inner;
+
+	/*Delete the inner framer;*/
+	(*(inner->deleter))(inner);
+
+	/*Free the stage;*/
+	kernel_free(framer);
+
+}
+
+
+/**
+ * crc_framer_nb_errors : returns the number of frames dropped by the stage;
+ *
+ * @param framer : the stage to examine;
+ * @return the number of frames dropped for a bad CRC;
+ */
+
+size_t crc_framer_nb_errors(const struct data_framer *const framer) {
+
+	/*Return the error counter;*/
+	return ((const struct crc_framer *) framer)->nb_errors;
+
+}
+
+
+/*------------------------------------------------------ Decoding ------------------------------------------------------*/
+
+/**
+ * crc_framer_check : verifies and removes the trailer of a decoded frame. If the check fails, the frame is counted;
+ *
+ * @param framer : the stage that decoded the frame;
+ * @return true if the frame is valid;
+ */
+
+static bool crc_framer_check(struct crc_framer *const framer) {
+
+	/*Cache the decoding block;*/
+	struct data_block *const block = framer->framer.decoding_block;
+
+	/*Cache the trailer size;*/
+	const size_t trailer_size = framer->trailer_size;
+
+	/*If the frame can't contain a trailer and data :*/
+	if (block->size <= trailer_size) {
+
+		/*Drop the frame;*/
+		framer->nb_errors++;
+		return false;
+
+	}
+
+	/*Determine the size of the frame's data;*/
+	const size_t size = block->size - trailer_size;
+
+	/*Cache the trailer;*/
+	const uint8_t *const trailer = (const uint8_t *) block->address + size;
+
+	/*Compute the CRC of the frame's data;*/
+	uint32_t crc = crc_compute(framer->type, block->address, size);
+
+	/*Compare the CRC with the trailer, least significant byte first;*/
+	for (size_t i = 0; i < trailer_size; i++) {
+
+		/*If bytes differ :*/
+		if (trailer[i] != (uint8_t) crc) {
+
+			/*Drop the frame;*/
+			framer->nb_errors++;
+			return false;
+
+		}
+
+		/*Focus on the next byte;*/
+		crc >>= 8;
+
+	}
+
+	/*Remove the trailer;*/
+	block->size = size;
+
+	/*The frame is valid;*/
+	return true;
+
+}
+
+
+/**
+ * crc_framer_update_drops : updates the drop counter of the stage, that includes frames dropped by the inner framer,
+ * 	and forwards inner truncations. A truncated frame then fails its check, and is also counted as a drop;
+ *
+ * @param framer : the stage to update;
+ */
+
+static inline void crc_framer_update_drops(struct crc_framer *const framer) {
+
+	/*Sum inner drops and CRC errors;*/
+	framer->framer.nb_drops = framer->inner->nb_drops + framer->nb_errors;
+	framer->framer.nb_truncations = framer->inner->nb_truncations;
+
+}
+
+
+/**
+ * crc_framer_decode : transmits @data to the inner framer, and verifies frames it completes;
+ *
+ * @param framer : the stage that must receive the data byte;
+ * @param data : the data byte to transmit;
+ * @return true if a valid frame is complete;
+ */
+
+bool crc_framer_decode(struct crc_framer *const framer, const uint8_t data) {
+
+	/*Cache the inner framer;*/
+	struct data_framer *const inner = framer->inner;
+
+	/*Share the decoding block;*/
+	inner->decoding_block = framer->framer.decoding_block;
+
+	/*Transmit the byte, and verify the frame if it is complete;*/
+	const bool valid = ((*(inner->decode))(inner, data)) && (crc_framer_check(framer));
+
+	/*Update the drop counter;*/
+	crc_framer_update_drops(framer);
+
+	/*Assert if a valid frame is complete;*/
+	return valid;
+
+}
+
+
+/**
+ * crc_framer_decode_block : transmits up to @size bytes to the inner framer, and verifies frames it completes. Stops
+ * 	right after the first valid frame;
+ *
+ * @param framer : the stage that must receive data bytes;
+ * @param data : the bytes to transmit;
+ * @param size : the number of bytes to transmit;
+ * @param frame_complete : set if a valid frame is complete;
+ * @return the number of bytes consumed;
+ */
+
+size_t crc_framer_decode_block(struct crc_framer *const framer, const uint8_t *const data, const size_t size,
+							   bool *const frame_complete) {
+
+	/*Cache the inner framer;*/
+	struct data_framer *const inner = framer->inner;
+
+	/*The number of bytes consumed;*/
+	size_t consumed = 0;
+
+	/*Share the decoding block;*/
+	inner->decoding_block = framer->framer.decoding_block;
+
+	/*While bytes remain :*/
+	while (consumed < size) {
+
+		/*Transmit bytes until the next frame boundary;*/
+		consumed += (*(inner->decode_block))(inner, data + consumed, size - consumed, frame_complete);
+
+		/*If a frame is complete and valid, stop after it;*/
+		if ((*frame_complete) && (crc_framer_check(framer))) {
+			crc_framer_update_drops(framer);
+			return consumed;
+		}
+
+	}
+
+	/*Update the drop counter;*/
+	crc_framer_update_drops(framer);
+
+	/*No valid frame;*/
+	*frame_complete = false;
+
+	/*All bytes were consumed;*/
+	return size;
+
+}
+
+
+/*------------------------------------------------------ Encoding ------------------------------------------------------*/
+
+/**
+ * crc_framer_seal : appends the CRC trailer to the encoding chain, if it was not already done;
+ *
+ * 	The CRC covers all segments of the chain, the trailer is appended to the last one;
+ *
+ * @param framer : the stage that encodes;
+ */
+
+static void crc_framer_seal(struct crc_framer *const framer) {
+
+	/*If the trailer is already appended, nothing to do;*/
+	if (framer->encoding_sealed) {
+		return;
+	}
+
+	/*Cache the frame;*/
+	struct data_block *const frame = framer->framer.encoding_block;
+
+	/*Cache the trailer size;*/
+	const size_t trailer_size = framer->trailer_size;
+
+	/*Compute the CRC of the first segment;*/
+	uint32_t crc = crc_compute(framer->type, frame->address, frame->size);
+
+	/*Continue the CRC over following segments, and find the last one;*/
+	struct data_block *block = frame, *next;
+	while ((next = data_block_next_segment(frame, block))) {
+		block = next;
+		crc = crc_continue(framer->type, crc, block->address, block->size);
+	}
+
+	/*The frame is sealed, with its trailer or without;*/
+	framer->encoding_sealed = true;
+
+	/*If the last segment can't contain the trailer, send the frame without it, the receiver will drop it. Interfaces
+	 * reserve the trailer, and reject such frames at commit;*/
+	if (block->max_size - block->size < trailer_size) {
+		return;
+	}
+
+	/*Cache the trailer;*/
+	uint8_t *const trailer = (uint8_t *) block->address + block->size;
+
+	/*Append the CRC, least significant byte first;*/
+	for (size_t i = 0; i < trailer_size; i++) {
+		trailer[i] = (uint8_t) crc;
+		crc >>= 8;
+	}
+
+	/*Update the segment size;*/
+	block->size += trailer_size;
+
+}
+
+
+/**
+ * crc_framer_get_encoded_byte : seals the current frame if required, and gets an encoded byte from the inner framer;
+ *
+ * @param framer : the stage that must provide the encoded byte;
+ * @param data : the location where the byte must be stored;
+ * @return true if the frame must be updated;
+ */
+
+bool crc_framer_get_encoded_byte(struct crc_framer *const framer, uint8_t *const data) {
+
+	/*Cache the inner framer;*/
+	struct data_framer *const inner = framer->inner;
+
+	/*Seal the frame;*/
+	crc_framer_seal(framer);
+
+	/*Share the encoding block;*/
+	inner->encoding_block = framer->framer.encoding_block;
+
+	/*Get a byte; If the frame is complete :*/
+	if ((*(inner->encode))(inner, data)) {
+
+		/*The next frame will have to be sealed;*/
+		framer->encoding_sealed = false;
+
+		/*A block update is required;*/
+		return true;
+
+	}
+
+	/*No block update required;*/
+	return false;
+
+}
+
+
+/**
+ * crc_framer_encode_block : seals the current frame if required, and gets up to @size encoded bytes from the inner
+ * 	framer;
+ *
+ * @param framer : the stage that must provide encoded bytes;
+ * @param data : the location where bytes must be stored;
+ * @param size : the maximal number of bytes to store;
+ * @param frame_complete : set if the frame must be updated;
+ * @return the number of bytes stored;
+ */
+
+size_t crc_framer_encode_block(struct crc_framer *const framer, uint8_t *const data, const size_t size,
+							   bool *const frame_complete) {
+
+	/*Cache the inner framer;*/
+	struct data_framer *const inner = framer->inner;
+
+	/*Seal the frame;*/
+	crc_framer_seal(framer);
+
+	/*Share the encoding block;*/
+	inner->encoding_block = framer->framer.encoding_block;
+
+	/*Get bytes until the frame boundary;*/
+	const size_t count = (*(inner->encode_block))(inner, data, size, frame_complete);
+
+	/*If the frame is complete, the next one will have to be sealed;*/
+	if (*frame_complete) {
+		framer->encoding_sealed = false;
+	}
+
+	/*Return the number of stored bytes;*/
+	return count;
+
+}
@@ -0,0 +1,56 @@
+/*
+  crc_framer.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef TRACER_CRC_FRAMER
+#define TRACER_CRC_FRAMER
+
+
+#include "framer.h"
+
+#include <kernel/res/net/crc.h>
+
+
+/*
+ * The CRC framer is a stage that adds an integrity check to another framer, the inner framer;
+ *
+ * 	Encoding :
+ *
+ * 	Before a frame is encoded, its CRC is appended to it, least significant byte first, and the inner framer encodes
+ * 	the frame and its trailer. The frame block, or the last segment of a chained frame, must have space for the
+ * 	trailer : the stage declares its size, interfaces reserve it, and reject frames that leave no space at commit.
+ * 	A frame that reaches the stage without space is sent without trailer, and dropped by the receiver;
+ *
+ * 	Decoding :
+ *
+ * 	The inner framer decodes frames with their trailer. The trailer is verified and removed. Frames with a bad CRC, or
+ * 	too short to contain a trailer, are dropped and counted;
+ *
+ * 	The trailer is binary, the inner framer must be able to carry any byte (COBS for example, not ascii);
+ */
+
+/*Create a CRC stage over @inner, that it owns;*/
+struct data_framer *crc_framer_create(struct data_framer *inner, enum crc_type type);
+
+/*Get the number of frames dropped for a bad CRC;*/
+size_t crc_framer_nb_errors(const struct data_framer *framer);
+
+
+#endif /*TRACER_CRC_FRAMER*/
@@ -41,7 +41,7 @@ struct data_framer {
 	/*The block where we save the result of the decoding;*/
 	struct data_block *decoding_block;
 
-	/*The block that contains frames to encode;*/
+	/*The block that contains frames to encode. May be the first block of a chain, that is encoded as a single frame;*/
 	struct data_block *encoding_block;
 
 
@@ -51,9 +51,34 @@ struct data_framer {
 	/*Read (and discard) a byte from the current frame. Will assert if the frame has been entirely encoded;*/
 	bool (*const encode)(struct data_framer *, uint8_t *data);
 
+
+	/*
+	 * Block operations process a byte span at once, and stop right after a frame boundary, so that the caller can
+	 * 	update the related block. They return the number of bytes consumed or produced, and set @frame_complete if a
+	 * 	frame boundary was reached;
+	 */
+
+	/*Write up to @size bytes in the framer;*/
+	size_t (*const decode_block)(struct data_framer *, const uint8_t *data, size_t size, bool *frame_complete);
+
+	/*Read up to @size encoded bytes from the current frame;*/
+	size_t (*const encode_block)(struct data_framer *, uint8_t *data, size_t size, bool *frame_complete);
+
+
 	/*Delete the framer;*/
 	void (*deleter)(struct data_framer *);
 
+
+	/*The number of bytes the framer appends to the last segment of a frame at encoding (a check trailer);*/
+	size_t trailer_size;
+
+
+	/*The number of received frames dropped by the framer (oversized, malformed, failed check);*/
+	size_t nb_drops;
+
+	/*The number of received frames truncated to the block size, and delivered;*/
+	size_t nb_truncations;
+
 };
 
 #endif /*TRACER_FRAMER_H*/
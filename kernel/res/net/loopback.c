@@ -0,0 +1,337 @@
+/*
+  loopback.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "loopback.h"
+
+#include <string.h>
+
+#include "std/syscall.h"
+
+
+#ifdef LOOPBACK_HOST_FD
+
+#include <unistd.h>
+
+#include <fcntl.h>
+
+#include <poll.h>
+
+#endif
+
+
+/*--------------------------------------------------- Pipe functions ---------------------------------------------------*/
+
+/**
+ * loopback_enable_rx : enables reception if a decoding block is available;
+ *
+ * @param iface : the interface to update;
+ */
+
+static void loopback_enable_rx(struct loopback_net21 *const iface) {
+
+	/*Enable reception if the framer can decode;*/
+	iface->rx_enabled = netf21_init_decoding(&iface->iface);
+
+}
+
+
+/**
+ * loopback_enable_tx : enables transmission if a frame is available for encoding;
+ *
+ * @param iface : the interface to update;
+ */
+
+static void loopback_enable_tx(struct loopback_net21 *const iface) {
+
+	/*Enable transmission if the framer has a frame to encode;*/
+	iface->tx_enabled = netf21_init_encoding(&iface->iface);
+
+}
+
+
+/*------------------------------------------------- Creation - Deletion ------------------------------------------------*/
+
+/**
+ * loopback_create : creates a loopback interface in memory mode, and enables reception;
+ *
+ * @param framer : the framer to use. Owned by the interface;
+ * @param nb_frames : the number of frames in each direction;
+ * @param frame_size : the maximal size of a frame;
+ * @return the created interface;
+ */
+
+struct loopback_net21 *loopback_create(struct data_framer *const framer, const size_t nb_frames,
+									   const size_t frame_size) {
+
+	/*Initialise the interface struct;*/
+	struct loopback_net21 init = {
+
+		/*Initialise the l2 adapter;*/
+		.iface = {
+
+			/*The l2 if will be initialised right after;*/
+			.iface = {},
+
+			/*Transfer the ownership of the framer;*/
+			.framer = framer,
+
+		},
+
+		/*Nothing enabled for instance;*/
+		.rx_enabled = false,
+		.tx_enabled = false,
+
+#ifdef LOOPBACK_HOST_FD
+
+		/*Memory mode;*/
+		.rx_fd = -1,
+		.tx_fd = -1,
+
+#endif
+
+	};
+
+	/*Initialise the layer 2 if;*/
+	netf2_init(
+		&init.iface.iface,
+		nb_frames,
+		frame_size,
+		(void (*)(struct netf2 *)) loopback_enable_rx,
+		(void (*)(struct netf2 *)) loopback_enable_tx,
+		(void (*)(struct netf2 *)) netf21_destruct
+	);
+
+	/*Reserve the trailer of the framer in tx frames;*/
+	netf21_reserve_trailer(&init.iface);
+
+	/*Allocate and initialise the if;*/
+	struct loopback_net21 *const iface = kernel_malloc_copy(sizeof(struct loopback_net21), &init);
+
+	/*Enable reception;*/
+	loopback_enable_rx(iface);
+
+	/*Return the interface;*/
+	return iface;
+
+}
+
+
+/**
+ * loopback_delete : deletes a loopback interface, its blocks and its framer;
+ *
+ * @param iface : the interface to delete;
+ */
+
+void loopback_delete(struct loopback_net21 *const iface) {
+
+	/*Delete the if, calling the superclass deleter;*/
+	netf2_delete((struct netf2 *) iface);
+
+}
+
+
+#ifdef LOOPBACK_HOST_FD
+
+/**
+ * loopback_attach_fds : attaches file descriptors to the interface;
+ *
+ * 	The receive descriptor is made non blocking, so that the pump never waits for bytes;
+ *
+ * @param iface : the interface to update;
+ * @param rx_fd : the descriptor to read received bytes from. Negative to receive encoded bytes;
+ * @param tx_fd : the descriptor to write encoded bytes to. Negative to receive them;
+ */
+
+void loopback_attach_fds(struct loopback_net21 *const iface, const int rx_fd, const int tx_fd) {
+
+	/*Save descriptors;*/
+	iface->rx_fd = rx_fd;
+	iface->tx_fd = tx_fd;
+
+	/*If a receive descriptor is provided, make reads non blocking;*/
+	if (rx_fd >= 0) {
+		fcntl(rx_fd, F_SETFL, fcntl(rx_fd, F_GETFL) | O_NONBLOCK);
+	}
+
+}
+
+#endif
+
+
+/*---------------------------------------------------- Data transfer ---------------------------------------------------*/
+
+/**
+ * loopback_receive : transmits received bytes to the framer. If reception is disabled, bytes are lost and counted;
+ *
+ * @param iface : the interface that receives;
+ * @param data : received bytes;
+ * @param size : the number of received bytes;
+ */
+
+static void loopback_receive(struct loopback_net21 *const iface, const uint8_t *const data, const size_t size) {
+
+	/*Bytes decoded;*/
+	size_t decoded = 0;
+
+	/*If reception is enabled, decode bytes, and disable reception if no block remains;*/
+	if (iface->rx_enabled) {
+		decoded = size;
+		iface->rx_enabled = netf_21_decode_block(&iface->iface, data, &decoded);
+	}
+
+	/*Bytes that were not decoded are lost;*/
+	iface->iface.iface.stats.rx_lost_bytes += size - decoded;
+
+}
+
+
+/**
+ * loopback_transmit : transmits encoded bytes, to the descriptor, or back to the framer in memory mode;
+ *
+ * @param iface : the interface that transmits;
+ * @param data : encoded bytes;
+ * @param size : the number of encoded bytes;
+ */
+
+static void loopback_transmit(struct loopback_net21 *const iface, const uint8_t *data, size_t size) {
+
+#ifdef LOOPBACK_HOST_FD
+
+	/*If a descriptor is attached :*/
+	if (iface->tx_fd >= 0) {
+
+		/*Write all bytes;*/
+		while (size) {
+
+			/*Write as many bytes as possible;*/
+			ssize_t written = write(iface->tx_fd, data, size);
+
+			/*If the write failed, bytes are lost;*/
+			if (written <= 0) {
+				return;
+			}
+
+			/*Update the span;*/
+			data += written;
+			size -= (size_t) written;
+
+		}
+
+		/*Complete;*/
+		return;
+
+	}
+
+#endif
+
+	/*Memory mode : receive encoded bytes;*/
+	loopback_receive(iface, data, size);
+
+}
+
+
+/**
+ * loopback_clear_to_send : asserts if the receiver accepts bytes. In memory mode, the receiver is the interface
+ * 	itself, and pauses the transmission while its reception is paused by flow control, as RTS / CTS would;
+ *
+ * @param iface : the interface that transmits;
+ * @return true if bytes can be transmitted;
+ */
+
+static bool loopback_clear_to_send(const struct loopback_net21 *const iface) {
+
+#ifdef LOOPBACK_HOST_FD
+
+	/*If a descriptor is attached, transmit if it accepts a burst without blocking. Bursts are smaller than PIPE_BUF;*/
+	if (iface->tx_fd >= 0) {
+
+		/*Poll the descriptor, without waiting;*/
+		struct pollfd fd = {.fd = iface->tx_fd, .events = POLLOUT};
+		return (poll(&fd, 1, 0) == 1) && (fd.revents & POLLOUT);
+
+	}
+
+#endif
+
+	/*Transmit if the reception is not paused;*/
+	return !iface->iface.iface.rx_throttled;
+
+}
+
+
+/**
+ * loopback_pump : moves up to @max_bytes encoded bytes, by bursts, as the UART interrupts do with their FIFOs;
+ *
+ * 	If a receive descriptor is attached, available bytes are read and decoded too;
+ *
+ * @param iface : the interface to pump;
+ * @param max_bytes : the maximal number of bytes to transmit;
+ * @return the number of bytes transmitted;
+ */
+
+size_t loopback_pump(struct loopback_net21 *const iface, const size_t max_bytes) {
+
+	/*Cache a burst of bytes;*/
+	uint8_t burst[LOOPBACK_BURST_SIZE];
+
+	/*The number of bytes transmitted;*/
+	size_t moved = 0;
+
+	/*While transmission is enabled, the receiver accepts bytes, and bytes can be moved :*/
+	while ((iface->tx_enabled) && (loopback_clear_to_send(iface)) && (moved < max_bytes)) {
+
+		/*Determine the number of bytes to get;*/
+		size_t size = max_bytes - moved;
+		if (size > LOOPBACK_BURST_SIZE) {
+			size = LOOPBACK_BURST_SIZE;
+		}
+
+		/*Get encoded bytes, and disable transmission if no frame remains;*/
+		iface->tx_enabled = netf_21_get_encoded_block(&iface->iface, burst, &size);
+
+		/*Transmit bytes;*/
+		loopback_transmit(iface, burst, size);
+
+		/*Update the counter;*/
+		moved += size;
+
+	}
+
+#ifdef LOOPBACK_HOST_FD
+
+	/*If a receive descriptor is attached :*/
+	if (iface->rx_fd >= 0) {
+
+		/*The number of bytes read;*/
+		ssize_t count;
+
+		/*Receive available bytes while reception is enabled. Otherwise, they wait in the descriptor, as in a FIFO;*/
+		while ((iface->rx_enabled) && ((count = read(iface->rx_fd, burst, LOOPBACK_BURST_SIZE)) > 0)) {
+			loopback_receive(iface, burst, (size_t) count);
+		}
+
+	}
+
+#endif
+
+	/*Return the number of bytes transmitted;*/
+	return moved;
+
+}
@@ -0,0 +1,83 @@
+/*
+  loopback.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_LOOPBACK_H
+#define TRACER_LOOPBACK_H
+
+#include <kernel/res/net/netf.h>
+
+
+/*
+ * The loopback driver is a software netf21 : it drives the framer's encode and decode operations, as the UART
+ * 	interrupts do, but moves bytes in software, when it is pumped;
+ *
+ * 	In memory mode, encoded bytes are decoded by the same interface : frames sent are received back;
+ *
+ * 	If LOOPBACK_HOST_FD is defined, (host builds only) encoded bytes can be written to a file descriptor, and
+ * 	received bytes read from another one, a pipe or a pty for example;
+ *
+ * 	It allows exercising the framing pipeline without the hardware;
+ */
+
+/*The number of bytes moved per framer call;*/
+#define LOOPBACK_BURST_SIZE 64
+
+
+struct loopback_net21 {
+
+	/*The OSI layer 1-2 if;*/
+	struct netf21 iface;
+
+	/*Reception and transmission enable flags, the software equivalent of interrupt enable bits;*/
+	volatile bool rx_enabled;
+	volatile bool tx_enabled;
+
+#ifdef LOOPBACK_HOST_FD
+
+	/*The descriptor received bytes are read from. Negative in memory mode;*/
+	int rx_fd;
+
+	/*The descriptor encoded bytes are written to. Negative in memory mode;*/
+	int tx_fd;
+
+#endif
+
+};
+
+
+/*Create a loopback interface. The framer is owned by the interface;*/
+struct loopback_net21 *loopback_create(struct data_framer *framer, size_t nb_frames, size_t frame_size);
+
+/*Delete a loopback interface;*/
+void loopback_delete(struct loopback_net21 *iface);
+
+/*Move up to @max_bytes encoded bytes. Returns the number of bytes moved;*/
+size_t loopback_pump(struct loopback_net21 *iface, size_t max_bytes);
+
+
+#ifdef LOOPBACK_HOST_FD
+
+/*Attach file descriptors to the interface. Negative descriptors select the memory mode;*/
+void loopback_attach_fds(struct loopback_net21 *iface, int rx_fd, int tx_fd);
+
+#endif
+
+
+#endif /*TRACER_LOOPBACK_H*/
@@ -20,10 +20,16 @@
 
 #include "netf.h"
 
+#include "protocol.h"
+
+#include "frame_pool.h"
+
 #include <string.h>
 
 #include "std/syscall.h"
 
+#include <kernel/core/except.h>
+
 
 
 
@@ -47,6 +53,11 @@ struct data_block *data_block_create(size_t size) {
 
 		/*Save the block size;*/
 		.max_size = size,
+
+		/*The block is held by its creator;*/
+		.loan = DATA_BLOCK_HELD,
+		.lender = 0,
+
 	};
 
 	/*Allocate the block;*/
@@ -103,31 +114,126 @@ void data_block_copy(const struct data_block *const src, struct data_block *cons
 }
 
 
+/**
+ * data_block_chain : appends @segment and its chain at the end of @frame's chain;
+ *
+ * @param frame : the first block of the chain to extend;
+ * @param segment : the first block of the chain to append;
+ */
+
+void data_block_chain(struct data_block *const frame, struct data_block *const segment) {
+
+	/*If the segment is already in the frame's chain :*/
+	if (segment == frame) {
+
+		/*Error, the chain would be corrupted;*/
+		kernel_error("netf.c : data_block_chain : a block can't be chained to itself;");
+
+	}
+
+	/*Concatenate both chains. Chains are circular, @segment comes after the last segment of @frame;*/
+	list_concat((struct list_head *) frame, (struct list_head *) segment);
+
+}
+
+
+/**
+ * data_block_unchain : removes @segment from its chain, and makes it a single block;
+ *
+ * @param segment : the block to remove;
+ */
+
+void data_block_unchain(struct data_block *const segment) {
+
+	/*Remove the block from its chain;*/
+	list_remove((struct list_head *) segment);
+
+	/*Reset its links;*/
+	list_init((struct list_head *) segment);
+
+}
+
+
+/**
+ * data_block_chain_size : returns the total size of @frame's chain;
+ *
+ * @param frame : the first block of the chain;
+ * @return the sum of the sizes of all segments;
+ */
+
+size_t data_block_chain_size(const struct data_block *const frame) {
+
+	/*The size of the first segment;*/
+	size_t size = frame->size;
+
+	/*Add the size of each following segment;*/
+	for (const struct data_block *segment = frame; (segment = data_block_next_segment(frame, segment));) {
+		size += segment->size;
+	}
+
+	/*Return the size of the chain;*/
+	return size;
+
+}
+
+
 /*----------------------------------------------------- Init - Exit ----------------------------------------------------*/
 
-/*Initalise a layer 2 if : create and fill fifos, assign function pointers;*/
-void netf2_init(
+/**
+ * netf2_setup : initialises @iface with empty rings, that can contain @capacity blocks per direction, and assigns
+ * 	function pointers;
+ *
+ * @param iface : the interface to initialise;
+ * @param capacity : the maximal number of blocks per direction;
+ * @param frame_size : the minimal size of frames;
+ * @param pooled : set if frames are drawn from the shared frame pool;
+ * @param enable_rx_hw_irq : the rx interrupt enabler;
+ * @param enable_tx_hw_irq : the tx interrupt enabler;
+ * @param destructor : the implementation deleter;
+ */
+
+static void netf2_setup(
 	struct netf2 *const iface,
-	size_t nb_frames,
+	const size_t capacity,
 	const size_t frame_size,
+	const bool pooled,
 	void (*const enable_rx_hw_irq)(struct netf2 *),
 	void (*const enable_tx_hw_irq)(struct netf2 *),
 	void (*const destructor)(struct netf2 *)
 ) {
 
-	/*Create the fifo initializer;*/
-	struct shared_fifo fifo_init = {
-		.list = 0,
-	};
-
 	/*Create the interfaces initializer;*/
 	struct netf2 iface_init = {
 
-		/*Allocate and initialise all lists;*/
-		.rx_empty = kernel_malloc_copy(sizeof(struct shared_fifo), &fifo_init),
-		.rx_nonempty = kernel_malloc_copy(sizeof(struct shared_fifo), &fifo_init),
-		.tx_empty = kernel_malloc_copy(sizeof(struct shared_fifo), &fifo_init),
-		.tx_nonempty = kernel_malloc_copy(sizeof(struct shared_fifo), &fifo_init),
+		/*Create all rings. Each one must be able to contain all blocks of its direction;*/
+		.rx_empty = block_ring_create(capacity),
+		.rx_nonempty = block_ring_create(capacity),
+		.tx_empty = block_ring_create(capacity),
+		.tx_nonempty = block_ring_create(capacity),
+
+		/*No cancelled tx block;*/
+		.tx_spare = 0,
+
+		/*Save the frame policy;*/
+		.pooled = pooled,
+		.frame_size = frame_size,
+
+		/*No trailer until a framer reserves it;*/
+		.tx_reserve = 0,
+
+		/*Quotas are set by the pooled initialiser;*/
+		.rx_quota = {},
+		.tx_quota = {},
+
+		/*No protocol attached;*/
+		.protocol = 0,
+
+		/*No traffic;*/
+		.stats = {},
+
+		/*No flow control;*/
+		.rx_watermark = 0,
+		.rx_throttled = false,
 
 		/*Assign function pointers;*/
 		.enable_rx_hw_irq = enable_rx_hw_irq,
@@ -136,6 +242,25 @@ void netf2_init(
 
 	};
 
+	/*Initialise the if;*/
+	memcpy(iface, &iface_init, sizeof(struct netf2));
+
+}
+
+
+/*Initalise a layer 2 if : create and fill rings, assign function pointers;*/
+void netf2_init(
+	struct netf2 *const iface,
+	size_t nb_frames,
+	const size_t frame_size,
+	void (*const enable_rx_hw_irq)(struct netf2 *),
+	void (*const enable_tx_hw_irq)(struct netf2 *),
+	void (*const destructor)(struct netf2 *)
+) {
+
+	/*Initialise the if with private frames;*/
+	netf2_setup(iface, nb_frames, frame_size, false, enable_rx_hw_irq, enable_tx_hw_irq, destructor);
+
 	/*
 	 * Create data blocks;
 	 */
@@ -146,25 +271,241 @@ void netf2_init(
 		/*Create a block;*/
 		struct data_block *block = data_block_create(frame_size);
 
-		/*Push the block in the rx_empty list;*/
-		shared_fifo_push(iface_init.rx_empty, (struct list_head *) block);
+		/*Push the block in the rx_empty ring;*/
+		block_ring_push(&iface->rx_empty, block);
 
 		/*Create another block;*/
 		block = data_block_create(frame_size);
 
-		/*Push the block in the tx_empty list;*/
-		shared_fifo_push(iface_init.tx_empty, (struct list_head *) block);
+		/*Push the block in the tx_empty ring;*/
+		block_ring_push(&iface->tx_empty, block);
 
 	}
 
-	/*Initialise the if;*/
-	memcpy(iface, &iface_init, sizeof(struct netf2));
+}
+
+
+/**
+ * netf2_reserve : allocates @quota's minimum of pool frames, and pushes them in @ring. Reserved frames are allocated
+ * 	for the interface rather than taken from the pool, so that the reservation never depends on other interfaces;
+ *
+ * @param iface : the interface that reserves frames;
+ * @param quota : the quota of the direction;
+ * @param ring : the ring of empty frames of the direction;
+ */
+
+static void netf2_reserve(struct netf2 *const iface, struct netf2_quota *const quota, struct block_ring *const ring) {
+
+	/*For each frame to reserve :*/
+	while (quota->held < quota->min) {
+
+		/*Allocate a pool frame, push it in the ring, and update the quota;*/
+		block_ring_push(ring, frame_pool_allocate(iface->frame_size));
+		quota->held++;
+
+	}
+
+}
+
+
+/**
+ * netf2_pool_share : returns the number of frames an interface adds to the pool : its reservation in both
+ * 	directions, and a single burst margin, that both directions share with other interfaces;
+ *
+ * @param iface : the pooled interface;
+ * @return the number of frames;
+ */
+
+static inline size_t netf2_pool_share(const struct netf2 *const iface) {
+
+	/*Two reservations, and the margin of a direction;*/
+	return iface->rx_quota.min + iface->rx_quota.max;
+
+}
+
+
+/**
+ * netf2_init_pooled : initialises a layer 2 if whose frames are drawn from the shared frame pool;
+ *
+ * 	@min_frames frames are reserved per direction and held by the interface. Up to @max_frames frames per direction
+ * 	are drawn from the pool when traffic bursts, and given back when they are released;
+ *
+ * 	The interface provisions the pool with its burst margin, @max_frames - @min_frames frames, that both directions
+ * 	and other interfaces draw from. Its share is withdrawn when it is deleted;
+ *
+ * 	The quota and the frame size may come from a process : they are checked, rather than failing the kernel;
+ *
+ * @param iface : the interface to initialise;
+ * @param min_frames : the number of frames reserved per direction;
+ * @param max_frames : the maximal number of frames held per direction;
+ * @param frame_size : the minimal size of frames;
+ * @param enable_rx_hw_irq : the rx interrupt enabler;
+ * @param enable_tx_hw_irq : the tx interrupt enabler;
+ * @param destructor : the implementation deleter;
+ * @return true if the interface was initialised, false if the quota is invalid, or if frames are too large for the
+ * 	pool;
+ */
+
+bool netf2_init_pooled(
+	struct netf2 *const iface,
+	const size_t min_frames,
+	const size_t max_frames,
+	const size_t frame_size,
+	void (*const enable_rx_hw_irq)(struct netf2 *),
+	void (*const enable_tx_hw_irq)(struct netf2 *),
+	void (*const destructor)(struct netf2 *)
+) {
+
+	/*If the cap is lesser than the reservation, or null, or if no class of the pool fits frames, fail;*/
+	if ((!max_frames) || (max_frames < min_frames) || (!frame_pool_block_size(frame_size))) {
+		return false;
+	}
+
+	/*Initialise the if with pooled frames, rings can contain the cap;*/
+	netf2_setup(iface, max_frames, frame_size, true, enable_rx_hw_irq, enable_tx_hw_irq, destructor);
+
+	/*Set both quotas;*/
+	iface->rx_quota = iface->tx_quota = (struct netf2_quota) {.min = min_frames, .max = max_frames, .held = 0};
+
+	/*Reserve frames;*/
+	netf2_reserve(iface, &iface->rx_quota, &iface->rx_empty);
+	netf2_reserve(iface, &iface->tx_quota, &iface->tx_empty);
+
+	/*Provision the burst margin;*/
+	frame_pool_provision(frame_size, max_frames - min_frames);
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * netf2_dispose : deletes a private block, or gives a pooled one back to the pool;
+ *
+ * @param iface : the interface that holds the block;
+ * @param block : the block to dispose of;
+ */
 
+static void netf2_dispose(const struct netf2 *const iface, struct data_block *const block) {
+
+	/*Give the block back or delete it;*/
+	if (iface->pooled) {
+		frame_pool_give(block);
+	} else {
+		data_block_delete(block);
+	}
 
 }
 
 
-/*Destruct the if : delete fifos and their content;TODO*/
+/**
+ * netf2_draw : draws a frame from the pool, if the interface's frames are pooled and the quota allows it;
+ *
+ * @param iface : the interface that draws;
+ * @param quota : the quota of the direction;
+ * @return the frame, or 0 if none can be drawn;
+ */
+
+static struct data_block *netf2_draw(struct netf2 *const iface, struct netf2_quota *const quota) {
+
+	struct data_block *block = 0;
+
+	/*Private frames can't be drawn;*/
+	if (!iface->pooled) {
+		return 0;
+	}
+
+	/*Enter a critical section, quotas are updated by both sides;*/
+	critical_section_enter();
+
+	/*If the cap is not reached, take a frame, and account it;*/
+	if ((quota->held < quota->max) && (block = frame_pool_take(iface->frame_size))) {
+		quota->held++;
+	}
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+	/*Return the frame;*/
+	return block;
+
+}
+
+
+/**
+ * netf2_release : gives a frame back to the pool, if the interface's frames are pooled and it holds more than its
+ * 	reservation;
+ *
+ * @param iface : the interface that releases;
+ * @param quota : the quota of the direction;
+ * @param block : the released frame;
+ * @return true if the frame was given back, false if the interface keeps it;
+ */
+
+static bool netf2_release(struct netf2 *const iface, struct netf2_quota *const quota, struct data_block *const block) {
+
+	bool released = false;
+
+	/*Private frames are kept;*/
+	if (!iface->pooled) {
+		return false;
+	}
+
+	/*Enter a critical section, quotas are updated by both sides;*/
+	critical_section_enter();
+
+	/*If the reservation is exceeded, the frame will be given back;*/
+	if (quota->held > quota->min) {
+		quota->held--;
+		released = true;
+	}
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+	/*Give the frame back;*/
+	if (released) {
+		frame_pool_give(block);
+	}
+
+	/*Return the decision;*/
+	return released;
+
+}
+
+
+/**
+ * netf2_rx_free : returns the number of frames that can receive : empty frames, and frames that can be drawn;
+ *
+ * @param iface : the interface;
+ * @return the number of free rx frames;
+ */
+
+static size_t netf2_rx_free(const struct netf2 *const iface) {
+
+	/*Cache the number of empty frames;*/
+	size_t count = block_ring_count(&iface->rx_empty);
+
+	/*If frames are pooled, add frames that can be drawn;*/
+	if (iface->pooled) {
+
+		/*Determine the margin of the quota, and the pool's free frames;*/
+		const size_t margin = iface->rx_quota.max - iface->rx_quota.held;
+		const size_t available = frame_pool_available(iface->frame_size);
+
+		/*Add the smallest;*/
+		count += (margin < available) ? margin : available;
+
+	}
+
+	/*Return the count;*/
+	return count;
+
+}
+
+
+/*Destruct the if : delete rings and their content;TODO*/
 void netf2_delete(struct netf2 *iface) {
 
 	/*Call the implementation's deleter;*/
@@ -173,26 +514,143 @@ void netf2_delete(struct netf2 *iface) {
 	/*Create a data block pointer;*/
 	struct data_block *block;
 
-	/*Create a macro that will delete all block from the fifo and delete the fifo;*/
-#define CLEAR_FIFO(fifo) {while((block = (struct data_block *)shared_fifo_pull((fifo)))) {data_block_delete(block);} kernel_free(fifo);}
+	/*Create a macro that will delete all block from the ring and delete the ring;*/
+#define CLEAR_RING(ring) {while((block = block_ring_pull(&(ring)))) {netf2_dispose(iface, block);} block_ring_delete(&(ring));}
 
-	/*Free all list and their content;*/
-	CLEAR_FIFO(iface->rx_empty);
-	CLEAR_FIFO(iface->tx_empty);
-	CLEAR_FIFO(iface->rx_nonempty);
-	CLEAR_FIFO(iface->tx_nonempty);
+	/*Free all rings and their content;*/
+	CLEAR_RING(iface->rx_empty);
+	CLEAR_RING(iface->tx_empty);
+	CLEAR_RING(iface->rx_nonempty);
+	CLEAR_RING(iface->tx_nonempty);
 
 	/*Undef the macro;*/
-#undef CLEAR_FIFO
+#undef CLEAR_RING
+
+	/*Delete cancelled tx blocks if any;*/
+	while ((block = iface->tx_spare)) {
+
+		/*The next spare block becomes the first one;*/
+		iface->tx_spare = data_block_next_segment(block, block);
+
+		/*Remove the block from the chain and dispose of it;*/
+		data_block_unchain(block);
+		netf2_dispose(iface, block);
+
+	}
+
+	/*If frames are pooled, all of them are back in the pool, withdraw the interface's share;*/
+	if (iface->pooled) {
+		frame_pool_withdraw(iface->frame_size, netf2_pool_share(iface));
+	}
 
 	/*Free the if;*/
 	kernel_free(iface);
 
 }
-int suussuus;
+
+
+/*---------------------------------------------------- Flow control ----------------------------------------------------*/
+
+/**
+ * netf2_set_rx_watermark : sets the number of free rx blocks under which reception is paused;
+ *
+ * 	While reception is paused, the driver leaves received bytes in the hardware, that deasserts RTS when its buffer
+ * 	fills, so that the sender stops before rx blocks run out. The remaining blocks receive bytes already read;
+ *
+ * 	The watermark must be lesser than the number of rx blocks, or reception will never resume;
+ *
+ * @param iface : the interface to configure;
+ * @param watermark : the watermark. 0 disables flow control;
+ */
+
+void netf2_set_rx_watermark(struct netf2 *const iface, const size_t watermark) {
+
+	/*Enter a critical section, the watermark is read in interrupts;*/
+	critical_section_enter();
+
+	/*Save the watermark;*/
+	iface->rx_watermark = watermark;
+
+	/*Reception is not paused anymore, the next block update will pause it if required;*/
+	iface->rx_throttled = false;
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+	/*Reception may have been paused, enable the rx interrupt;*/
+	(*(iface->enable_rx_hw_irq))(iface);
+
+}
+
+
+/*----------------------------------------------------- Statistics -----------------------------------------------------*/
+
+/**
+ * netf2_get_stats : copies the statistics of @iface in @dst;
+ *
+ * 	Counters are updated in interrupts, the copy is made in a critical section to get a consistent sample;
+ *
+ * @param iface : the interface to sample;
+ * @param dst : the location where to copy statistics;
+ */
+
+void netf2_get_stats(const struct netf2 *const iface, struct netf2_stats *const dst) {
+
+	/*Enter a critical section;*/
+	critical_section_enter();
+
+	/*Copy statistics;*/
+	memcpy(dst, &iface->stats, sizeof(struct netf2_stats));
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+}
+
+
+/**
+ * netf2_reset_stats : resets the statistics of @iface;
+ *
+ * @param iface : the interface to reset;
+ */
+
+void netf2_reset_stats(struct netf2 *const iface) {
+
+	/*Enter a critical section;*/
+	critical_section_enter();
+
+	/*Reset statistics;*/
+	memset(&iface->stats, 0, sizeof(struct netf2_stats));
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+}
+
 
 /*---------------------------------------------------- IRQ functions ---------------------------------------------------*/
 
+/**
+ * netf2_push : pushes @block in @ring. Rings are sized to contain all blocks of their direction, a failure
+ * 	witnesses a block that was created outside of the interface, or pushed twice;
+ *
+ * @param ring : the ring to push in;
+ * @param block : the block to push;
+ */
+
+static inline void netf2_push(struct block_ring *const ring, struct data_block *const block) {
+
+	/*Push the block; If the ring is full :*/
+	if (!block_ring_push(ring, block)) {
+
+		/*Error;*/
+		kernel_error("netf.c : netf2_push : ring full;");
+
+	}
+
+}
+
+
 /**
  * netf2_get_new_rx_block : Pushes @block in rx_nonempty list of @iface. Pulls and return a block from
  * rx_empty (can be 0);
@@ -204,17 +662,82 @@ int suussuus;
 
 struct data_block *netf2_get_new_rx_block(struct netf2 *iface, struct data_block *block) {
 
-	/*Push @block in rx_nonempty;*/
-	shared_fifo_push(iface->rx_nonempty, (struct list_head *) block);
+	/*Cache the protocol;*/
+	struct protocol_t *const protocol = iface->protocol;
+
+	/*Cache statistics;*/
+	struct netf2_stats *const stats = &iface->stats;
 
-	/*Pull a block from rx_empty and return it;*/
-	return (struct data_block *) shared_fifo_pull(iface->rx_empty);
+	struct data_block *new_block;
+
+	/*Update counters;*/
+	stats->rx_frames++;
+	stats->rx_bytes += block->size;
+
+	/*If a protocol is attached :*/
+	if (protocol) {
+
+		/*If the frame can't be dispatched, it is dropped, and its block is reused for the next frame;*/
+		if (!protocol_dispatch(protocol, block)) {
+			stats->rx_unrouted++;
+			block->size = 0;
+			return block;
+		}
+
+	} else {
+
+		/*Push @block in rx_nonempty;*/
+		netf2_push(&iface->rx_nonempty, block);
+
+		/*Update the peak depth;*/
+		if (block_ring_count(&iface->rx_nonempty) > stats->rx_peak_depth) {
+			stats->rx_peak_depth = block_ring_count(&iface->rx_nonempty);
+		}
+
+	}
+
+	/*Pull a block from rx_empty, or draw one from the pool;*/
+	if (!(new_block = block_ring_pull(&iface->rx_empty))) {
+		new_block = netf2_draw(iface, &iface->rx_quota);
+	}
+
+	/*If none is available, reception will stop;*/
+	if (!new_block) {
+		stats->rx_stalls++;
+	}
+
+	/*If free blocks fell under the watermark, pause reception;*/
+	if ((iface->rx_watermark) && (!iface->rx_throttled) && (netf2_rx_free(iface) < iface->rx_watermark)) {
+		iface->rx_throttled = true;
+		stats->rx_throttles++;
+	}
+
+	/*Return the new block;*/
+	return new_block;
 
 }
 
 
 /**
- * netf2_get_new_tx_block : Pushes @block in tx_empty list of @iface. Pulls and return a block from
+ * netf2_recycle_tx : gives a transmitted block back to the pool if the reservation is exceeded, or pushes it in
+ * 	tx_empty;
+ *
+ * @param iface : the interface that transmitted the block;
+ * @param block : the transmitted block;
+ */
+
+static void netf2_recycle_tx(struct netf2 *const iface, struct data_block *const block) {
+
+	/*If the block is kept, push it in tx_empty;*/
+	if (!netf2_release(iface, &iface->tx_quota, block)) {
+		netf2_push(&iface->tx_empty, block);
+	}
+
+}
+
+
+/**
+ * netf2_get_new_tx_block : Pushes @block and its segments in tx_empty list of @iface. Pulls and return a block from
  * tx_nonempty (can be 0);
  *
  * @param iface : the interface where to push and pull tx blocks;
@@ -224,11 +747,262 @@ struct data_block *netf2_get_new_rx_block(struct netf2 *iface, struct data_block
 
 struct data_block *netf2_get_new_tx_block(struct netf2 *iface, struct data_block *block) {
 
-	/*Push @block in tx_empty;*/
-	shared_fifo_push(iface->tx_empty, (struct list_head *) block);
+	struct data_block *segment;
+
+	/*Update counters;*/
+	iface->stats.tx_frames++;
+	iface->stats.tx_bytes += data_block_chain_size(block);
+
+	/*Recycle all following segments;*/
+	while ((segment = data_block_next_segment(block, block))) {
+		data_block_unchain(segment);
+		netf2_recycle_tx(iface, segment);
+	}
+
+	/*Recycle @block;*/
+	netf2_recycle_tx(iface, block);
 
 	/*Pull a block from tx_nonempty and return it;*/
-	return (struct data_block *) shared_fifo_pull(iface->tx_nonempty);
+	return block_ring_pull(&iface->tx_nonempty);
+
+}
+
+
+/*------------------------------------------------------ Zero-copy -----------------------------------------------------*/
+
+/**
+ * netf2_lend : marks @block lent by @iface, with the provided loan state;
+ *
+ * @param iface : the interface that lends the block;
+ * @param block : the lent block, may be null;
+ * @param loan : the loan state;
+ * @return @block;
+ */
+
+static inline struct data_block *
+netf2_lend(struct netf2 *const iface, struct data_block *const block, const enum data_block_loan loan) {
+
+	/*If a block was pulled :*/
+	if (block) {
+
+		/*Save the loan state and the lender;*/
+		block->loan = loan;
+		block->lender = iface;
+
+	}
+
+	/*Return the block;*/
+	return block;
+
+}
+
+
+/**
+ * netf2_take_back : verifies that @block was lent by @iface with the provided loan state, and marks it held.
+ * 	Errors if the block was not lent, lent by another interface, or lent for another direction;
+ *
+ * @param iface : the interface the block is handed back to;
+ * @param block : the block handed back;
+ * @param loan : the expected loan state;
+ */
+
+static void netf2_take_back(struct netf2 *const iface, struct data_block *const block, const enum data_block_loan loan) {
+
+	/*If the block was not lent by this interface, for this direction :*/
+	if ((block->loan != loan) || (block->lender != iface)) {
+
+		/*Error. Most likely a double return;*/
+		kernel_error("netf.c : netf2_take_back : block not lent by the interface, or already returned;");
+
+	}
+
+	/*The block is held again;*/
+	block->loan = DATA_BLOCK_HELD;
+	block->lender = 0;
+
+}
+
+
+/**
+ * netf2_borrow_rx_frame : pulls a received frame from rx_nonempty, and lends it to the caller;
+ *
+ * 	The frame must be handed back with netf2_return_rx_frame;
+ *
+ * @param iface : the interface to pull from;
+ * @return the received frame, or 0 if there is none;
+ */
+
+struct data_block *netf2_borrow_rx_frame(struct netf2 *const iface) {
+
+	/*Pull a frame from rx_nonempty and lend it;*/
+	return netf2_lend(iface, block_ring_pull(&iface->rx_nonempty), DATA_BLOCK_RX_LOAN);
+
+}
+
+
+/**
+ * netf2_return_rx_frame : takes back a frame lent by netf2_borrow_rx_frame, and makes it available for reception;
+ *
+ * @param iface : the interface that lent the frame;
+ * @param block : the processed frame;
+ */
+
+void netf2_return_rx_frame(struct netf2 *const iface, struct data_block *const block) {
+
+	/*Take the block back;*/
+	netf2_take_back(iface, block, DATA_BLOCK_RX_LOAN);
+
+	/*Discard its content;*/
+	block->size = 0;
+
+	/*Give the block back to the pool if the reservation is exceeded, or push it in rx_empty;*/
+	if (!netf2_release(iface, &iface->rx_quota, block)) {
+		netf2_push(&iface->rx_empty, block);
+	}
+
+	/*Enter a critical section, the pause flag is set in interrupts;*/
+	critical_section_enter();
+
+	/*If reception is paused and free blocks reached the watermark, resume;*/
+	if ((iface->rx_throttled) && (netf2_rx_free(iface) >= iface->rx_watermark)) {
+		iface->rx_throttled = false;
+	}
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+	/*Enable the rx interrupt, reception may have stopped for lack of blocks;*/
+	(*(iface->enable_rx_hw_irq))(iface);
+
+}
+
+
+/**
+ * netf2_borrow_tx_frame : pulls an empty frame from tx_empty, and lends it to the caller;
+ *
+ * 	The frame must be handed back with netf2_commit_tx_frame or netf2_cancel_tx_frame;
+ *
+ * @param iface : the interface to pull from;
+ * @return an empty frame, or 0 if there is none;
+ */
+
+struct data_block *netf2_borrow_tx_frame(struct netf2 *const iface) {
+
+	/*Use cancelled blocks first, then pull from tx_empty, then draw from the pool;*/
+	struct data_block *block = iface->tx_spare;
+
+	/*If there was a cancelled block :*/
+	if (block) {
+
+		/*The next cancelled block becomes the first one;*/
+		iface->tx_spare = data_block_next_segment(block, block);
+
+		/*Remove the block from the spare chain;*/
+		data_block_unchain(block);
+
+	} else if (!(block = block_ring_pull(&iface->tx_empty))) {
+
+		/*If tx_empty is empty, draw a block from the pool;*/
+		block = netf2_draw(iface, &iface->tx_quota);
+
+	}
+
+	/*Lend the block;*/
+	netf2_lend(iface, block, DATA_BLOCK_TX_LOAN);
+
+	/*If a frame was pulled, empty it;*/
+	if (block) {
+		block->size = 0;
+	}
+
+	/*Return the frame;*/
+	return block;
+
+}
+
+
+/**
+ * netf2_take_back_chain : takes back all segments of a chain lent by netf2_borrow_tx_frame;
+ *
+ * @param iface : the interface that lent segments;
+ * @param frame : the first block of the chain;
+ */
+
+static void netf2_take_back_chain(struct netf2 *const iface, struct data_block *const frame) {
+
+	/*Take each segment back;*/
+	for (struct data_block *segment = frame; segment; segment = data_block_next_segment(frame, segment)) {
+		netf2_take_back(iface, segment, DATA_BLOCK_TX_LOAN);
+	}
+
+}
+
+
+/**
+ * netf2_commit_tx_frame : takes back a frame lent by netf2_borrow_tx_frame, and queues it for transmission;
+ *
+ * 	The frame can be a chain of blocks lent by the interface. Only the first block is queued, segments are
+ * 	transmitted with it, and returned to tx_empty after its transmission;
+ *
+ * 	The framer appends its trailer to the last segment during the transmission. If the segment can't contain it, the
+ * 	frame is cancelled here, rather than failing in the interrupt;
+ *
+ * @param iface : the interface that lent the frame;
+ * @param block : the filled frame;
+ * @return true if the frame was queued, false if it was cancelled;
+ */
+
+bool netf2_commit_tx_frame(struct netf2 *const iface, struct data_block *const block) {
+
+	/*Find the last segment of the chain, the one previous the frame in the circular list;*/
+	const struct data_block *const last = (const struct data_block *) block->head.prev;
+
+	/*If it can't contain the trailer, cancel the frame;*/
+	if (last->max_size - last->size < iface->tx_reserve) {
+		netf2_cancel_tx_frame(iface, block);
+		return false;
+	}
+
+	/*Take the frame and its segments back;*/
+	netf2_take_back_chain(iface, block);
+
+	/*Push the block in tx_nonempty;*/
+	netf2_push(&iface->tx_nonempty, block);
+
+	/*Update the peak depth;*/
+	if (block_ring_count(&iface->tx_nonempty) > iface->stats.tx_peak_depth) {
+		iface->stats.tx_peak_depth = block_ring_count(&iface->tx_nonempty);
+	}
+
+	/*Enable the tx interrupt;*/
+	(*(iface->enable_tx_hw_irq))(iface);
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * netf2_cancel_tx_frame : takes back a frame lent by netf2_borrow_tx_frame, and its chain, without transmitting it;
+ *
+ * 	tx_empty is pushed by the hardware side only, blocks are cached in the spare chain, and will be lent again first;
+ *
+ * @param iface : the interface that lent the frame;
+ * @param block : the unused frame;
+ */
+
+void netf2_cancel_tx_frame(struct netf2 *const iface, struct data_block *const block) {
+
+	/*Take the frame and its segments back;*/
+	netf2_take_back_chain(iface, block);
+
+	/*Append blocks to the spare chain, or start it;*/
+	if (iface->tx_spare) {
+		data_block_chain(iface->tx_spare, block);
+	} else {
+		iface->tx_spare = block;
+	}
 
 }
 
@@ -239,6 +1013,8 @@ struct data_block *netf2_get_new_tx_block(struct netf2 *iface, struct data_block
  * netf2_get_message : attempts to get a received frame, and if not null, copies its content in @block;
  * 	Asserts if success;
  *
+ * 	Callers that can process the frame in place should use netf2_borrow_rx_frame instead;
+ *
  * @param iface : the interface to pull from;
  * @param frame : the block where to copy the frame;
  * @return true if the frame was successfully copies, false if not;
@@ -246,8 +1022,8 @@ struct data_block *netf2_get_new_tx_block(struct netf2 *iface, struct data_block
 
 bool netf2_get_frame(struct netf2 *iface, struct data_block *frame) {
 
-	/*Pull a frame from rx_nonempty;*/
-	const struct data_block *const ne_frame = (struct data_block *) shared_fifo_pull(iface->rx_nonempty);
+	/*Borrow a received frame;*/
+	struct data_block *const ne_frame = netf2_borrow_rx_frame(iface);
 
 	/*If no frame was available :*/
 	if (!ne_frame) {
@@ -260,11 +1036,8 @@ bool netf2_get_frame(struct netf2 *iface, struct data_block *frame) {
 	/*Copy the content of @ne_frame in @frame;*/
 	data_block_copy(ne_frame, frame);
 
-	/*Push ne_frame in rx_empty;*/
-	shared_fifo_push(iface->rx_empty, (struct list_head *) ne_frame);
-
-	/*Enable the rx interrupt;*/
-	(*(iface->enable_tx_hw_irq))(iface);
+	/*Return ne_frame, re-enables the rx interrupt;*/
+	netf2_return_rx_frame(iface, ne_frame);
 
 	/*Complete;*/
 	return true;
@@ -274,7 +1047,9 @@ bool netf2_get_frame(struct netf2 *iface, struct data_block *frame) {
 
 /**
  * netf2_send_message : attempts to get a frame container, copies @frame into it, and asserts if success;
-
+ *
+ * 	Callers that can build the frame in place should use netf2_borrow_tx_frame instead;
+ *
  * @param iface : the interface that will send the frame;
  * @param frame : the frame to send;
  * @return true if the frame was successfully copied, false if not;
@@ -282,8 +1057,8 @@ bool netf2_get_frame(struct netf2 *iface, struct data_block *frame) {
 
 bool netf2_send_frame(struct netf2 *iface, const struct data_block *const frame) {
 
-	/*Pull a frame from tx_empty;*/
-	struct data_block *e_frame = (struct data_block *) shared_fifo_pull(iface->tx_empty);
+	/*Borrow an empty frame;*/
+	struct data_block *e_frame = netf2_borrow_tx_frame(iface);
 
 	/*If no frame was available :*/
 	if (!e_frame) {
@@ -296,14 +1071,8 @@ bool netf2_send_frame(struct netf2 *iface, const struct data_block *const frame)
 	/*Copy the content of @frame in @e_frame;*/
 	data_block_copy(frame, e_frame);
 
-	/*Push ne_frame in tx_nonempty;*/
-	shared_fifo_push(iface->tx_nonempty, (struct list_head *) e_frame);
-
-	/*Enable the interrupt;*/
-	(*(iface->enable_tx_hw_irq))(iface);
-
-	/*Complete;*/
-	return true;
+	/*Commit e_frame, enables the tx interrupt. Fails if the frame leaves no space for the trailer;*/
+	return netf2_commit_tx_frame(iface, e_frame);
 
 }
 
@@ -328,10 +1097,48 @@ void netf21_destruct(struct netf21 *iface) {
 }
 
 
+/*------------------------------------------------------- Framer -------------------------------------------------------*/
+
+/**
+ * netf21_reserve_trailer : reserves the trailer of the framer at the end of tx frames, so that frames that can't
+ * 	contain it are rejected at commit;
+ *
+ * @param iface : the interface, whose l2 if is initialised;
+ */
+
+void netf21_reserve_trailer(struct netf21 *const iface) {
+
+	/*Reserve the trailer size;*/
+	iface->iface.tx_reserve = iface->framer->trailer_size;
+
+}
+
+
+/*----------------------------------------------------- Statistics -----------------------------------------------------*/
+
+/**
+ * netf21_get_stats : copies the statistics of @iface in @dst, and adds frames dropped and truncated by the framer;
+ *
+ * @param iface : the interface to sample;
+ * @param dst : the location where to copy statistics;
+ */
+
+void netf21_get_stats(const struct netf21 *const iface, struct netf2_stats *const dst) {
+
+	/*Copy the layer 2 statistics;*/
+	netf2_get_stats(&iface->iface, dst);
+
+	/*Sample framer drops and truncations;*/
+	dst->rx_framer_drops = iface->framer->nb_drops;
+	dst->rx_framer_truncations = iface->framer->nb_truncations;
+
+}
+
+
 /**
  * netf21_init_decoding : verifies that the framer contains a non null decoding block.
  * 	If not, attempts to get one, and if it fails, returns false.
- * 	If a non null block is present or provided, returns true;
+ * 	If a non null block is present or provided, returns true, unless reception is paused by flow control;
  *
  * @param iface : the interface to init;
  * @return true if the decoding function can be called;
@@ -342,13 +1149,21 @@ bool netf21_init_decoding(struct netf21 *iface) {
 	/*Cache the framer;*/
 	struct data_framer *framer = iface->framer;
 
+	/*If reception is paused, received bytes must stay in the hardware;*/
+	if (iface->iface.rx_throttled) {
+		return false;
+	}
+
 	/*If the decoding block exists, complete;*/
 	if (framer->decoding_block) {
 		return true;
 	}
 
-	/*If null decoding block, attempt to get one from rx_empty;*/
-	struct data_block *block = (struct data_block *) shared_fifo_pull(iface->iface.rx_empty);
+	/*If null decoding block, attempt to get one from rx_empty, or from the pool;*/
+	struct data_block *block = block_ring_pull(&iface->iface.rx_empty);
+	if (!block) {
+		block = netf2_draw(&iface->iface, &iface->iface.rx_quota);
+	}
 
 	/*If the block is null, fail;*/
 	if (!block) {
@@ -384,7 +1199,7 @@ bool netf21_init_encoding(struct netf21 *iface) {
 	}
 
 	/*If null encoding block, attempt to get one from tx_nonempty;*/
-	struct data_block *block = (struct data_block *) shared_fifo_pull(iface->iface.tx_nonempty);
+	struct data_block *block = block_ring_pull(&iface->iface.tx_nonempty);
 
 	/*If the block is null, fail;*/
 	if (!block) {
@@ -423,6 +1238,9 @@ bool netf_21_decode_byte(struct netf21 *iface, uint8_t data) {
 		 * This should not have happened, and witnesses a flaw in the program that uses the if.
 		 */
 
+		/*Count the lost byte;*/
+		iface->iface.stats.rx_lost_bytes++;
+
 		/*Return false, to disable future transmission; byte will be lost;*/
 		return false;
 
@@ -439,8 +1257,8 @@ bool netf_21_decode_byte(struct netf21 *iface, uint8_t data) {
 		struct data_block *new_block =
 			framer->decoding_block = netf2_get_new_rx_block(&iface->iface, framer->decoding_block);
 
-		/*Assert if the provided block exists;*/
-		return new_block != 0;
+		/*Assert if the provided block exists, and reception is not paused;*/
+		return (new_block != 0) && (!iface->iface.rx_throttled);
 
 	}
 
@@ -498,3 +1316,110 @@ bool netf_21_get_encoded_byte(struct netf21 *iface, uint8_t *data) {
 
 
 }
+
+
+/**
+ * netf_21_decode_block : transmits up to *@size bytes to @iface for decoding, and updates *@size with the number of
+ * 	bytes decoded; Asserts if more bytes can be written. If not, the transmission must stop;
+ *
+ * 	The framer is called once per frame boundary instead of once per byte. If no block is available to store the next
+ * 	frame, decoding stops at the boundary : the caller keeps remaining bytes, or counts them as lost;
+ *
+ * @param iface : the interface that must receive bytes;
+ * @param data : the bytes to decode;
+ * @param size : in : the number of bytes to decode, out : the number of bytes decoded;
+ * @return true if there is space for data to be received;
+ */
+
+bool netf_21_decode_block(struct netf21 *iface, const uint8_t *data, size_t *const size) {
+
+	/*Cache the framer;*/
+	struct data_framer *framer = iface->framer;
+
+	/*Cache the number of bytes to decode;*/
+	size_t remaining = *size;
+
+	/*While bytes remain :*/
+	while (remaining) {
+
+		/*If the framer has no block to receive data, stop before remaining bytes;*/
+		if (!framer->decoding_block) {
+			break;
+		}
+
+		/*The frame completion flag;*/
+		bool frame_complete;
+
+		/*Transmit bytes to the framer, until the next frame boundary;*/
+		size_t consumed = (*(framer->decode_block))(framer, data, remaining, &frame_complete);
+
+		/*Update the span;*/
+		data += consumed;
+		remaining -= consumed;
+
+		/*If the frame is complete, send the block in the net2 for storage and get another;*/
+		if (frame_complete) {
+			framer->decoding_block = netf2_get_new_rx_block(&iface->iface, framer->decoding_block);
+		}
+
+	}
+
+	/*Report bytes decoded;*/
+	*size -= remaining;
+
+	/*Assert if a block is available for further readings, and reception is not paused;*/
+	return (framer->decoding_block != 0) && (!iface->iface.rx_throttled);
+
+}
+
+
+/**
+ * netf_21_get_encoded_block : receive up to *@size encoded bytes from @iface, and update *@size with the number of
+ * 	bytes provided. Asserts if more bytes can be read. If not, the procedure must stop;
+ *
+ * @param iface : the interface that must provide bytes;
+ * @param data : the location where to store bytes;
+ * @param size : in : the number of bytes that can be stored, out : the number of bytes stored;
+ * @return true if there are more bytes to receive.
+ */
+
+bool netf_21_get_encoded_block(struct netf21 *iface, uint8_t *data, size_t *const size) {
+
+	/*Cache the framer;*/
+	struct data_framer *framer = iface->framer;
+
+	/*Cache the available space;*/
+	size_t space = *size;
+
+	/*While there is space :*/
+	while (space) {
+
+		/*If the framer has no block to encode, stop;*/
+		if (!framer->encoding_block) {
+			break;
+		}
+
+		/*The frame completion flag;*/
+		bool frame_complete;
+
+		/*Get bytes from the framer, until the next frame boundary;*/
+		size_t produced = (*(framer->encode_block))(framer, data, space, &frame_complete);
+
+		/*Update the span;*/
+		data += produced;
+		space -= produced;
+
+		/*If the frame is complete, send the block in the net2 for storage and get another;*/
+		if (frame_complete) {
+			framer->encoding_block = netf2_get_new_tx_block(&iface->iface, framer->encoding_block);
+		}
+
+	}
+
+	/*Save the number of bytes stored;*/
+	*size -= space;
+
+	/*Assert if a block remains to be encoded;*/
+	return framer->encoding_block != 0;
+
+}
@@ -28,15 +28,44 @@
 
 #include <stddef.h>
 
-#include <data_structures/containers/concurrent/shared_fifo.h>
+#include <list.h>
+
+#include <kernel/res/net/block_ring.h>
 #include <kernel/res/net/framer/framer.h>
 
 
 
 /*----------------------------------------------------- Data block -----------------------------------------------------*/
 
+struct netf2;
+
+struct protocol_t;
+
+/*
+ * A data block is owned by its interface, or lent to a process by the zero-copy API. Its loan state allows
+ * 	detecting blocks returned twice or to the wrong interface;
+ */
+
+enum data_block_loan {
+
+	/*The block is owned by its interface (fifos, framer, hardware);*/
+	DATA_BLOCK_HELD = 0,
+
+	/*The block was borrowed from rx_nonempty, and must be returned to rx_empty;*/
+	DATA_BLOCK_RX_LOAN,
+
+	/*The block was borrowed from tx_empty, and must be committed to tx_nonempty or cancelled to tx_empty;*/
+	DATA_BLOCK_TX_LOAN,
+
+};
+
+
 /*
  * To store messages of a variable length, we will use data blocks; They reference a memory zone, and can be linked;
+ *
+ * 	On transmission, a frame can be a chain of blocks : the first block is the frame, the following ones are its
+ * 	segments, and the frame's content is the concatenation of all blocks' contents. A header can so be prepended to
+ * 	a payload without copy. A single block is a chain of one segment;
  */
 
 struct data_block {
@@ -53,6 +82,12 @@ struct data_block {
 	/*The block's maximal size, constant;*/
 	const size_t max_size;
 
+	/*The block's loan state;*/
+	enum data_block_loan loan;
+
+	/*The interface that lent the block. Null if the block is held;*/
+	struct netf2 *lender;
+
 };
 
 /*Create a data block;*/
@@ -64,21 +99,152 @@ void data_block_delete(struct data_block *block);
 /*Copy the content of @src into @dst. Error if dst is not big enough;*/
 void data_block_copy(const struct data_block *src, struct data_block *dst);
 
+/*Append @segment and its chain at the end of @frame's chain;*/
+void data_block_chain(struct data_block *frame, struct data_block *segment);
+
+/*Remove @segment from its chain;*/
+void data_block_unchain(struct data_block *segment);
+
+/*Get the size of @frame's chain;*/
+size_t data_block_chain_size(const struct data_block *frame);
+
+
+/**
+ * data_block_next_segment : returns the segment that follows @segment in @frame's chain;
+ *
+ * @param frame : the first block of the chain;
+ * @param segment : a segment of the chain;
+ * @return the next segment, or 0 if @segment is the last one;
+ */
+
+static inline struct data_block *
+data_block_next_segment(const struct data_block *const frame, const struct data_block *const segment) {
+
+	/*Cache the next block in the chain;*/
+	struct data_block *const next = (struct data_block *) segment->head.next;
+
+	/*The chain is circular, the frame marks its end;*/
+	return (next == frame) ? 0 : next;
+
+}
+
 /*
  * ------------------------------------------- OSI layer 2 network if -------------------------------------------
  */
 
+/*
+ * Interface statistics. Counters only increase, and are sampled with netf2_get_stats;
+ */
+
+struct netf2_stats {
+
+	/*Frames and bytes received and transmitted;*/
+	size_t rx_frames;
+	size_t rx_bytes;
+	size_t tx_frames;
+	size_t tx_bytes;
+
+	/*Received bytes lost because no block was available to decode them;*/
+	size_t rx_lost_bytes;
+
+	/*Number of times reception stopped because rx_empty was exhausted;*/
+	size_t rx_stalls;
+
+	/*Number of times reception was paused because free blocks fell under the watermark;*/
+	size_t rx_throttles;
+
+	/*Received frames dropped by the framer (oversized, malformed, failed check). Sampled from the framer;*/
+	size_t rx_framer_drops;
+
+	/*Received frames truncated to the block size by the framer, and delivered. Sampled from the framer;*/
+	size_t rx_framer_truncations;
+
+	/*Received frames dropped by the protocol (no header, closed or full channel);*/
+	size_t rx_unrouted;
+
+	/*Peak number of frames waiting in rx_nonempty and tx_nonempty;*/
+	size_t rx_peak_depth;
+	size_t tx_peak_depth;
+
+	/*Hardware errors reported by the driver;*/
+	size_t hw_overruns;
+	size_t hw_framing_errors;
+	size_t hw_noise_errors;
+	size_t hw_parity_errors;
+
+	/*Hardware interrupts handled by the driver : rx, tx, and idle line. Divide byte counts to get bytes per interrupt;*/
+	size_t hw_rx_interrupts;
+	size_t hw_tx_interrupts;
+	size_t hw_idle_interrupts;
+
+};
+
+
+/*
+ * The frame quota of an interface direction, when frames are drawn from the shared frame pool;
+ */
+
+struct netf2_quota {
+
+	/*The number of frames reserved at init, that are never given back to the pool;*/
+	size_t min;
+
+	/*The maximal number of frames held;*/
+	size_t max;
+
+	/*The number of frames held;*/
+	volatile size_t held;
+
+};
+
+
 /*
  * A layer 2 peripheral receives delimited frames.
  */
 
 struct netf2 {
 
-	/*The protocol if;*/
-	/*TODO struct protocol_t protocol;*/
+	/*The protocol that demultiplexes received frames. If null, frames are queued in rx_nonempty;*/
+	struct protocol_t *protocol;
+
+	/*
+	 * The quadruplet of block rings, to transmit frame containers between hw_specs and sw irq;
+	 *
+	 * 	rx_nonempty and tx_empty are pushed by the hardware side, rx_empty and tx_nonempty by the process side.
+	 * 	Each ring must be pulled by a single context;
+	 */
+	struct block_ring rx_empty, rx_nonempty, tx_empty, tx_nonempty;
+
+	/*Chain of tx blocks cancelled by the process side, lent again before pulling tx_empty;*/
+	struct data_block *tx_spare;
+
+	/*
+	 * If set, frames are drawn from the shared frame pool when rings are empty, and given back beyond the reserved
+	 * 	minimum when they are released. If not, frames are private, and allocated at init;
+	 */
+	bool pooled;
+
+	/*The minimal size of frames;*/
+	size_t frame_size;
+
+	/*The number of bytes that must remain free at the end of committed frames, for the framer's trailer;*/
+	size_t tx_reserve;
 
-	/*The quadruplet of shared fifos, to transmit frame containers between hw_specs and sw irq*/
-	struct shared_fifo *const rx_empty, *const rx_nonempty, *const tx_empty, *const tx_nonempty;
+	/*Frame quotas of both directions, if frames are pooled;*/
+	struct netf2_quota rx_quota, tx_quota;
+
+	/*Statistics, updated by the interface and its driver;*/
+	struct netf2_stats stats;
+
+	/*
+	 * Flow control : when less than rx_watermark blocks remain in rx_empty, reception is paused before blocks run
+	 * 	out, and resumes when the watermark is reached again. The driver stops draining the hardware, and its
+	 * 	backpressure (RTS) stops the sender. Null watermark disables flow control;
+	 */
+	size_t rx_watermark;
+
+	/*Set while reception is paused by flow control;*/
+	volatile bool rx_throttled;
 
 	/*Enable hardware interrupts;*/
 	void (*const enable_rx_hw_irq)(struct netf2 *);
@@ -91,7 +257,7 @@ struct netf2 {
 
 /*----------------------------------------------------- Init - Exit ----------------------------------------------------*/
 
-/*Initalise a layer 2 if : create and fill fifos, assign function pointers;*/
+/*Initalise a layer 2 if : create and fill rings, assign function pointers;*/
 void netf2_init(
 	struct netf2 *iface,
 	size_t nb_frames,
@@ -102,10 +268,38 @@ void netf2_init(
 );
 
 
-/*Destruct the if : delete fifos and their content;*/
+/*Initialise a layer 2 if whose frames are drawn from the shared frame pool. @min_frames are reserved per direction.
+ * False if the quota is invalid, or if no pool class fits frames;*/
+bool netf2_init_pooled(
+	struct netf2 *iface,
+	size_t min_frames,
+	size_t max_frames,
+	size_t frame_size,
+	void (*enable_rx_hw_irq)(struct netf2 *),
+	void (*enable_tx_hw_irq)(struct netf2 *),
+	void (*destructor)(struct netf2 *)
+);
+
+
+/*Destruct the if : delete rings and their content;*/
 void netf2_delete(struct netf2 *iface);
 
 
+/*---------------------------------------------------- Flow control ----------------------------------------------------*/
+
+/*Set the number of free rx blocks under which reception is paused. 0 disables flow control;*/
+void netf2_set_rx_watermark(struct netf2 *iface, size_t watermark);
+
+
+/*----------------------------------------------------- Statistics -----------------------------------------------------*/
+
+/*Copy the interface's statistics in @dst;*/
+void netf2_get_stats(const struct netf2 *iface, struct netf2_stats *dst);
+
+/*Reset the interface's statistics;*/
+void netf2_reset_stats(struct netf2 *iface);
+
+
 /*---------------------------------------------------- IRQ functions ---------------------------------------------------*/
 
 /*Push @block in rx_nonempty list of @interfaces, transfer in both rx lists, pull-return a block from rx_empty (can be 0);*/
@@ -124,6 +318,45 @@ bool netf2_get_frame(struct netf2 *iface, struct data_block *frame);
 bool netf2_send_frame(struct netf2 *iface, const struct data_block *block);
 
 
+/*------------------------------------------------------ Zero-copy -----------------------------------------------------*/
+
+/*
+ * The zero-copy API lends interface blocks to the caller, that works on them in place and hands them back.
+ * 	A lent block must be handed back exactly once, to the interface that lent it;
+ */
+
+/*Borrow a received frame. Returns 0 if none is available;*/
+struct data_block *netf2_borrow_rx_frame(struct netf2 *iface);
+
+/*Hand back a received frame after processing. Its content is discarded;*/
+void netf2_return_rx_frame(struct netf2 *iface, struct data_block *block);
+
+/*Borrow an empty frame to fill. Returns 0 if none is available;*/
+struct data_block *netf2_borrow_tx_frame(struct netf2 *iface);
+
+/*Hand back a filled frame for transmission. All segments of its chain must have been borrowed from @iface. If its
+ * last segment can't contain the framer's trailer, the frame is cancelled and false is returned;*/
+bool netf2_commit_tx_frame(struct netf2 *iface, struct data_block *block);
+
+/*Hand back a borrowed tx frame and its chain without transmitting it;*/
+void netf2_cancel_tx_frame(struct netf2 *iface, struct data_block *block);
+
+
+/**
+ * netf2_tx_capacity : returns the number of bytes a single block tx frame of @iface can contain, the framer's trailer
+ * 	excluded;
+ *
+ * @param iface : the interface to examine;
+ */
+
+static inline size_t netf2_tx_capacity(const struct netf2 *iface) {
+
+	/*The trailer is appended at the end of the frame;*/
+	return (iface->frame_size > iface->tx_reserve) ? iface->frame_size - iface->tx_reserve : 0;
+
+}
+
+
 /**
  * netf2_message_available : asserts if messages can be polled from @iface;
  *
@@ -133,7 +366,7 @@ bool netf2_send_frame(struct netf2 *iface, const struct data_block *block);
 static inline bool netf2_message_available(struct netf2 *iface) {
 
 	/*Assert if rx_nonempty contains messages;*/
-	return !shared_fifo_empty(iface->rx_nonempty);
+	return !block_ring_empty(&iface->rx_nonempty);
 
 }
 
@@ -162,6 +395,18 @@ struct netf21 {
 void netf21_destruct(struct netf21 *iface);
 
 
+/*------------------------------------------------------- Framer -------------------------------------------------------*/
+
+/*Reserve the trailer of the framer at the end of tx frames. Must be called once the l2 if is initialised;*/
+void netf21_reserve_trailer(struct netf21 *iface);
+
+
+/*----------------------------------------------------- Statistics -----------------------------------------------------*/
+
+/*Copy the interface's statistics in @dst, framer drops included;*/
+void netf21_get_stats(const struct netf21 *iface, struct netf2_stats *dst);
+
+
 /*--------------------------------------------------- Init functions ---------------------------------------------------*/
 
 /*Initialise the decoding structure, assert if decoding can happen;*/
@@ -179,4 +424,11 @@ bool netf_21_decode_byte(struct netf21 *iface, uint8_t data);
 /*Get an encoded byte. Asserts if more bytes can be read. If not, the procedure must stop;*/
 bool netf_21_get_encoded_byte(struct netf21 *iface, uint8_t *data);
 
+/*Decode up to *@size received bytes, and update *@size. Asserts if more bytes can be written. If not, the procedure must
+ * stop;*/
+bool netf_21_decode_block(struct netf21 *iface, const uint8_t *data, size_t *size);
+
+/*Get up to *@size encoded bytes, and update *@size. Asserts if more bytes can be read. If not, the procedure must stop;*/
+bool netf_21_get_encoded_block(struct netf21 *iface, uint8_t *data, size_t *size);
+
 #endif /*TRACER_NETF_H*/
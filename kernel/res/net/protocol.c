@@ -19,3 +19,466 @@
 */
 
 #include "protocol.h"
+
+#include <string.h>
+
+#include "std/syscall.h"
+
+#include <kernel/exec/sched.h>
+
+#include <kernel/core/except.h>
+
+#include <khal/prmpt.h>
+
+
+/*----------------------------------------------------- Init - Exit ----------------------------------------------------*/
+
+/**
+ * protocol_init : initialises @protocol with all channels closed, and attaches it to @iface. From now on, frames
+ * 	received by @iface are dispatched to channels;
+ *
+ * @param protocol : the protocol to initialise;
+ * @param iface : the interface to demultiplex;
+ */
+
+void protocol_init(struct protocol_t *const protocol, struct netf2 *const iface) {
+
+	/*Reset all channels and counters;*/
+	memset(protocol, 0, sizeof(struct protocol_t));
+
+	/*Save the interface;*/
+	protocol->iface = iface;
+
+	/*Attach the protocol to the interface;*/
+	iface->protocol = protocol;
+
+}
+
+
+/**
+ * protocol_exit : detaches @protocol from its interface, and closes all its channels;
+ *
+ * @param protocol : the protocol to detach;
+ */
+
+void protocol_exit(struct protocol_t *const protocol) {
+
+	uint8_t channel;
+
+	/*Detach the protocol, frames will be queued in rx_nonempty;*/
+	protocol->iface->protocol = 0;
+
+	/*Close all open channels;*/
+	for (channel = 0; channel < PROTOCOL_NB_CHANNELS; channel++) {
+		if (protocol->channels[channel].open) {
+			protocol_close(protocol, channel);
+		}
+	}
+
+}
+
+
+/*------------------------------------------------------ Channels ------------------------------------------------------*/
+
+/**
+ * protocol_get_channel : returns the required channel. Error if the index is invalid;
+ *
+ * @param protocol : the protocol that owns the channel;
+ * @param channel : the channel index;
+ * @return the channel;
+ */
+
+static struct protocol_channel *protocol_get_channel(struct protocol_t *const protocol, const uint8_t channel) {
+
+	/*If the index is invalid :*/
+	if (channel >= PROTOCOL_NB_CHANNELS) {
+
+		/*Error;*/
+		kernel_error("protocol.c : protocol_get_channel : invalid channel index;");
+
+	}
+
+	/*Return the channel;*/
+	return protocol->channels + channel;
+
+}
+
+
+/**
+ * protocol_lend : marks a queued frame lent by the interface, so that it can be returned with netf2_return_rx_frame;
+ *
+ * @param protocol : the protocol the frame was dispatched to;
+ * @param block : the frame, pulled from a channel queue;
+ */
+
+static void protocol_lend(const struct protocol_t *const protocol, struct data_block *const block) {
+
+	/*The interface lends the frame;*/
+	block->loan = DATA_BLOCK_RX_LOAN;
+	block->lender = protocol->iface;
+
+}
+
+
+/**
+ * protocol_open : opens a channel, with a queue of @depth frames. Error if the channel is already open;
+ *
+ * @param protocol : the protocol that owns the channel;
+ * @param channel : the channel index;
+ * @param depth : the maximal number of frames that can be queued in the channel;
+ */
+
+void protocol_open(struct protocol_t *const protocol, const uint8_t channel, const size_t depth) {
+
+	/*Cache the channel;*/
+	struct protocol_channel *const ch = protocol_get_channel(protocol, channel);
+
+	/*If the channel is already open :*/
+	if (ch->open) {
+
+		/*Error;*/
+		kernel_error("protocol.c : protocol_open : channel already open;");
+
+	}
+
+	/*Create the queue;*/
+	struct block_ring queue = block_ring_create(depth);
+
+	/*Initialise the channel;*/
+	memcpy(&ch->queue, &queue, sizeof(struct block_ring));
+	ch->reader = 0;
+	ch->nb_frames = 0;
+	ch->nb_drops = 0;
+
+	/*The queue must be initialised before frames are dispatched;*/
+	BLOCK_RING_BARRIER();
+
+	/*Open the channel;*/
+	ch->open = true;
+
+}
+
+
+/**
+ * protocol_close : closes a channel. Queued frames are returned to the interface, and a waiting reader is resumed;
+ *
+ * 	Frames are returned as the subscriber would have : pooled frames above the reservation go back to the pool, and
+ * 	reception resumes if it was throttled;
+ *
+ * @param protocol : the protocol that owns the channel;
+ * @param channel : the channel index;
+ */
+
+void protocol_close(struct protocol_t *const protocol, const uint8_t channel) {
+
+	/*Cache the channel;*/
+	struct protocol_channel *const ch = protocol_get_channel(protocol, channel);
+
+	/*Cache the interface;*/
+	struct netf2 *const iface = protocol->iface;
+
+	struct data_block *block;
+
+	/*The dispatcher must not access the channel while it is closed;*/
+	critical_section_enter();
+
+	/*Close the channel;*/
+	ch->open = false;
+
+	/*Return all queued frames to the interface, lending them first, as protocol_read does;*/
+	while ((block = block_ring_pull(&ch->queue))) {
+		protocol_lend(protocol, block);
+		netf2_return_rx_frame(iface, block);
+	}
+
+	/*If a reader waits, resume it, it will find the channel closed;*/
+	if (ch->reader) {
+		sched_resume_prc(ch->reader);
+		ch->reader = 0;
+	}
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+	/*Delete the queue;*/
+	block_ring_delete(&ch->queue);
+
+}
+
+
+/*---------------------------------------------------- IRQ functions ---------------------------------------------------*/
+
+/**
+ * protocol_dispatch : reads the channel header of a received frame, queues the frame in its channel, and resumes the
+ * 	channel's reader if it waits;
+ *
+ * 	Called by the interface, in the reception interrupt. If the frame can't be queued, it is counted, and its block is
+ * 	still owned by the interface;
+ *
+ * @param protocol : the protocol that demultiplexes the frame;
+ * @param block : the received frame;
+ * @return true if the frame was queued;
+ */
+
+bool protocol_dispatch(struct protocol_t *const protocol, struct data_block *const block) {
+
+	/*If the frame has no header :*/
+	if (block->size < PROTOCOL_HEADER_SIZE) {
+
+		/*Drop it;*/
+		protocol->nb_unrouted++;
+		return false;
+
+	}
+
+	/*Read the channel index;*/
+	const uint8_t channel = *(const uint8_t *) block->address;
+
+	/*If the channel is invalid or closed :*/
+	if ((channel >= PROTOCOL_NB_CHANNELS) || (!protocol->channels[channel].open)) {
+
+		/*Drop the frame;*/
+		protocol->nb_unrouted++;
+		return false;
+
+	}
+
+	/*Cache the channel;*/
+	struct protocol_channel *const ch = protocol->channels + channel;
+
+	/*Queue the frame; If the queue is full :*/
+	if (!block_ring_push(&ch->queue, block)) {
+
+		/*Drop the frame;*/
+		ch->nb_drops++;
+		return false;
+
+	}
+
+	/*Update the counter;*/
+	ch->nb_frames++;
+
+	/*Cache the reader;*/
+	struct sched_elmt *const reader = ch->reader;
+
+	/*If a reader waits :*/
+	if (reader) {
+
+		/*Resume it;*/
+		ch->reader = 0;
+		sched_resume_prc(reader);
+
+		/*Require a context switch, the reader may have a higher priority;*/
+		__prmpt_trigger();
+
+	}
+
+	/*The frame is queued;*/
+	return true;
+
+}
+
+
+/*------------------------------------------------------- Polling ------------------------------------------------------*/
+
+/**
+ * protocol_read : borrows the first frame queued in a channel. The frame must be returned with protocol_release;
+ *
+ * 	If the channel is empty and @wait is set, the calling process is stopped, and will be resumed when a frame is
+ * 	dispatched to the channel, or when the channel is closed. Must be called from the process's syscall, that
+ * 	returns 0 and must be retried once the process is resumed;
+ *
+ * @param protocol : the protocol that owns the channel;
+ * @param channel : the channel index;
+ * @param wait : set if the process must be stopped until a frame is available;
+ * @return the frame, or 0 if the channel is empty or closed;
+ */
+
+struct data_block *protocol_read(struct protocol_t *const protocol, const uint8_t channel, const bool wait) {
+
+	/*Cache the channel;*/
+	struct protocol_channel *const ch = protocol_get_channel(protocol, channel);
+
+	/*If the channel is closed, no frame;*/
+	if (!ch->open) {
+		return 0;
+	}
+
+	/*Checking the queue and registering the reader must not be interrupted by the dispatcher;*/
+	critical_section_enter();
+
+	/*Pull a frame;*/
+	struct data_block *const block = block_ring_pull(&ch->queue);
+
+	/*If no frame is available, and the process must wait, stop it and register it as the reader;*/
+	if ((!block) && (wait)) {
+		ch->reader = sched_stop_prc();
+	}
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+	/*If no frame is available :*/
+	if (!block) {
+
+		/*If the process was stopped, require a context switch;*/
+		if (wait) {
+			__prmpt_trigger();
+		}
+
+		/*No frame;*/
+		return 0;
+
+	}
+
+	/*Lend the frame, it will be returned to the interface;*/
+	protocol_lend(protocol, block);
+
+	/*Return the frame;*/
+	return block;
+
+}
+
+
+/**
+ * protocol_release : returns a frame borrowed from a channel to the interface;
+ *
+ * 	Several subscribers can release frames, pushes in rx_empty are serialised;
+ *
+ * @param protocol : the protocol the frame was read from;
+ * @param block : the processed frame;
+ */
+
+void protocol_release(struct protocol_t *const protocol, struct data_block *const block) {
+
+	/*Serialise producers of rx_empty;*/
+	critical_section_enter();
+
+	/*Return the frame to the interface;*/
+	netf2_return_rx_frame(protocol->iface, block);
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+}
+
+
+/**
+ * protocol_borrow_tx_frame : borrows an empty frame to send on a channel, and writes its header;
+ *
+ * 	The payload must be written after the header, and the size updated accordingly;
+ *
+ * @param protocol : the protocol to send on;
+ * @param channel : the channel index;
+ * @return the frame, or 0 if none is available;
+ */
+
+struct data_block *protocol_borrow_tx_frame(struct protocol_t *const protocol, const uint8_t channel) {
+
+	/*Validate the channel index;*/
+	protocol_get_channel(protocol, channel);
+
+	/*Serialise consumers of tx_empty;*/
+	critical_section_enter();
+
+	/*Borrow a frame;*/
+	struct data_block *const block = netf2_borrow_tx_frame(protocol->iface);
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+	/*If a frame was borrowed :*/
+	if (block) {
+
+		/*Write the header;*/
+		*(uint8_t *) block->address = channel;
+		block->size = PROTOCOL_HEADER_SIZE;
+
+	}
+
+	/*Return the frame;*/
+	return block;
+
+}
+
+
+/**
+ * protocol_commit_tx_frame : hands back a frame borrowed with protocol_borrow_tx_frame for transmission;
+ *
+ * @param protocol : the protocol the frame was borrowed from;
+ * @param block : the filled frame;
+ * @return true if the frame was queued, false if it left no space for the framer's trailer, and was cancelled;
+ */
+
+bool protocol_commit_tx_frame(struct protocol_t *const protocol, struct data_block *const block) {
+
+	/*Serialise producers of tx_nonempty;*/
+	critical_section_enter();
+
+	/*Commit the frame;*/
+	const bool committed = netf2_commit_tx_frame(protocol->iface, block);
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+	/*Return the result;*/
+	return committed;
+
+}
+
+
+/**
+ * protocol_borrow_tx_payload : borrows an empty block, to be filled with a payload and sent with
+ * 	protocol_commit_tx_payload, or handed back with protocol_commit_tx_frame after a header was chained to it by
+ * 	another layer;
+ *
+ * @param protocol : the protocol to send on;
+ * @return the block, or 0 if none is available;
+ */
+
+struct data_block *protocol_borrow_tx_payload(struct protocol_t *const protocol) {
+
+	/*Serialise consumers of tx_empty;*/
+	critical_section_enter();
+
+	/*Borrow a block;*/
+	struct data_block *const block = netf2_borrow_tx_frame(protocol->iface);
+
+	/*Leave the critical section;*/
+	critical_section_leave();
+
+	/*Return the block;*/
+	return block;
+
+}
+
+
+/**
+ * protocol_commit_tx_payload : borrows a header block, chains @payload after it, and commits the chain as a single
+ * 	frame; The payload is not copied;
+ *
+ * @param protocol : the protocol to send on;
+ * @param channel : the channel index;
+ * @param payload : the payload block, borrowed from the interface, possibly chained;
+ * @return true if the frame was committed, false if no header block was available, the payload being still owned by
+ * 	the caller, or if the frame left no space for the framer's trailer, the payload being handed back;
+ */
+
+bool protocol_commit_tx_payload(struct protocol_t *const protocol, const uint8_t channel,
+								struct data_block *const payload) {
+
+	/*Borrow a frame, its header is written;*/
+	struct data_block *const header = protocol_borrow_tx_frame(protocol, channel);
+
+	/*If no block was available, the payload is still owned by the caller;*/
+	if (!header) {
+		return false;
+	}
+
+	/*Chain the payload after the header;*/
+	data_block_chain(header, payload);
+
+	/*Commit the chain;*/
+	return protocol_commit_tx_frame(protocol, header);
+
+}
@@ -21,11 +21,153 @@
 #ifndef TRACER_PROTOCOL_H
 #define TRACER_PROTOCOL_H
 
+#include <stdbool.h>
+
+#include <stdint.h>
+
+#include <stddef.h>
+
+#include <kernel/res/net/netf.h>
+
+
+struct sched_elmt;
+
+
+/*--------------------------------------------------- Make Parameters --------------------------------------------------*/
+
+/*The number of channels of a protocol;*/
+#if !defined(PROTOCOL_NB_CHANNELS)
+
+#define PROTOCOL_NB_CHANNELS 8
+
+#endif
+
+
+/*The size of the channel header, at the start of each frame;*/
+#define PROTOCOL_HEADER_SIZE 1
+
+
+/*------------------------------------------------------ Protocol ------------------------------------------------------*/
+
+/*
+ * A protocol demultiplexes the frames of a netf2 : the first byte of each frame is a channel index, and frames are
+ * 	dispatched, without copy, to the queue of the channel, as soon as they are received;
+ *
+ * 	A process subscribes to a channel by opening it. It then reads frames from the channel, and releases them to the
+ * 	interface once they are processed. A process that reads an empty channel can be stopped, and is resumed when a
+ * 	frame is dispatched to the channel;
+ *
+ * 	Frames addressed to a closed channel, or to a full channel, are dropped and counted;
+ */
+
+struct protocol_channel {
+
+	/*The queue of received frames. Pushed by the dispatcher, pulled by the subscriber;*/
+	struct block_ring queue;
+
+	/*The subscriber, stopped until a frame is received. Null if no reader waits;*/
+	struct sched_elmt *volatile reader;
+
+	/*Is the channel open ?*/
+	volatile bool open;
+
+	/*The number of frames dispatched to the channel;*/
+	size_t nb_frames;
+
+	/*The number of frames dropped because the queue was full;*/
+	size_t nb_drops;
+
+};
+
 
 struct protocol_t {
 
+	/*The interface the protocol demultiplexes;*/
+	struct netf2 *iface;
 
+	/*Channels;*/
+	struct protocol_channel channels[PROTOCOL_NB_CHANNELS];
+
+	/*The number of frames dropped because they had no header, or were addressed to a closed channel;*/
+	size_t nb_unrouted;
 
 };
 
+
+/*----------------------------------------------------- Init - Exit ----------------------------------------------------*/
+
+/*Initialise the protocol and attach it to @iface. All channels are closed;*/
+void protocol_init(struct protocol_t *protocol, struct netf2 *iface);
+
+/*Close all channels and detach the protocol;*/
+void protocol_exit(struct protocol_t *protocol);
+
+
+/*------------------------------------------------------ Channels ------------------------------------------------------*/
+
+/*Open a channel, that can queue up to @depth frames;*/
+void protocol_open(struct protocol_t *protocol, uint8_t channel, size_t depth);
+
+/*Close a channel. Queued frames are returned to the interface;*/
+void protocol_close(struct protocol_t *protocol, uint8_t channel);
+
+
+/*---------------------------------------------------- IRQ functions ---------------------------------------------------*/
+
+/*Dispatch a received frame to its channel. Asserts if the frame was queued; If not, the block is still owned by the caller;*/
+bool protocol_dispatch(struct protocol_t *protocol, struct data_block *block);
+
+
+/*------------------------------------------------------- Polling ------------------------------------------------------*/
+
+/*Borrow a frame from a channel. If none is available and @wait is set, the caller is stopped until one is received;*/
+struct data_block *protocol_read(struct protocol_t *protocol, uint8_t channel, bool wait);
+
+/*Return a frame borrowed from a channel to the interface;*/
+void protocol_release(struct protocol_t *protocol, struct data_block *block);
+
+/*Borrow an empty frame to send on a channel. Its header is written;*/
+struct data_block *protocol_borrow_tx_frame(struct protocol_t *protocol, uint8_t channel);
+
+/*Hand back a filled frame for transmission. False if it left no space for the framer's trailer, and was cancelled;*/
+bool protocol_commit_tx_frame(struct protocol_t *protocol, struct data_block *block);
+
+/*Borrow an empty block to fill with a payload, without header;*/
+struct data_block *protocol_borrow_tx_payload(struct protocol_t *protocol);
+
+/*Send a payload block on a channel, after a chained header block. False if no header block is available, or if the
+ * frame was rejected by protocol_commit_tx_frame;*/
+bool protocol_commit_tx_payload(struct protocol_t *protocol, uint8_t channel, struct data_block *payload);
+
+
+/**
+ * protocol_payload : returns the address of a frame's payload, after the channel header;
+ *
+ * @param block : the frame;
+ * @return the address of the payload;
+ */
+
+static inline void *protocol_payload(const struct data_block *const block) {
+
+	/*The payload follows the header;*/
+	return (uint8_t *) block->address + PROTOCOL_HEADER_SIZE;
+
+}
+
+
+/**
+ * protocol_payload_size : returns the size of a received frame's payload;
+ *
+ * @param block : the frame;
+ * @return the size of the payload;
+ */
+
+static inline size_t protocol_payload_size(const struct data_block *const block) {
+
+	/*Dispatched frames always contain the header;*/
+	return block->size - PROTOCOL_HEADER_SIZE;
+
+}
+
+
 #endif /*TRACER_PROTOCOL_H*/
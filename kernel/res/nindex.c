@@ -0,0 +1,427 @@
+/*
+  nindex.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <kernel/res/nindex.h>
+
+#include <string.h>
+
+#include <stdmem.h>
+
+#include <kernel/res/kdmem.h>
+
+#include <kernel/hard/debug/printk.h>
+
+
+/*--------------------------------------------------- Make Parameters --------------------------------------------------*/
+
+/*The number of entries allocated at the first insertion. Must be a power of two;*/
+#if !defined(NINDEX_MIN_CAPACITY)
+
+#define NINDEX_MIN_CAPACITY 16
+
+#endif
+
+
+/*------------------------------------------------------- Hashing ------------------------------------------------------*/
+
+/**
+ * nindex_hash : hashes a name with FNV-1a, and determines its length in the same pass;
+ *
+ * @param name : the name to hash;
+ * @param length : the location where to store the name's length;
+ * @return the name's hash;
+ */
+
+static uint32_t nindex_hash(const char *name, size_t *const length) {
+
+	/*Initialise the hash to the FNV offset basis;*/
+	uint32_t hash = 2166136261u;
+
+	/*Cache the name's start;*/
+	const char *const start = name;
+
+	/*For each character :*/
+	while (*name) {
+
+		/*Mix the character and multiply by the FNV prime;*/
+		hash = (hash ^ (uint8_t) *(name++)) * 16777619u;
+
+	}
+
+	/*Save the length;*/
+	*length = (size_t) (name - start);
+
+	/*Return the hash;*/
+	return hash;
+
+}
+
+
+/*------------------------------------------------------- Probing ------------------------------------------------------*/
+
+/**
+ * nindex_find : searches the entry that contains a name;
+ *
+ * 	Names are compared only if the cached hash matches;
+ *
+ * @param index : the index to search in;
+ * @param name : the name to search for;
+ * @param hash : the name's hash;
+ * @return the name's entry, or 0 if the name is not present;
+ */
+
+static struct nindex_entry *nindex_find(const struct nindex *const index, const char *const name, const uint32_t hash) {
+
+	/*Cache the capacity mask;*/
+	const size_t mask = index->capacity - 1;
+
+	/*Cache the entries table;*/
+	struct nindex_entry *const entries = index->entries;
+
+	/*If the table is not allocated, the name is not present;*/
+	if (!entries) {
+		return 0;
+	}
+
+	/*For each entry from the hash's home slot, until a free entry is found :*/
+	for (size_t slot = hash & mask; entries[slot].name; slot = (slot + 1) & mask) {
+
+		/*Cache the entry;*/
+		struct nindex_entry *const entry = entries + slot;
+
+		/*If hashes and names match, the entry is found;*/
+		if ((entry->hash == hash) && (!strcmp(entry->name, name))) {
+			return entry;
+		}
+
+	}
+
+	/*A free entry was reached, the name is not present;*/
+	return 0;
+
+}
+
+
+/**
+ * nindex_place : copies an entry in the first free entry after its home slot. The table must not be full;
+ *
+ * @param entries : the entries table;
+ * @param mask : the capacity mask of the table;
+ * @param src : the entry to copy;
+ */
+
+static void nindex_place(struct nindex_entry *const entries, const size_t mask, const struct nindex_entry *const src) {
+
+	/*Start from the hash's home slot;*/
+	size_t slot = src->hash & mask;
+
+	/*Find the first free entry;*/
+	while (entries[slot].name) {
+		slot = (slot + 1) & mask;
+	}
+
+	/*Copy the entry;*/
+	entries[slot] = *src;
+
+}
+
+
+/**
+ * nindex_grow : allocates the table, or doubles it, and moves all entries in the new table using their cached hashes;
+ *
+ * @param index : the index to grow;
+ * @return true if the table could be allocated;
+ */
+
+static bool nindex_grow(struct nindex *const index) {
+
+	/*Cache the current table and its capacity;*/
+	struct nindex_entry *const old_entries = index->entries;
+	const size_t old_capacity = index->capacity;
+
+	/*Determine the new capacity;*/
+	const size_t capacity = (old_capacity) ? (old_capacity << 1) : NINDEX_MIN_CAPACITY;
+
+	/*Allocate the new table, with all entries free;*/
+	struct nindex_entry *const entries = kcalloc(capacity * sizeof(struct nindex_entry));
+
+	/*If the allocation failed, fail;*/
+	if (!entries) {
+		return false;
+	}
+
+	/*For each used entry of the old table, copy it in the new one;*/
+	for (size_t slot = 0; slot < old_capacity; slot++) {
+		if (old_entries[slot].name) {
+			nindex_place(entries, capacity - 1, old_entries + slot);
+		}
+	}
+
+	/*Free the old table;*/
+	if (old_entries) {
+		kfree(old_entries);
+	}
+
+	/*Update the index;*/
+	index->entries = entries;
+	index->capacity = capacity;
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/*------------------------------------------------------ Index API -----------------------------------------------------*/
+
+/**
+ * nindex_add : copies the name in the kernel heap and adds it to the index, associated to @data;
+ *
+ * 	The table is grown before it becomes more than three quarters full;
+ *
+ * @param index : the index to update;
+ * @param name : the name to add;
+ * @param data : the data to associate to the name;
+ * @return true if the name was added, false if it is too long, already present, or if the heap is full;
+ */
+
+bool nindex_add(struct nindex *const index, const char *const name, void *const data) {
+
+	size_t length;
+
+	/*Hash the name;*/
+	const uint32_t hash = nindex_hash(name, &length);
+
+	/*If the name is too long, or already present, fail;*/
+	if ((length > index->name_max_length) || (nindex_find(index, name, hash))) {
+		return false;
+	}
+
+	/*If the table would be more than three quarters full, grow it. If it fails, fail;*/
+	if ((((index->elements + 1) << 2) > (index->capacity * 3)) && (!nindex_grow(index))) {
+		return false;
+	}
+
+	/*Allocate the name's copy;*/
+	char *const copy = kmalloc(length + 1);
+
+	/*If the allocation failed, fail;*/
+	if (!copy) {
+		return false;
+	}
+
+	/*Copy the name with its terminating null;*/
+	memcpy(copy, name, length + 1);
+
+	/*Create the entry;*/
+	const struct nindex_entry entry = {
+		.hash = hash,
+		.name = copy,
+		.data = data,
+	};
+
+	/*Place the entry in the table;*/
+	nindex_place(index->entries, index->capacity - 1, &entry);
+
+	/*Update the number of elements;*/
+	index->elements++;
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * nindex_get : searches for a name and returns its data;
+ *
+ * @param index : the index to search in;
+ * @param name : the name to search for;
+ * @return the data associated to the name, or 0 if it is not present;
+ */
+
+void *nindex_get(const struct nindex *const index, const char *const name) {
+
+	size_t length;
+
+	/*Search for the name's entry;*/
+	const struct nindex_entry *const entry = nindex_find(index, name, nindex_hash(name, &length));
+
+	/*Return the entry's data if found;*/
+	return (entry) ? entry->data : 0;
+
+}
+
+
+/**
+ * nindex_set : updates the data associated to a name;
+ *
+ * @param index : the index to update;
+ * @param name : the name to search for;
+ * @param data : the new data;
+ * @return true if the name was present;
+ */
+
+bool nindex_set(struct nindex *const index, const char *const name, void *const data) {
+
+	size_t length;
+
+	/*Search for the name's entry;*/
+	struct nindex_entry *const entry = nindex_find(index, name, nindex_hash(name, &length));
+
+	/*If the name is not present, fail;*/
+	if (!entry) {
+		return false;
+	}
+
+	/*Update the data;*/
+	entry->data = data;
+
+	/*Complete;*/
+	return true;
+
+}
+
+
+/**
+ * nindex_remove : removes a name from the index and frees its copy;
+ *
+ * 	To keep probe sequences valid without tombstones, following entries of the cluster are shifted back in the freed
+ * 	entry when their home slot allows it;
+ *
+ * @param index : the index to update;
+ * @param name : the name to remove;
+ * @return the data that was associated to the name, or 0 if it was not present;
+ */
+
+void *nindex_remove(struct nindex *const index, const char *const name) {
+
+	size_t length;
+
+	/*Search for the name's entry;*/
+	struct nindex_entry *const entry = nindex_find(index, name, nindex_hash(name, &length));
+
+	/*If the name is not present, nothing to do;*/
+	if (!entry) {
+		return 0;
+	}
+
+	/*Cache the table and the capacity mask;*/
+	struct nindex_entry *const entries = index->entries;
+	const size_t mask = index->capacity - 1;
+
+	/*Cache the data;*/
+	void *const data = entry->data;
+
+	/*Free the name's copy and the entry;*/
+	kfree(entry->name);
+	entry->name = 0;
+
+	/*The freed slot, and the slot to examine;*/
+	size_t hole = (size_t) (entry - entries), slot = hole;
+
+	/*For each following entry of the cluster :*/
+	while (entries[slot = (slot + 1) & mask].name) {
+
+		/*Determine the entry's home slot;*/
+		const size_t home = entries[slot].hash & mask;
+
+		/*If the home slot is cyclically in ]hole, slot], the entry must stay in place;*/
+		if (((slot - home) & mask) < ((slot - hole) & mask)) {
+			continue;
+		}
+
+		/*Shift the entry back in the hole, and free its previous slot;*/
+		entries[hole] = entries[slot];
+		entries[slot].name = 0;
+
+		/*The entry's previous slot is the new hole;*/
+		hole = slot;
+
+	}
+
+	/*Update the number of elements;*/
+	index->elements--;
+
+	/*Return the data;*/
+	return data;
+
+}
+
+
+/**
+ * nindex_clear : frees all name copies and the table. The index is reset and can be used again;
+ *
+ * @param index : the index to clear;
+ * @param deleter : called on the data of each removed name. Can be null;
+ */
+
+void nindex_clear(struct nindex *const index, void (*const deleter)(void *data)) {
+
+	/*Cache the entries table;*/
+	struct nindex_entry *const entries = index->entries;
+
+	/*If the table is not allocated, nothing to do;*/
+	if (!entries) {
+		return;
+	}
+
+	/*For each used entry :*/
+	for (size_t slot = 0; slot < index->capacity; slot++) {
+		if (entries[slot].name) {
+
+			/*Free the name's copy;*/
+			kfree(entries[slot].name);
+
+			/*Delete the data if required;*/
+			if (deleter) {
+				(*deleter)(entries[slot].data);
+			}
+
+		}
+	}
+
+	/*Free the table;*/
+	kfree(entries);
+
+	/*Reset the index;*/
+	index->entries = 0;
+	index->capacity = 0;
+	index->elements = 0;
+
+}
+
+
+/**
+ * nindex_list : prints all names of the index, in table order;
+ *
+ * @param index : the index to list;
+ */
+
+void nindex_list(const struct nindex *const index) {
+
+	/*For each used entry, print its name;*/
+	for (size_t slot = 0; slot < index->capacity; slot++) {
+		if (index->entries[slot].name) {
+			printkf("%s\n\r", index->entries[slot].name);
+		}
+	}
+
+}
@@ -0,0 +1,45 @@
+/*
+  crc.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * This file contains declarations for all khal dependant CRC functions;
+ */
+
+#ifndef TRACER_KHAL_CRC_H
+#define TRACER_KHAL_CRC_H
+
+#include <stdbool.h>
+
+#include <stdint.h>
+
+#include <stddef.h>
+
+
+/*
+ * Compute the CRC of a byte span with the hardware CRC unit; Implemented by the hardware, if it has a CRC unit;
+ *
+ * 	@width is 16 or 32. If @reflected, input bytes and the result are bit-reversed. The result is xored with @xor_out;
+ */
+
+extern uint32_t __crc_hw_compute(uint8_t width, uint32_t polynomial, uint32_t seed, bool reflected, uint32_t xor_out,
+								 const uint8_t *data, size_t size);
+
+
+#endif /*TRACER_KHAL_CRC_H*/
@@ -31,6 +31,13 @@
 extern uint8_t __ram_min;
 extern const uint8_t __ram_max;
 
+/*The free part of the lower RAM region. Empty if the RAM is not split;*/
+extern uint8_t __ram_l_min;
+extern const uint8_t __ram_l_max;
+
+/*The lowest free address of the upper RAM region. Its highest is __ram_max;*/
+extern uint8_t __ram_u_min;
+
 /*Load and virtual min and max addresses of data section (resp) in FLASH, RAM and RAM;*/
 extern const uint8_t __data_lma_min;
 extern const uint8_t __data_vma_min;
@@ -61,4 +68,17 @@ extern const uint8_t __umod_min;
 extern const uint8_t __umod_max;
 
 
+
+/*
+ * Placement attributes; Hot code and data can be placed in the lower RAM region, close to the core's code bus.
+ * 	They are copied at startup with .data. DMA buffers are RAM_DMA frames, allocated in the upper region;
+ */
+
+/*Place a function in RAM, in the lower region;*/
+#define __ram_hot_text __attribute__((section(".ram_hot_text"), noinline, long_call))
+
+/*Place an initialised variable in RAM, in the lower region;*/
+#define __ram_hot_data __attribute__((section(".ram_hot_data")))
+
+
 #endif /*TRACER_LINK_H*/
@@ -33,6 +33,20 @@ kinetis_k_khal:
 KHAL_RULES += kinetis_k_khal
 
 
+#------------ CRC unit ------------
+
+#Kinetis k CRC unit;
+kinetis_k_crc:
+
+#Compile the CRC source;
+	$(KHAL_CC) -o $(KHAL_OBJS_BDIR)/kx_crc.o -c $(KX_DIR)/kx_crc.c
+
+#The CRC unit is used only if the hardware CRC is enabled;
+ifeq ($(BOPS_HW_CRC),1)
+KHAL_RULES += kinetis_k_crc
+endif
+
+
 #------------ Flash config ------------
 
 
@@ -80,3 +80,19 @@ PLL_LOL_INT ?= 0
 
 #Should a loss of lock in the PLL generate a reset ?
 PLL_LOL_RESET ?= 0
+
+
+#------------------------------------------------------- FlexNVM -------------------------------------------------------
+
+#The size of the FlexNVM area used as data flash by the flash driver. If the FlexNVM is partitioned to back the
+#	EEPROM, only the data flash part must be declared;
+FLEXNVM_DATA_SIZE ?= 131072
+
+
+#-------------------------------------------------------- UARTs --------------------------------------------------------
+
+#The frequency of the clock that drives UART0 and UART1 (the core clock);
+UART_CORE_CLOCK ?= 120000000
+
+#The frequency of the clock that drives other UARTs (the bus clock);
+UART_BUS_CLOCK ?= 60000000
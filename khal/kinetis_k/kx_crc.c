@@ -0,0 +1,136 @@
+/*
+  kx_crc.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include <stdint.h>
+
+#include <arch/kx_sim.h>
+
+#include <crc.h>
+
+
+/*-------------------------------------------------------- Registers ---------------------------------------------------*/
+
+/*The CRC data register, accessed by word or by byte;*/
+#define CRC_DATA ((volatile uint32_t *) 0x40032000)
+#define CRC_DATALL ((volatile uint8_t *) 0x40032000)
+
+/*The CRC polynomial register;*/
+#define CRC_GPOLY ((volatile uint32_t *) 0x40032004)
+
+/*The CRC control register;*/
+#define CRC_CTRL ((volatile uint32_t *) 0x40032008)
+
+/*Transpose bits in bytes and bytes, for writes and for reads;*/
+#define CRC_CTRL_TOT_BITS_BYTES ((uint32_t) 2 << 30)
+#define CRC_CTRL_TOTR_BITS_BYTES ((uint32_t) 2 << 28)
+
+/*Complement the read result;*/
+#define CRC_CTRL_FXOR ((uint32_t) 1 << 26)
+
+/*Writes to DATA are seeds;*/
+#define CRC_CTRL_WAS ((uint32_t) 1 << 25)
+
+/*32 bits CRC;*/
+#define CRC_CTRL_TCRC ((uint32_t) 1 << 24)
+
+
+/*------------------------------------------------------- Computation --------------------------------------------------*/
+
+/**
+ * __crc_hw_compute : computes the CRC of a byte span with the CRC module;
+ *
+ * 	Aligned words are written at once, remaining bytes are written in the low byte of DATA;
+ *
+ * 	The module is not shared, callers must not preempt each other;
+ *
+ * @param width : the CRC width, 16 or 32;
+ * @param polynomial : the generator polynomial, in the normal form;
+ * @param seed : the initial value;
+ * @param reflected : set if input bytes and the result are bit-reversed;
+ * @param xor_out : the value to xor the result with. Only null and all-ones are supported by the hardware;
+ * @param data : the bytes to process;
+ * @param size : the number of bytes to process;
+ * @return the CRC;
+ */
+
+uint32_t __crc_hw_compute(const uint8_t width, const uint32_t polynomial, const uint32_t seed, const bool reflected,
+						  const uint32_t xor_out, const uint8_t *data, size_t size) {
+
+	/*Determine the control word;*/
+	uint32_t ctrl = 0;
+
+	/*Select the width;*/
+	if (width == 32) {
+		ctrl |= CRC_CTRL_TCRC;
+	}
+
+	/*Select transpositions;*/
+	if (reflected) {
+		ctrl |= CRC_CTRL_TOT_BITS_BYTES | CRC_CTRL_TOTR_BITS_BYTES;
+	}
+
+	/*Select the final complement;*/
+	if (xor_out) {
+		ctrl |= CRC_CTRL_FXOR;
+	}
+
+	/*Enable the module's clock;*/
+	sim_enable_CRC_clock_gating();
+
+	/*Configure the module, and write the polynomial;*/
+	*CRC_CTRL = ctrl;
+	*CRC_GPOLY = polynomial;
+
+	/*Write the seed;*/
+	*CRC_CTRL = ctrl | CRC_CTRL_WAS;
+	*CRC_DATA = seed;
+	*CRC_CTRL = ctrl;
+
+	/*Write bytes until data is word aligned;*/
+	while (size && ((size_t) data & 3)) {
+		*CRC_DATALL = *(data++);
+		size--;
+	}
+
+	/*Write aligned words; When bytes are not transposed, the first byte must be the most significant;*/
+	while (size >= 4) {
+
+		/*Cache the word;*/
+		uint32_t word = *(const uint32_t *) data;
+
+		/*Write the word, in the stream order;*/
+		*CRC_DATA = (reflected) ? word : __builtin_bswap32(word);
+
+		/*Update the span;*/
+		data += 4;
+		size -= 4;
+
+	}
+
+	/*Write remaining bytes;*/
+	while (size--) {
+		*CRC_DATALL = *(data++);
+	}
+
+	/*Read the result. A 16 bits CRC is in the low half-word;*/
+	return (width == 32) ? *CRC_DATA : (*CRC_DATA & 0xFFFF);
+
+}
@@ -0,0 +1,155 @@
+/*
+  kx_edma.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_KX_EDMA_H
+#define TRACER_KX_EDMA_H
+
+#include <stdint.h>
+
+
+/*
+ * The eDMA controller moves data between peripherals and memory without the core. Each of its 16 channels is
+ * 	described by a transfer control descriptor (TCD), and is routed to a peripheral request source by the DMAMUX;
+ *
+ * 	Drivers own their channels, that are provided by their hardware specs. Only the register map and basic channel
+ * 	operations are defined here;
+ */
+
+
+//----------------------------------------------------- Memory Map -----------------------------------------------------
+
+/*
+ * The eDMA control registers;
+ */
+
+struct __attribute__ ((packed)) K64_eDMA_registers {
+	volatile uint32_t CR;
+	volatile uint32_t ES;
+	volatile uint32_t unused1;
+	volatile uint32_t ERQ;
+	volatile uint32_t unused2;
+	volatile uint32_t EEI;
+	volatile uint8_t CEEI;
+	volatile uint8_t SEEI;
+	volatile uint8_t CERQ;
+	volatile uint8_t SERQ;
+	volatile uint8_t CDNE;
+	volatile uint8_t SSRT;
+	volatile uint8_t CERR;
+	volatile uint8_t CINT;
+	volatile uint32_t unused3;
+	volatile uint32_t INT;
+	volatile uint32_t unused4;
+	volatile uint32_t ERR;
+	volatile uint32_t unused5;
+	volatile uint32_t HRS;
+};
+
+
+/*
+ * A transfer control descriptor : a major loop of CITER minor loops, each one moving NBYTES bytes;
+ */
+
+struct __attribute__ ((packed)) K64_eDMA_TCD {
+	volatile uint32_t SADDR;
+	volatile int16_t SOFF;
+	volatile uint16_t ATTR;
+	volatile uint32_t NBYTES;
+	volatile int32_t SLAST;
+	volatile uint32_t DADDR;
+	volatile int16_t DOFF;
+	volatile uint16_t CITER;
+	volatile int32_t DLASTSGA;
+	volatile uint16_t CSR;
+	volatile uint16_t BITER;
+};
+
+
+//The eDMA control registers;
+#define K64_EDMA ((struct K64_eDMA_registers *) 0x40008000)
+
+//The TCD of a channel;
+#define K64_EDMA_TCD(channel) (((struct K64_eDMA_TCD *) 0x40009000) + (channel))
+
+//The DMAMUX configuration register of a channel;
+#define K64_DMAMUX_CHCFG(channel) (((volatile uint8_t *) 0x40021000) + (channel))
+
+
+//Interrupt at the end of the major loop;
+#define EDMA_TCD_CSR_INTMAJOR ((uint16_t) (1 << 1))
+
+//Interrupt at the half of the major loop;
+#define EDMA_TCD_CSR_INTHALF ((uint16_t) (1 << 2))
+
+//Clear the channel's request at the end of the major loop;
+#define EDMA_TCD_CSR_DREQ ((uint16_t) (1 << 3))
+
+//Enable the DMAMUX channel;
+#define DMAMUX_CHCFG_ENBL ((uint8_t) (1 << 7))
+
+
+//-------------------------------------------------- Channel operations ------------------------------------------------
+
+//The SIM clock gating registers of the DMAMUX and the eDMA, and their bits;
+#define K64_EDMA_SCGC6 ((volatile uint32_t *) 0x4004803C)
+#define K64_EDMA_SCGC7 ((volatile uint32_t *) 0x40048040)
+#define SCGC6_DMAMUX ((uint32_t) (1 << 1))
+#define SCGC7_DMA ((uint32_t) (1 << 1))
+
+
+//Enable the eDMA and DMAMUX clocks;
+static inline void K64_eDMA_enable_clocks() {
+	*K64_EDMA_SCGC6 |= SCGC6_DMAMUX;
+	*K64_EDMA_SCGC7 |= SCGC7_DMA;
+}
+
+
+//Route a channel to a request source. The channel must be disabled first, as the source can't change while enabled;
+static inline void K64_eDMA_route(const uint8_t channel, const uint8_t source) {
+	*K64_DMAMUX_CHCFG(channel) = 0;
+	*K64_DMAMUX_CHCFG(channel) = (uint8_t) (DMAMUX_CHCFG_ENBL | (source & 0x3F));
+}
+
+
+//Disconnect a channel from its request source;
+static inline void K64_eDMA_unroute(const uint8_t channel) {
+	*K64_DMAMUX_CHCFG(channel) = 0;
+}
+
+
+//Let the channel's hardware requests start minor loops;
+static inline void K64_eDMA_enable_requests(const uint8_t channel) {
+	K64_EDMA->SERQ = channel;
+}
+
+
+//Ignore the channel's hardware requests;
+static inline void K64_eDMA_disable_requests(const uint8_t channel) {
+	K64_EDMA->CERQ = channel;
+}
+
+
+//Acknowledge the channel's interrupt;
+static inline void K64_eDMA_clear_interrupt(const uint8_t channel) {
+	K64_EDMA->CINT = channel;
+}
+
+
+#endif //TRACER_KX_EDMA_H
@@ -0,0 +1,283 @@
+/*
+  kx_flash.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+//--------------------------------------------------- Make parameters --------------------------------------------------
+
+/*
+ * kx.mk must provide :
+ * 	- FTFE_REG : 		start of the flash memory module register area;
+ * 	- FMC_REG : 		start of the flash memory controller register area;
+ * 	- NVM_ADDR : 		address of the FlexNVM area in the memory map;
+ * 	- NVM_CMD_ADDR : 	address of the FlexNVM area for flash commands;
+ * 	- NVM_SIZE : 		size of the FlexNVM area used as data flash, not backing the EEPROM;
+ * 	- SECTOR_SIZE : 	size of a FlexNVM sector;
+ * 	- PHRASE_SIZE : 	size of a program phrase;
+ */
+
+//If one of the macro was not provided :
+#if !defined(FTFE_REG) || !defined(FMC_REG) || !defined(NVM_ADDR) || !defined(NVM_CMD_ADDR) || !defined(NVM_SIZE) \
+	|| !defined(SECTOR_SIZE) || !defined(PHRASE_SIZE)
+
+//Log
+#error "Error, at least one macro argument hasn't been provided. Check the makefile;"
+
+//Define macros. Allows debugging on IDE environment;
+#define FTFE_REG 0
+#define FMC_REG 0
+#define NVM_ADDR 0
+#define NVM_CMD_ADDR 0
+#define NVM_SIZE 4096
+#define SECTOR_SIZE 4096
+#define PHRASE_SIZE 8
+
+#endif
+
+
+//------------------------------------------------------ Includes ------------------------------------------------------
+
+#include <if/flash.h>
+
+#include <fs/iinode.h>
+
+#include <kernel/exec/mod_hook>
+
+#include <stdmem.h>
+
+
+//------------------------------------------------ Internal parameters ------------------------------------------------
+
+/*
+ * FTFE registers : command registers are grouped by four, in big endian order. FCCOB0 (the command) and FCCOB1-3
+ * 	(the address) thus form a little endian word at offset 4, and data bytes of a phrase are at offsets 8 to 15, in
+ * 	memory order;
+ */
+
+#define FSTAT		((volatile uint8_t *) (FTFE_REG))
+#define FCCOB_CMD	((volatile uint32_t *) (FTFE_REG + 0x04))
+#define FCCOB_DATA	((volatile uint8_t *) (FTFE_REG + 0x08))
+
+//Command complete. W1C, writing it launches the command;
+#define FSTAT_CCIF		((uint8_t) 0x80)
+
+//Error flags. ACCERR and FPVIOL are W1C;
+#define FSTAT_ACCERR	((uint8_t) 0x20)
+#define FSTAT_FPVIOL	((uint8_t) 0x10)
+#define FSTAT_MGSTAT0	((uint8_t) 0x01)
+
+//Commands;
+#define CMD_PROGRAM_PHRASE	((uint32_t) 0x07)
+#define CMD_ERASE_SECTOR	((uint32_t) 0x09)
+
+//The FMC cache control register of the FlexNVM bank, and its invalidation bits;
+#define PFB23CR		((volatile uint32_t *) (FMC_REG + 0x08))
+#define PFB_INVALIDATE	((uint32_t) 0x00F80000)
+
+
+//---------------------------------------------------- Driver state ----------------------------------------------------
+
+//Set while a launched command has not been observed completed. The FMC cache is invalidated at completion;
+static volatile bool command_pending = false;
+
+//Set if the last command failed;
+static volatile bool command_failed = false;
+
+//The if reference, for neutralisation at close;
+static struct flash_if *if_ref = 0;
+
+
+//-------------------------------------------------- Flash operations --------------------------------------------------
+
+/*
+ * Commands are launched and never waited for : sector erases take tens of milliseconds, during which the core keeps
+ * 	executing from the program flash, as the FlexNVM is a separate block;
+ */
+
+//Is a command executing ? Records the completion of the last one;
+static bool flash_busy() {
+
+	//If the command complete flag is cleared, a command is executing;
+	if (!(*FSTAT & FSTAT_CCIF)) {
+		return true;
+	}
+
+	//If a command has just completed :
+	if (command_pending) {
+
+		//Record its status;
+		command_failed = (bool) (*FSTAT & (FSTAT_ACCERR | FSTAT_FPVIOL | FSTAT_MGSTAT0));
+
+		//Invalidate the FlexNVM cache and prefetch buffer, that may contain data of the previous flash content;
+		*PFB23CR |= PFB_INVALIDATE;
+
+		//Mark the command observed;
+		command_pending = false;
+
+	}
+
+	//Not busy;
+	return false;
+
+}
+
+
+//Did the last command fail ?
+static bool flash_failed() {
+
+	//Update the command status and return it;
+	flash_busy();
+	return command_failed;
+
+}
+
+
+//Launch a command, whose FCCOB data registers are already written;
+static void flash_launch(const uint32_t command, const size_t offset) {
+
+	//Clear error flags of the previous command;
+	*FSTAT = FSTAT_ACCERR | FSTAT_FPVIOL;
+
+	//Write the command and the FlexNVM address;
+	*FCCOB_CMD = (command << 24) | (NVM_CMD_ADDR + offset);
+
+	//Mark the command pending;
+	command_pending = true;
+
+	//Launch the command;
+	*FSTAT = FSTAT_CCIF;
+
+}
+
+
+//Launch the erase of a sector;
+static bool flash_erase(const size_t sector) {
+
+	//If a command is executing, or if the sector doesn't exist, fail;
+	if ((flash_busy()) || (sector >= NVM_SIZE / SECTOR_SIZE)) {
+		return false;
+	}
+
+	//Launch the erase;
+	flash_launch(CMD_ERASE_SECTOR, sector * SECTOR_SIZE);
+
+	//Complete;
+	return true;
+
+}
+
+
+//Launch the program of a phrase;
+static bool flash_program(const size_t offset, const uint8_t *const phrase) {
+
+	//If a command is executing, or if the offset is invalid, fail;
+	if ((flash_busy()) || (offset >= NVM_SIZE) || (offset % PHRASE_SIZE)) {
+		return false;
+	}
+
+	//Write data bytes;
+	for (uint8_t i = 0; i < PHRASE_SIZE; i++) {
+		FCCOB_DATA[i] = phrase[i];
+	}
+
+	//Launch the program;
+	flash_launch(CMD_PROGRAM_PHRASE, offset);
+
+	//Complete;
+	return true;
+
+}
+
+
+//The flash if;
+static const struct flash_if flash_iface = {
+	.memory = (const volatile uint8_t *) NVM_ADDR,
+	.sector_size = SECTOR_SIZE,
+	.phrase_size = PHRASE_SIZE,
+	.nb_sectors = NVM_SIZE / SECTOR_SIZE,
+
+	.busy = &flash_busy,
+	.failed = &flash_failed,
+	.erase = &flash_erase,
+	.program = &flash_program,
+};
+
+
+//--------------------------------------------------- File Operations --------------------------------------------------
+
+//Transmit the flash if;
+static bool fs_flash_interface(struct iinode *const node, void *const iface, const size_t iface_size) {
+
+	//If the size doesn't match, fail;
+	if (iface_size != sizeof(struct flash_if)) {
+		return false;
+	}
+
+	//Eventually if with the flash;
+	return iface_connect(iface, &flash_iface, &if_ref);
+
+}
+
+
+//Close the flash resource : will neutralise the if;
+static void fs_flash_close(struct iinode *const node) {
+
+	//Cache the if;
+	struct flash_if *const iface = if_ref;
+
+	//If the flash is interfaced :
+	if (iface) {
+
+		//Neutralise the struct;
+		memcpy(iface, &neutral_flash_if, sizeof(struct flash_if));
+
+		//Reset the if pointer;
+		if_ref = 0;
+
+	}
+
+}
+
+
+//The flash file operations;
+static const struct inode_ops flash_ops = {
+	.interface = &fs_flash_interface,
+	.close = &fs_flash_close,
+};
+
+
+//The flash iinode;
+static struct iinode flash_inode = INODE(&flash_ops);
+
+
+//----------------------------------------------------- Init - Exit ----------------------------------------------------
+
+static bool flash_init() {
+
+	//Register the flash file;
+	fs_create("flash", &flash_inode);
+
+	//Complete;
+	return true;
+
+}
+
+
+//Embed the flash module in the executable;
+KERNEL_HOOK_MODULE(PERIPHERAL_MODULE, flash, &flash_init)
@@ -18,6 +18,29 @@
 
 */
 
+//--------------------------------------------------- Make parameters --------------------------------------------------
+
+/*
+ * kinetis_k.mk must provide :
+ * 	- MODULE_NAME : name of the module, prefix of channels symbols;
+ * 	- NB_CHANNELS : number of channels;
+ */
+
+//If one of the macro was not provided :
+#if !defined(MODULE_NAME) || !defined(NB_CHANNELS)
+
+//Log
+#error "Error, at least one macro argument hasn't been provided. Check the makefile;"
+
+//Define macros. Allows debugging on IDE environment;
+#define MODULE_NAME uart
+#define NB_CHANNELS 6
+
+#endif
+
+
+//------------------------------------------------------ Includes ------------------------------------------------------
+
 #include "kx_uart.h"
 
 
@@ -25,6 +48,20 @@
 
 #include <string.h>
 
+#include <kernel/core/except.h>
+
+#include <kernel/core/ram.h>
+
+#include <kernel/exec/mod_hook>
+
+#include <fs/iinode.h>
+
+#include <macro/incr_call.h>
+
+#include <kernel/exec/module_array.h>
+
+#include "kx_uart_n.h"
+
 
 /*
  * SET : will set [data]'s bits that are set to 1 in [mask]. [data] is of size [size];
@@ -54,6 +91,58 @@
 #define CLEAR_BIT(data, bit_id, size) CLEAR(data, 1 << (bit_id), size)
 
 
+/*
+ * K64_UART_BURST_SIZE : the number of bytes transferred between the FIFOs and the framer in one call;
+ */
+
+#define K64_UART_BURST_SIZE 16
+
+
+/*
+ * K64_UART_DMA_RX_SIZE : the size of the rx circular buffer in DMA mode. Bytes are decoded at each half of it;
+ * 	Must be a power of two;
+ */
+
+#if !defined(K64_UART_DMA_RX_SIZE)
+
+#define K64_UART_DMA_RX_SIZE 512
+
+#endif
+
+#if (K64_UART_DMA_RX_SIZE < 2) || (K64_UART_DMA_RX_SIZE & (K64_UART_DMA_RX_SIZE - 1))
+
+#error "K64_UART_DMA_RX_SIZE must be a power of two;"
+
+#endif
+
+//The size of a half of the rx circular buffer;
+#define K64_UART_DMA_RX_HALF (K64_UART_DMA_RX_SIZE / 2)
+
+
+/*
+ * K64_UART_DMA_TX_SIZE : the size of the tx staging buffer in DMA mode. Frames are encoded in it, then transmitted;
+ * 	Both buffers share a single RAM frame;
+ */
+
+#if !defined(K64_UART_DMA_TX_SIZE)
+
+#define K64_UART_DMA_TX_SIZE 256
+
+#endif
+
+
+/*
+ * K64_UART_RX_HEADROOM : the number of rx FIFO entries kept above the adaptive watermark, to absorb the interrupt
+ * 	latency;
+ */
+
+#if !defined(K64_UART_RX_HEADROOM)
+
+#define K64_UART_RX_HEADROOM 2
+
+#endif
+
+
 //--------------------------------------------------- Private headers --------------------------------------------------
 
 //-------------------------- Peripheral init --------------------------
@@ -132,6 +221,25 @@ static void enable_tx_interrupt(struct K64_UART_net21 *iface);
 //static void disable_tx_trigger(const struct K64_UART_interrupt_pipe_t *pipe);
 
 
+//Resume rx DMA transfers;
+static void enable_rx_dma(struct K64_UART_net21 *iface);
+
+//Start a tx DMA transfer if none is in progress;
+static void enable_tx_dma(struct K64_UART_net21 *iface);
+
+
+//-------------------------- DMA mode --------------------------
+
+//Allocate the frame that contains DMA buffers;
+static uint8_t *dma_allocate_frame();
+
+//Setup both DMA channels;
+static void dma_start(const struct K64_UART_driver_t *driver_data);
+
+//Stop both DMA channels and release DMA buffers;
+static void dma_stop(const struct K64_UART_driver_t *driver_data);
+
+
 //Update the rx watermark;
 //static void update_rx_watermark(const struct K64_UART_interrupt_pipe_t *pipe, size_t nb_bytes);
 
@@ -154,8 +262,8 @@ void initialise_peripheral(const struct K64_UART_hw *const peripheral_data) {
 	//Cache the memory pointer;
 	struct K64_UART_registers *const registers = peripheral_data->registers;
 
-	//Turn on the UART0's clock;//TODO MAKE A SIM DRIVER;
-	SIM_SCGC4 |= SIM_SCGC4_UART0;
+	//Turn on the UART's clock;
+	*(peripheral_data->clock_gating_reg) |= peripheral_data->clock_gating_mask;
 
 	//Clear C2 to disable all interrupts;
 	registers->C2 = 0;
@@ -301,7 +409,7 @@ void stop_peripheral(const struct K64_UART_hw *driver_data) {
 	CLEAR(registers->C2, UART_C2_RE | UART_C2_TE, 8);
 
 	//Disable interrupts;
-	CLEAR(registers->C2, UART_C2_TIE | UART_C2_RIE, 8);
+	CLEAR(registers->C2, UART_C2_TIE | UART_C2_RIE | UART_C2_ILIE, 8);
 
 	//Flush FIFOs;
 	registers->CFIFO |= UART_CFIFO_RXFLUSH;
@@ -317,7 +425,7 @@ void stop_peripheral(const struct K64_UART_hw *driver_data) {
  * K64_UART_create : creates an instance of a K64 UART if from hardware if specs;
  */
 
-struct K64_UART_driver_t *K64_UART_create(struct K64_UART_hw *const specs) {
+struct K64_UART_driver_t *K64_UART_create(const struct K64_UART_hw *const specs) {
 
 	//Initialise the peripheral;
 	initialise_peripheral(specs);
@@ -583,13 +691,21 @@ configure_transmission_layer(const struct K64_UART_hw *const hw_specs, const str
 
 /*
  * K64_UART_start : configures the transmission stack_data, creates streams, and starts the UART;
+ *
+ * 	The configuration may come from a process : if it can't be applied, the UART is not started, the framer is not
+ * 	owned, and false is returned;
  */
 
-void K64_UART_start(struct K64_UART_driver_t *driver_data, const struct UART_config_t *config) {
+bool K64_UART_start(struct K64_UART_driver_t *driver_data, const struct UART_config_t *config) {
 
 	//Cache the hardware struct;
 	const struct K64_UART_hw *hw_specs = &driver_data->hw_specs;
 
+	//If DMA is required, the UART must have dedicated rx and tx request sources. Fail before touching the hardware;
+	if ((config->dma_enabled) && ((!hw_specs->dma_rx_source) || (!hw_specs->dma_tx_source))) {
+		return false;
+	}
+
 	//Initialise different parts of the UART;
 	configure_packet_format(hw_specs, config);
 	configure_modem(hw_specs, config);
@@ -611,6 +727,12 @@ void K64_UART_start(struct K64_UART_driver_t *driver_data, const struct UART_con
 	//Get both FIFOs sizes;
 	sizes_from_PFIFO(registers->PFIFO, &rx_fifo_size, &tx_fifo_size);
 
+	//Determine if the rx watermark must adapt to traffic;
+	const bool adaptive_watermark = (config->adaptive_watermark) && (!config->dma_enabled);
+
+	//In DMA mode, allocate the frame that contains DMA buffers;
+	uint8_t *const dma_frame = (config->dma_enabled) ? dma_allocate_frame() : 0;
+
 	//Initialise the interfaces struct;
 	struct K64_UART_net21 interface_init = {
 
@@ -630,17 +752,86 @@ void K64_UART_start(struct K64_UART_driver_t *driver_data, const struct UART_con
 
 		.tx_fifo_size = tx_fifo_size,
 
+		//The adaptive watermark is not used in DMA mode, where requests are made per byte;
+		.adaptive_watermark = adaptive_watermark,
+
+		//Keep some entries free above the watermark;
+		.rx_watermark_max = (rx_fifo_size > K64_UART_RX_HEADROOM) ?
+							(uint8_t) (rx_fifo_size - K64_UART_RX_HEADROOM) : (uint8_t) 1,
+
+		//In adaptive mode, the idle line interrupt follows the rx interrupt;
+		.rx_interrupts = (adaptive_watermark) ? (uint8_t) (UART_C2_RIE | UART_C2_ILIE) : (uint8_t) UART_C2_RIE,
+
+		//Save the transfer mode;
+		.dma = config->dma_enabled,
+
+		//Both DMA buffers are in the DMA frame, rx first;
+		.dma_frame = dma_frame,
+		.dma_rx_buffer = dma_frame,
+		.dma_rx_read = 0,
+		.dma_rx_written = 0,
+		.dma_rx_boundary = 0,
+		.dma_tx_buffer = (dma_frame) ? dma_frame + K64_UART_DMA_RX_SIZE : 0,
+
+		//Reception will be resumed at startup, no transmission in progress;
+		.dma_rx_paused = true,
+		.dma_tx_active = false,
+
+		//Cache DMA channels;
+		.rx_tcd = K64_EDMA_TCD(hw_specs->dma_rx_channel),
+		.tx_tcd = K64_EDMA_TCD(hw_specs->dma_tx_channel),
+		.rx_channel = hw_specs->dma_rx_channel,
+		.tx_channel = hw_specs->dma_tx_channel,
+
 	};
 
-	//Initialise the layer 2 if;
-	netf2_init(
-		&interface_init.iface.iface,
-		config->nb_frames,
-		config->max_frame_size,
-		(void (*)(struct netf2 *)) enable_rx_interrupt,
-		(void (*)(struct netf2 *)) enable_tx_interrupt,
-		(void (*)(struct netf2 *)) netf21_destruct
-	);
+	//In DMA mode, the net2 if resumes DMA transfers. Otherwise, it enables interrupts;
+	void (*const enable_rx)(struct netf2 *) = (config->dma_enabled) ?
+		(void (*)(struct netf2 *)) enable_rx_dma : (void (*)(struct netf2 *)) enable_rx_interrupt;
+	void (*const enable_tx)(struct netf2 *) = (config->dma_enabled) ?
+		(void (*)(struct netf2 *)) enable_tx_dma : (void (*)(struct netf2 *)) enable_tx_interrupt;
+
+	//Initialise the layer 2 if, with shared frames if required, or with its own frames;
+	if (config->shared_frames) {
+
+		//Initialise with pooled frames;
+		const bool initialised = netf2_init_pooled(
+			&interface_init.iface.iface,
+			config->min_frames,
+			config->nb_frames,
+			config->max_frame_size,
+			enable_rx,
+			enable_tx,
+			(void (*)(struct netf2 *)) netf21_destruct
+		);
+
+		//If the quota or the frame size is invalid, release the DMA frame, and fail;
+		if (!initialised) {
+
+			if (dma_frame) {
+				ram_free_frame(dma_frame);
+			}
+
+			return false;
+
+		}
+
+	} else {
+		netf2_init(
+			&interface_init.iface.iface,
+			config->nb_frames,
+			config->max_frame_size,
+			enable_rx,
+			enable_tx,
+			(void (*)(struct netf2 *)) netf21_destruct
+		);
+	}
+
+	//Set the flow control watermark. When reception is paused, the FIFO fills and RTS is deasserted;
+	interface_init.iface.iface.rx_watermark = config->rx_watermark;
+
+	//Reserve the trailer of the framer in tx frames;
+	netf21_reserve_trailer(&interface_init.iface);
 
 	//Allocate and initialise the if;
 	driver_data->iface = kernel_malloc_copy(sizeof(struct K64_UART_net21), &interface_init);
@@ -648,9 +839,22 @@ void K64_UART_start(struct K64_UART_driver_t *driver_data, const struct UART_con
 	//Initialise the hardware in a safe state;
 	start_peripheral(hw_specs);
 
-	//Attempt to enable both interrupts;
-	enable_rx_interrupt(driver_data->iface);
-	enable_tx_interrupt(driver_data->iface);
+	//In DMA mode, setup channels, and route UART requests to them;
+	if (config->dma_enabled) {
+		dma_start(driver_data);
+	}
+
+	//In adaptive mode, clearing the idle flag may read an empty FIFO. The resulting underflow is handled, not an error;
+	if (adaptive_watermark) {
+		CLEAR(registers->CFIFO, UART_CFIFO_RXUFE, 8);
+	}
+
+	//Attempt to enable both directions;
+	(*enable_rx)((struct netf2 *) driver_data->iface);
+	(*enable_tx)((struct netf2 *) driver_data->iface);
+
+	//Complete;
+	return true;
 
 }
 
@@ -659,16 +863,24 @@ void K64_UART_start(struct K64_UART_driver_t *driver_data, const struct UART_con
  * K64_UART_start : this function stops the UART and resets the hardware;
  */
 
-void K64_UART_stop(const struct K64_UART_driver_t *driver_data) {
+void K64_UART_stop(struct K64_UART_driver_t *const driver_data) {
 
 	//Cache the hardware struct;
 	const struct K64_UART_hw *hw_specs = &driver_data->hw_specs;
 
+	//Reset the hardware in a safe state, so that no interrupt accesses the if anymore;
+	stop_peripheral(hw_specs);
+
+	//In DMA mode, stop channels and release DMA buffers;
+	if (driver_data->iface->dma) {
+		dma_stop(driver_data);
+	}
+
 	//Delete the if, calling the superclass deleter;
 	netf2_delete((struct netf2 *) driver_data->iface);
 
-	//Reset the hardware in a safe state;
-	stop_peripheral(hw_specs);
+	//The UART is stopped;
+	driver_data->iface = 0;
 
 }
 
@@ -678,22 +890,27 @@ void K64_UART_stop(const struct K64_UART_driver_t *driver_data) {
 //Enable the rx trigger;
 static void enable_rx_interrupt(struct K64_UART_net21 *const iface) {
 
+	//Enter a critical section, rx_empty and C2 are also accessed by the rx interrupt;
+	critical_section_enter();
+
 	//Initialise the net21 if decoding;
 	bool decoding_authorised = netf21_init_decoding(&iface->iface);
 
 	//If the decoding is not authorised :
 	if (!decoding_authorised) {
 
-		//Disable the rx interrupt : clear the RIE bit in C2;
-		*(iface->C2) &= ~UART_C2_RIE;
+		//Disable rx interrupts : clear the RIE bit in C2, and ILIE in adaptive mode;
+		*(iface->C2) &= ~iface->rx_interrupts;
 
 	} else {
 
-		//Enable the rx interrupt : set the RIE bit in C2;
-		*(iface->C2) |= UART_C2_RIE;
+		//Enable rx interrupts : set the RIE bit in C2, and ILIE in adaptive mode;
+		*(iface->C2) |= iface->rx_interrupts;
 
 	}
 
+	//Leave the critical section;
+	critical_section_leave();
 
 }
 
@@ -701,16 +918,18 @@ static void enable_rx_interrupt(struct K64_UART_net21 *const iface) {
 //Enable the tx trigger;
 static void enable_tx_interrupt(struct K64_UART_net21 *const iface) {
 
+	//Enter a critical section, tx_nonempty and C2 are also accessed by the tx interrupt;
+	critical_section_enter();
+
 	//Initialise the net21 if encoding;
-	bool encoding_authorised = netf21_init_encoding(&iface->iface);//TODO ERROR HERE
+	bool encoding_authorised = netf21_init_encoding(&iface->iface);
 
-	//If the decoding is not authorised :
+	//If the encoding is not authorised :
 	if (!encoding_authorised) {
 
 		//Disable the tx interrupt : clear the TIE bit in C2;
 		*(iface->C2) &= ~UART_C2_TIE;
 
-
 	} else {
 
 		//Enable the tx interrupt : set the TIE bit in C2;
@@ -718,6 +937,494 @@ static void enable_tx_interrupt(struct K64_UART_net21 *const iface) {
 
 	}
 
+	//Leave the critical section;
+	critical_section_leave();
+
+}
+
+
+//-------------------------------------------------- Adaptive watermark ------------------------------------------------
+
+/*
+ * In adaptive mode, the rx watermark doubles at each rx interrupt, up to the FIFO size minus a headroom, so that
+ * 	sustained traffic is read by bursts. Bytes that stay under the watermark at the end of a frame are read at the
+ * 	idle line interrupt, that also halves the watermark, as a high one only pays off under sustained traffic;
+ */
+
+
+/*
+ * clear_idle_flag : clears the idle line flag if the rx FIFO is empty. Otherwise, the flag will be cleared when bytes
+ * 	are read;
+ */
+
+static void clear_idle_flag(struct K64_UART_registers *const registers) {
+
+	//If the flag is still set (read S1) and the FIFO is empty :
+	if ((registers->S1 & UART_S1_IDLE) && (!registers->RCFIFO)) {
+
+		//Read D, after S1, to clear the flag. The line is idle, no byte is being received;
+		registers->D;
+
+		//Reading an empty FIFO misaligns its pointers : flush it, and clear the underflow flag;
+		registers->CFIFO |= UART_CFIFO_RXFLUSH;
+		registers->SFIFO = UART_SFIFO_RXUF;
+
+	}
+
+}
+
+
+/*
+ * raise_rx_watermark : doubles the rx watermark, up to its maximum;
+ */
+
+static void raise_rx_watermark(const struct K64_UART_net21 *const iface, struct K64_UART_registers *const registers) {
+
+	//Double the watermark;
+	uint8_t watermark = (uint8_t) (registers->RWFIFO << 1);
+
+	//Saturate;
+	if (watermark > iface->rx_watermark_max) {
+		watermark = iface->rx_watermark_max;
+	}
+
+	//Update the watermark;
+	registers->RWFIFO = watermark;
+
+}
+
+
+/*
+ * rx_idle : reads bytes that stay under the watermark, lowers the watermark, and clears the idle line flag;
+ */
+
+static void rx_idle(const struct K64_UART_driver_t *const driver_data) {
+
+	//Cache the registers;
+	struct K64_UART_registers *const registers = driver_data->hw_specs.registers;
+
+	//Read remaining bytes. Clears the flag if any;
+	K64_UART_rx_read(driver_data);
+
+	//Halve the watermark, at least 1;
+	registers->RWFIFO = (uint8_t) ((registers->RWFIFO > 1) ? (registers->RWFIFO >> 1) : 1);
+
+	//Clear the flag if no byte was read;
+	clear_idle_flag(registers);
+
+}
+
+
+//------------------------------------------------------ DMA mode ------------------------------------------------------
+
+/*
+ * In DMA mode, UART requests are routed to two eDMA channels :
+ * 	- the rx channel copies each received byte in a circular buffer, and interrupts at each half of it. The idle line
+ * 		interrupt catches the end of frames that do not fill a half;
+ * 	- the tx channel copies a staging buffer to D, and interrupts when it is transmitted. Frames are encoded in the
+ * 		staging buffer in bulk, as framers transform data, that can't be transmitted directly from data blocks;
+ *
+ * 	The core is then interrupted per buffer half or per staging buffer, instead of per FIFO watermark;
+ */
+
+
+/*
+ * dma_allocate_frame : allocates a RAM frame in the DMA region, to contain both DMA buffers;
+ */
+
+static uint8_t *dma_allocate_frame() {
+
+	//If both buffers can't fit in a frame :
+	if (K64_UART_DMA_RX_SIZE + K64_UART_DMA_TX_SIZE > ram_frame_size()) {
+
+		//Error, buffers are too big;
+		kernel_error("K64_UART.c : dma_allocate_frame : DMA buffers do not fit in a RAM frame;");
+
+	}
+
+	//Allocate a frame, preferably in the region that does not contend with instruction fetch;
+	return ram_alloc_frame_attr(RAM_DMA);
+
+}
+
+
+/*
+ * dma_setup_interrupt : configures and enables the interrupt of an eDMA channel;
+ */
+
+static void dma_setup_interrupt(const uint8_t channel, void (*const link)()) {
+
+	//Disable the interrupt;
+	core_IC_disable(channel);
+
+	//Use the status priority, DMA interrupts replace status ones;
+	core_IC_set_priority(channel, DRIVER_STARUS_INTERRUPT_PRIORITY);
+
+	//Eventually de-activate a pending interrupt;
+	core_IC_clear_pending(channel);
+
+	//Set the provided interrupt link as the interrupt function;
+	core_IC_set_handler(channel, link);
+
+	//Enable the interrupt;
+	core_IC_enable(channel);
+
+}
+
+
+/*
+ * dma_start : configures both eDMA channels, and lets the UART emit DMA requests instead of interrupts;
+ */
+
+static void dma_start(const struct K64_UART_driver_t *const driver_data) {
+
+	//Cache the hardware specs, the registers and the if;
+	const struct K64_UART_hw *const hw_specs = &driver_data->hw_specs;
+	struct K64_UART_registers *const registers = hw_specs->registers;
+	struct K64_UART_net21 *const iface = driver_data->iface;
+
+	//Turn on the eDMA and the DMAMUX;
+	K64_eDMA_enable_clocks();
+
+
+	//Cache the rx TCD;
+	struct K64_eDMA_TCD *tcd = iface->rx_tcd;
+
+	//Each request moves a byte from D to the circular buffer;
+	tcd->SADDR = (uint32_t) &registers->D;
+	tcd->SOFF = 0;
+	tcd->ATTR = 0;
+	tcd->NBYTES = 1;
+	tcd->SLAST = 0;
+	tcd->DADDR = (uint32_t) iface->dma_rx_buffer;
+	tcd->DOFF = 1;
+
+	//The major loop covers the buffer, and the destination goes back to its start at the end of it;
+	tcd->CITER = tcd->BITER = K64_UART_DMA_RX_SIZE;
+	tcd->DLASTSGA = -K64_UART_DMA_RX_SIZE;
+
+	//Interrupt at each half of the buffer;
+	tcd->CSR = EDMA_TCD_CSR_INTHALF | EDMA_TCD_CSR_INTMAJOR;
+
+
+	//Cache the tx TCD;
+	tcd = iface->tx_tcd;
+
+	//Each request moves a byte from the staging buffer to D. Sizes are set at each transfer;
+	tcd->SADDR = (uint32_t) iface->dma_tx_buffer;
+	tcd->SOFF = 1;
+	tcd->ATTR = 0;
+	tcd->NBYTES = 1;
+	tcd->SLAST = 0;
+	tcd->DADDR = (uint32_t) &registers->D;
+	tcd->DOFF = 0;
+	tcd->CITER = tcd->BITER = 1;
+	tcd->DLASTSGA = 0;
+
+	//Interrupt at the end of the transfer, and ignore requests until the next one;
+	tcd->CSR = EDMA_TCD_CSR_INTMAJOR | EDMA_TCD_CSR_DREQ;
+
+
+	//Route UART requests to both channels;
+	K64_eDMA_route(iface->rx_channel, hw_specs->dma_rx_source);
+	K64_eDMA_route(iface->tx_channel, hw_specs->dma_tx_source);
+
+	//Setup both channels interrupts;
+	dma_setup_interrupt(iface->rx_channel, hw_specs->dma_rx_link);
+	dma_setup_interrupt(iface->tx_channel, hw_specs->dma_tx_link);
+
+
+	//Request a byte as long as the tx FIFO has space;
+	registers->TWFIFO = (uint8_t) (iface->tx_fifo_size - 1);
+
+	//RDRF and TDRE generate DMA requests instead of interrupts;
+	SET(registers->C5, UART_C5_RDMAS | UART_C5_TDMAS, 8);
+
+	//Clearing the idle flag may read an empty FIFO. The resulting underflow is handled, not an error;
+	CLEAR(registers->CFIFO, UART_CFIFO_RXUFE, 8);
+
+	//Enable rx and tx requests, and the idle line interrupt. Channels requests are enabled by the net21 if;
+	SET(registers->C2, UART_C2_RIE | UART_C2_TIE | UART_C2_ILIE, 8);
+
+}
+
+
+/*
+ * dma_stop : stops both eDMA channels, and releases DMA buffers;
+ */
+
+static void dma_stop(const struct K64_UART_driver_t *const driver_data) {
+
+	//Cache the hardware specs and the if;
+	const struct K64_UART_hw *const hw_specs = &driver_data->hw_specs;
+	struct K64_UART_net21 *const iface = driver_data->iface;
+
+	//Stop UART requests;
+	CLEAR(hw_specs->registers->C2, UART_C2_RIE | UART_C2_TIE | UART_C2_ILIE, 8);
+
+	//Ignore requests, and disconnect both channels;
+	K64_eDMA_disable_requests(iface->rx_channel);
+	K64_eDMA_disable_requests(iface->tx_channel);
+	K64_eDMA_unroute(iface->rx_channel);
+	K64_eDMA_unroute(iface->tx_channel);
+
+	//Disable both channels interrupts;
+	core_IC_disable(iface->rx_channel);
+	core_IC_disable(iface->tx_channel);
+
+	//Release DMA buffers;
+	ram_free_frame(iface->dma_frame);
+
+}
+
+
+/*
+ * The eDMA destination address only gives the write index modulo the buffer size. The number of bytes written is
+ * 	rebuilt from a lower bound : the previous count, or in the rx DMA interrupt, the half boundary that raised it.
+ * 	When the writer passed unread bytes, the overrun is detected, as long as the interrupt is serviced less than a
+ * 	buffer after its boundary; K64_UART_DMA_RX_SIZE must cover the worst interrupt latency;
+ */
+
+
+/*
+ * dma_rx_update : updates and returns the number of bytes written by the eDMA, knowing that it is at least @min;
+ */
+
+static size_t dma_rx_update(struct K64_UART_net21 *const iface, size_t min) {
+
+	//Determine the write index from the eDMA destination address;
+	const size_t position = (size_t) ((uint8_t *) iface->rx_tcd->DADDR - iface->dma_rx_buffer);
+
+	//The previous count is also a lower bound. Counts run freely, compare their difference;
+	if ((ptrdiff_t) (iface->dma_rx_written - min) > 0) {
+		min = iface->dma_rx_written;
+	}
+
+	//The count is the first one after the bound that matches the write index;
+	const size_t written = min + ((position - min) & (K64_UART_DMA_RX_SIZE - 1));
+
+	//Save and return the count;
+	iface->dma_rx_written = written;
+	return written;
+
+}
+
+
+/*
+ * dma_rx_drain : decodes bytes written by the eDMA in the rx circular buffer since the last call;
+ *
+ * 	If no more data can be received, rx DMA requests are disabled : remaining bytes stay in the buffer and in the
+ * 	FIFO, so that RTS is deasserted if enabled, until reception is resumed;
+ *
+ * 	If the eDMA wrote more than a buffer since the last call, unread bytes were overwritten : they are dropped, and
+ * 	the overrun is counted;
+ */
+
+static void dma_rx_drain(struct K64_UART_net21 *const iface) {
+
+	//Cache the buffer, the read count, and the write count;
+	const uint8_t *const buffer = iface->dma_rx_buffer;
+	size_t read = iface->dma_rx_read;
+	const size_t written = dma_rx_update(iface, iface->dma_rx_written);
+
+	//If the writer lapped the reader :
+	if (written - read > K64_UART_DMA_RX_SIZE) {
+
+		//Count the overrun and lost bytes;
+		struct netf2_stats *const stats = &iface->iface.iface.stats;
+		stats->hw_overruns++;
+		stats->rx_lost_bytes += written - read;
+
+		//Drop unread bytes, their order is lost;
+		read = written;
+
+	}
+
+	//While bytes remain to be decoded :
+	while (read != written) {
+
+		//Decode up to the write count, or up to the end of the buffer;
+		const size_t index = read & (K64_UART_DMA_RX_SIZE - 1);
+		size_t count = written - read;
+		if (count > K64_UART_DMA_RX_SIZE - index) {
+			count = K64_UART_DMA_RX_SIZE - index;
+		}
+
+		//Decode bytes and get a stop request. Bytes that could not be decoded stay in the buffer;
+		bool space_available = netf_21_decode_block((struct netf21 *) iface, buffer + index, &count);
+
+		//Update the read count;
+		read += count;
+
+		//If no more data can be received :
+		if (!space_available) {
+
+			//Pause reception : ignore rx requests;
+			K64_eDMA_disable_requests(iface->rx_channel);
+			iface->dma_rx_paused = true;
+
+			//The idle flag can't be cleared while bytes stay in the FIFO : disable the idle line interrupt;
+			*(iface->C2) &= ~UART_C2_ILIE;
+
+			//Stop decoding;
+			break;
+
+		}
+
+	}
+
+	//Save the read count;
+	iface->dma_rx_read = read;
+
+}
+
+
+/*
+ * dma_rx_idle : clears the idle line flag, and decodes bytes that wait in the rx buffer;
+ */
+
+static void dma_rx_idle(const struct K64_UART_driver_t *const driver_data) {
+
+	//Cache the registers;
+	struct K64_UART_registers *const registers = driver_data->hw_specs.registers;
+
+	//Clear the flag if the eDMA emptied the FIFO. Otherwise, it will be cleared at the next interrupt;
+	clear_idle_flag(registers);
+
+	//If reception is not paused, decode received bytes;
+	if ((driver_data->iface) && (!driver_data->iface->dma_rx_paused)) {
+		dma_rx_drain(driver_data->iface);
+	}
+
+}
+
+
+//Resume rx DMA transfers;
+static void enable_rx_dma(struct K64_UART_net21 *const iface) {
+
+	//Enter a critical section, the rx buffer is drained in interrupts;
+	critical_section_enter();
+
+	//If reception is paused, and data can be received again :
+	if ((iface->dma_rx_paused) && (netf21_init_decoding(&iface->iface))) {
+
+		//Resume reception;
+		iface->dma_rx_paused = false;
+
+		//Decode bytes received before the pause;
+		dma_rx_drain(iface);
+
+		//If reception was not paused again, accept rx requests, and re-enable the idle line interrupt;
+		if (!iface->dma_rx_paused) {
+			K64_eDMA_enable_requests(iface->rx_channel);
+			*(iface->C2) |= UART_C2_ILIE;
+		}
+
+	}
+
+	//Leave the critical section;
+	critical_section_leave();
+
+}
+
+
+/*
+ * dma_tx_fill : encodes frames in the tx staging buffer, and starts its transfer;
+ */
+
+static void dma_tx_fill(struct K64_UART_net21 *const iface) {
+
+	//Fill the staging buffer;
+	size_t size = K64_UART_DMA_TX_SIZE;
+	netf_21_get_encoded_block((struct netf21 *) iface, iface->dma_tx_buffer, &size);
+
+	//If no byte was encoded, complete;
+	if (!size) {
+		return;
+	}
+
+	//Cache the tx TCD;
+	struct K64_eDMA_TCD *const tcd = iface->tx_tcd;
+
+	//Clear the previous transfer's completion before updating the TCD;
+	K64_EDMA->CDNE = iface->tx_channel;
+
+	//Transmit the staging buffer;
+	tcd->SADDR = (uint32_t) iface->dma_tx_buffer;
+	tcd->CITER = tcd->BITER = (uint16_t) size;
+
+	//Mark the transfer in progress, and accept tx requests until its end;
+	iface->dma_tx_active = true;
+	K64_eDMA_enable_requests(iface->tx_channel);
+
+}
+
+
+//Start a tx DMA transfer if none is in progress;
+static void enable_tx_dma(struct K64_UART_net21 *const iface) {
+
+	//Enter a critical section, transfers are started in interrupts;
+	critical_section_enter();
+
+	//If no transfer is in progress, and a frame is available, start a transfer;
+	if ((!iface->dma_tx_active) && (netf21_init_encoding(&iface->iface))) {
+		dma_tx_fill(iface);
+	}
+
+	//Leave the critical section;
+	critical_section_leave();
+
+}
+
+
+/*
+ * K64_UART_dma_rx_interrupt : decodes received bytes at each half of the rx circular buffer;
+ */
+
+void K64_UART_dma_rx_interrupt(const struct K64_UART_driver_t *const driver_data) {
+
+	//Cache the if;
+	struct K64_UART_net21 *const iface = driver_data->iface;
+
+	//The interrupt is raised at each half of the buffer : the eDMA wrote at least up to the next half boundary;
+	const size_t written = dma_rx_update(iface, iface->dma_rx_boundary + K64_UART_DMA_RX_HALF);
+
+	//Save the last boundary crossed. Interrupts of boundaries crossed before the acknowledgement are merged;
+	iface->dma_rx_boundary = written & ~(size_t) (K64_UART_DMA_RX_HALF - 1);
+
+	//Acknowledge and count the interrupt. The write index was read before, so that no boundary is counted twice;
+	K64_eDMA_clear_interrupt(iface->rx_channel);
+	iface->iface.iface.stats.hw_rx_interrupts++;
+
+	//If reception is not paused, decode received bytes;
+	if (!iface->dma_rx_paused) {
+		dma_rx_drain(iface);
+	}
+
+}
+
+
+/*
+ * K64_UART_dma_tx_interrupt : starts the next transfer when the tx staging buffer is transmitted;
+ */
+
+void K64_UART_dma_tx_interrupt(const struct K64_UART_driver_t *const driver_data) {
+
+	//Cache the if;
+	struct K64_UART_net21 *const iface = driver_data->iface;
+
+	//Acknowledge and count the interrupt;
+	K64_eDMA_clear_interrupt(iface->tx_channel);
+	iface->iface.iface.stats.hw_tx_interrupts++;
+
+	//The staging buffer is transmitted;
+	iface->dma_tx_active = false;
+
+	//If a frame is available, start the next transfer;
+	if (netf21_init_encoding(&iface->iface)) {
+		dma_tx_fill(iface);
+	}
+
 }
 
 
@@ -735,13 +1442,22 @@ void K64_UART_status_interrupt(const struct K64_UART_driver_t *driver_data) {
 	//Cache C2, S1, and C5;
 	uint8_t C2 = registers->C2, S1 = registers->S1, C5 = registers->C5;
 
-	//TODO IDLE LINE;
+	//Cache the if, and its statistics;
+	struct K64_UART_net21 *const iface = driver_data->iface;
+	struct netf2_stats *const stats = &iface->iface.iface.stats;
 
 	//TODO TRANSMISSION COMPLETE;
 
 	//If the rx interrupt is enabled, if its flag is asserted, and interrupt request should be made :
 	if ((C2 & UART_C2_RIE) && (S1 & UART_S1_RDRF) &&  (!(C5 &UART_C5_RDMAS))) {
 
+		//Count the interrupt;
+		stats->hw_rx_interrupts++;
+
+		//In adaptive mode, the watermark was reached, raise it;
+		if (iface->adaptive_watermark) {
+			raise_rx_watermark(iface, registers);
+		}
 
 		//Read from rx;
 		K64_UART_rx_read(driver_data);
@@ -751,13 +1467,30 @@ void K64_UART_status_interrupt(const struct K64_UART_driver_t *driver_data) {
 	//If the tx interrupt is enabled, if its flag is asserted, and interrupt request should be made :
 	if ((C2 & UART_C2_TIE) && (S1 & UART_S1_TDRE) && (!(C5 &UART_C5_TDMAS))) {
 
-		//teensy35_led_count(4);
+		//Count the interrupt;
+		stats->hw_tx_interrupts++;
 
 		//Read from tx;
 		K64_UART_tx_write(driver_data);
 
 	}
 
+	//If the idle line interrupt is enabled and the line is idle, the end of a frame may wait in the FIFO or the rx
+	//	DMA buffer :
+	if ((C2 & UART_C2_ILIE) && (S1 & UART_S1_IDLE)) {
+
+		//Count the interrupt;
+		stats->hw_idle_interrupts++;
+
+		//Process the idle line, depending on the mode;
+		if (C5 & UART_C5_RDMAS) {
+			dma_rx_idle(driver_data);
+		} else {
+			rx_idle(driver_data);
+		}
+
+	}
+
 	//teensy35_led_count(6);
 
 }
@@ -786,12 +1519,28 @@ void K64_UART_error_interrupt(const struct K64_UART_driver_t *driver_data) {
 	//Cache the register pointer;
 	struct K64_UART_registers *const registers = peripheral_data->registers;
 
+	//Cache S1 and SFIFO, that contain error flags;
+	uint8_t S1 = registers->S1, SFIFO = registers->SFIFO;
+
+	//If the interface is created, count errors;
+	if (driver_data->iface) {
+
+		//Cache the interface statistics;
+		struct netf2_stats *const stats = &driver_data->iface->iface.iface.stats;
+
+		//Count each error;
+		if (S1 & UART_S1_FE) stats->hw_framing_errors++;
+		if (S1 & UART_S1_NF) stats->hw_noise_errors++;
+		if (S1 & UART_S1_PF) stats->hw_parity_errors++;
+		if ((S1 & UART_S1_OR) || (SFIFO & UART_SFIFO_RXOF)) stats->hw_overruns++;
+
+	}
+
 	//Unlock reception by checking the framing error flag. At the same time, check noise or parity;
-	if (registers->C2 & (UART_S1_FE | UART_S1_NF | UART_S1_PF)) {
+	if (S1 & (UART_S1_FE | UART_S1_NF | UART_S1_PF)) {
 
 		//In case of framing - parity - noise error, we read and discard;
 
-		//TODO VOLATILE CHECK
 		//Read D, to discard and clear flags;
 		registers->D;
 
@@ -801,12 +1550,9 @@ void K64_UART_error_interrupt(const struct K64_UART_driver_t *driver_data) {
 	uint8_t C2 = registers->C2;
 
 	//If there was a receiver overrun or overflow :
-	if (registers->SFIFO & (UART_SFIFO_RXOF | UART_SFIFO_RXUF)) {
-
-		//Read D to clear the flag;
+	if ((S1 & UART_S1_OR) || (SFIFO & (UART_SFIFO_RXOF | UART_SFIFO_RXUF))) {
 
-		//TODO VOLATILE CHECK
-		//Read S1 and Dto discard and clear flags;
+		//Read S1 and D to discard and clear flags;
 		registers->S1;
 		registers->D;
 
@@ -820,7 +1566,7 @@ void K64_UART_error_interrupt(const struct K64_UART_driver_t *driver_data) {
 	}
 
 	//If there was a transmitter overflow :
-	if (registers->SFIFO | UART_SFIFO_TXOF) {
+	if (SFIFO & UART_SFIFO_TXOF) {
 
 		//Turn off tx;
 		CLEAR(registers->C2, UART_C2_TE, 8);
@@ -860,20 +1606,28 @@ void K64_UART_tx_write(const struct K64_UART_driver_t *const driver) {
 	//As checking the packet mode takes more processing time than just send the 9-th bit, we won't check it.
 	struct K64_UART_registers *const registers = hw_specs->registers;
 
+	//The number of spaces in the tx buffer;
+	size_t spaces;
+
 	//While there are spaces in the tx buffer;
-	while (registers->TCFIFO != tx_fifo_size) {
+	while ((spaces = (size_t) (tx_fifo_size - registers->TCFIFO))) {
+
+		//Cache a burst of bytes to write;
+		uint8_t burst[K64_UART_BURST_SIZE];
 
-		//Cache a space for the byte to write;
-		uint8_t data;
+		//Determine the number of bytes to get;
+		size_t size = (spaces < K64_UART_BURST_SIZE) ? spaces : K64_UART_BURST_SIZE;
 
-		//Initialise the byte to write and get a stop request;
-		bool data_available = netf_21_get_encoded_byte((struct netf21 *) iface, &data);
+		//Get encoded bytes and a stop request;
+		bool data_available = netf_21_get_encoded_block((struct netf21 *) iface, burst, &size);
 
 		//Read S1;
 		registers->S1;
 
-		//Now, copy the byte in D;
-		registers->D = data;
+		//Now, copy all bytes in D;
+		for (size_t i = 0; i < size; i++) {
+			registers->D = burst[i];
+		}
 
 		//If no more data is available :
 		if (!data_available) {
@@ -904,25 +1658,38 @@ void K64_UART_rx_read(const struct K64_UART_driver_t *const driver) {
 	//As checking the packet mode takes more processing time than just send the 9-th bit, we won't check it.
 	struct K64_UART_registers *const registers = hw_specs->registers;
 
+	//The number of bytes in the rx buffer;
+	size_t count;
+
 	//While there are bytes in the rx buffer;
-	while (registers->RCFIFO) {
+	while ((count = registers->RCFIFO)) {
+
+		//Cache a burst of received bytes;
+		uint8_t burst[K64_UART_BURST_SIZE];
+
+		//Limit to the burst size;
+		if (count > K64_UART_BURST_SIZE) {
+			count = K64_UART_BURST_SIZE;
+		}
 
 		//Read S1;
 		registers->S1;
 
-		//Get a received byte;
-		uint8_t data = registers->D;
-
-		//Initialise the byte to write and get a stop request;
-		bool space_available = netf_21_decode_byte((struct netf21 *) iface, data);
+		//Get all received bytes;
+		for (size_t i = 0; i < count; i++) {
+			burst[i] = registers->D;
+		}
 
+		//Decode bytes and get a stop request. Bytes that could not be decoded are out of the FIFO, and lost;
+		size_t decoded = count;
+		bool space_available = netf_21_decode_block((struct netf21 *) iface, burst, &decoded);
+		iface->iface.iface.stats.rx_lost_bytes += count - decoded;
 
 		//If no more data is available :
 		if (!space_available) {
 
-
-			//Disable the rx interrupt : clear the TIE bit in C2;
-			registers->C2 &= ~UART_C2_RIE;
+			//Disable rx interrupts : clear the RIE bit in C2, and ILIE in adaptive mode;
+			registers->C2 &= ~iface->rx_interrupts;
 
 			//Complete;
 			return;
@@ -933,4 +1700,161 @@ void K64_UART_rx_read(const struct K64_UART_driver_t *const driver) {
 
 	//All data has been read, the interrupt can remain set;
 
-}
\ No newline at end of file
+}
+
+
+
+//------------------------------------------------------- Module -------------------------------------------------------
+
+/*
+ * Each UART is a channel of the module, compiled from kx_uart_n.c with its own registers, clock gate, interrupt
+ * 	channels and DMA settings. The module creates their drivers, and registers a file for each one :
+ * 	- init starts the UART with the provided UART_config_t, restarting it if it was already started;
+ * 	- interface provides the UART's network interface (struct netf2 *);
+ * 	- reset stops the UART;
+ */
+
+MODULE_CREATE_SPECS_ARRAY(channels)
+
+
+/*
+ * The channel inode will only contain the channel index;
+ */
+
+struct channel_inode {
+
+	//The inode base;
+	struct iinode node;
+
+	//The channel index;
+	uint8_t channel_index;
+
+};
+
+//Inodes will be stored in an array;
+static struct channel_inode inodes[NB_CHANNELS];
+
+
+//Start the UART with the provided configuration;
+static bool channel_fs_init(const struct channel_inode *const node, const struct UART_config_t *const config,
+							const size_t config_size) {
+
+	//Cache the channel's driver;
+	struct K64_UART_driver_t *const driver = *(channels[node->channel_index]->driver);
+
+	//If the config size is invalid, fail;
+	if (config_size != sizeof(struct UART_config_t)) {
+		return false;
+	}
+
+	//If the UART is started, stop it;
+	if (driver->iface) {
+		K64_UART_stop(driver);
+	}
+
+	//Start the UART. Fails if the configuration can't be applied;
+	return K64_UART_start(driver, config);
+
+}
+
+
+//Provide the UART's network interface;
+static bool channel_fs_interface(const struct channel_inode *const node, struct netf2 **const iface,
+								 const size_t iface_size) {
+
+	//Cache the channel's driver;
+	const struct K64_UART_driver_t *const driver = *(channels[node->channel_index]->driver);
+
+	//If the size is invalid, or if the UART is not started, fail;
+	if ((iface_size != sizeof(struct netf2 *)) || (!driver->iface)) {
+		return false;
+	}
+
+	//Provide the interface;
+	*iface = (struct netf2 *) driver->iface;
+
+	//Complete;
+	return true;
+
+}
+
+
+//Stop the UART;
+static void channel_fs_reset(const struct channel_inode *const node) {
+
+	//Cache the channel's driver;
+	struct K64_UART_driver_t *const driver = *(channels[node->channel_index]->driver);
+
+	//If the UART is started, stop it;
+	if (driver->iface) {
+		K64_UART_stop(driver);
+	}
+
+}
+
+
+/*
+ * The file operations for a UART channel;
+ */
+
+static struct inode_ops channel_ops = {
+	.init = (bool (*)(struct iinode *, const void *, size_t)) &channel_fs_init,
+	.interface = (bool (*)(struct iinode *, void *, size_t)) &channel_fs_interface,
+	.reset = (void (*)(struct iinode *)) &channel_fs_reset,
+};
+
+
+/**
+ * channel_register : creates the channel's driver, and registers its file; Called by the module's init function;
+ */
+
+static void channel_register(uint8_t channel_index) {
+
+	//Cache the channel data ref;
+	const struct channel_specs *channel = channels[channel_index];
+
+	//Create the driver, that initialises the peripheral. Interrupt links will use it;
+	*(channel->driver) = K64_UART_create(channel->hw_specs);
+
+	//Cache the inode;
+	struct channel_inode *node = inodes + channel_index;
+
+	//Create the inode initializer;
+	struct channel_inode init = {
+
+		//Transmit operations;
+		.node = INODE (&channel_ops),
+
+		//Initialise the channel index;
+		.channel_index = channel_index,
+
+	};
+
+	//Initialise the inode;
+	memcpy(node, &init, sizeof(struct channel_inode));
+
+	//Register a file with no content leading to our operations;
+	fs_create(channel->name, (struct iinode *) node);
+
+}
+
+
+static bool uart_init() {
+
+	//Write the call to the registration function;
+	#define UART_REGISTER(i) channel_register(i);
+
+	//Write each channel's registration call;
+	INCR_CALL(NB_CHANNELS, UART_REGISTER);
+
+	//Macro not used anymore;
+	#undef UART_REGISTER
+
+	//Complete;
+	return true;
+
+}
+
+
+//Embed the UART module in the executable;
+KERNEL_HOOK_MODULE(PERIPHERAL_MODULE, uart, &uart_init)
@@ -32,6 +32,8 @@
 #include <memory/interrupt_pipe.h>
 #include <net/netf.h>
 
+#include "kx_edma.h"
+
 //----------------------------------------------------- Memory Map -----------------------------------------------------
 
 /*
@@ -111,6 +113,10 @@ struct K64_UART_hw {
 	//The clock frequency;
 	const uint32_t clock_frequency;
 
+	//The clock gating register, and the mask of the UART's bit;
+	volatile uint32_t *const clock_gating_reg;
+	const uint32_t clock_gating_mask;
+
 	//The status interrupt channel;
 	const uint8_t status_int_channel;
 
@@ -120,7 +126,19 @@ struct K64_UART_hw {
 	//Interrupt link function;
 	void (*const status_link)();
 	void (*const error_link)();
-	
+
+	//The eDMA channels used in DMA mode;
+	const uint8_t dma_rx_channel;
+	const uint8_t dma_tx_channel;
+
+	//The DMAMUX request sources of the UART. Null if the UART has no dedicated rx and tx sources;
+	const uint8_t dma_rx_source;
+	const uint8_t dma_tx_source;
+
+	//DMA interrupt link functions. The interrupt channel of an eDMA channel is its index;
+	void (*const dma_rx_link)();
+	void (*const dma_tx_link)();
+
 };
 
 
@@ -139,6 +157,46 @@ struct K64_UART_net21 {
 	//The size of the tx hardware fifo;
 	const uint8_t tx_fifo_size;
 
+	//Set if the rx watermark adapts to traffic;
+	const bool adaptive_watermark;
+
+	//The maximal rx watermark in adaptive mode;
+	const uint8_t rx_watermark_max;
+
+	//The C2 bits that enable rx interrupts. Includes the idle line interrupt in adaptive mode;
+	const uint8_t rx_interrupts;
+
+	//Set if data is transferred by the eDMA;
+	const bool dma;
+
+	//The RAM frame that contains DMA buffers. Null if not in DMA mode;
+	uint8_t *const dma_frame;
+
+	//The rx circular buffer, written by the eDMA;
+	uint8_t *const dma_rx_buffer;
+
+	//The numbers of bytes decoded and written since the start. They run freely, and are masked to index the buffer;
+	size_t dma_rx_read;
+	size_t dma_rx_written;
+
+	//The last half boundary of the buffer the eDMA crossed, counted like dma_rx_written;
+	size_t dma_rx_boundary;
+
+	//Set if rx DMA requests are disabled, because no block can receive data;
+	volatile bool dma_rx_paused;
+
+	//The tx staging buffer, where frames are encoded, and read by the eDMA;
+	uint8_t *const dma_tx_buffer;
+
+	//Set if the tx staging buffer is being transmitted;
+	volatile bool dma_tx_active;
+
+	//DMA channels TCDs and indices;
+	struct K64_eDMA_TCD *const rx_tcd;
+	struct K64_eDMA_TCD *const tx_tcd;
+	const uint8_t rx_channel;
+	const uint8_t tx_channel;
+
 };
 
 
@@ -209,7 +267,7 @@ types K64_UART_stream_t {
 //------------------------------------------------- Creation - Deletion ------------------------------------------------
 
 //Create an instance of a K64 UART if from hardware specs;
-struct K64_UART_driver_t *K64_UART_create(struct K64_UART_hw *);
+struct K64_UART_driver_t *K64_UART_create(const struct K64_UART_hw *);
 
 //Delete an instance of a K64 UART if;
 void K64_UART_delete(struct K64_UART_driver_t *);
@@ -217,11 +275,11 @@ void K64_UART_delete(struct K64_UART_driver_t *);
 
 //---------------------------------------------------- Start - Stop ----------------------------------------------------
 
-//Initialise the UART; The internal network if is created;
-void K64_UART_start(struct K64_UART_driver_t *driver_data, const struct UART_config_t *config);
+//Initialise the UART; The internal network if is created; False if the configuration can't be applied;
+bool K64_UART_start(struct K64_UART_driver_t *driver_data, const struct UART_config_t *config);
 
-//De-initialise the UART; The internal network if is to_delete;
-void K64_UART_stop(const struct K64_UART_driver_t *driver_data);
+//De-initialise the UART; The internal network if is deleted;
+void K64_UART_stop(struct K64_UART_driver_t *driver_data);
 
 
 //----------------------------------------------------- Interrupts -----------------------------------------------------
@@ -236,5 +294,11 @@ void K64_UART_status_interrupt(const struct K64_UART_driver_t *driver_data);
 //The error function;
 void K64_UART_error_interrupt(const struct K64_UART_driver_t *instance);
 
+//The rx DMA function, called at the half and the end of the rx circular buffer;
+void K64_UART_dma_rx_interrupt(const struct K64_UART_driver_t *driver_data);
+
+//The tx DMA function, called when the tx staging buffer is transmitted;
+void K64_UART_dma_tx_interrupt(const struct K64_UART_driver_t *driver_data);
+
 
 #endif //TRACER_TEENSY35_UART_H
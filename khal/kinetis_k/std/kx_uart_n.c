@@ -0,0 +1,149 @@
+/*
+  kx_uart_n.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+//------------------------------------------------ Module channel header -----------------------------------------------
+
+#include <kernel/exec/module_channel.h>
+
+//--------------------------------------------------- Make parameters --------------------------------------------------
+
+/*
+ * kinetis_k.mk must provide, in addition to channel parameters :
+ * 	- CHANNEL_NAME : name of the channel;
+ * 	- REG : start of the channel's registers area;
+ * 	- CLOCK_FREQUENCY : frequency of the clock that drives the UART;
+ * 	- SCGC_REG, SCGC_BIT : clock gating register, and the UART's bit in it;
+ * 	- STATUS_INT_CHANNEL, ERROR_INT_CHANNEL : interrupt channels;
+ * 	- DMA_RX_CHANNEL, DMA_TX_CHANNEL : eDMA channels used in DMA mode;
+ * 	- DMA_RX_SOURCE, DMA_TX_SOURCE : DMAMUX request sources, 0 if the UART has no dedicated rx and tx sources;
+ */
+
+//If one of the macro was not provided :
+#if !defined(CHANNEL_NAME) || !defined(REG) || !defined(CLOCK_FREQUENCY) || !defined(SCGC_REG) || \
+	!defined(SCGC_BIT) || !defined(STATUS_INT_CHANNEL) || !defined(ERROR_INT_CHANNEL) || \
+	!defined(DMA_RX_CHANNEL) || !defined(DMA_TX_CHANNEL) || !defined(DMA_RX_SOURCE) || !defined(DMA_TX_SOURCE)
+
+//Log
+#error "Error, at least one macro argument hasn't been provided. Check the makefile;"
+
+//Define macros. Allows debugging on IDE environment;
+#define CHANNEL_NAME "name"
+#define REG 0
+#define CLOCK_FREQUENCY 0
+#define SCGC_REG 0
+#define SCGC_BIT 0
+#define STATUS_INT_CHANNEL 0
+#define ERROR_INT_CHANNEL 0
+#define DMA_RX_CHANNEL 0
+#define DMA_TX_CHANNEL 0
+#define DMA_RX_SOURCE 0
+#define DMA_TX_SOURCE 0
+
+#endif
+
+
+//------------------------------------------------------ headers -------------------------------------------------------
+
+#include <stdint.h>
+
+#include "kx_uart_n.h"
+
+
+//--------------------------------------------------- Interrupt links --------------------------------------------------
+
+//The channel's driver. Created by the UART module;
+static struct K64_UART_driver_t *driver;
+
+
+//Process status interrupts;
+static void status_link() {
+	K64_UART_status_interrupt(driver);
+}
+
+
+//Process error interrupts;
+static void error_link() {
+	K64_UART_error_interrupt(driver);
+}
+
+
+//Process rx DMA interrupts;
+static void dma_rx_link() {
+	K64_UART_dma_rx_interrupt(driver);
+}
+
+
+//Process tx DMA interrupts;
+static void dma_tx_link() {
+	K64_UART_dma_tx_interrupt(driver);
+}
+
+
+//------------------------------------------------------- Channel ------------------------------------------------------
+
+/*
+ * The hardware specs of the UART;
+ */
+
+static const struct K64_UART_hw hw_specs = {
+
+	//The register area;
+	.registers = (struct K64_UART_registers *) (REG),
+
+	//The clock, and its gate;
+	.clock_frequency = CLOCK_FREQUENCY,
+	.clock_gating_reg = (volatile uint32_t *) (SCGC_REG),
+	.clock_gating_mask = (uint32_t) 1 << (SCGC_BIT),
+
+	//Interrupt channels;
+	.status_int_channel = STATUS_INT_CHANNEL,
+	.error_int_channel = ERROR_INT_CHANNEL,
+
+	//Interrupt links;
+	.status_link = &status_link,
+	.error_link = &error_link,
+
+	//DMA settings;
+	.dma_rx_channel = DMA_RX_CHANNEL,
+	.dma_tx_channel = DMA_TX_CHANNEL,
+	.dma_rx_source = DMA_RX_SOURCE,
+	.dma_tx_source = DMA_TX_SOURCE,
+	.dma_rx_link = &dma_rx_link,
+	.dma_tx_link = &dma_tx_link,
+
+};
+
+
+static struct channel_specs channel = {
+
+	//Save the string name;
+	.name = STR(CHANNEL_NAME),
+
+	//Provide the hardware specs;
+	.hw_specs = &hw_specs,
+
+	//Provide the location of the driver;
+	.driver = &driver,
+
+};
+
+
+//Reference the channel;
+MODULE_REFERENCE_CHANNEL(channel)
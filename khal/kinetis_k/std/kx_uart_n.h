@@ -0,0 +1,39 @@
+/*
+  kx_uart_n.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_KX_UART_CHANNEL_DATA_H
+#define TRACER_KX_UART_CHANNEL_DATA_H
+
+#include "kx_uart.h"
+
+struct channel_specs {
+
+	//The channel's name;
+	const char *name;
+
+	//The channel's hardware specs;
+	const struct K64_UART_hw *const hw_specs;
+
+	//The location of the channel's driver, created by the module, and used by interrupt links;
+	struct K64_UART_driver_t **const driver;
+
+};
+
+#endif //TRACER_KX_UART_CHANNEL_DATA_H
@@ -0,0 +1,379 @@
+/*
+  arq_bench.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Simulation of the ARQ over a lossy, slow link. Two ARQs exchange payloads in both directions, each one over a
+ * 	loopback interface with a COBS + CRC-16 framer, whose encoded bytes go through host pipes;
+ *
+ * 	Between the pipes, the harness simulates the link : it delimits encoded frames, delays them by their
+ * 	transmission time at LINK_RATE and by the latency, and corrupts a byte of some of them, which the CRC of the
+ * 	receiver drops. Time is simulated, in milliseconds, and all payloads must be delivered intact and in order;
+ *
+ * 	For each loss rate and latency, reports the goodput of payloads in each direction, its share of the line rate,
+ * 	and retransmissions. A single configuration can be run with : arq_bench <loss percent> <latency ms>;
+ */
+
+#include "host.h"
+
+#include <unistd.h>
+
+#include <fcntl.h>
+
+#include <string.h>
+
+#include <kernel/res/net/arq.h>
+
+#include <kernel/res/net/loopback.h>
+
+#include <kernel/res/net/protocol.h>
+
+#include <kernel/res/net/framer/cobs_framer.h>
+
+#include <kernel/res/net/framer/crc_framer.h>
+
+
+/*The number of payloads sent in each direction;*/
+#if !defined(NB_PAYLOADS)
+
+#define NB_PAYLOADS 2000
+
+#endif
+
+/*The rate of the link, in bytes per millisecond. 115200 bauds carry 11.5 bytes per millisecond;*/
+#if !defined(LINK_RATE)
+
+#define LINK_RATE 12
+
+#endif
+
+/*The payload size, and the window;*/
+#define PAYLOAD_SIZE 64
+#define WINDOW 8
+
+/*Interface frames contain the ARQ header, the payload, and the CRC;*/
+#define FRAME_SIZE (ARQ_HEADER_SIZE + PAYLOAD_SIZE + 2)
+#define NB_IFACE_FRAMES 16
+
+/*The maximal size of an encoded frame, and the number of frames in flight on a link;*/
+#define MAX_ENCODED (2 * FRAME_SIZE)
+#define LINK_FRAMES 256
+
+/*The maximal simulated duration, in milliseconds;*/
+#define MAX_TIME 3600000
+
+
+/*No protocol is attached to simulation interfaces;*/
+bool protocol_dispatch(struct protocol_t *protocol, struct data_block *block) {
+	(void) protocol, (void) block;
+	return false;
+}
+
+
+/*The simulated time;*/
+static uint32_t sim_time;
+
+/*The ARQ reads the simulated time;*/
+uint32_t sysclock_milliseconds() {
+	return sim_time;
+}
+
+
+/*--------------------------------------------------------- Link -------------------------------------------------------*/
+
+/*An encoded frame in flight, without its delimiter;*/
+struct link_frame {
+
+	/*Encoded bytes;*/
+	uint8_t data[MAX_ENCODED];
+	size_t size;
+
+	/*The delivery time;*/
+	uint32_t time;
+
+};
+
+/*A direction of the link, between the pipe the sender writes to, and the pipe the receiver reads from;*/
+struct link {
+
+	/*The descriptor encoded bytes are read from, and the one they are delivered to;*/
+	int rx_fd, tx_fd;
+
+	/*The frame being delimited;*/
+	struct link_frame partial;
+
+	/*Frames in flight, in a ring;*/
+	struct link_frame frames[LINK_FRAMES];
+	size_t first, count;
+
+	/*The time the line is free at;*/
+	uint32_t free_time;
+
+	/*The percentage of corrupted frames, and the latency;*/
+	uint32_t loss, latency;
+
+	/*The number of frames carried and corrupted;*/
+	size_t nb_frames, nb_corrupted;
+
+};
+
+
+/*
+ * link_queue : queues the delimited frame, after the previous ones on the line, and corrupts it if it is lost;
+ */
+
+static void link_queue(struct link *const link) {
+
+	CHECK(link->count < LINK_FRAMES);
+	struct link_frame *const frame = link->frames + (link->first + link->count++) % LINK_FRAMES;
+	*frame = link->partial;
+
+	/*Transmit the frame and its delimiter when the line is free, it arrives after the latency;*/
+	const uint32_t start = (link->free_time > sim_time) ? link->free_time : sim_time;
+	link->free_time = start + (uint32_t) ((frame->size + 1 + LINK_RATE - 1) / LINK_RATE);
+	frame->time = link->free_time + link->latency;
+
+	/*Corrupt a byte of lost frames. The result is not null, so that the frame stays delimited;*/
+	if (host_random(100) < link->loss) {
+		uint8_t *const byte = frame->data + host_random((uint32_t) frame->size);
+		*byte = (uint8_t) (*byte ^ (1 + host_random(255)));
+		if (!*byte) {
+			*byte = 0xFF;
+		}
+		link->nb_corrupted++;
+	}
+
+	link->nb_frames++;
+	link->partial.size = 0;
+
+}
+
+
+/*
+ * link_step : delimits the frames the sender wrote, and delivers frames whose time is reached;
+ */
+
+static void link_step(struct link *const link) {
+
+	uint8_t burst[256];
+	ssize_t count;
+
+	/*Delimit encoded frames;*/
+	while ((count = read(link->rx_fd, burst, sizeof(burst))) > 0) {
+		for (ssize_t i = 0; i < count; i++) {
+			if (!burst[i]) {
+				if (link->partial.size) {
+					link_queue(link);
+				}
+			} else {
+				CHECK(link->partial.size < MAX_ENCODED);
+				link->partial.data[link->partial.size++] = burst[i];
+			}
+		}
+	}
+
+	/*Deliver arrived frames, with their delimiter;*/
+	while ((link->count) && (link->frames[link->first].time <= sim_time)) {
+		const struct link_frame *const frame = link->frames + link->first;
+		const uint8_t delimiter = 0;
+		CHECK(write(link->tx_fd, frame->data, frame->size) == (ssize_t) frame->size);
+		CHECK(write(link->tx_fd, &delimiter, 1) == 1);
+		link->first = (link->first + 1) % LINK_FRAMES;
+		link->count--;
+	}
+
+}
+
+
+/*-------------------------------------------------------- Ends --------------------------------------------------------*/
+
+/*An end of the simulation : an ARQ over a loopback interface, and its traffic;*/
+struct end {
+
+	/*The interface and the ARQ;*/
+	struct loopback_net21 *iface;
+	struct arq *arq;
+
+	/*The number of payloads sent and received;*/
+	size_t nb_sent, nb_received;
+
+	/*The time the last payload was received at;*/
+	uint32_t done_time;
+
+};
+
+
+/*
+ * fill_payload : writes the payload @sequence : the sequence number, then a pattern that depends on it;
+ */
+
+static void fill_payload(uint8_t *const payload, const size_t sequence) {
+
+	memcpy(payload, &sequence, sizeof(size_t));
+	for (size_t i = sizeof(size_t); i < PAYLOAD_SIZE; i++) {
+		payload[i] = (uint8_t) (sequence * 31 + i);
+	}
+
+}
+
+
+/*
+ * end_step : sends payloads while the window allows, polls the ARQ, and verifies received payloads;
+ */
+
+static void end_step(struct end *const end, struct data_block *const buffer) {
+
+	uint8_t payload[PAYLOAD_SIZE];
+
+	/*Send as many payloads as the window allows;*/
+	while (end->nb_sent < NB_PAYLOADS) {
+		fill_payload(payload, end->nb_sent);
+		if (!arq_send(end->arq, payload, PAYLOAD_SIZE)) {
+			break;
+		}
+		end->nb_sent++;
+	}
+
+	/*Process frames, and move encoded bytes;*/
+	arq_poll(end->arq);
+	loopback_pump(end->iface, 4096);
+
+	/*Verify received payloads. They arrive once, in order;*/
+	while (arq_read(end->arq, buffer)) {
+		fill_payload(payload, end->nb_received++);
+		CHECK(buffer->size == PAYLOAD_SIZE);
+		CHECK(!memcmp(buffer->address, payload, PAYLOAD_SIZE));
+		end->done_time = sim_time;
+	}
+
+}
+
+
+/*------------------------------------------------------ Simulation ----------------------------------------------------*/
+
+/*
+ * simulate : exchanges NB_PAYLOADS payloads in each direction, with @loss percent of frames corrupted, and
+ * 	@latency milliseconds of latency, and reports the goodput;
+ */
+
+static void simulate(const uint32_t loss, const uint32_t latency) {
+
+	static struct link links[2];
+	struct end ends[2];
+	struct data_block *const buffer = data_block_create(PAYLOAD_SIZE);
+
+	sim_time = 0;
+
+	/*Each end writes encoded bytes to its sending pipe, the link delivers them to the other end's receiving pipe;*/
+	int sending[2][2], receiving[2][2];
+
+	for (size_t i = 0; i < 2; i++) {
+
+		CHECK(!pipe(sending[i]) && !pipe(receiving[1 - i]));
+
+		/*The link reads from the sending pipe without waiting;*/
+		memset(links + i, 0, sizeof(struct link));
+		links[i].rx_fd = sending[i][0];
+		links[i].tx_fd = receiving[1 - i][1];
+		links[i].loss = loss;
+		links[i].latency = latency;
+		fcntl(links[i].rx_fd, F_SETFL, fcntl(links[i].rx_fd, F_GETFL) | O_NONBLOCK);
+
+	}
+
+	for (size_t i = 0; i < 2; i++) {
+
+		/*Create the end, and attach its pipes;*/
+		memset(ends + i, 0, sizeof(struct end));
+		ends[i].iface = loopback_create(crc_framer_create(cobs_framer_create(), CRC_16), NB_IFACE_FRAMES, FRAME_SIZE);
+		ends[i].arq = arq_create(&ends[i].iface->iface.iface, WINDOW, PAYLOAD_SIZE);
+		loopback_attach_fds(ends[i].iface, receiving[i][0], sending[i][1]);
+
+	}
+
+	/*Run until all payloads are delivered and acknowledged;*/
+	while ((ends[0].nb_received < NB_PAYLOADS) || (ends[1].nb_received < NB_PAYLOADS) ||
+		   (ends[0].arq->tx_base != ends[0].arq->tx_next) || (ends[1].arq->tx_base != ends[1].arq->tx_next)) {
+
+		CHECK(++sim_time < MAX_TIME);
+
+		for (size_t i = 0; i < 2; i++) {
+			end_step(ends + i, buffer);
+		}
+
+		for (size_t i = 0; i < 2; i++) {
+			link_step(links + i);
+		}
+
+	}
+
+	/*Report each direction;*/
+	for (size_t i = 0; i < 2; i++) {
+
+		const struct end *const sender = ends + i, *const receiver = ends + 1 - i;
+		const double goodput = (double) NB_PAYLOADS * PAYLOAD_SIZE / receiver->done_time;
+
+		struct netf2_stats stats;
+		netf21_get_stats(&receiver->iface->iface, &stats);
+
+		printf("loss %2u%% latency %3u ms %c->%c : %7.2f B/ms %5.1f%% of line, %4zu retransmitted, %3zu rto ms, "
+			   "%4zu corrupted, %4zu crc drops\n", loss, latency, (int) ('A' + i), (int) ('B' - i), goodput,
+			   100 * goodput / LINK_RATE, sender->arq->nb_retransmitted, (size_t) sender->arq->rto,
+			   links[i].nb_corrupted, stats.rx_framer_drops);
+
+	}
+
+	/*Delete ends and links;*/
+	for (size_t i = 0; i < 2; i++) {
+		close(sending[i][0]);
+		close(sending[i][1]);
+		close(receiving[i][0]);
+		close(receiving[i][1]);
+		arq_delete(ends[i].arq);
+		loopback_delete(ends[i].iface);
+	}
+
+	data_block_delete(buffer);
+
+}
+
+
+int main(int argc, char **argv) {
+
+	host_seed(40);
+
+	/*Run a single configuration if provided;*/
+	if (argc == 3) {
+		simulate((uint32_t) atoi(argv[1]), (uint32_t) atoi(argv[2]));
+		return 0;
+	}
+
+	/*Sweep loss rates and latencies;*/
+	static const uint32_t losses[] = {0, 1, 5, 10, 20};
+	static const uint32_t latencies[] = {1, 10, 50};
+
+	for (size_t i = 0; i < sizeof(latencies) / sizeof(*latencies); i++) {
+		for (size_t j = 0; j < sizeof(losses) / sizeof(*losses); j++) {
+			simulate(losses[j], latencies[i]);
+		}
+	}
+
+	return 0;
+
+}
@@ -0,0 +1,436 @@
+/*
+  cobs_test.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Round-trip tests of the COBS framer. Frames are encoded and decoded byte per byte and by blocks, cut in random
+ * 	spans, and compared : both paths must produce the same stream, and decode it to the same frames;
+ *
+ * 	Group boundaries are tested explicitly : full groups of 254 bytes, and zeros right after them, where no zero is
+ * 	implied by the code byte. Oversized and truncated frames must be dropped, and the decoder must resynchronise;
+ */
+
+#include "host.h"
+
+#include <string.h>
+
+#include <kernel/res/net/netf.h>
+
+#include <kernel/res/net/protocol.h>
+
+#include <kernel/res/net/framer/cobs_framer.h>
+
+
+/*The number of random frames;*/
+#if !defined(NB_FRAMES)
+
+#define NB_FRAMES 20000
+
+#endif
+
+/*The maximal size of random frames, several groups;*/
+#define MAX_FRAME 800
+
+/*The size of the decoding block;*/
+#define BLOCK_SIZE 1024
+
+/*The maximal size of an encoded frame, one code byte per started group, and the delimiter;*/
+#define MAX_ENCODED(size) ((size) + (size) / 254 + 2)
+
+/*The size of the stream buffer;*/
+#define STREAM_SIZE (4 * MAX_ENCODED(BLOCK_SIZE))
+
+
+/*Frames are not received through an interface;*/
+bool protocol_dispatch(struct protocol_t *protocol, struct data_block *block) {
+	(void) protocol, (void) block;
+	return false;
+}
+
+
+/*The framer, and its decoding block;*/
+static struct data_framer *framer;
+static struct data_block *rx_block;
+
+
+/*
+ * encode : encodes @frame in @stream, byte per byte, or by blocks of random spans. Returns the encoded size;
+ */
+
+static size_t encode(struct data_block *const frame, uint8_t *const stream, const bool blocks) {
+
+	framer->encoding_block = frame;
+
+	size_t size = 0;
+	bool complete = false;
+
+	while (!complete) {
+
+		CHECK(size < STREAM_SIZE);
+
+		if (blocks) {
+
+			/*Spans of 1 to 300 bytes, so that runs are cut anywhere;*/
+			size_t span = 1 + host_random(300);
+			if (span > STREAM_SIZE - size) {
+				span = STREAM_SIZE - size;
+			}
+
+			const size_t count = (*(framer->encode_block))(framer, stream + size, span, &complete);
+			CHECK((count) && (count <= span));
+
+			/*The encoder only stops early at the frame end;*/
+			CHECK((complete) || (count == span));
+			size += count;
+
+		} else {
+			complete = (*(framer->encode))(framer, stream + size++);
+		}
+
+	}
+
+	/*Only the delimiter is zero;*/
+	CHECK(!stream[size - 1]);
+	CHECK(!memchr(stream, 0, size - 1));
+
+	return size;
+
+}
+
+
+/*
+ * decode : decodes @size bytes of @stream, byte per byte, or by blocks of random spans. Decoded frames are
+ * 	concatenated in @frames, and their sizes stored in @sizes. Returns the number of frames;
+ */
+
+static size_t decode(const uint8_t *const stream, const size_t size, const bool blocks, uint8_t *const frames,
+					 size_t *const sizes, const size_t max_frames) {
+
+	size_t index = 0, nb_frames = 0, offset = 0;
+
+	while (index < size) {
+
+		bool complete;
+
+		if (blocks) {
+
+			size_t span = 1 + host_random(300);
+			if (span > size - index) {
+				span = size - index;
+			}
+
+			const size_t count = (*(framer->decode_block))(framer, stream + index, span, &complete);
+			CHECK((count) && (count <= span));
+
+			/*The decoder only stops early at a frame boundary;*/
+			CHECK((complete) || (count == span));
+			index += count;
+
+		} else {
+			complete = (*(framer->decode))(framer, stream[index++]);
+		}
+
+		/*Save the frame, and clear the block;*/
+		if (complete) {
+			CHECK(nb_frames < max_frames);
+			memcpy(frames + offset, rx_block->address, rx_block->size);
+			offset += sizes[nb_frames++] = rx_block->size;
+			rx_block->size = 0;
+		}
+
+	}
+
+	return nb_frames;
+
+}
+
+
+/*
+ * round_trip : encodes @frame, which may be a chain, with both paths, checks that streams are identical, and that
+ * 	both decoding paths restore @data;
+ */
+
+static void round_trip(struct data_block *const frame, const uint8_t *const data, const size_t size) {
+
+	static uint8_t byte_stream[STREAM_SIZE], block_stream[STREAM_SIZE], decoded[BLOCK_SIZE];
+
+	const size_t byte_size = encode(frame, byte_stream, false);
+	const size_t block_size = encode(frame, block_stream, true);
+
+	CHECK(byte_size == block_size);
+	CHECK(!memcmp(byte_stream, block_stream, byte_size));
+	CHECK(byte_size <= MAX_ENCODED(size));
+
+	for (size_t blocks = 0; blocks < 2; blocks++) {
+		size_t decoded_size;
+		CHECK(decode(byte_stream, byte_size, blocks, decoded, &decoded_size, 1) == 1);
+		CHECK(decoded_size == size);
+		CHECK(!memcmp(decoded, data, size));
+	}
+
+}
+
+
+/*
+ * frame_set : copies @size bytes of @data in a frame;
+ */
+
+static struct data_block *frame_set(struct data_block *const frame, const uint8_t *const data, const size_t size) {
+	CHECK(size <= frame->max_size);
+	memcpy(frame->address, data, size);
+	frame->size = size;
+	return frame;
+}
+
+
+/*
+ * random_frame : generates a random frame of @size bytes, with zeros at a random density, from none to all;
+ */
+
+static void random_frame(uint8_t *const data, const size_t size) {
+
+	const uint32_t zero_rate = host_random(4) ? host_random(64) : 256;
+
+	for (size_t i = 0; i < size; i++) {
+		data[i] = (host_random(256) < zero_rate) ? 0 : (uint8_t) (1 + host_random(255));
+	}
+
+}
+
+
+/*--------------------------------------------------------- Tests ------------------------------------------------------*/
+
+/*
+ * test_random : random frames, in a single block, and split in chains of segments;
+ */
+
+static void test_random() {
+
+	static uint8_t data[MAX_FRAME];
+
+	struct data_block *const frame = data_block_create(MAX_FRAME);
+	struct data_block *segments[4];
+	for (size_t i = 0; i < 4; i++) {
+		segments[i] = data_block_create(MAX_FRAME);
+	}
+
+	for (size_t n = 0; n < NB_FRAMES; n++) {
+
+		const size_t size = 1 + host_random(MAX_FRAME);
+		random_frame(data, size);
+
+		/*Single block;*/
+		round_trip(frame_set(frame, data, size), data, size);
+
+		/*Chain of up to four segments, possibly empty, cut at random offsets;*/
+		const size_t nb_segments = 2 + host_random(3);
+		size_t offset = 0;
+		for (size_t i = 0; i < nb_segments; i++) {
+			const size_t length = (i == nb_segments - 1) ? size - offset : host_random((uint32_t) (size - offset + 1));
+			frame_set(segments[i], data + offset, length);
+			if (i) {
+				data_block_chain(segments[0], segments[i]);
+			}
+			offset += length;
+		}
+		round_trip(segments[0], data, size);
+		for (size_t i = 1; i < nb_segments; i++) {
+			data_block_unchain(segments[i]);
+		}
+
+	}
+
+	data_block_delete(frame);
+	for (size_t i = 0; i < 4; i++) {
+		data_block_delete(segments[i]);
+	}
+
+}
+
+
+/*
+ * test_groups : frames around the 254 bytes group size. A full group implies no zero, the next code does;
+ */
+
+static void test_groups() {
+
+	static uint8_t data[BLOCK_SIZE], stream[STREAM_SIZE];
+
+	struct data_block *const frame = data_block_create(BLOCK_SIZE);
+
+	/*Non-zero frames around one and two full groups;*/
+	static const size_t sizes[] = {1, 253, 254, 255, 507, 508, 509, 762};
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+
+		const size_t size = sizes[i];
+		for (size_t j = 0; j < size; j++) {
+			data[j] = (uint8_t) (1 + j % 255);
+		}
+		frame_set(frame, data, size);
+
+		/*One code byte per started group, and the delimiter;*/
+		const size_t encoded = encode(frame, stream, false);
+		CHECK(encoded == size + (size + 253) / 254 + 1);
+
+		/*Full groups are coded 0xFF, a partial one by its size plus one;*/
+		CHECK(stream[0] == ((size >= 254) ? 0xFF : size + 1));
+		if (size > 254) {
+			CHECK(stream[255] == ((size >= 508) ? 0xFF : size - 254 + 1));
+		}
+
+		round_trip(frame, data, size);
+
+	}
+
+	/*A zero right after a full group : its own empty group, then the remaining data;*/
+	memset(data, 0x55, 254);
+	data[254] = 0;
+	data[255] = 0x66;
+	encode(frame_set(frame, data, 256), stream, false);
+	CHECK(stream[0] == 0xFF);
+	CHECK((stream[255] == 0x01) && (stream[256] == 0x02) && (stream[257] == 0x66) && (!stream[258]));
+	round_trip(frame, data, 256);
+
+	/*A frame ending with a zero after a full group;*/
+	CHECK(encode(frame_set(frame, data, 255), stream, false) == 258);
+	CHECK((stream[255] == 0x01) && (stream[256] == 0x01) && (!stream[257]));
+	round_trip(frame, data, 255);
+
+	/*Zeros after a full group, and after a group full but for its zero;*/
+	memset(data, 0x55, 600);
+	data[254] = data[255] = 0;
+	data[253 + 256] = 0;
+	round_trip(frame_set(frame, data, 600), data, 600);
+
+	/*Zero frames;*/
+	memset(data, 0, 600);
+	for (size_t size = 1; size <= 600; size += 199) {
+		CHECK(encode(frame_set(frame, data, size), stream, false) == size + 2);
+		round_trip(frame, data, size);
+	}
+
+	data_block_delete(frame);
+
+}
+
+
+/*
+ * test_errors : oversized and truncated frames are dropped without delivering anything, and the next frame is
+ * 	received. Empty frames are ignored;
+ */
+
+static void test_errors() {
+
+	static uint8_t data[BLOCK_SIZE + 1], stream[4 * STREAM_SIZE], frames[4 * BLOCK_SIZE];
+	size_t sizes[4];
+
+	struct data_block *const frame = data_block_create(BLOCK_SIZE + 1);
+
+	for (size_t blocks = 0; blocks < 2; blocks++) {
+
+		const size_t drops = framer->nb_drops;
+		size_t size = 0;
+
+		/*A frame that fits exactly;*/
+		random_frame(data, BLOCK_SIZE);
+		size += encode(frame_set(frame, data, BLOCK_SIZE), stream + size, false);
+
+		/*A frame one byte too long;*/
+		random_frame(data, BLOCK_SIZE + 1);
+		size += encode(frame_set(frame, data, BLOCK_SIZE + 1), stream + size, false);
+
+		/*A frame truncated in the middle of a group : the delimiter comes early;*/
+		memset(data, 0x77, 100);
+		const size_t truncated = encode(frame_set(frame, data, 100), stream + size, false);
+		stream[size + truncated - 50] = 0;
+		size += truncated - 49;
+
+		/*Empty frames, only delimiters;*/
+		stream[size++] = 0;
+		stream[size++] = 0;
+
+		/*A valid frame, then a frame cut right after a full group's code;*/
+		memset(data, 0x11, 10);
+		size += encode(frame_set(frame, data, 10), stream + size, false);
+		stream[size++] = 0xFF;
+		stream[size++] = 0;
+
+		/*A valid frame resynchronises;*/
+		memset(data, 0x22, 300);
+		size += encode(frame_set(frame, data, 300), stream + size, false);
+
+		const size_t nb_frames = decode(stream, size, blocks, frames, sizes, 4);
+
+		/*Three frames are received, the exact fit, and both short frames, intact;*/
+		CHECK(nb_frames == 3);
+		CHECK((sizes[0] == BLOCK_SIZE) && (sizes[1] == 10) && (sizes[2] == 300));
+		CHECK(frames[BLOCK_SIZE] == 0x11);
+		CHECK((frames[BLOCK_SIZE + 10] == 0x22) && (frames[BLOCK_SIZE + 10 + 299] == 0x22));
+
+		/*The oversized frame and both truncated ones are dropped, empty frames are not counted;*/
+		CHECK(framer->nb_drops - drops == 3);
+		CHECK(!framer->nb_truncations);
+
+	}
+
+	/*A stream cut at random, then resumed with a delimiter, resynchronises on the next frame;*/
+	for (size_t n = 0; n < 1000; n++) {
+
+		const size_t frame_size = 1 + host_random(MAX_FRAME);
+		random_frame(data, frame_size);
+		const size_t encoded = encode(frame_set(frame, data, frame_size), stream, false);
+
+		/*Cut the frame before its delimiter, and terminate the stream;*/
+		size_t size = host_random((uint32_t) encoded - 1);
+		stream[size++] = 0;
+
+		/*Send a valid frame;*/
+		random_frame(data, frame_size);
+		size += encode(frame_set(frame, data, frame_size), stream + size, false);
+
+		const size_t nb_frames = decode(stream, size, host_random(2), frames, sizes, 2);
+
+		/*The cut frame may be decoded if it was cut at a group boundary, but never as the valid frame;*/
+		CHECK((nb_frames) && (sizes[nb_frames - 1] == frame_size));
+		CHECK(!memcmp(frames + ((nb_frames == 2) ? sizes[0] : 0), data, frame_size));
+
+	}
+
+	data_block_delete(frame);
+
+}
+
+
+int main() {
+
+	host_seed(33);
+
+	framer = cobs_framer_create();
+	rx_block = data_block_create(BLOCK_SIZE);
+	framer->decoding_block = rx_block;
+
+	test_random();
+	test_groups();
+	test_errors();
+
+	printf("cobs_test : ok\n");
+
+	return 0;
+
+}
@@ -0,0 +1,117 @@
+/*
+  crc_bench.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Benchmark of the hardware CRC path against the software slice-by-8 tables, for frame sized spans;
+ *
+ * 	The software path is timed. The hardware path runs against the CRC model, that traps each register access : its
+ * 	host time is meaningless, and the benchmark reports its register accesses per frame instead. On target, each
+ * 	access is a bus write of a few cycles, where the software path costs about 8 table lookups per 8 bytes;
+ */
+
+#include "host.h"
+
+#include "crc_model.h"
+
+
+/*The number of bytes of each software measure;*/
+#if !defined(NB_BYTES)
+
+#define NB_BYTES 200000000
+
+#endif
+
+/*The number of frames of each hardware measure;*/
+#define NB_HW_FRAMES 1000
+
+/*The maximal frame size;*/
+#define MAX_FRAME 1024
+
+
+/*Frame sizes, the UART frames of the kernel are 64 to 256 bytes;*/
+static const size_t frame_sizes[] = {16, 64, 256, 1024};
+
+
+/*
+ * bench_software : times the software path over frames of @size, at alignment @offset;
+ */
+
+static void bench_software(const enum crc_type type, const size_t size, const size_t offset, const uint8_t *const data) {
+
+	const size_t nb_frames = NB_BYTES / size;
+	volatile uint32_t sink = 0;
+
+	const double start = host_time();
+	for (size_t i = 0; i < nb_frames; i++) {
+		sink ^= crc_compute(type, data + offset, size);
+	}
+	const double duration = host_time() - start;
+
+	char name[64];
+	snprintf(name, sizeof(name), "sw crc%s %4zu B +%zu", (type == CRC_16) ? "16" : "32", size, offset);
+	host_report(name, "frames", nb_frames, nb_frames * size, duration);
+
+}
+
+
+/*
+ * bench_hardware : counts the register accesses of the hardware path over frames of @size, at alignment @offset;
+ */
+
+static void bench_hardware(const enum crc_type type, const size_t size, const size_t offset, const uint8_t *const data) {
+
+	const size_t accesses = crc_model.nb_accesses;
+
+	for (size_t i = 0; i < NB_HW_FRAMES; i++) {
+		CHECK(hw_crc_compute(type, data + offset, size) == crc_compute(type, data + offset, size));
+	}
+
+	const double per_frame = (double) (crc_model.nb_accesses - accesses) / NB_HW_FRAMES;
+	printf("hw crc%s %4zu B +%zu %27.1f accesses/frame %6.3f accesses/B\n", (type == CRC_16) ? "16" : "32", size,
+		   offset, per_frame, per_frame / (double) size);
+
+}
+
+
+int main() {
+
+	static uint8_t data[MAX_FRAME + 8] __attribute__((aligned(8)));
+
+	host_seed(34);
+
+	crc_model_init();
+
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = (uint8_t) host_random(256);
+	}
+
+	/*Aligned frames, and frames whose head and tail are written by bytes;*/
+	for (enum crc_type type = CRC_16; type <= CRC_32; type++) {
+		for (size_t i = 0; i < sizeof(frame_sizes) / sizeof(*frame_sizes); i++) {
+			for (size_t offset = 0; offset < 2; offset++) {
+				bench_software(type, frame_sizes[i], offset * 3, data);
+				bench_hardware(type, frame_sizes[i], offset * 3, data);
+			}
+		}
+	}
+
+	return 0;
+
+}
@@ -0,0 +1,32 @@
+/*
+  crc_hw.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * The hardware path of crc.c, renamed so that it links next to the software path. It calls __crc_hw_compute, in
+ * 	kx_crc.c, that runs against the CRC model;
+ */
+
+#define KERNEL_HW_CRC
+
+#define crc_size hw_crc_size
+#define crc_compute hw_crc_compute
+#define crc_continue hw_crc_continue
+
+#include <kernel/res/net/crc.c>
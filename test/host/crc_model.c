@@ -0,0 +1,347 @@
+/*
+  crc_model.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#define _GNU_SOURCE
+
+#include "crc_model.h"
+
+#include "host.h"
+
+#include <signal.h>
+
+#include <string.h>
+
+#include <ucontext.h>
+
+#include <sys/mman.h>
+
+#include <arch/kx_sim.h>
+
+
+#if !defined(__x86_64__) || !defined(__linux__)
+
+#error "The CRC model traps register accesses, and requires x86_64 Linux;"
+
+#endif
+
+
+/*The address of the module's registers, and the size of their page;*/
+#define CRC_BASE ((void *) 0x40032000)
+#define PAGE_SIZE 4096
+
+/*Register offsets;*/
+#define REG_DATA 0
+#define REG_GPOLY 4
+#define REG_CTRL 8
+
+/*Control fields;*/
+#define CTRL_TOT(ctrl) (((ctrl) >> 30) & 3)
+#define CTRL_TOTR(ctrl) (((ctrl) >> 28) & 3)
+#define CTRL_FXOR ((uint32_t) 1 << 26)
+#define CTRL_WAS ((uint32_t) 1 << 25)
+#define CTRL_TCRC ((uint32_t) 1 << 24)
+
+/*Transpositions;*/
+#define TRANSPOSE_BITS 1
+#define TRANSPOSE_BYTES 2
+
+/*The trap flag of RFLAGS, that executes a single instruction;*/
+#define TRAP_FLAG 0x100
+
+
+/*The simulated module;*/
+struct crc_model crc_model;
+
+
+/*-------------------------------------------------------- Datapath ----------------------------------------------------*/
+
+/*
+ * width_mask : the mask of the CRC width;
+ */
+
+static uint32_t width_mask() {
+	return (crc_model.ctrl & CTRL_TCRC) ? 0xFFFFFFFF : 0xFFFF;
+}
+
+
+/*
+ * transpose : applies a transposition to the @size low bytes of @value. 1 transposes bits in bytes, 2 transposes
+ * 	bits in bytes and bytes, 3 transposes bytes only;
+ */
+
+static uint32_t transpose(uint32_t value, const size_t size, const uint8_t type) {
+
+	/*Transpose bits in each byte;*/
+	if ((type == 1) || (type == 2)) {
+		uint32_t reversed = 0;
+		for (size_t i = 0; i < size; i++) {
+			uint8_t byte = (uint8_t) (value >> (8 * i)), rev = 0;
+			for (uint8_t bit = 0; bit < 8; bit++) {
+				rev = (uint8_t) ((rev << 1) | ((byte >> bit) & 1));
+			}
+			reversed |= (uint32_t) rev << (8 * i);
+		}
+		value = reversed;
+	}
+
+	/*Transpose bytes;*/
+	if ((type == 2) || (type == 3)) {
+		uint32_t reversed = 0;
+		for (size_t i = 0; i < size; i++) {
+			reversed |= ((value >> (8 * i)) & 0xFF) << (8 * (size - 1 - i));
+		}
+		value = reversed;
+	}
+
+	return value;
+
+}
+
+
+/*
+ * process_byte : shifts a byte in the CRC, most significant bit first;
+ */
+
+static void process_byte(const uint8_t byte) {
+
+	const uint32_t mask = width_mask();
+	const uint8_t width = (mask == 0xFFFF) ? 16 : 32;
+	const uint32_t top = (uint32_t) 1 << (width - 1);
+	const uint32_t polynomial = crc_model.gpoly & mask;
+
+	uint32_t crc = crc_model.crc ^ ((uint32_t) byte << (width - 8));
+	for (uint8_t bit = 0; bit < 8; bit++) {
+		crc = (crc & top) ? ((crc << 1) ^ polynomial) : (crc << 1);
+	}
+
+	crc_model.crc = crc & mask;
+
+}
+
+
+/*
+ * read_data : the value of DATA, as the driver reads it;
+ */
+
+static uint32_t read_data() {
+
+	const uint32_t mask = width_mask();
+	uint32_t value = transpose(crc_model.crc & mask, (mask == 0xFFFF) ? 2 : 4, CTRL_TOTR(crc_model.ctrl));
+
+	/*Complement if required;*/
+	if (crc_model.ctrl & CTRL_FXOR) {
+		value ^= mask;
+	}
+
+	return value;
+
+}
+
+
+/*
+ * write_data : applies a write of @size bytes to DATA : a seed if WAS is set, data otherwise;
+ */
+
+static void write_data(const uint32_t written, const size_t size) {
+
+	/*Writes are transposed, seeds included;*/
+	const uint32_t value = transpose(written, size, CTRL_TOT(crc_model.ctrl));
+
+	/*A seed replaces the state;*/
+	if (crc_model.ctrl & CTRL_WAS) {
+		CHECK(size == 4);
+		crc_model.crc = value & width_mask();
+		return;
+	}
+
+	/*Data is processed most significant byte first;*/
+	for (size_t i = size; i--;) {
+		process_byte((uint8_t) (value >> (8 * i)));
+	}
+
+}
+
+
+/*-------------------------------------------------------- Accesses ----------------------------------------------------*/
+
+/*The access being executed, and its width for writes;*/
+static size_t access_offset;
+static size_t access_size;
+static bool access_write;
+
+
+/*
+ * write_size : decodes the width of the store instruction at @rip. Compilers emit mov forms for volatile stores;
+ */
+
+static size_t write_size(const uint8_t *rip) {
+
+	bool operand_16 = false, rex_w = false;
+
+	/*Skip the operand size and REX prefixes;*/
+	for (;; rip++) {
+		if (*rip == 0x66) {
+			operand_16 = true;
+		} else if ((*rip & 0xF0) == 0x40) {
+			rex_w = (bool) (*rip & 8);
+		} else {
+			break;
+		}
+	}
+
+	/*mov r/m8, r8 and mov r/m8, imm8;*/
+	if ((*rip == 0x88) || (*rip == 0xC6)) {
+		return 1;
+	}
+
+	/*mov r/m, r and mov r/m, imm;*/
+	if ((*rip == 0x89) || (*rip == 0xC7)) {
+		return (operand_16) ? 2 : (rex_w) ? 8 : 4;
+	}
+
+	/*Other stores are not expected from the driver;*/
+	fprintf(stderr, "crc model : unknown store opcode 0x%02x\n", *rip);
+	abort();
+
+}
+
+
+/*
+ * publish : writes current register values in the page, before an access;
+ */
+
+static void publish() {
+
+	volatile uint32_t *const page = CRC_BASE;
+	page[REG_DATA / 4] = read_data();
+	page[REG_GPOLY / 4] = crc_model.gpoly;
+	page[REG_CTRL / 4] = crc_model.ctrl;
+
+}
+
+
+/*
+ * fault_handler : starts an access of the driver;
+ */
+
+static void fault_handler(int signal, siginfo_t *const info, void *const context) {
+
+	(void) signal;
+
+	/*Other faults are real ones : restore the default action, so that the access crashes;*/
+	const uint8_t *const address = info->si_addr;
+	if ((address < (uint8_t *) CRC_BASE) || (address >= (uint8_t *) CRC_BASE + REG_CTRL + 4)) {
+		struct sigaction action = {.sa_handler = SIG_DFL};
+		sigaction(SIGSEGV, &action, 0);
+		return;
+	}
+
+	/*The clock must be enabled before any access;*/
+	CHECK(crc_model.clock_enabled);
+
+	/*Save the access. The page fault error code tells writes;*/
+	ucontext_t *const uc = context;
+	access_offset = (size_t) (address - (uint8_t *) CRC_BASE);
+	access_write = (bool) (uc->uc_mcontext.gregs[REG_ERR] & 2);
+	access_size = (access_write) ? write_size((const uint8_t *) uc->uc_mcontext.gregs[REG_RIP]) : 0;
+	crc_model.nb_accesses++;
+
+	/*Open the page with current values, and execute the access alone;*/
+	mprotect(CRC_BASE, PAGE_SIZE, PROT_READ | PROT_WRITE);
+	publish();
+	uc->uc_mcontext.gregs[REG_EFL] |= TRAP_FLAG;
+
+}
+
+
+/*
+ * trap_handler : completes an access of the driver;
+ */
+
+static void trap_handler(int signal, siginfo_t *const info, void *const context) {
+
+	(void) signal, (void) info;
+
+	/*Stop single stepping;*/
+	ucontext_t *const uc = context;
+	uc->uc_mcontext.gregs[REG_EFL] &= ~TRAP_FLAG;
+
+	/*Apply writes. Reads have no side effect;*/
+	if (access_write) {
+
+		/*Get the written value;*/
+		uint32_t value = 0;
+		memcpy(&value, (uint8_t *) CRC_BASE + access_offset, (access_size > 4) ? 4 : access_size);
+
+		/*Data is written at the low lanes of DATA, control registers as words;*/
+		if (access_offset == REG_DATA) {
+			CHECK(access_size <= 4);
+			write_data(value, access_size);
+		} else {
+			CHECK(access_size == 4);
+			if (access_offset == REG_GPOLY) {
+				crc_model.gpoly = value;
+			} else {
+				CHECK(access_offset == REG_CTRL);
+				crc_model.ctrl = value;
+			}
+		}
+
+	}
+
+	/*Close the page;*/
+	mprotect(CRC_BASE, PAGE_SIZE, PROT_NONE);
+
+}
+
+
+/*---------------------------------------------------------- Model -----------------------------------------------------*/
+
+/*Enable the clock of the module, as the SIM would;*/
+void sim_enable_CRC_clock_gating() {
+	crc_model.clock_enabled = true;
+}
+
+
+/*Map registers, install access handlers, and reset the module;*/
+void crc_model_init() {
+
+	static bool mapped;
+
+	/*Install handlers;*/
+	struct sigaction action = {.sa_flags = SA_SIGINFO};
+	action.sa_sigaction = &fault_handler;
+	CHECK(!sigaction(SIGSEGV, &action, 0));
+	action.sa_sigaction = &trap_handler;
+	CHECK(!sigaction(SIGTRAP, &action, 0));
+
+	/*Map the page once;*/
+	if (!mapped) {
+		void *const page = mmap(CRC_BASE, PAGE_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+		CHECK(page == CRC_BASE);
+		mapped = true;
+	}
+
+	/*Reset the module. The reset value of DATA and GPOLY is 0xFFFFFFFF and 0x1021;*/
+	memset(&crc_model, 0, sizeof(crc_model));
+	crc_model.crc = 0xFFFFFFFF;
+	crc_model.gpoly = 0x1021;
+
+}
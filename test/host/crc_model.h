@@ -0,0 +1,89 @@
+/*
+  crc_model.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_HOST_CRC_MODEL_H
+#define TRACER_HOST_CRC_MODEL_H
+
+#include <stdbool.h>
+
+#include <stdint.h>
+
+#include <stddef.h>
+
+#include <kernel/res/net/crc.h>
+
+
+/*
+ * Behavioural model of the K64 CRC module. The unmodified kx_crc.c driver runs against it;
+ *
+ * 	Registers live in an inaccessible page, as in the UART model (see uart_model.h) : each access of the driver
+ * 	faults, the model publishes register values, lets the access execute alone, and applies it. The width of a
+ * 	write is decoded from the faulting instruction, as the module processes 1, 2 or 4 bytes depending on it;
+ *
+ * 	The model implements, as described by the reference manual :
+ * 	- 16 and 32 bits CRCs (TCRC), with the polynomial of GPOLY;
+ * 	- seed writes (WAS), transposed like data;
+ * 	- write transpositions (TOT), within the access width, and read transpositions (TOTR);
+ * 	- the final complement of reads (FXOR);
+ *
+ * 	Data bytes are processed most significant first, after transposition. Accesses while the clock is gated fail;
+ *
+ * 	The model traps memory accesses, and requires x86_64 Linux;
+ */
+
+/*The state of the CRC module;*/
+struct crc_model {
+
+	/*Set when the driver has enabled the clock of the module;*/
+	bool clock_enabled;
+
+	/*The control and polynomial registers;*/
+	uint32_t ctrl;
+	uint32_t gpoly;
+
+	/*The CRC state, in its normal (not transposed) form;*/
+	uint32_t crc;
+
+	/*The number of register accesses;*/
+	size_t nb_accesses;
+
+};
+
+/*The simulated module;*/
+extern struct crc_model crc_model;
+
+
+/*Map registers, install access handlers, and reset the module;*/
+void crc_model_init();
+
+
+/*
+ * The hardware path of crc.c, built by crc_hw.c with KERNEL_HW_CRC over kx_crc.c. The software path of crc.c keeps
+ * 	its names, so that both can be compared in one program;
+ */
+
+size_t hw_crc_size(enum crc_type type);
+
+uint32_t hw_crc_compute(enum crc_type type, const uint8_t *data, size_t size);
+
+uint32_t hw_crc_continue(enum crc_type type, uint32_t crc, const uint8_t *data, size_t size);
+
+
+#endif /*TRACER_HOST_CRC_MODEL_H*/
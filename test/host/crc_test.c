@@ -0,0 +1,121 @@
+/*
+  crc_test.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Test of the hardware CRC path against the software tables. kx_crc.c runs against the CRC model, crc.c is built
+ * 	twice : its software path, and its hardware path (crc_hw.c). Both must give the standard check values, and the
+ * 	same CRCs for random spans, at all alignments, computed at once or continued across splits;
+ */
+
+#include "host.h"
+
+#include "crc_model.h"
+
+
+/*The number of random spans checked for each CRC;*/
+#if !defined(NB_SPANS)
+
+#define NB_SPANS 20000
+
+#endif
+
+/*The maximal size of a random span;*/
+#define MAX_SPAN 300
+
+
+/*------------------------------------------------------ Unit tests ----------------------------------------------------*/
+
+/*
+ * test_check_values : both paths give the check values of the standard, for "123456789";
+ */
+
+static void test_check_values() {
+
+	const uint8_t *const check = (const uint8_t *) "123456789";
+
+	CHECK(crc_compute(CRC_16, check, 9) == 0x29B1);
+	CHECK(crc_compute(CRC_32, check, 9) == 0xCBF43926);
+	CHECK(hw_crc_compute(CRC_16, check, 9) == 0x29B1);
+	CHECK(hw_crc_compute(CRC_32, check, 9) == 0xCBF43926);
+
+	/*The empty span gives the seed, after the final complement;*/
+	CHECK(hw_crc_compute(CRC_16, check, 0) == crc_compute(CRC_16, check, 0));
+	CHECK(hw_crc_compute(CRC_32, check, 0) == crc_compute(CRC_32, check, 0));
+
+	CHECK(hw_crc_size(CRC_16) == crc_size(CRC_16));
+	CHECK(hw_crc_size(CRC_32) == crc_size(CRC_32));
+
+	/*The driver enabled the clock of the module;*/
+	CHECK(crc_model.clock_enabled);
+
+}
+
+
+/*
+ * test_random_spans : random spans, at random alignments, give the same CRC on both paths, at once and continued
+ * 	after a random split. The split makes the hardware path restart from an unaligned address;
+ */
+
+static void test_random_spans(const enum crc_type type) {
+
+	static uint8_t buffer[MAX_SPAN + 8] __attribute__((aligned(8)));
+
+	for (size_t i = 0; i < NB_SPANS; i++) {
+
+		/*Fill a random span, at a random alignment;*/
+		const size_t offset = host_random(8);
+		const size_t size = host_random(MAX_SPAN + 1);
+		uint8_t *const data = buffer + offset;
+		for (size_t j = 0; j < size; j++) {
+			data[j] = (uint8_t) host_random(256);
+		}
+
+		/*Compute at once;*/
+		const uint32_t crc = crc_compute(type, data, size);
+		CHECK(hw_crc_compute(type, data, size) == crc);
+
+		/*Continue after a split;*/
+		const size_t split = host_random((uint32_t) size + 1);
+		CHECK(crc_continue(type, crc_compute(type, data, split), data + split, size - split) == crc);
+		CHECK(hw_crc_continue(type, hw_crc_compute(type, data, split), data + split, size - split) == crc);
+
+		/*Paths can be mixed, so that frames encoded by one are checked by the other;*/
+		CHECK(hw_crc_continue(type, crc_compute(type, data, split), data + split, size - split) == crc);
+
+	}
+
+}
+
+
+int main() {
+
+	host_seed(34);
+
+	crc_model_init();
+
+	test_check_values();
+	test_random_spans(CRC_16);
+	test_random_spans(CRC_32);
+
+	printf("crc_test : ok\n");
+
+	return 0;
+
+}
@@ -0,0 +1,345 @@
+/*
+  devfs_test.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Tests of the devfs, mounted on /dev over a tmpfs root, as the kernel mounts it. The iinode index is replaced by a
+ * 	table of device files, that counts lookups, so that the test can tell walks served by the dentry cache from walks
+ * 	that reach the index;
+ */
+
+/*api.h names the resource type FILE, as stdio does;*/
+#define FILE vfs_file
+
+#include <kernel/res/fs/api.h>
+
+#undef FILE
+
+#include "host.h"
+
+#include <string.h>
+
+#include <kernel/res/fs/devfs.h>
+
+#include <kernel/core/ram.h>
+
+#include <kernel/exec/mod_hook>
+
+
+/*The tmpfs and devfs modules, and the mount of /dev;*/
+extern const struct mod_hook tmpfs, devfs, dev_mount;
+
+
+/*------------------------------------------------------ Device files --------------------------------------------------*/
+
+#define NB_FILES 5
+
+/*
+ * The device files. pit_0 is registered by the test;
+ */
+
+static struct {
+
+	/*The name of the file;*/
+	const char *name;
+
+	/*Set if the file is registered, and if it is opened;*/
+	bool registered, opened;
+
+} files[NB_FILES] = {
+	{.name = "uart_0", .registered = true},
+	{.name = "uart_1", .registered = true},
+	{.name = "flash", .registered = true},
+	{.name = "spi_0", .registered = true},
+	{.name = "pit_0", .registered = false},
+};
+
+
+/*The number of files and classes searched, and of files opened;*/
+static size_t nb_gets, nb_class_gets, nb_opens;
+
+
+/*Find a registered file. Descriptors are indices plus one;*/
+static size_t file_find(const char *const name) {
+	for (size_t i = 0; i < NB_FILES; i++) {
+		if ((files[i].registered) && (!strcmp(files[i].name, name))) {
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+struct iinode *fs_get(const char *const name) {
+	nb_gets++;
+	return (file_find(name)) ? (struct iinode *) files : 0;
+}
+
+bool fs_class_exists(const char *const class) {
+	nb_class_gets++;
+	const size_t length = strlen(class);
+	for (size_t i = 0; i < NB_FILES; i++) {
+		if ((files[i].registered) && (!strncmp(files[i].name, class, length)) && (files[i].name[length] == '_')) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*As iinodes, a file can be opened once;*/
+file_descriptor fs_open(const char *const name) {
+	const size_t fd = file_find(name);
+	if ((!fd) || (files[fd - 1].opened)) {
+		return 0;
+	}
+	nb_opens++;
+	files[fd - 1].opened = true;
+	return fd;
+}
+
+void fs_close(const file_descriptor fd) {
+	CHECK((fd) && (fd <= NB_FILES) && (files[fd - 1].opened));
+	files[fd - 1].opened = false;
+}
+
+
+/*------------------------------------------------------ RAM frames ----------------------------------------------------*/
+
+/*The tmpfs root only stores the /dev directory, frames are served by the host heap;*/
+size_t ram_frame_size() {
+	return 1024;
+}
+
+void *ram_alloc_frame_region(const enum ram_region region) {
+	return malloc(1024);
+}
+
+void ram_free_frame(void *const frame) {
+	free(frame);
+}
+
+
+/*--------------------------------------------------------- Tests ------------------------------------------------------*/
+
+/*
+ * lookups : returns the number of index searches since the last call;
+ */
+
+static size_t lookups() {
+	const size_t count = nb_gets + nb_class_gets;
+	nb_gets = nb_class_gets = 0;
+	return count;
+}
+
+
+/*
+ * open_close : opens a device file, checks its descriptor, and closes it. Returns false if it can't be opened;
+ */
+
+static bool open_close(const char *const path, const char *const name) {
+
+	struct resrc *const rd = vfs_open(path);
+	if (!rd) {
+		return false;
+	}
+
+	CHECK(devfs_descriptor(rd) == file_find(name));
+	CHECK(files[devfs_descriptor(rd) - 1].opened);
+	vfs_close(rd);
+	CHECK(!files[file_find(name) - 1].opened);
+	return true;
+
+}
+
+
+/*
+ * test_walk : class directories and files are resolved through the index once, then by the dentry cache;
+ */
+
+static void test_walk() {
+
+	lookups();
+
+	/*The first open resolves the class and the file in the index;*/
+	CHECK(open_close("/dev/uart/0", "uart_0"));
+	CHECK(lookups() == 2);
+
+	/*Repeated opens are served by the dentry cache;*/
+	for (size_t i = 0; i < 100; i++) {
+		CHECK(open_close("/dev/uart/0", "uart_0"));
+	}
+	CHECK(lookups() == 0);
+
+	/*The class directory is cached, only the new file is searched;*/
+	CHECK(open_close("/dev/uart/1", "uart_1"));
+	CHECK(lookups() == 1);
+
+	/*A file without class is at the root;*/
+	CHECK(open_close("/dev/flash", "flash"));
+	CHECK(nb_gets == 1);
+	lookups();
+
+	/*A file with a class is only in its class directory. A class is not a file;*/
+	CHECK(!vfs_open("/dev/uart_0"));
+	CHECK(!vfs_open("/dev/uart/2"));
+	CHECK(!vfs_open("/dev/uart"));
+	CHECK(!vfs_open("/dev/flash/0"));
+
+	/*Names that exceed the index length fail;*/
+	CHECK(!vfs_open("/dev/uart/0123456789012345678901234567890"));
+	lookups();
+
+	/*Failures are cached too;*/
+	CHECK(!vfs_open("/dev/uart_0"));
+	CHECK(!vfs_open("/dev/uart/2"));
+	CHECK(lookups() == 0);
+
+	/*A file is opened once, a failed open leaves the file system idle;*/
+	struct resrc *const rd = vfs_open("/dev/spi/0");
+	CHECK(rd);
+	CHECK(!vfs_open("/dev/spi/0"));
+	vfs_close(rd);
+
+	/*Files are not created nor deleted through the vfs;*/
+	CHECK(!vfs_create("/dev/uart/3"));
+	CHECK(!vfs_delete("/dev/uart/0"));
+
+	/*Resources of other file systems have no descriptor;*/
+	struct resrc *const dir = vfs_open("/dev");
+	if (dir) {
+		CHECK(!devfs_descriptor(dir));
+		vfs_close(dir);
+	}
+
+}
+
+
+/*
+ * test_negative_lru : negative dentries are bounded, the least recently used one is evicted, and searched again;
+ */
+
+static void test_negative_lru() {
+
+	char path[32];
+
+	/*Fill the list of negative dentries;*/
+	for (size_t i = 0; i < VFS_NEGATIVE_DENTRIES_MAX; i++) {
+		sprintf(path, "/dev/x%u", (unsigned) i);
+		CHECK(!vfs_open(path));
+	}
+	lookups();
+
+	/*All are cached;*/
+	for (size_t i = 0; i < VFS_NEGATIVE_DENTRIES_MAX; i++) {
+		sprintf(path, "/dev/x%u", (unsigned) i);
+		CHECK(!vfs_open(path));
+	}
+	CHECK(lookups() == 0);
+
+	/*Use x0, so that x1 is the least recently used;*/
+	CHECK(!vfs_open("/dev/x0"));
+
+	/*A new failure evicts x1;*/
+	sprintf(path, "/dev/x%u", VFS_NEGATIVE_DENTRIES_MAX);
+	CHECK(!vfs_open(path));
+	CHECK(lookups());
+	lookups();
+
+	/*x0 is still cached, x1 is searched again, and evicts x2;*/
+	CHECK(!vfs_open("/dev/x0"));
+	CHECK(lookups() == 0);
+	CHECK(!vfs_open("/dev/x1"));
+	CHECK(lookups());
+	CHECK(!vfs_open("/dev/x3"));
+	CHECK(lookups() == 0);
+	CHECK(!vfs_open("/dev/x2"));
+	CHECK(lookups());
+
+	/*Positive dentries are not bounded, the walk still hits the cache;*/
+	CHECK(open_close("/dev/uart/0", "uart_0"));
+	CHECK(lookups() == 0);
+
+	/*A file registered after a failed lookup is hidden by its negative dentry, until evicted;*/
+	CHECK(!vfs_open("/dev/pit/0"));
+	files[4].registered = true;
+	CHECK(!vfs_open("/dev/pit/0"));
+	for (size_t i = 0; i < VFS_NEGATIVE_DENTRIES_MAX; i++) {
+		sprintf(path, "/dev/y%u", (unsigned) i);
+		CHECK(!vfs_open(path));
+	}
+	CHECK(open_close("/dev/pit/0", "pit_0"));
+
+}
+
+
+/*
+ * test_busy_unmount : file systems with opened files, or with mounted file systems, can't be unmounted;
+ */
+
+static void test_busy_unmount() {
+
+	/*An opened file keeps the devfs busy, the devfs keeps the root busy;*/
+	struct resrc *const rd = vfs_open("/dev/uart/0");
+	CHECK(rd);
+	CHECK(!vfs_unmount("/dev"));
+	CHECK(!vfs_unmount("/"));
+
+	/*Once closed, the devfs can be unmounted, then the root;*/
+	vfs_close(rd);
+	CHECK(!vfs_unmount("/"));
+	CHECK(vfs_unmount("/dev"));
+	CHECK(!vfs_unmount("/dev"));
+
+	/*Remounting the devfs searches files again;*/
+	lookups();
+	CHECK(vfs_mount("/dev", "devfs", 0));
+	CHECK(open_close("/dev/uart/0", "uart_0"));
+	CHECK(lookups() == 2);
+
+	/*Nodes are deleted with their file system;*/
+	CHECK(vfs_unmount("/dev"));
+	CHECK(vfs_unmount("/"));
+	CHECK(!vfs_open("/dev/uart/0"));
+
+	/*The kernel mount can be repeated;*/
+	CHECK((*(dev_mount.init))());
+	CHECK(open_close("/dev/flash", "flash"));
+	CHECK(vfs_unmount("/dev"));
+	CHECK(vfs_unmount("/"));
+
+}
+
+
+int main() {
+
+	/*Register the tmpfs and the devfs;*/
+	CHECK((*(tmpfs.init))());
+	CHECK((*(devfs.init))());
+
+	/*Mount /dev as the kernel does, after drivers registered their files;*/
+	CHECK((*(dev_mount.init))());
+
+	test_walk();
+	test_negative_lru();
+	test_busy_unmount();
+
+	printf("devfs_test : ok\n");
+
+	return 0;
+
+}
@@ -0,0 +1,267 @@
+/*
+  framer_bench.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Benchmark of framer decoding and encoding, one function pointer call per byte, as the UART FIFO loops did, against
+ * 	block operations over spans, as FIFO drains (8 bytes) and DMA bursts (256 bytes) provide them;
+ *
+ * 	Reports bytes per cycle. Cycles are read from the time stamp counter on x86, and are nanoseconds elsewhere;
+ */
+
+#include "host.h"
+
+#include <string.h>
+
+#include <kernel/res/net/netf.h>
+
+#include <kernel/res/net/protocol.h>
+
+#include <kernel/res/net/framer/ascii_framer.h>
+
+#include <kernel/res/net/framer/cobs_framer.h>
+
+
+/*The number of stream bytes of each measure;*/
+#if !defined(NB_BYTES)
+
+#define NB_BYTES 50000000
+
+#endif
+
+/*The size of the decoded stream, replayed until NB_BYTES are decoded;*/
+#define STREAM_SIZE (1 << 20)
+
+/*The maximal frame size;*/
+#define MAX_FRAME 1024
+
+
+/*Frame sizes, and block spans;*/
+static const size_t frame_sizes[] = {16, 64, 256, 1024};
+static const size_t spans[] = {8, 256};
+
+
+/*Frames are not received through an interface;*/
+bool protocol_dispatch(struct protocol_t *protocol, struct data_block *block) {
+	(void) protocol, (void) block;
+	return false;
+}
+
+
+/*
+ * cycles : returns the cycle counter;
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#define CYCLE_UNIT "cycle"
+
+static inline uint64_t cycles() {
+	return __builtin_ia32_rdtsc();
+}
+
+#else
+
+#define CYCLE_UNIT "ns"
+
+static inline uint64_t cycles() {
+	return (uint64_t) (host_time() * 1e9);
+}
+
+#endif
+
+
+/*
+ * report : prints the bytes per cycle of a measure;
+ */
+
+static void report(const char *const framer_name, const char *const operation, const size_t frame_size,
+				   const size_t span, const size_t nb_bytes, const uint64_t nb_cycles) {
+
+	char path[32];
+	if (span) {
+		snprintf(path, sizeof(path), "block %zu", span);
+	} else {
+		snprintf(path, sizeof(path), "per byte");
+	}
+
+	printf("%-5s %-6s %4zu B %-10s %8.3f B/%s\n", framer_name, operation, frame_size, path,
+		   (double) nb_bytes / (double) nb_cycles, CYCLE_UNIT);
+
+}
+
+
+/*
+ * bench_encode : encodes frames of @frame_size until NB_BYTES are produced, per byte if @span is null, by blocks of
+ * 	@span otherwise;
+ */
+
+static void bench_encode(const char *const name, struct data_framer *const framer, const size_t frame_size,
+						 const size_t span) {
+
+	static uint8_t out[2 * MAX_FRAME];
+
+	/*Printable content, so that any framer carries it;*/
+	struct data_block *const frame = data_block_create(frame_size);
+	for (size_t i = 0; i < frame_size; i++) {
+		((uint8_t *) frame->address)[i] = (uint8_t) ('a' + i % 26);
+	}
+	frame->size = frame_size;
+	framer->encoding_block = frame;
+
+	size_t nb_bytes = 0, size = 0;
+
+	const uint64_t start = cycles();
+
+	while (nb_bytes < NB_BYTES) {
+
+		bool complete = false;
+		size = 0;
+
+		if (span) {
+			while (!complete) {
+				size += (*(framer->encode_block))(framer, out + size, span, &complete);
+			}
+		} else {
+			while (!complete) {
+				complete = (*(framer->encode))(framer, out + size++);
+			}
+		}
+
+		nb_bytes += size;
+
+	}
+
+	const uint64_t nb_cycles = cycles() - start;
+
+	/*The last frame is entirely encoded. Both framers add at least two bytes, a code or a line feed, and the end;*/
+	CHECK((size >= frame_size + 2) && (size <= frame_size + frame_size / 254 + 2));
+
+	report(name, "encode", frame_size, span, nb_bytes, nb_cycles);
+
+	data_block_delete(frame);
+
+}
+
+
+/*
+ * bench_decode : decodes a stream of frames of @frame_size until NB_BYTES are consumed, per byte if @span is null,
+ * 	by blocks of @span otherwise. Checks the number of frames received;
+ */
+
+static void bench_decode(const char *const name, struct data_framer *const framer, const size_t frame_size,
+						 const size_t span) {
+
+	static uint8_t stream[STREAM_SIZE + 2 * MAX_FRAME];
+
+	/*Encode frames with the framer until the stream is full;*/
+	struct data_block *const frame = data_block_create(frame_size);
+	for (size_t i = 0; i < frame_size; i++) {
+		((uint8_t *) frame->address)[i] = (uint8_t) ('a' + i % 26);
+	}
+	frame->size = frame_size;
+	framer->encoding_block = frame;
+
+	size_t stream_size = 0, nb_stream_frames = 0;
+	while (stream_size < STREAM_SIZE) {
+		bool complete = false;
+		while (!complete) {
+			stream_size += (*(framer->encode_block))(framer, stream + stream_size, 2 * MAX_FRAME, &complete);
+		}
+		nb_stream_frames++;
+	}
+
+	struct data_block *const rx_block = data_block_create(MAX_FRAME);
+	framer->decoding_block = rx_block;
+
+	size_t nb_bytes = 0, nb_frames = 0, nb_replays = 0;
+
+	const uint64_t start = cycles();
+
+	while (nb_bytes < NB_BYTES) {
+
+		const uint8_t *data = stream, *const end = stream + stream_size;
+
+		if (span) {
+			while (data < end) {
+				const size_t size = ((size_t) (end - data) < span) ? (size_t) (end - data) : span;
+				bool complete;
+				data += (*(framer->decode_block))(framer, data, size, &complete);
+				nb_frames += complete;
+			}
+		} else {
+			while (data < end) {
+				nb_frames += (*(framer->decode))(framer, *(data++));
+			}
+		}
+
+		nb_bytes += stream_size;
+		nb_replays++;
+
+	}
+
+	const uint64_t nb_cycles = cycles() - start;
+
+	/*All frames were received, intact;*/
+	CHECK(nb_frames == nb_replays * nb_stream_frames);
+	CHECK((rx_block->size == frame_size) && (!memcmp(rx_block->address, frame->address, frame_size)));
+
+	report(name, "decode", frame_size, span, nb_bytes, nb_cycles);
+
+	data_block_delete(rx_block);
+	data_block_delete(frame);
+
+}
+
+
+/*
+ * bench_framer : measures both operations of a framer, per byte and by blocks;
+ */
+
+static void bench_framer(const char *const name, struct data_framer *(*const create)()) {
+
+	for (size_t f = 0; f < sizeof(frame_sizes) / sizeof(*frame_sizes); f++) {
+
+		struct data_framer *framer = create();
+		bench_decode(name, framer, frame_sizes[f], 0);
+		for (size_t s = 0; s < sizeof(spans) / sizeof(*spans); s++) {
+			bench_decode(name, framer, frame_sizes[f], spans[s]);
+		}
+
+		bench_encode(name, framer, frame_sizes[f], 0);
+		for (size_t s = 0; s < sizeof(spans) / sizeof(*spans); s++) {
+			bench_encode(name, framer, frame_sizes[f], spans[s]);
+		}
+
+		(*(framer->deleter))(framer);
+		free(framer);
+
+	}
+
+}
+
+
+int main() {
+
+	bench_framer("ascii", &ascii_framer_create);
+	bench_framer("cobs", &cobs_framer_create);
+
+	return 0;
+
+}
@@ -0,0 +1,106 @@
+/*
+  host.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#define _GNU_SOURCE
+
+#include "host.h"
+
+#include <pthread.h>
+
+#include <time.h>
+
+#include <kernel/core/except.h>
+
+
+/*--------------------------------------------------- Critical sections ------------------------------------------------*/
+
+/*
+ * On target, a critical section masks interrupts. On host, interrupts are simulated by threads, and a critical
+ * 	section is a recursive lock, so that sections can nest as on target;
+ */
+
+/*The lock of critical sections;*/
+static pthread_mutex_t critical_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+
+/*Enter a critical section;*/
+void critical_section_enter() {
+	pthread_mutex_lock(&critical_lock);
+}
+
+
+/*Leave a critical section;*/
+void critical_section_leave() {
+	pthread_mutex_unlock(&critical_lock);
+}
+
+
+/*------------------------------------------------------- Helpers ------------------------------------------------------*/
+
+/*The state of the pseudo random generator;*/
+static uint32_t random_state = 1;
+
+
+/*Get the current monotonic time, in seconds;*/
+double host_time() {
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+
+}
+
+
+/*Seed the pseudo random generator. A null state would stay null;*/
+void host_seed(const uint32_t seed) {
+	random_state = seed ? seed : 1;
+}
+
+
+/*Get a pseudo random number in [0, @range[. xorshift32 is enough for test patterns;*/
+uint32_t host_random(const uint32_t range) {
+
+	uint32_t x = random_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	random_state = x;
+
+	return range ? x % range : x;
+
+}
+
+
+/*Print a benchmark result line;*/
+void host_report(const char *const name, const char *const unit, const size_t nb_ops, const size_t nb_bytes,
+				 const double duration) {
+
+	/*Print operations per second;*/
+	printf("%-40s %12.0f %s/s", name, (double) nb_ops / duration, unit);
+
+	/*Print bytes per second if relevant;*/
+	if (nb_bytes) {
+		printf(" %10.2f MB/s", (double) nb_bytes / duration / 1e6);
+	}
+
+	printf("\n");
+
+}
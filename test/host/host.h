@@ -0,0 +1,63 @@
+/*
+  host.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_HOST_H
+#define TRACER_HOST_H
+
+#include <stdbool.h>
+
+#include <stdint.h>
+
+#include <stddef.h>
+
+#include <stdio.h>
+
+#include <stdlib.h>
+
+
+/*
+ * Host tests and benchmarks share a few helpers : checks that abort with their location, a monotonic clock, and a
+ * 	deterministic pseudo random generator, so that failures can be replayed from their seed;
+ */
+
+/*Abort with the location of the failed check;*/
+#define CHECK(cond)\
+	do {\
+		if (!(cond)) {\
+			fprintf(stderr, "%s:%d : check failed : %s\n", __FILE__, __LINE__, #cond);\
+			abort();\
+		}\
+	} while (0)
+
+
+/*Get the current monotonic time, in seconds;*/
+double host_time();
+
+/*Seed the pseudo random generator;*/
+void host_seed(uint32_t seed);
+
+/*Get a pseudo random number in [0, @range[;*/
+uint32_t host_random(uint32_t range);
+
+/*Print a benchmark result line : the number of @unit per second, and optionally bytes per second;*/
+void host_report(const char *name, const char *unit, size_t nb_ops, size_t nb_bytes, double duration);
+
+
+#endif /*TRACER_HOST_H*/
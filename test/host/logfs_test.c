@@ -0,0 +1,840 @@
+/*
+  logfs_test.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Tests of the logfs against a simulated flash. The file system is mounted through the vfs, and its pump task is
+ * 	run by the harness, for a number of steps or until it stops itself, as the scheduler would share the core;
+ *
+ * 	The simulated flash behaves as the K64 FlexNVM : commands last several polls of the busy state, the area of a
+ * 	command reads garbage while it executes, and a phrase that is not erased can't be programmed. Erase and program
+ * 	failures, and rejected programs, are injected. Power losses are simulated by mounting snapshots of the flash;
+ */
+
+/*api.h names the resource type FILE, as stdio does;*/
+#define FILE vfs_file
+
+#include <kernel/res/fs/api.h>
+
+#undef FILE
+
+#include "host.h"
+
+#include <setjmp.h>
+
+#include <string.h>
+
+#include <kernel/res/fs/iinode.h>
+
+#include <kernel/res/if/flash.h>
+
+#include <kernel/exec/sched.h>
+
+#include <kernel/exec/mod_hook>
+
+#include <khal/prmpt.h>
+
+#include <kernel/core/except.h>
+
+
+/*The number of power loss trials;*/
+#if !defined(NB_TRIALS)
+
+#define NB_TRIALS 100
+
+#endif
+
+/*The flash geometry;*/
+#define NB_SECTORS 32
+#define SECTOR_SIZE 4096
+#define PHRASE_SIZE 8
+
+/*The number of busy polls that commands last;*/
+#define ERASE_POLLS 200
+#define PROGRAM_POLLS 3
+
+/*The size of test data;*/
+#define DATA_SIZE (1 << 20)
+
+
+/*The logfs module;*/
+extern const struct mod_hook logfs;
+
+
+/*-------------------------------------------------- Simulated flash ---------------------------------------------------*/
+
+/*
+ * Flash commands;
+ */
+
+enum flash_command {
+
+	NO_COMMAND,
+
+	ERASE,
+
+	PROGRAM,
+
+};
+
+
+/*
+ * The simulated flash;
+ */
+
+static struct {
+
+	/*The content of the flash;*/
+	uint8_t image[NB_SECTORS * SECTOR_SIZE];
+
+	/*The command in progress, its offset, and the number of polls before its completion;*/
+	uint8_t command;
+	size_t offset;
+	size_t polls;
+
+	/*The phrase being programmed, and the content of its location before the program;*/
+	uint8_t phrase[PHRASE_SIZE];
+	uint8_t saved[PHRASE_SIZE];
+
+	/*Set if the last command failed;*/
+	bool failed;
+
+	/*Faults injected in the next commands : a failed erase, a failed program, and a rejected program;*/
+	bool fail_erase, fail_program, reject_program;
+
+	/*Erases of each sector, programs, rejected programs, and busy polls;*/
+	size_t nb_erases[NB_SECTORS];
+	size_t nb_programs, nb_rejects, nb_polls;
+
+} flash;
+
+
+/*The pump task runner, that the busy state interrupts when the task has used its steps;*/
+static void task_poll();
+
+
+/*
+ * garbage : fills an area with random bytes, as read during a command;
+ */
+
+static void garbage(const size_t offset, const size_t size) {
+	for (size_t i = 0; i < size; i++) {
+		flash.image[offset + i] = (uint8_t) host_random(256);
+	}
+}
+
+
+/*Is a command executing ? Each poll makes the command progress;*/
+static bool flash_busy() {
+
+	/*Count the poll, and let the task runner interrupt the task;*/
+	flash.nb_polls++;
+	task_poll();
+
+	/*If no command is executing, or if it is not complete, report it;*/
+	if ((!flash.polls) || (--flash.polls)) {
+		return flash.polls != 0;
+	}
+
+	/*Complete the erase :*/
+	if (flash.command == ERASE) {
+
+		/*If it must fail, the sector keeps garbage;*/
+		if (flash.fail_erase) {
+			flash.fail_erase = false;
+			flash.failed = true;
+		} else {
+			memset(flash.image + flash.offset, 0xFF, SECTOR_SIZE);
+			flash.nb_erases[flash.offset / SECTOR_SIZE]++;
+		}
+
+	} else {
+
+		/*Complete the program. A failed program leaves a partially programmed phrase;*/
+		for (size_t i = 0; i < PHRASE_SIZE; i++) {
+			flash.image[flash.offset + i] = (flash.failed) ?
+				(uint8_t) (flash.saved[i] & flash.phrase[i] & host_random(256)) : flash.phrase[i];
+		}
+
+	}
+
+	/*No more command;*/
+	flash.command = NO_COMMAND;
+	return false;
+
+}
+
+
+/*Did the last command fail ?*/
+static bool flash_failed() {
+	CHECK(!flash.polls);
+	return flash.failed;
+}
+
+
+/*Launch the erase of a sector;*/
+static bool flash_erase(const size_t sector) {
+
+	/*The flash must be idle, and the sector must exist;*/
+	CHECK(!flash.polls);
+	CHECK(sector < NB_SECTORS);
+
+	/*Start the erase. The sector reads garbage until it completes;*/
+	flash.command = ERASE;
+	flash.offset = sector * SECTOR_SIZE;
+	flash.polls = ERASE_POLLS;
+	flash.failed = false;
+	garbage(flash.offset, SECTOR_SIZE);
+
+	return true;
+
+}
+
+
+/*Launch the program of a phrase;*/
+static bool flash_program(const size_t offset, const uint8_t *const phrase) {
+
+	/*The flash must be idle, and the phrase aligned;*/
+	CHECK(!flash.polls);
+	CHECK((!(offset % PHRASE_SIZE)) && (offset < sizeof(flash.image)));
+
+	/*If the program must be rejected, don't launch it;*/
+	if (flash.reject_program) {
+		flash.reject_program = false;
+		flash.nb_rejects++;
+		return false;
+	}
+
+	/*Start the program;*/
+	flash.command = PROGRAM;
+	flash.offset = offset;
+	flash.polls = PROGRAM_POLLS;
+	flash.failed = flash.fail_program;
+	flash.fail_program = false;
+	flash.nb_programs++;
+	memcpy(flash.phrase, phrase, PHRASE_SIZE);
+	memcpy(flash.saved, flash.image + offset, PHRASE_SIZE);
+
+	/*A phrase that is not erased can't be programmed;*/
+	for (size_t i = 0; i < PHRASE_SIZE; i++) {
+		if (flash.saved[i] != 0xFF) {
+			flash.failed = true;
+		}
+	}
+
+	/*The phrase reads garbage until the program completes;*/
+	garbage(offset, PHRASE_SIZE);
+
+	return true;
+
+}
+
+
+/*The flash if of the simulated flash;*/
+static const struct flash_if flash_iface = {
+	.memory = flash.image,
+	.sector_size = SECTOR_SIZE,
+	.phrase_size = PHRASE_SIZE,
+	.nb_sectors = NB_SECTORS,
+	.busy = &flash_busy,
+	.failed = &flash_failed,
+	.erase = &flash_erase,
+	.program = &flash_program,
+};
+
+
+/*The simulated flash is the only device, named "flash";*/
+file_descriptor fs_open(const char *const name) {
+	return (strcmp(name, "flash")) ? 0 : 1;
+}
+
+bool iop_interface(const file_descriptor fd, void *const data, const size_t size) {
+	CHECK((fd == 1) && (size == sizeof(struct flash_if)));
+	memcpy(data, &flash_iface, size);
+	return true;
+}
+
+void fs_close(const file_descriptor fd) {
+	CHECK(fd == 1);
+}
+
+
+/*
+ * flash_commands : returns the number of commands launched;
+ */
+
+static size_t flash_commands() {
+
+	size_t count = flash.nb_programs;
+	for (size_t i = 0; i < NB_SECTORS; i++) {
+		count += flash.nb_erases[i];
+	}
+
+	return count;
+
+}
+
+
+/*
+ * flash_power_loss : replaces the flash content with a snapshot taken during activity. The command in progress is
+ * 	lost, its area holds garbage;
+ */
+
+static void flash_power_loss(const uint8_t *const snapshot) {
+	memcpy(flash.image, snapshot, sizeof(flash.image));
+	flash.command = NO_COMMAND;
+	flash.polls = 0;
+}
+
+
+/*----------------------------------------------------- Pump task ------------------------------------------------------*/
+
+/*
+ * The pump task, created by the logfs. It runs until it stops itself, or until it has polled the flash a number of
+ * 	times;
+ */
+
+static struct {
+
+	/*The descriptor of the task;*/
+	struct prc_desc desc;
+
+	/*Set once created, while running, when a stop was required, and once stopped;*/
+	bool created, running, stop_required, stopped;
+
+	/*The number of polls before the task is interrupted. Null if not limited;*/
+	size_t budget;
+
+	/*The context of the runner;*/
+	jmp_buf runner;
+
+} task;
+
+
+/*Create the task. The logfs creates only one;*/
+void sched_create_prc(struct prc_desc *const desc, struct prc_req *const req) {
+	CHECK((!task.created) && (req->stack_size));
+	task.desc = *desc;
+	task.created = true;
+}
+
+/*Require the stop of the task;*/
+struct sched_elmt *sched_stop_prc() {
+	CHECK(task.running);
+	task.stop_required = true;
+	return (struct sched_elmt *) &task;
+}
+
+/*Resume the task. A stop not committed yet is cancelled;*/
+void sched_resume_prc(struct sched_elmt *const element) {
+
+	CHECK(element == (struct sched_elmt *) &task);
+
+	/*If the stop is not committed, cancel it;*/
+	if (task.stop_required) {
+		task.stop_required = false;
+		return;
+	}
+
+	/*The task must be stopped;*/
+	CHECK(task.stopped);
+	task.stopped = false;
+
+}
+
+/*A context switch commits a required stop, and returns to the runner;*/
+void __prmpt_trigger() {
+
+	CHECK(task.running);
+
+	if (task.stop_required) {
+		task.stop_required = false;
+		task.stopped = true;
+		longjmp(task.runner, 1);
+	}
+
+}
+
+
+/*If the task is running and has used its polls, preempt it. It is in a critical section, between two steps;*/
+static void task_poll() {
+
+	if ((task.running) && (task.budget) && (!--task.budget)) {
+		critical_section_leave();
+		longjmp(task.runner, 1);
+	}
+
+}
+
+
+/*
+ * task_run : runs the pump task, if it is not stopped, until it stops itself, or for @budget polls if not null;
+ */
+
+static void task_run(const size_t budget) {
+
+	/*If the task doesn't run, nothing to do;*/
+	if ((!task.created) || (task.stopped)) {
+		return;
+	}
+
+	/*Run the task, it returns here when stopped or preempted;*/
+	task.budget = budget;
+	task.running = true;
+	if (!setjmp(task.runner)) {
+		(*(task.desc.function))((void *) task.desc.args, task.desc.args_size);
+	}
+	task.running = false;
+
+}
+
+
+/*------------------------------------------------------- Files --------------------------------------------------------*/
+
+/*Test data, and the read buffer;*/
+static uint8_t data[DATA_SIZE], out[DATA_SIZE];
+
+
+/*
+ * mount : mounts the simulated flash on the root;
+ */
+
+static void mount() {
+	CHECK(vfs_mount("/", "logfs", "flash"));
+}
+
+
+/*
+ * remount : programs all data, and mounts the file system again;
+ */
+
+static void remount() {
+	CHECK(vfs_unmount("/"));
+	mount();
+}
+
+
+/*
+ * file_read : reads a whole file, and returns its size;
+ */
+
+static size_t file_read(const char *const path) {
+
+	struct resrc *const rd = vfs_open(path);
+	CHECK(rd);
+
+	const size_t size = vfs_read(rd, out, sizeof(out));
+	vfs_close(rd);
+
+	return size;
+
+}
+
+
+/*
+ * file_check : verifies the content of a file;
+ */
+
+static void file_check(const char *const path, const size_t size, const uint8_t *const content) {
+
+	const size_t read = file_read(path);
+
+	if (read != size) {
+		fprintf(stderr, "%s : %zu bytes read, %zu expected\n", path, read, size);
+	}
+	CHECK(read == size);
+	CHECK(!memcmp(out, content, size));
+
+}
+
+
+/*------------------------------------------------------- Tests --------------------------------------------------------*/
+
+/*
+ * test_format : an unformatted flash is mounted, and formatted by the task;
+ */
+
+static void test_format() {
+
+	/*The flash is not erased;*/
+	memset(flash.image, 0, sizeof(flash.image));
+
+	/*Only the flash device can be mounted;*/
+	CHECK(!vfs_mount("/", "logfs", "nodev"));
+	CHECK(!task.created);
+
+	/*The mount creates the task, that erases and formats all sectors, and stops;*/
+	mount();
+	CHECK(task.created);
+	task_run(0);
+	CHECK(task.stopped);
+	for (size_t i = 0; i < NB_SECTORS; i++) {
+		CHECK(flash.nb_erases[i] == 1);
+	}
+
+	/*The file system is empty;*/
+	CHECK(!vfs_open("/log"));
+	remount();
+
+}
+
+
+/*
+ * test_staged : staged data is read from RAM, without waiting for the flash, and closing a file doesn't wait;
+ */
+
+static void test_staged() {
+
+	/*Create a file, the task is resumed to program its CREATE record;*/
+	CHECK(vfs_create("/staged"));
+	CHECK(!task.stopped);
+	task_run(0);
+
+	/*Write less than a record, the data is staged;*/
+	struct resrc *const rd = vfs_open("/staged");
+	CHECK(vfs_write(rd, data, 100) == 100);
+
+	/*Read it : the flash is not polled;*/
+	const size_t polls = flash.nb_polls, commands = flash_commands();
+	CHECK(vfs_seek(rd, 0));
+	CHECK(vfs_read(rd, out, sizeof(out)) == 100);
+	CHECK(!memcmp(out, data, 100));
+	CHECK(flash.nb_polls == polls);
+
+	/*Closing seals the data, and resumes the task, without programming;*/
+	vfs_close(rd);
+	CHECK(!task.stopped);
+	CHECK(flash_commands() == commands);
+
+	/*The sealed data is still read from RAM, then from the flash once programmed;*/
+	file_check("/staged", 100, data);
+	CHECK(flash.nb_polls == polls);
+	task_run(0);
+	CHECK(flash_commands() > commands);
+	file_check("/staged", 100, data);
+
+	/*Delete the file;*/
+	CHECK(vfs_delete("/staged"));
+	task_run(0);
+
+}
+
+
+/*
+ * test_log : a log file receives bursts, while the task runs for random durations. Reads at random positions never
+ * 	launch commands;
+ *
+ * @return the size of the log;
+ */
+
+static size_t test_log() {
+
+	CHECK(vfs_create("/log"));
+	struct resrc *const rd = vfs_open("/log");
+
+	size_t size = 0, nb_shorts = 0;
+
+	/*Write 60K by bursts of 37 bytes :*/
+	while (size < 60000) {
+
+		/*Write, a write is short if the stages are full during an erase;*/
+		const size_t count = vfs_write(rd, data + size, 37);
+		nb_shorts += (count < 37);
+		size += count;
+
+		/*Let the task run;*/
+		task_run(1 + host_random(20));
+
+		/*Sometimes, read at a random position;*/
+		if (!host_random(50)) {
+
+			const size_t offset = host_random((uint32_t) size), commands = flash_commands();
+
+			/*The read is short only if a sector is being erased;*/
+			CHECK(vfs_seek(rd, offset));
+			const size_t count = vfs_read(rd, out, sizeof(out));
+			CHECK((count == size - offset) || ((count < size - offset) && (flash.command == ERASE)));
+			CHECK(!memcmp(out, data + offset, count));
+			CHECK(flash_commands() == commands);
+			CHECK(vfs_seek(rd, size));
+
+		}
+
+	}
+
+	/*Report writes that were short, as the task was erasing;*/
+	printf("log : %zu bytes, %zu short writes\n", size, nb_shorts);
+
+	/*Close, and check before and after the programming of the end of the log;*/
+	vfs_close(rd);
+	file_check("/log", size, data);
+	task_run(0);
+	file_check("/log", size, data);
+
+	/*The log survives a remount;*/
+	remount();
+	file_check("/log", size, data);
+
+	return size;
+
+}
+
+
+/*
+ * test_collection : two files are written, one is deleted and recreated periodically, so that segments are collected.
+ * 	Programs fail, are rejected, and an erase fails;
+ */
+
+static void test_collection(const size_t log_size) {
+
+	size_t size_a = 0, size_b = 0;
+
+	CHECK(vfs_create("/a"));
+	CHECK(vfs_create("/b"));
+	struct resrc *a = vfs_open("/a"), *b = vfs_open("/b");
+
+	for (size_t round = 0; round < 30; round++) {
+
+		/*Interleave writes of both files;*/
+		for (size_t i = 0; i < 200; i++) {
+			size_a += vfs_write(a, data + size_a, 13);
+			size_b += vfs_write(b, data + 100000 + size_b, 29);
+			task_run(1 + host_random(20));
+		}
+
+		/*Every three rounds, check b and recreate it;*/
+		if (round % 3 == 2) {
+			vfs_close(b);
+			task_run(0);
+			file_check("/b", size_b, data + 100000);
+			CHECK(vfs_delete("/b"));
+			CHECK(vfs_create("/b"));
+			b = vfs_open("/b");
+			size_b = 0;
+		}
+
+		/*Inject faults;*/
+		if (round == 10) {
+			flash.fail_program = true;
+		}
+		if ((round >= 15) && (round < 18)) {
+			flash.reject_program = true;
+		}
+		if (round == 20) {
+			flash.fail_erase = true;
+		}
+
+	}
+
+	vfs_close(a);
+	vfs_close(b);
+	task_run(0);
+
+	/*All faults occurred;*/
+	CHECK((!flash.fail_program) && (!flash.fail_erase) && (flash.nb_rejects == 3));
+
+	/*Check files before and after a remount;*/
+	file_check("/a", size_a, data);
+	file_check("/b", size_b, data + 100000);
+	file_check("/log", log_size, data);
+	CHECK(!vfs_open("/c"));
+	remount();
+	file_check("/a", size_a, data);
+	file_check("/b", size_b, data + 100000);
+	file_check("/log", log_size, data);
+
+	printf("collection : a %zu bytes, %zu program rejects\n", size_a, flash.nb_rejects);
+
+}
+
+
+/*
+ * test_full : a file is written until the flash is full. Once deleted, its space is reclaimed;
+ */
+
+static void test_full(const size_t log_size) {
+
+	size_t size = file_read("/a");
+	struct resrc *rd = vfs_open("/a");
+	CHECK(vfs_seek(rd, size));
+
+	/*Write until writes fail, while the task has nothing left to do;*/
+	while (size < DATA_SIZE - 200) {
+
+		/*Write;*/
+		const size_t count = vfs_write(rd, data + size, 200);
+		size += count;
+
+		/*If the write failed, let the task complete its work. If it was stopped, the flash is full;*/
+		if (!count) {
+			if (task.stopped) {
+				break;
+			}
+			task_run(0);
+		}
+
+	}
+	CHECK(size < DATA_SIZE - 200);
+	vfs_close(rd);
+	task_run(0);
+	file_check("/a", size, data);
+	printf("full : a %zu bytes\n", size);
+
+	/*Delete the file, the task erases its segments;*/
+	CHECK(vfs_delete("/a"));
+	while (flash.command != ERASE) {
+		CHECK(!task.stopped);
+		task_run(2);
+	}
+
+	/*During the erase, a read of programmed data is short, and doesn't poll the flash;*/
+	const size_t polls = flash.nb_polls;
+	CHECK(file_read("/log") < log_size);
+	CHECK(flash.nb_polls == polls);
+
+	/*Once the erase is complete, the whole file is read;*/
+	task_run(0);
+	file_check("/log", log_size, data);
+
+	/*A new file can be written;*/
+	CHECK(vfs_create("/c"));
+	rd = vfs_open("/c");
+	size = 0;
+	while (size < 30000) {
+		size += vfs_write(rd, data + size, 50);
+		task_run(1 + host_random(20));
+	}
+	vfs_close(rd);
+	file_check("/c", size, data);
+
+	/*Check after a remount;*/
+	remount();
+	file_check("/c", size, data);
+	file_check("/log", log_size, data);
+	CHECK(!vfs_open("/a"));
+
+}
+
+
+/*
+ * test_power_loss : a file is appended while the task runs, and the flash is snapshotted at a random step. The
+ * 	snapshot must mount, with a prefix of the data written, that contains all data durable before;
+ */
+
+static void test_power_loss(const size_t log_size) {
+
+	static uint8_t snapshot[NB_SECTORS * SECTOR_SIZE];
+
+	for (size_t trial = 0; trial < NB_TRIALS; trial++) {
+
+		/*The recovered size of the file, durable;*/
+		size_t durable = file_read("/c");
+
+		/*If the file is big, recreate it, and make the records durable;*/
+		if (durable > 30000) {
+			CHECK(vfs_delete("/c"));
+			CHECK(vfs_create("/c"));
+			task_run(0);
+			durable = 0;
+		}
+
+		/*Append a random size, and snapshot at a random position;*/
+		struct resrc *const rd = vfs_open("/c");
+		CHECK(vfs_seek(rd, durable));
+		const size_t end = durable + 1000 + host_random(10000);
+		const size_t at = durable + host_random((uint32_t) (end - durable));
+		size_t size = durable, snapshot_size = 0;
+		bool erasing = false;
+
+		while (size < end) {
+
+			/*Write, a short write must be followed by progress of the task;*/
+			const size_t count = vfs_write(rd, data + size, 1 + host_random(300));
+			CHECK(count || (!task.stopped));
+			size += count;
+			task_run(1 + host_random(20));
+
+			/*Snapshot once, after a random number of steps;*/
+			if ((!snapshot_size) && (size >= at)) {
+				task_run(1 + host_random(300));
+				memcpy(snapshot, flash.image, sizeof(snapshot));
+				snapshot_size = size;
+				erasing = (flash.command == ERASE);
+			}
+
+		}
+		vfs_close(rd);
+		task_run(0);
+		file_check("/c", size, data);
+
+		/*Lose the power at the snapshot, and mount;*/
+		CHECK(vfs_unmount("/"));
+		flash_power_loss(snapshot);
+		mount();
+
+		/*The file holds a prefix of the data, that contains durable data;*/
+		const size_t recovered = file_read("/c");
+		CHECK((durable <= recovered) && (recovered <= snapshot_size));
+		file_check("/c", recovered, data);
+		file_check("/log", log_size, data);
+
+		if (!(trial % 20)) {
+			printf("power loss %zu : %zu..%zu, snapshot at %zu, %zu recovered%s\n",
+				   trial, durable, end, snapshot_size, recovered, (erasing) ? " (erasing)" : "");
+		}
+
+	}
+
+	/*Print the wear;*/
+	size_t min = (size_t) -1, max = 0;
+	for (size_t i = 0; i < NB_SECTORS; i++) {
+		min = (flash.nb_erases[i] < min) ? flash.nb_erases[i] : min;
+		max = (flash.nb_erases[i] > max) ? flash.nb_erases[i] : max;
+	}
+	printf("wear : %zu to %zu erases per sector, %zu programs\n", min, max, flash.nb_programs);
+
+}
+
+
+int main() {
+
+	host_seed(1);
+
+	/*Generate test data;*/
+	for (size_t i = 0; i < DATA_SIZE; i++) {
+		data[i] = (uint8_t) host_random(256);
+	}
+
+	/*Register the logfs;*/
+	CHECK((*(logfs.init))());
+
+	test_format();
+	test_staged();
+	const size_t log_size = test_log();
+	test_collection(log_size);
+	test_full(log_size);
+	test_power_loss(log_size);
+
+	CHECK(vfs_unmount("/"));
+
+	printf("logfs_test : ok\n");
+
+	return 0;
+
+}
@@ -0,0 +1,175 @@
+/*
+  loopback_bench.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * End-to-end framing benchmark. Frames are sent through a loopback interface, encoded and decoded by its framer,
+ * 	and received back, in memory, or through a host pipe. Each received frame is verified;
+ *
+ * 	Reports frames/s, and payload bytes/s;
+ */
+
+#include "host.h"
+
+#include <unistd.h>
+
+#include <string.h>
+
+#include <kernel/res/net/loopback.h>
+
+#include <kernel/res/net/protocol.h>
+
+#include <kernel/res/net/framer/ascii_framer.h>
+
+#include <kernel/res/net/framer/cobs_framer.h>
+
+#include <kernel/res/net/framer/crc_framer.h>
+
+
+/*The number of frames of each measure;*/
+#if !defined(NB_FRAMES)
+
+#define NB_FRAMES 1000000
+
+#endif
+
+/*The payload size of frames;*/
+#define PAYLOAD_SIZE 64
+
+/*The maximal size of frames, including CRCs;*/
+#define FRAME_SIZE 128
+
+/*The number of frames in each direction of the interface;*/
+#define NB_IFACE_FRAMES 16
+
+/*The number of bytes moved at each pump;*/
+#define PUMP_SIZE 1024
+
+
+/*No protocol is attached to benchmark interfaces;*/
+bool protocol_dispatch(struct protocol_t *protocol, struct data_block *block) {
+	(void) protocol, (void) block;
+	return false;
+}
+
+
+/*
+ * fill_payload : writes the payload of the frame @sequence. Payloads are printable, so that any framer can carry
+ * 	them, and start with the sequence number, so that losses and reorders are detected;
+ */
+
+static void fill_payload(uint8_t *const payload, const size_t sequence) {
+
+	/*Write the sequence number;*/
+	snprintf((char *) payload, PAYLOAD_SIZE, "%016zx", sequence);
+
+	/*Complete with letters;*/
+	for (size_t i = 16; i < PAYLOAD_SIZE; i++) {
+		payload[i] = (uint8_t) ('a' + (sequence + i) % 26);
+	}
+
+}
+
+
+/*
+ * bench_framer : sends NB_FRAMES frames through a loopback interface using @framer, and verifies them;
+ *
+ * @param name : the name of the measure;
+ * @param framer : the framer to use, owned by the interface;
+ * @param use_pipe : set if encoded bytes must go through a host pipe;
+ */
+
+static void bench_framer(const char *const name, struct data_framer *const framer, const bool use_pipe) {
+
+	/*Create the interface, and cache its layer 2;*/
+	struct loopback_net21 *const iface = loopback_create(framer, NB_IFACE_FRAMES, FRAME_SIZE);
+	struct netf2 *const l2 = &iface->iface.iface;
+
+	/*Pause the transmission before rx blocks run out, as RTS would, so that no byte is lost;*/
+	netf2_set_rx_watermark(l2, 2);
+
+	/*If required, send bytes through a pipe;*/
+	int fds[2] = {-1, -1};
+	if (use_pipe) {
+		CHECK(!pipe(fds));
+		loopback_attach_fds(iface, fds[0], fds[1]);
+	}
+
+	uint8_t expected[PAYLOAD_SIZE];
+	size_t sent = 0, received = 0;
+
+	const double start = host_time();
+
+	while (received < NB_FRAMES) {
+
+		struct data_block *block;
+
+		/*Send as many frames as possible;*/
+		while ((sent < NB_FRAMES) && (block = netf2_borrow_tx_frame(l2))) {
+			fill_payload(block->address, sent++);
+			block->size = PAYLOAD_SIZE;
+			CHECK(netf2_commit_tx_frame(l2, block));
+		}
+
+		/*Move bytes;*/
+		loopback_pump(iface, PUMP_SIZE);
+
+		/*Verify and return received frames;*/
+		while ((block = netf2_borrow_rx_frame(l2))) {
+			fill_payload(expected, received++);
+			CHECK(block->size == PAYLOAD_SIZE);
+			CHECK(!memcmp(block->address, expected, PAYLOAD_SIZE));
+			netf2_return_rx_frame(l2, block);
+		}
+
+	}
+
+	const double duration = host_time() - start;
+
+	/*No frame may have been dropped or truncated;*/
+	struct netf2_stats stats;
+	netf21_get_stats(&iface->iface, &stats);
+	CHECK(!stats.rx_framer_drops);
+	CHECK(!stats.rx_framer_truncations);
+	CHECK(!stats.rx_lost_bytes);
+
+	host_report(name, "frames", NB_FRAMES, NB_FRAMES * PAYLOAD_SIZE, duration);
+
+	loopback_delete(iface);
+	if (use_pipe) {
+		close(fds[0]);
+		close(fds[1]);
+	}
+
+}
+
+
+int main() {
+
+	bench_framer("ascii, memory", ascii_framer_create(), false);
+	bench_framer("cobs, memory", cobs_framer_create(), false);
+	bench_framer("cobs + crc16, memory", crc_framer_create(cobs_framer_create(), CRC_16), false);
+	bench_framer("cobs + crc32, memory", crc_framer_create(cobs_framer_create(), CRC_32), false);
+
+	bench_framer("ascii, pipe", ascii_framer_create(), true);
+	bench_framer("cobs + crc16, pipe", crc_framer_create(cobs_framer_create(), CRC_16), true);
+
+	return 0;
+
+}
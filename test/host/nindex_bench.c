@@ -0,0 +1,303 @@
+/*
+  nindex_bench.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Benchmark of the name index against a linear list, as the nostd nlist that registries used before : entries are
+ * 	linked in insertion order, and a name is resolved by comparing it with each entry;
+ *
+ * 	Names are those of the port driver's pin files, that registers every MK64 pin. Reports lookups of present names
+ * 	in random order, lookups of absent names, and the cost of filling and emptying the registry, in random order;
+ */
+
+#include "host.h"
+
+#include <string.h>
+
+#include <kernel/res/nindex.h>
+
+
+/*The number of lookups of each measure;*/
+#if !defined(NB_LOOKUPS)
+
+#define NB_LOOKUPS 5000000
+
+#endif
+
+/*The maximal number of entries;*/
+#define MAX_ENTRIES 1000
+
+/*The maximal length of names;*/
+#define NAME_LENGTH 15
+
+
+/*Registry sizes;*/
+static const size_t sizes[] = {10, 30, 100, 300, 1000};
+
+
+/*---------------------------------------------------- Linear list -----------------------------------------------------*/
+
+/*
+ * A list entry, as nlist's;
+ */
+
+struct nlist_entry {
+
+	/*The next entry;*/
+	struct nlist_entry *next;
+
+	/*The name, copied;*/
+	char *name;
+
+	/*The data;*/
+	void *data;
+
+};
+
+
+/*
+ * The list;
+ */
+
+struct nlist {
+
+	/*The first and last entries;*/
+	struct nlist_entry *first, *last;
+
+};
+
+
+/*Add a name at the end of the list. Fails if it is present;*/
+static bool nlist_add(struct nlist *const list, const char *const name, void *const data) {
+
+	for (struct nlist_entry *entry = list->first; entry; entry = entry->next) {
+		if (!strcmp(entry->name, name)) {
+			return false;
+		}
+	}
+
+	struct nlist_entry *const entry = malloc(sizeof(struct nlist_entry));
+	entry->next = 0;
+	entry->name = strdup(name);
+	entry->data = data;
+
+	if (list->last) {
+		list->last->next = entry;
+	} else {
+		list->first = entry;
+	}
+	list->last = entry;
+
+	return true;
+
+}
+
+/*Get the data associated to a name;*/
+static void *nlist_get(const struct nlist *const list, const char *const name) {
+
+	for (const struct nlist_entry *entry = list->first; entry; entry = entry->next) {
+		if (!strcmp(entry->name, name)) {
+			return entry->data;
+		}
+	}
+
+	return 0;
+
+}
+
+/*Remove a name;*/
+static void *nlist_remove(struct nlist *const list, const char *const name) {
+
+	struct nlist_entry *previous = 0;
+
+	for (struct nlist_entry *entry = list->first; entry; previous = entry, entry = entry->next) {
+
+		if (strcmp(entry->name, name)) {
+			continue;
+		}
+
+		if (previous) {
+			previous->next = entry->next;
+		} else {
+			list->first = entry->next;
+		}
+		if (list->last == entry) {
+			list->last = previous;
+		}
+
+		void *const data = entry->data;
+		free(entry->name);
+		free(entry);
+		return data;
+
+	}
+
+	return 0;
+
+}
+
+
+/*------------------------------------------------------ Benchmark -----------------------------------------------------*/
+
+/*Pin file names, and absent names of the same shape;*/
+static char names[MAX_ENTRIES][NAME_LENGTH + 1], absent[MAX_ENTRIES][NAME_LENGTH + 1];
+
+/*The random order of lookups;*/
+static uint16_t order[NB_LOOKUPS];
+
+
+/*
+ * bench_size : measures both registries with @size entries;
+ */
+
+static void bench_size(const size_t size) {
+
+	struct nindex index = {
+		.elements = 0,
+		.name_max_length = NAME_LENGTH,
+	};
+
+	struct nlist list = {0, 0};
+
+	char name[64];
+	volatile size_t sink = 0;
+
+	/*Lookups cycle through the registry, so that each measure costs about the same time;*/
+	const size_t nb_lookups = NB_LOOKUPS / ((size > 100) ? size / 100 : 1);
+
+	for (size_t i = 0; i < nb_lookups; i++) {
+		order[i] = (uint16_t) host_random((uint32_t) size);
+	}
+
+	/*The order of removals;*/
+	size_t permutation[MAX_ENTRIES];
+	for (size_t i = 0; i < size; i++) {
+		permutation[i] = i;
+	}
+	for (size_t i = size - 1; i; i--) {
+		const size_t j = host_random((uint32_t) (i + 1)), swap = permutation[i];
+		permutation[i] = permutation[j];
+		permutation[j] = swap;
+	}
+
+	/*Fill and empty the registries, removing names in random order, for enough rounds to be measured;*/
+	const size_t nb_rounds = 1 + 100000 / size;
+	double add_index = 0, add_list = 0, remove_index = 0, remove_list = 0;
+
+	for (size_t r = 0; r < nb_rounds; r++) {
+
+		double start = host_time();
+		for (size_t i = 0; i < size; i++) {
+			CHECK(nindex_add(&index, names[i], (void *) (i + 1)));
+		}
+		add_index += host_time() - start;
+
+		start = host_time();
+		for (size_t i = 0; i < size; i++) {
+			CHECK(nlist_add(&list, names[i], (void *) (i + 1)));
+		}
+		add_list += host_time() - start;
+
+		/*Keep the registries filled after the last round;*/
+		if (r == nb_rounds - 1) {
+			break;
+		}
+
+		start = host_time();
+		for (size_t i = 0; i < size; i++) {
+			CHECK(nindex_remove(&index, names[permutation[i]]) == (void *) (permutation[i] + 1));
+		}
+		remove_index += host_time() - start;
+
+		start = host_time();
+		for (size_t i = 0; i < size; i++) {
+			CHECK(nlist_remove(&list, names[permutation[i]]) == (void *) (permutation[i] + 1));
+		}
+		remove_list += host_time() - start;
+
+	}
+
+	snprintf(name, sizeof(name), "nindex %4zu add", size);
+	host_report(name, "ops", nb_rounds * size, 0, add_index);
+	snprintf(name, sizeof(name), "nlist  %4zu add", size);
+	host_report(name, "ops", nb_rounds * size, 0, add_list);
+	snprintf(name, sizeof(name), "nindex %4zu remove", size);
+	host_report(name, "ops", (nb_rounds - 1) * size, 0, remove_index);
+	snprintf(name, sizeof(name), "nlist  %4zu remove", size);
+	host_report(name, "ops", (nb_rounds - 1) * size, 0, remove_list);
+
+	/*Present names;*/
+	double start = host_time();
+	for (size_t i = 0; i < nb_lookups; i++) {
+		sink += (size_t) nindex_get(&index, names[order[i]]);
+	}
+	snprintf(name, sizeof(name), "nindex %4zu get", size);
+	host_report(name, "ops", nb_lookups, 0, host_time() - start);
+
+	start = host_time();
+	for (size_t i = 0; i < nb_lookups; i++) {
+		sink += (size_t) nlist_get(&list, names[order[i]]);
+	}
+	snprintf(name, sizeof(name), "nlist  %4zu get", size);
+	host_report(name, "ops", nb_lookups, 0, host_time() - start);
+
+	/*Absent names;*/
+	start = host_time();
+	for (size_t i = 0; i < nb_lookups; i++) {
+		CHECK(!nindex_get(&index, absent[order[i]]));
+	}
+	snprintf(name, sizeof(name), "nindex %4zu miss", size);
+	host_report(name, "ops", nb_lookups, 0, host_time() - start);
+
+	start = host_time();
+	for (size_t i = 0; i < nb_lookups; i++) {
+		CHECK(!nlist_get(&list, absent[order[i]]));
+	}
+	snprintf(name, sizeof(name), "nlist  %4zu miss", size);
+	host_report(name, "ops", nb_lookups, 0, host_time() - start);
+
+	/*Empty;*/
+	for (size_t i = 0; i < size; i++) {
+		CHECK(nindex_remove(&index, names[i]) == (void *) (i + 1));
+		CHECK(nlist_remove(&list, names[i]) == (void *) (i + 1));
+	}
+
+	CHECK((!index.elements) && (!list.first));
+	nindex_clear(&index, 0);
+
+}
+
+
+int main() {
+
+	host_seed(46);
+
+	/*Pins are named by port and index, as the port driver's files, absent names by an index beyond 32;*/
+	for (size_t i = 0; i < MAX_ENTRIES; i++) {
+		snprintf(names[i], sizeof(names[i]), "port%c_%zu", (char) ('a' + i / 32), i % 32);
+		snprintf(absent[i], sizeof(absent[i]), "port%c_%zu", (char) ('a' + i / 32), 32 + i % 32);
+	}
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+		bench_size(sizes[i]);
+	}
+
+	return 0;
+
+}
@@ -0,0 +1,380 @@
+/*
+  nindex_test.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Tests of the name index. Names are chosen by their hash, so that they collide on chosen home slots, and removals
+ * 	are checked entry by entry : the following entries of a cluster must be shifted back, except those that would
+ * 	move before their home slot;
+ *
+ * 	Random operations are then checked against a reference table, with a small name space so that clusters form,
+ * 	through several growths;
+ */
+
+#include "host.h"
+
+#include <string.h>
+
+#include <kernel/res/nindex.h>
+
+
+/*The capacity of the table at the first insertion;*/
+#define MIN_CAPACITY 16
+
+/*The number of random operations;*/
+#if !defined(NB_OPERATIONS)
+
+#define NB_OPERATIONS 200000
+
+#endif
+
+/*The size of the random name space;*/
+#define NB_NAMES 700
+
+
+/*
+ * hash : the FNV-1a hash of a name, as the index computes it;
+ */
+
+static uint32_t hash(const char *name) {
+	uint32_t h = 2166136261u;
+	while (*name) {
+		h = (h ^ (uint8_t) *(name++)) * 16777619u;
+	}
+	return h;
+}
+
+
+/*
+ * colliding : generates @nb_names names homed at @home in a table of @capacity entries;
+ */
+
+static void colliding(char (*const names)[16], const size_t nb_names, const size_t home, const size_t capacity) {
+
+	size_t count = 0;
+
+	for (uint32_t i = 0; count < nb_names; i++) {
+		char name[16];
+		snprintf(name, sizeof(name), "n%u", i);
+		if ((hash(name) & (capacity - 1)) == home) {
+			strcpy(names[count++], name);
+		}
+	}
+
+}
+
+
+/*
+ * slot_of : returns the slot of a name in the table, or the capacity if it is absent;
+ */
+
+static size_t slot_of(const struct nindex *const index, const char *const name) {
+	for (size_t slot = 0; slot < index->capacity; slot++) {
+		if ((index->entries[slot].name) && (!strcmp(index->entries[slot].name, name))) {
+			return slot;
+		}
+	}
+	return index->capacity;
+}
+
+
+/*
+ * check_invariants : checks cached hashes, the number of elements, and that no free entry lies between an entry and
+ * 	its home slot, so that probes find every name;
+ */
+
+static void check_invariants(const struct nindex *const index) {
+
+	const size_t mask = index->capacity - 1;
+	size_t elements = 0;
+
+	for (size_t slot = 0; slot < index->capacity; slot++) {
+
+		const struct nindex_entry *const entry = index->entries + slot;
+		if (!entry->name) {
+			continue;
+		}
+
+		elements++;
+		CHECK(entry->hash == hash(entry->name));
+
+		for (size_t s = entry->hash & mask; s != slot; s = (s + 1) & mask) {
+			CHECK(index->entries[s].name);
+		}
+
+		CHECK(nindex_get(index, entry->name) == entry->data);
+
+	}
+
+	CHECK(elements == index->elements);
+
+	/*Growth keeps the table at most three quarters full;*/
+	CHECK(elements * 4 <= index->capacity * 3);
+
+}
+
+
+/*-------------------------------------------------------- Tests -------------------------------------------------------*/
+
+/*
+ * test_api : additions, updates, lookups and removals, and their failures;
+ */
+
+static void test_api() {
+
+	struct nindex index = {
+		.elements = 0,
+		.name_max_length = 8,
+	};
+
+	/*An empty index has no table;*/
+	CHECK(!nindex_get(&index, "a"));
+	CHECK(!nindex_set(&index, "a", (void *) 1));
+	CHECK(!nindex_remove(&index, "a"));
+	CHECK(!index.entries);
+
+	/*Names are copied, duplicates and names longer than the maximum are rejected;*/
+	char name[16] = "uart_0";
+	CHECK(nindex_add(&index, name, (void *) 1));
+	strcpy(name, "spi_0");
+	CHECK(nindex_get(&index, "uart_0") == (void *) 1);
+	CHECK(!nindex_add(&index, "uart_0", (void *) 2));
+	CHECK(nindex_add(&index, "12345678", (void *) 3));
+	CHECK(!nindex_add(&index, "123456789", (void *) 4));
+	CHECK(nindex_add(&index, "", (void *) 5));
+	CHECK(nindex_get(&index, "") == (void *) 5);
+	CHECK((index.elements == 3) && (index.capacity == MIN_CAPACITY));
+
+	/*Updates only apply to present names;*/
+	CHECK(nindex_set(&index, "uart_0", (void *) 6));
+	CHECK(nindex_get(&index, "uart_0") == (void *) 6);
+	CHECK(!nindex_set(&index, "uart_1", (void *) 6));
+	CHECK(!nindex_get(&index, "uart_1"));
+
+	/*Removal returns the data, once;*/
+	CHECK(nindex_remove(&index, "uart_0") == (void *) 6);
+	CHECK(!nindex_remove(&index, "uart_0"));
+	CHECK(!nindex_get(&index, "uart_0"));
+	CHECK(index.elements == 2);
+
+	/*A removed name can be added again;*/
+	CHECK(nindex_add(&index, "uart_0", (void *) 7));
+	check_invariants(&index);
+
+	nindex_clear(&index, 0);
+	CHECK((!index.entries) && (!index.capacity) && (!index.elements));
+
+}
+
+
+/*
+ * test_backward_shift : names collide on a home slot, and removals shift the cluster back;
+ */
+
+static void test_backward_shift() {
+
+	struct nindex index = {
+		.elements = 0,
+		.name_max_length = 15,
+	};
+
+	/*Three names homed at 4, one at 5, and one at 8;*/
+	char at4[3][16], at5[1][16], at8[1][16];
+	colliding(at4, 3, 4, MIN_CAPACITY);
+	colliding(at5, 1, 5, MIN_CAPACITY);
+	colliding(at8, 1, 8, MIN_CAPACITY);
+
+	/*The cluster spans slots 4 to 8 : a4 a4 a4 a5 a8;*/
+	for (size_t i = 0; i < 3; i++) {
+		CHECK(nindex_add(&index, at4[i], (void *) (i + 1)));
+	}
+	CHECK(nindex_add(&index, at5[0], (void *) 4));
+	CHECK(nindex_add(&index, at8[0], (void *) 5));
+	CHECK(index.capacity == MIN_CAPACITY);
+	CHECK((slot_of(&index, at4[0]) == 4) && (slot_of(&index, at4[1]) == 5) && (slot_of(&index, at4[2]) == 6));
+	CHECK((slot_of(&index, at5[0]) == 7) && (slot_of(&index, at8[0]) == 8));
+	check_invariants(&index);
+
+	/*Removing the head shifts both colliding names and the name homed at 5 back. The name at its home stays;*/
+	CHECK(nindex_remove(&index, at4[0]) == (void *) 1);
+	CHECK((slot_of(&index, at4[1]) == 4) && (slot_of(&index, at4[2]) == 5) && (slot_of(&index, at5[0]) == 6));
+	CHECK((!index.entries[7].name) && (slot_of(&index, at8[0]) == 8));
+	check_invariants(&index);
+
+	/*Removing the last colliding name shifts the name homed at 5 back to its home;*/
+	CHECK(nindex_remove(&index, at4[2]) == (void *) 3);
+	CHECK((slot_of(&index, at4[1]) == 4) && (slot_of(&index, at5[0]) == 5) && (!index.entries[6].name));
+	check_invariants(&index);
+
+	/*Removing the head again : the name homed at 5 must not move before its home;*/
+	CHECK(nindex_remove(&index, at4[1]) == (void *) 2);
+	CHECK((!index.entries[4].name) && (slot_of(&index, at5[0]) == 5));
+	check_invariants(&index);
+
+	nindex_clear(&index, 0);
+
+	/*Names homed at the last slot wrap around the table;*/
+	char at15[4][16], at0[1][16];
+	colliding(at15, 4, 15, MIN_CAPACITY);
+	colliding(at0, 1, 0, MIN_CAPACITY);
+
+	for (size_t i = 0; i < 3; i++) {
+		CHECK(nindex_add(&index, at15[i], (void *) (i + 1)));
+	}
+	CHECK(nindex_add(&index, at0[0], (void *) 4));
+	CHECK((slot_of(&index, at15[0]) == 15) && (slot_of(&index, at15[1]) == 0) && (slot_of(&index, at15[2]) == 1));
+	CHECK(slot_of(&index, at0[0]) == 2);
+
+	/*The removal shifts entries back across the end of the table;*/
+	CHECK(nindex_remove(&index, at15[0]) == (void *) 1);
+	CHECK((slot_of(&index, at15[1]) == 15) && (slot_of(&index, at15[2]) == 0) && (slot_of(&index, at0[0]) == 1));
+	check_invariants(&index);
+
+	/*Absent colliding names probe the cluster and fail;*/
+	CHECK(!nindex_get(&index, at15[3]));
+	CHECK(!nindex_remove(&index, at15[3]));
+
+	nindex_clear(&index, 0);
+
+}
+
+
+/*
+ * test_growth : the table doubles before it is more than three quarters full, entries keep their data;
+ */
+
+static size_t nb_deleted;
+
+static void count_deleted(void *const data) {
+	CHECK(data);
+	nb_deleted++;
+}
+
+static void test_growth() {
+
+	struct nindex index = {
+		.elements = 0,
+		.name_max_length = 15,
+	};
+
+	char name[16];
+
+	for (size_t i = 0; i < 1000; i++) {
+
+		const size_t capacity = index.capacity;
+		snprintf(name, sizeof(name), "pin_%zu", i);
+		CHECK(nindex_add(&index, name, (void *) (i + 1)));
+
+		/*The table grows exactly when a quarter of it would be left free;*/
+		CHECK((index.capacity == capacity) == ((capacity) && ((i + 1) * 4 <= capacity * 3)));
+
+	}
+
+	check_invariants(&index);
+	CHECK(index.capacity == 2048);
+
+	for (size_t i = 0; i < 1000; i++) {
+		snprintf(name, sizeof(name), "pin_%zu", i);
+		CHECK(nindex_get(&index, name) == (void *) (i + 1));
+	}
+
+	/*Clearing passes each data to the deleter;*/
+	nb_deleted = 0;
+	nindex_clear(&index, &count_deleted);
+	CHECK(nb_deleted == 1000);
+
+}
+
+
+/*
+ * test_random : random operations against a reference, the index is checked periodically;
+ */
+
+static void test_random() {
+
+	struct nindex index = {
+		.elements = 0,
+		.name_max_length = 15,
+	};
+
+	static bool present[NB_NAMES];
+	static size_t values[NB_NAMES];
+	char name[16];
+
+	for (size_t n = 0; n < NB_OPERATIONS; n++) {
+
+		/*Use a part of the name space, so that the number of elements varies across growths;*/
+		const size_t range = 1 + (n / 1000) % NB_NAMES;
+		const size_t i = host_random((uint32_t) range);
+		snprintf(name, sizeof(name), "c%zu", i);
+
+		switch (host_random(4)) {
+
+			case 0:
+				CHECK(nindex_add(&index, name, (void *) (n + 1)) == !present[i]);
+				if (!present[i]) {
+					present[i] = true;
+					values[i] = n + 1;
+				}
+				break;
+
+			case 1:
+				CHECK(nindex_remove(&index, name) == (present[i] ? (void *) values[i] : 0));
+				present[i] = false;
+				break;
+
+			case 2:
+				CHECK(nindex_set(&index, name, (void *) (n + 1)) == present[i]);
+				if (present[i]) {
+					values[i] = n + 1;
+				}
+				break;
+
+			default:
+				CHECK(nindex_get(&index, name) == (present[i] ? (void *) values[i] : 0));
+				break;
+
+		}
+
+		if (!(n % 97)) {
+			check_invariants(&index);
+		}
+
+	}
+
+	check_invariants(&index);
+	nindex_clear(&index, 0);
+
+}
+
+
+int main() {
+
+	host_seed(46);
+
+	test_api();
+	test_backward_shift();
+	test_growth();
+	test_random();
+
+	printf("nindex_test : ok\n");
+
+	return 0;
+
+}
@@ -0,0 +1,183 @@
+/*
+  protocol_test.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Test of the protocol over a loopback interface : frames are dispatched to channels as they are received, read and
+ * 	released by the subscriber, and returned to the interface when their channel is closed;
+ *
+ * 	Closing a channel that holds frames must return them as the subscriber would : reception, paused by flow control
+ * 	while the frames were queued, resumes;
+ */
+
+#include "host.h"
+
+#include <string.h>
+
+#include <kernel/res/net/loopback.h>
+
+#include <kernel/res/net/protocol.h>
+
+#include <kernel/res/net/framer/cobs_framer.h>
+
+
+/*The number of frames in each direction of the interface, and their size;*/
+#define NB_IFACE_FRAMES 8
+#define FRAME_SIZE 32
+
+/*The free rx frames under which reception is paused;*/
+#define RX_WATERMARK 3
+
+/*The channel of the test;*/
+#define CHANNEL 1
+
+
+/*------------------------------------------------------ Scheduler -----------------------------------------------------*/
+
+/*
+ * Readers never wait in this test;
+ */
+
+struct sched_elmt *sched_stop_prc() {
+	CHECK(false);
+	return 0;
+}
+
+void sched_resume_prc(struct sched_elmt *const element) {
+	(void) element;
+	CHECK(false);
+}
+
+void __prmpt_trigger() {
+}
+
+
+/*-------------------------------------------------------- Tests -------------------------------------------------------*/
+
+/*
+ * send : sends @count frames on the channel, whose payload is their index;
+ */
+
+static void send(struct protocol_t *const protocol, const size_t count) {
+
+	for (size_t i = 0; i < count; i++) {
+		struct data_block *const block = protocol_borrow_tx_frame(protocol, CHANNEL);
+		CHECK(block);
+		*((uint8_t *) protocol_payload(block)) = (uint8_t) i;
+		block->size = PROTOCOL_HEADER_SIZE + 1;
+		CHECK(protocol_commit_tx_frame(protocol, block));
+	}
+
+}
+
+
+/*
+ * pump : moves bytes one by one, as a UART would, until the interface stops transmitting;
+ */
+
+static void pump(struct loopback_net21 *const iface) {
+	while (loopback_pump(iface, 1));
+}
+
+
+/*
+ * test_dispatch : frames are queued in their channel, in order, and released to the interface;
+ */
+
+static void test_dispatch(struct loopback_net21 *const iface, struct protocol_t *const protocol) {
+
+	struct netf2 *const l2 = &iface->iface.iface;
+
+	protocol_open(protocol, CHANNEL, NB_IFACE_FRAMES);
+	send(protocol, 2);
+	pump(iface);
+
+	/*Both frames were dispatched, in order;*/
+	for (size_t i = 0; i < 2; i++) {
+		struct data_block *const block = protocol_read(protocol, CHANNEL, false);
+		CHECK(block);
+		CHECK(protocol_payload_size(block) == 1);
+		CHECK(*(uint8_t *) protocol_payload(block) == i);
+		protocol_release(protocol, block);
+	}
+	CHECK(!protocol_read(protocol, CHANNEL, false));
+
+	/*Frames to a closed channel are dropped;*/
+	protocol_close(protocol, CHANNEL);
+	send(protocol, 1);
+	pump(iface);
+	CHECK(protocol->nb_unrouted == 1);
+	CHECK(block_ring_count(&l2->rx_empty) + 1 == NB_IFACE_FRAMES);
+
+}
+
+
+/*
+ * test_close_throttled : frames queued in a channel pause reception. Closing the channel returns them through the
+ * 	interface, and reception resumes;
+ */
+
+static void test_close_throttled(struct loopback_net21 *const iface, struct protocol_t *const protocol) {
+
+	struct netf2 *const l2 = &iface->iface.iface;
+	const size_t unrouted = protocol->nb_unrouted;
+
+	/*Queue frames in the channel until reception is paused. The interface holds the remaining frames;*/
+	protocol_open(protocol, CHANNEL, NB_IFACE_FRAMES);
+	send(protocol, NB_IFACE_FRAMES);
+	pump(iface);
+	CHECK(l2->rx_throttled);
+	const size_t queued = protocol->channels[CHANNEL].nb_frames;
+	CHECK(queued < NB_IFACE_FRAMES);
+	CHECK(block_ring_count(&l2->rx_empty) < RX_WATERMARK);
+
+	/*Close the channel. Its frames are back, reception resumes;*/
+	protocol_close(protocol, CHANNEL);
+	CHECK(!l2->rx_throttled);
+	CHECK(block_ring_count(&l2->rx_empty) + 1 == NB_IFACE_FRAMES);
+
+	/*Remaining frames are received, and dropped, as their channel is closed;*/
+	pump(iface);
+	CHECK(protocol->nb_unrouted - unrouted == NB_IFACE_FRAMES - queued);
+	CHECK(block_ring_count(&l2->rx_empty) + 1 == NB_IFACE_FRAMES);
+
+}
+
+
+int main() {
+
+	/*A loopback interface, with flow control;*/
+	struct loopback_net21 *const iface = loopback_create(cobs_framer_create(), NB_IFACE_FRAMES, FRAME_SIZE);
+	netf2_set_rx_watermark(&iface->iface.iface, RX_WATERMARK);
+
+	/*Attach a protocol;*/
+	static struct protocol_t protocol;
+	protocol_init(&protocol, &iface->iface.iface);
+
+	test_dispatch(iface, &protocol);
+	test_close_throttled(iface, &protocol);
+
+	protocol_exit(&protocol);
+	loopback_delete(iface);
+
+	printf("protocol_test : ok\n");
+
+	return 0;
+
+}
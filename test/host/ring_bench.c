@@ -0,0 +1,313 @@
+/*
+  ring_bench.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Throughput benchmark of block rings against the shared fifo they replaced in netf2;
+ *
+ * 	The shared fifo is reproduced here : a linked list of blocks, accessed in critical sections. A transfer moves a
+ * 	block around the netf2 loop : pulled from the empty queue, pushed in the full queue, pulled from it and pushed
+ * 	back. The loop is measured in a single thread, where the critical section only costs its lock, and in two
+ * 	threads, where both sides contend;
+ *
+ * 	On host, a critical section is a mutex, much more expensive than masking interrupts on target. The single thread
+ * 	figures are the closest to the target's;
+ */
+
+#include "host.h"
+
+#include <pthread.h>
+
+#include <sched.h>
+
+#include <string.h>
+
+#include <list.h>
+
+#include <kernel/core/except.h>
+
+#include <kernel/res/net/block_ring.h>
+
+
+/*The number of transfers of each measure;*/
+#if !defined(NB_TRANSFERS)
+
+#define NB_TRANSFERS 4000000
+
+#endif
+
+/*The number of blocks circulating in the loop;*/
+#define NB_BLOCKS 16
+
+
+/*A benchmark block, that can be linked in a shared fifo;*/
+struct bench_block {
+
+	/*The link of the shared fifo;*/
+	struct list_head head;
+
+	/*The sequence number;*/
+	volatile size_t sequence;
+
+};
+
+
+/*----------------------------------------------------- Shared fifo ----------------------------------------------------*/
+
+/*The shared fifo : a list of blocks, whose accesses are critical;*/
+struct shared_fifo {
+
+	/*The first block of the list, null if empty;*/
+	struct list_head *first;
+
+};
+
+
+/*Push @head at the end of @fifo;*/
+static void shared_fifo_push(struct shared_fifo *const fifo, struct list_head *const head) {
+
+	critical_section_enter();
+
+	list_init(head);
+
+	if (fifo->first) {
+		list_concat(fifo->first, head);
+	} else {
+		fifo->first = head;
+	}
+
+	critical_section_leave();
+
+}
+
+
+/*Pull the first element of @fifo, null if empty;*/
+static struct list_head *shared_fifo_pull(struct shared_fifo *const fifo) {
+
+	critical_section_enter();
+
+	struct list_head *const head = fifo->first;
+
+	if (head) {
+
+		/*The next element becomes the first, if any;*/
+		fifo->first = (head->next == head) ? 0 : head->next;
+		list_remove(head);
+
+	}
+
+	critical_section_leave();
+
+	return head;
+
+}
+
+
+/*---------------------------------------------------- Queue adapter ---------------------------------------------------*/
+
+/*Both queue types are measured with the same loops;*/
+struct bench_queues {
+
+	/*Are rings used ?*/
+	bool rings;
+
+	/*Rings. They have constant fields, and are allocated;*/
+	struct block_ring *empty_ring, *full_ring;
+
+	/*Shared fifos;*/
+	struct shared_fifo empty_fifo, full_fifo;
+
+};
+
+
+/*Push a block in the empty or the full queue;*/
+static inline void queue_push(struct bench_queues *const queues, const bool full, struct bench_block *const block) {
+
+	if (queues->rings) {
+		block_ring_push(full ? queues->full_ring : queues->empty_ring, (struct data_block *) block);
+	} else {
+		shared_fifo_push(full ? &queues->full_fifo : &queues->empty_fifo, &block->head);
+	}
+
+}
+
+
+/*Pull a block from the empty or the full queue;*/
+static inline struct bench_block *queue_pull(struct bench_queues *const queues, const bool full) {
+
+	if (queues->rings) {
+		return (struct bench_block *) block_ring_pull(full ? queues->full_ring : queues->empty_ring);
+	} else {
+		return (struct bench_block *) shared_fifo_pull(full ? &queues->full_fifo : &queues->empty_fifo);
+	}
+
+}
+
+
+/*Allocate a ring;*/
+static struct block_ring *ring_new(const size_t min_capacity) {
+
+	const struct block_ring ring = block_ring_create(min_capacity);
+
+	return memcpy(malloc(sizeof(struct block_ring)), &ring, sizeof(struct block_ring));
+
+}
+
+
+/*Create queues, and place all blocks in the empty one;*/
+static void queues_init(struct bench_queues *const queues, const bool rings, struct bench_block *const blocks) {
+
+	queues->rings = rings;
+	queues->empty_ring = ring_new(NB_BLOCKS);
+	queues->full_ring = ring_new(NB_BLOCKS);
+	queues->empty_fifo.first = queues->full_fifo.first = 0;
+
+	for (size_t i = 0; i < NB_BLOCKS; i++) {
+		queue_push(queues, false, &blocks[i]);
+	}
+
+}
+
+
+/*Delete rings;*/
+static void queues_delete(struct bench_queues *const queues) {
+	block_ring_delete(queues->empty_ring);
+	block_ring_delete(queues->full_ring);
+	free(queues->empty_ring);
+	free(queues->full_ring);
+}
+
+
+/*------------------------------------------------------ Measures ------------------------------------------------------*/
+
+/*
+ * bench_single : moves blocks around the loop in a single thread, by bursts of NB_BLOCKS;
+ */
+
+static void bench_single(const bool rings) {
+
+	struct bench_block blocks[NB_BLOCKS];
+	struct bench_queues queues;
+	queues_init(&queues, rings, blocks);
+
+	const double start = host_time();
+
+	for (size_t transfers = 0; transfers < NB_TRANSFERS; transfers += NB_BLOCKS) {
+
+		/*The interrupt side fills all blocks;*/
+		struct bench_block *block;
+		while ((block = queue_pull(&queues, false))) {
+			block->sequence = transfers;
+			queue_push(&queues, true, block);
+		}
+
+		/*The process side returns them;*/
+		while ((block = queue_pull(&queues, true))) {
+			queue_push(&queues, false, block);
+		}
+
+	}
+
+	host_report(rings ? "block_ring, single thread" : "shared_fifo, single thread", "transfers", NB_TRANSFERS, 0,
+				host_time() - start);
+
+	queues_delete(&queues);
+
+}
+
+
+/*The queues of the threaded measure;*/
+static struct bench_queues *threaded_queues;
+
+
+/*The producer of the threaded measure;*/
+static void *producer(void *arg) {
+
+	(void) arg;
+
+	for (size_t sequence = 0; sequence < NB_TRANSFERS;) {
+
+		struct bench_block *const block = queue_pull(threaded_queues, false);
+
+		if (!block) {
+			sched_yield();
+			continue;
+		}
+
+		block->sequence = sequence++;
+		queue_push(threaded_queues, true, block);
+
+	}
+
+	return 0;
+
+}
+
+
+/*
+ * bench_threaded : moves blocks around the loop between two threads;
+ */
+
+static void bench_threaded(const bool rings) {
+
+	struct bench_block blocks[NB_BLOCKS];
+	struct bench_queues queues;
+	queues_init(&queues, rings, blocks);
+	threaded_queues = &queues;
+
+	const double start = host_time();
+
+	pthread_t thread;
+	CHECK(!pthread_create(&thread, 0, &producer, 0));
+
+	for (size_t expected = 0; expected < NB_TRANSFERS;) {
+
+		struct bench_block *const block = queue_pull(&queues, true);
+
+		if (!block) {
+			sched_yield();
+			continue;
+		}
+
+		CHECK(block->sequence == expected++);
+		queue_push(&queues, false, block);
+
+	}
+
+	CHECK(!pthread_join(thread, 0));
+
+	host_report(rings ? "block_ring, two threads" : "shared_fifo, two threads", "transfers", NB_TRANSFERS, 0,
+				host_time() - start);
+
+	queues_delete(&queues);
+
+}
+
+
+int main() {
+
+	bench_single(false);
+	bench_single(true);
+
+	bench_threaded(false);
+	bench_threaded(true);
+
+	return 0;
+
+}
@@ -0,0 +1,278 @@
+/*
+  ring_test.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Stress test of block rings. A thread plays the interrupt handler of a netf2 : it pulls blocks from an empty ring,
+ * 	writes a sequence number in them, and pushes them in a non empty ring. The main thread plays the process : it
+ * 	pulls blocks, verifies their sequence, and returns them. Neither side takes a lock;
+ */
+
+#include "host.h"
+
+#include <pthread.h>
+
+#include <sched.h>
+
+#include <string.h>
+
+#include <kernel/res/net/block_ring.h>
+
+
+/*The number of blocks exchanged by each threaded test;*/
+#if !defined(NB_TRANSFERS)
+
+#define NB_TRANSFERS 2000000
+
+#endif
+
+
+/*A test block. Rings only manipulate pointers, and never dereference them;*/
+struct test_block {
+
+	/*The sequence number, written by the producer before the push;*/
+	volatile size_t sequence;
+
+	/*Padding, so that blocks do not share cache lines;*/
+	uint8_t padding[56];
+
+};
+
+
+/*------------------------------------------------------ Unit tests ----------------------------------------------------*/
+
+/*
+ * test_capacity : verifies the rounding of capacities, and full and empty conditions;
+ */
+
+static void test_capacity() {
+
+	struct test_block blocks[16];
+
+	/*A capacity is rounded up to a power of two;*/
+	struct block_ring ring = block_ring_create(9);
+	CHECK(ring.mask == 15);
+	CHECK(block_ring_empty(&ring));
+
+	/*Fill the ring;*/
+	for (size_t i = 0; i < 16; i++) {
+		CHECK(block_ring_push(&ring, (struct data_block *) &blocks[i]));
+	}
+
+	/*A full ring refuses blocks;*/
+	CHECK(block_ring_count(&ring) == 16);
+	CHECK(!block_ring_push(&ring, (struct data_block *) &blocks[0]));
+
+	/*Blocks are pulled in order;*/
+	for (size_t i = 0; i < 16; i++) {
+		CHECK(block_ring_pull(&ring) == (struct data_block *) &blocks[i]);
+	}
+
+	/*An empty ring returns null;*/
+	CHECK(!block_ring_pull(&ring));
+	CHECK(block_ring_empty(&ring));
+
+	block_ring_delete(&ring);
+
+}
+
+
+/*
+ * test_index_wrap : verifies that free running indices can overflow;
+ */
+
+static void test_index_wrap() {
+
+	struct test_block blocks[4];
+
+	struct block_ring ring = block_ring_create(4);
+
+	/*Place both indices just before the overflow;*/
+	ring.head = ring.tail = (size_t) -2;
+
+	/*Cross the overflow several times;*/
+	for (size_t round = 0; round < 8; round++) {
+
+		for (size_t i = 0; i < 4; i++) {
+			CHECK(block_ring_push(&ring, (struct data_block *) &blocks[i]));
+		}
+
+		CHECK(block_ring_count(&ring) == 4);
+		CHECK(!block_ring_push(&ring, (struct data_block *) &blocks[0]));
+
+		for (size_t i = 0; i < 4; i++) {
+			CHECK(block_ring_pull(&ring) == (struct data_block *) &blocks[i]);
+		}
+
+		CHECK(block_ring_empty(&ring));
+
+	}
+
+	block_ring_delete(&ring);
+
+}
+
+
+/*---------------------------------------------------- Threaded test ---------------------------------------------------*/
+
+/*The pair of rings of the threaded test, as in a netf2;*/
+static struct block_ring *empty_ring, *full_ring;
+
+/*The number of blocks to transfer;*/
+static size_t nb_transfers;
+
+/*The number of times each side found its ring empty. Shows that both sides actually raced;*/
+static size_t producer_starved, consumer_starved;
+
+
+/*
+ * ring_new : allocates a ring; Rings have constant fields, and can't be assigned;
+ */
+
+static struct block_ring *ring_new(const size_t min_capacity) {
+
+	const struct block_ring ring = block_ring_create(min_capacity);
+
+	return memcpy(malloc(sizeof(struct block_ring)), &ring, sizeof(struct block_ring));
+
+}
+
+
+/*
+ * producer : the interrupt side; Transfers a random burst of blocks at each call;
+ */
+
+static void *producer(void *arg) {
+
+	(void) arg;
+
+	size_t sequence = 0;
+
+	while (sequence < nb_transfers) {
+
+		/*Transfer a burst;*/
+		uint32_t burst = host_random(8) + 1;
+
+		while (burst-- && (sequence < nb_transfers)) {
+
+			/*Get an empty block;*/
+			struct test_block *const block = (struct test_block *) block_ring_pull(empty_ring);
+
+			/*If none, the process holds all blocks;*/
+			if (!block) {
+				producer_starved++;
+				sched_yield();
+				break;
+			}
+
+			/*Fill and publish it;*/
+			block->sequence = sequence++;
+			CHECK(block_ring_push(full_ring, (struct data_block *) block));
+
+		}
+
+	}
+
+	return 0;
+
+}
+
+
+/*
+ * test_threaded : exchanges blocks between two threads through a pair of rings, and verifies their sequence;
+ *
+ * @param nb_blocks : the number of blocks circulating between rings;
+ * @param transfers : the number of blocks to transfer;
+ */
+
+static void test_threaded(const size_t nb_blocks, const size_t transfers) {
+
+	/*Create the blocks and both rings;*/
+	struct test_block *const blocks = calloc(nb_blocks, sizeof(struct test_block));
+	empty_ring = ring_new(nb_blocks);
+	full_ring = ring_new(nb_blocks);
+
+	/*All blocks start empty;*/
+	for (size_t i = 0; i < nb_blocks; i++) {
+		CHECK(block_ring_push(empty_ring, (struct data_block *) &blocks[i]));
+	}
+
+	nb_transfers = transfers;
+	producer_starved = consumer_starved = 0;
+
+	/*Start the producer;*/
+	pthread_t thread;
+	CHECK(!pthread_create(&thread, 0, &producer, 0));
+
+	/*Consume all blocks;*/
+	for (size_t expected = 0; expected < nb_transfers;) {
+
+		struct test_block *const block = (struct test_block *) block_ring_pull(full_ring);
+
+		/*If none, wait for the producer;*/
+		if (!block) {
+			consumer_starved++;
+			sched_yield();
+			continue;
+		}
+
+		/*The sequence must be written before the block is published, and blocks must not be lost;*/
+		CHECK(block->sequence == expected);
+		expected++;
+
+		/*Return the block;*/
+		CHECK(block_ring_push(empty_ring, (struct data_block *) block));
+
+	}
+
+	CHECK(!pthread_join(thread, 0));
+
+	/*All blocks are back;*/
+	CHECK(block_ring_count(empty_ring) == nb_blocks);
+	CHECK(block_ring_empty(full_ring));
+
+	printf("ring_test : %zu blocks, %zu transfers, producer starved %zu, consumer starved %zu\n",
+		   nb_blocks, nb_transfers, producer_starved, consumer_starved);
+
+	block_ring_delete(empty_ring);
+	block_ring_delete(full_ring);
+	free(empty_ring);
+	free(full_ring);
+	free(blocks);
+
+}
+
+
+int main() {
+
+	host_seed(31);
+
+	test_capacity();
+	test_index_wrap();
+
+	/*A single block makes both sides alternate at each transfer, many blocks let them run in parallel;*/
+	test_threaded(1, NB_TRANSFERS / 20);
+	test_threaded(4, NB_TRANSFERS);
+	test_threaded(64, NB_TRANSFERS);
+
+	printf("ring_test : ok\n");
+
+	return 0;
+
+}
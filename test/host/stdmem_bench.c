@@ -0,0 +1,215 @@
+/*
+  stdmem_bench.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Benchmark of the kernel memory functions across sizes and alignments, against a byte loop, as the previous
+ * 	implementation was, and against the host's functions;
+ *
+ * 	On host, the kernel functions run their portable word implementation; LDM / STM bursts are only built for
+ * 	ARMv7-M. The ratio to the byte loop is the relevant figure, the host's functions use vector units;
+ */
+
+#include "host.h"
+
+#include <string.h>
+
+#include "stdmem_host.h"
+
+
+/*The number of bytes of each measure;*/
+#if !defined(NB_BYTES)
+
+#define NB_BYTES 200000000
+
+#endif
+
+/*The maximal size;*/
+#define MAX_SIZE 4096
+
+
+/*Sizes, from struct initialisers to frames;*/
+static const size_t sizes[] = {8, 16, 32, 64, 256, 1024, 4096};
+
+/*Source and destination offsets : both aligned, destination misaligned, source misaligned, same misalignment;*/
+static const size_t offsets[][2] = {{0, 0}, {0, 1}, {3, 0}, {5, 5}};
+
+#define NB_OFFSETS (sizeof(offsets) / sizeof(*offsets))
+
+
+/*
+ * Implementations;
+ */
+
+enum impl {
+
+	/*The previous byte loop;*/
+	BYTES,
+
+	/*The kernel functions;*/
+	KERNEL,
+
+	/*The host's functions;*/
+	HOST,
+
+};
+
+static const char *const impl_names[] = {"bytes", "kernel", "host"};
+
+
+/*The byte loops. Not inlined, so that they are not replaced by host calls;*/
+static void __attribute__((noinline, optimize("no-tree-loop-distribute-patterns")))
+bytes_copy(void *const dst, const void *const src, size_t size) {
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	while (size--) {
+		*(d++) = *(s++);
+	}
+}
+
+static void __attribute__((noinline, optimize("no-tree-loop-distribute-patterns")))
+bytes_set(void *const dst, const uint8_t value, size_t size) {
+	uint8_t *d = dst;
+	while (size--) {
+		*(d++) = value;
+	}
+}
+
+
+/*
+ * bench_copy : times copies of @size, at the given offsets, and reports them;
+ */
+
+static void bench_copy(const enum impl impl, const bool move, const size_t size, const size_t src_offset,
+					   const size_t dst_offset, uint8_t *const src, uint8_t *const dst) {
+
+	const size_t nb_ops = NB_BYTES / size;
+
+	const double start = host_time();
+	for (size_t i = 0; i < nb_ops; i++) {
+		switch (impl) {
+			case BYTES:
+				bytes_copy(dst + dst_offset, src + src_offset, size);
+				break;
+			case KERNEL:
+				if (move) {
+					nostd_memmove(dst + dst_offset, src + src_offset, size);
+				} else {
+					nostd_memcpy(dst + dst_offset, src + src_offset, size);
+				}
+				break;
+			default:
+				if (move) {
+					memmove(dst + dst_offset, src + src_offset, size);
+				} else {
+					memcpy(dst + dst_offset, src + src_offset, size);
+				}
+				/*Prevent the host's functions from being optimised across iterations;*/
+				__asm__ __volatile__("" : : "r" (dst) : "memory");
+				break;
+		}
+	}
+	const double duration = host_time() - start;
+
+	CHECK(!memcmp(dst + dst_offset, src + src_offset, size));
+
+	char name[64];
+	snprintf(name, sizeof(name), "%-7s %-6s %4zu B +%zu+%zu", move ? "memmove" : "memcpy", impl_names[impl], size,
+			 src_offset, dst_offset);
+	host_report(name, "ops", nb_ops, nb_ops * size, duration);
+
+}
+
+
+/*
+ * bench_set : times fills of @size, at the given offset, and reports them;
+ */
+
+static void bench_set(const enum impl impl, const size_t size, const size_t offset, uint8_t *const dst) {
+
+	const size_t nb_ops = NB_BYTES / size;
+
+	const double start = host_time();
+	for (size_t i = 0; i < nb_ops; i++) {
+		switch (impl) {
+			case BYTES:
+				bytes_set(dst + offset, (uint8_t) i, size);
+				break;
+			case KERNEL:
+				nostd_memset(dst + offset, (uint8_t) i, size);
+				break;
+			default:
+				memset(dst + offset, (uint8_t) i, size);
+				__asm__ __volatile__("" : : "r" (dst) : "memory");
+				break;
+		}
+	}
+	const double duration = host_time() - start;
+
+	CHECK(dst[offset + size - 1] == (uint8_t) (nb_ops - 1));
+
+	char name[64];
+	snprintf(name, sizeof(name), "%-7s %-6s %4zu B +%zu", "memset", impl_names[impl], size, offset);
+	host_report(name, "ops", nb_ops, nb_ops * size, duration);
+
+}
+
+
+int main() {
+
+	static uint8_t src[MAX_SIZE + 16] __attribute__((aligned(16)));
+	static uint8_t dst[MAX_SIZE + 16] __attribute__((aligned(16)));
+
+	host_seed(27);
+
+	for (size_t i = 0; i < sizeof(src); i++) {
+		src[i] = (uint8_t) host_random(256);
+	}
+
+	/*Disjoint copies;*/
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+		for (size_t o = 0; o < NB_OFFSETS; o++) {
+			for (enum impl impl = BYTES; impl <= HOST; impl++) {
+				bench_copy(impl, false, sizes[s], offsets[o][0], offsets[o][1], src, dst);
+			}
+		}
+	}
+
+	/*Backward moves, a few bytes forward in the same buffer. Only the kernel and host functions handle overlaps;*/
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+		for (size_t o = 0; o < NB_OFFSETS; o++) {
+			for (enum impl impl = KERNEL; impl <= HOST; impl++) {
+				memcpy(dst, src, sizeof(dst));
+				bench_copy(impl, true, sizes[s], offsets[o][0], offsets[o][1] + 8, dst, dst);
+			}
+		}
+	}
+
+	/*Fills;*/
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+		for (size_t o = 0; o < 2; o++) {
+			for (enum impl impl = BYTES; impl <= HOST; impl++) {
+				bench_set(impl, sizes[s], o * 3, dst);
+			}
+		}
+	}
+
+	return 0;
+
+}
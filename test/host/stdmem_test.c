@@ -0,0 +1,214 @@
+/*
+  stdmem_test.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Tests of the kernel memory functions against the host's, for all sizes up to a few words of bursts, and all
+ * 	source and destination alignments. Bytes around the destination must be left untouched;
+ */
+
+#include "host.h"
+
+#include <string.h>
+
+#include "stdmem_host.h"
+
+
+/*The maximal size of exhaustive tests, several bursts and words around each boundary;*/
+#define MAX_SIZE 160
+
+/*Alignments tested, beyond a 64 bits word;*/
+#define NB_OFFSETS 9
+
+/*Large sizes, tested at a few alignments;*/
+static const size_t large_sizes[] = {1000, 4093, 4096, 65536 + 7};
+
+#define BUFFER_SIZE (65536 + 64)
+
+
+/*The source, the destination, and the expected destination;*/
+static uint8_t src[BUFFER_SIZE] __attribute__((aligned(16)));
+static uint8_t dst[BUFFER_SIZE] __attribute__((aligned(16)));
+static uint8_t ref[BUFFER_SIZE] __attribute__((aligned(16)));
+
+
+/*
+ * fill : fills a buffer with random bytes;
+ */
+
+static void fill(uint8_t *const buffer, const size_t size) {
+	for (size_t i = 0; i < size; i++) {
+		buffer[i] = (uint8_t) host_random(256);
+	}
+}
+
+
+/*
+ * check_copy : copies @size bytes from src + @src_offset to dst + @dst_offset, and compares with the host's copy;
+ */
+
+static void check_copy(const size_t size, const size_t src_offset, const size_t dst_offset) {
+
+	/*The destination and guard bytes;*/
+	const size_t span = size + 2 * NB_OFFSETS;
+	CHECK((span > size) && (span <= BUFFER_SIZE));
+
+	/*Randomise the destination, so that guard bytes differ from the source;*/
+	fill(dst, span);
+	memcpy(ref, dst, span);
+
+	nostd_memcpy(dst + dst_offset, src + src_offset, size);
+	memcpy(ref + dst_offset, src + src_offset, size);
+
+	CHECK(!memcmp(dst, ref, span));
+
+}
+
+
+/*
+ * check_move : moves @size bytes in a buffer, from @from to @to, and compares with the host's move;
+ */
+
+static void check_move(const size_t size, const size_t from, const size_t to) {
+
+	/*The span of both blocks, and guard bytes;*/
+	const size_t span = size + from + to + NB_OFFSETS;
+	CHECK((span > size) && (span <= BUFFER_SIZE));
+
+	fill(dst, span);
+	memcpy(ref, dst, span);
+
+	nostd_memmove(dst + to, dst + from, size);
+	memmove(ref + to, ref + from, size);
+
+	CHECK(!memcmp(dst, ref, span));
+
+}
+
+
+/*
+ * check_set : sets @size bytes at dst + @offset, and compares with the host's fill;
+ */
+
+static void check_set(const size_t size, const size_t offset, const uint8_t value) {
+
+	const size_t span = size + 2 * NB_OFFSETS;
+	CHECK((span > size) && (span <= BUFFER_SIZE));
+
+	fill(dst, span);
+	memcpy(ref, dst, span);
+
+	nostd_memset(dst + offset, value, size);
+	memset(ref + offset, value, size);
+
+	CHECK(!memcmp(dst, ref, span));
+
+}
+
+
+/*
+ * test_copy : all sizes and alignments, aligned and shifted paths;
+ */
+
+static void test_copy() {
+
+	for (size_t size = 0; size <= MAX_SIZE; size++) {
+		for (size_t s = 0; s < NB_OFFSETS; s++) {
+			for (size_t d = 0; d < NB_OFFSETS; d++) {
+				check_copy(size, s, d);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < sizeof(large_sizes) / sizeof(*large_sizes); i++) {
+		check_copy(large_sizes[i], 0, 0);
+		check_copy(large_sizes[i], 3, 0);
+		check_copy(large_sizes[i], 0, 5);
+		check_copy(large_sizes[i], 7, 1);
+	}
+
+}
+
+
+/*
+ * test_move : overlaps in both directions, at all distances up to a few words, disjoint blocks are copied;
+ */
+
+static void test_move() {
+
+	for (size_t size = 0; size <= MAX_SIZE; size++) {
+		for (size_t from = 0; from < 2 * NB_OFFSETS; from++) {
+			for (size_t to = 0; to < 2 * NB_OFFSETS; to++) {
+				check_move(size, from, to);
+			}
+		}
+	}
+
+	/*Large overlapping moves, backward by words and by bytes, and a disjoint one;*/
+	for (size_t i = 0; i < sizeof(large_sizes) / sizeof(*large_sizes) - 1; i++) {
+		const size_t size = large_sizes[i];
+		check_move(size, 0, 8);
+		check_move(size, 8, 0);
+		check_move(size, 1, 12);
+		check_move(size, 13, 2);
+	}
+	check_move(1000, 0, 1010);
+
+}
+
+
+/*
+ * test_set : all sizes and alignments, with values that fill words differently;
+ */
+
+static void test_set() {
+
+	static const uint8_t values[] = {0, 0x01, 0x7f, 0xa5, 0xff};
+
+	for (size_t v = 0; v < sizeof(values); v++) {
+		for (size_t size = 0; size <= MAX_SIZE; size++) {
+			for (size_t offset = 0; offset < NB_OFFSETS; offset++) {
+				check_set(size, offset, values[v]);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < sizeof(large_sizes) / sizeof(*large_sizes); i++) {
+		check_set(large_sizes[i], 0, 0);
+		check_set(large_sizes[i], 3, 0xa5);
+	}
+
+}
+
+
+int main() {
+
+	host_seed(27);
+
+	fill(src, BUFFER_SIZE);
+
+	test_copy();
+	test_move();
+	test_set();
+
+	printf("stdmem_test : ok\n");
+
+	return 0;
+
+}
@@ -0,0 +1,33 @@
+/*
+  kx_sim.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_HOST_KX_SIM_H
+#define TRACER_HOST_KX_SIM_H
+
+/*
+ * Host replacement of the K64 system integration module. Clock gates of modelled peripherals are defined by their
+ * 	model;
+ */
+
+/*Enable the clock of the CRC module. Defined by the CRC model;*/
+void sim_enable_CRC_clock_gating();
+
+
+#endif /*TRACER_HOST_KX_SIM_H*/
@@ -0,0 +1,104 @@
+/*
+  kx_chip.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_HOST_KX_CHIP_H
+#define TRACER_HOST_KX_CHIP_H
+
+/*
+ * Host replacement of the chip definitions that kinetis drivers get from the target build : UART register bits, as
+ * 	described by the K64 reference manual, and the interrupt controller, that the UART simulator implements;
+ *
+ * 	This header is included before each source, and so includes nothing, and uses no fixed width type in prototypes.
+ * 	Its directory also resolves the nostd include of kx_uart.c, whose path is relative to the repository's parent;
+ */
+
+
+/*--------------------------------------------------- UART registers ---------------------------------------------------*/
+
+#define UART_C1_LOOPS ((uint8_t) 0x80)
+#define UART_C1_RSRC ((uint8_t) 0x20)
+#define UART_C1_M ((uint8_t) 0x10)
+#define UART_C1_PE ((uint8_t) 0x02)
+#define UART_C1_PT ((uint8_t) 0x01)
+
+#define UART_C2_TIE ((uint8_t) 0x80)
+#define UART_C2_TCIE ((uint8_t) 0x40)
+#define UART_C2_RIE ((uint8_t) 0x20)
+#define UART_C2_ILIE ((uint8_t) 0x10)
+#define UART_C2_TE ((uint8_t) 0x08)
+#define UART_C2_RE ((uint8_t) 0x04)
+
+#define UART_S1_TDRE ((uint8_t) 0x80)
+#define UART_S1_TC ((uint8_t) 0x40)
+#define UART_S1_RDRF ((uint8_t) 0x20)
+#define UART_S1_IDLE ((uint8_t) 0x10)
+#define UART_S1_OR ((uint8_t) 0x08)
+#define UART_S1_NF ((uint8_t) 0x04)
+#define UART_S1_FE ((uint8_t) 0x02)
+#define UART_S1_PF ((uint8_t) 0x01)
+
+#define UART_C3_ORIE ((uint8_t) 0x08)
+#define UART_C3_NEIE ((uint8_t) 0x04)
+#define UART_C3_FEIE ((uint8_t) 0x02)
+#define UART_C3_PEIE ((uint8_t) 0x01)
+
+#define UART_C4_M10 ((uint8_t) 0x20)
+
+#define UART_C5_TDMAS ((uint8_t) 0x80)
+#define UART_C5_RDMAS ((uint8_t) 0x20)
+
+#define UART_MODEM_RXRTSE ((uint8_t) 0x08)
+#define UART_MODEM_TXCTSE ((uint8_t) 0x01)
+
+#define UART_PFIFO_TXFE ((uint8_t) 0x80)
+#define UART_PFIFO_RXFE ((uint8_t) 0x08)
+
+#define UART_CFIFO_TXFLUSH ((uint8_t) 0x80)
+#define UART_CFIFO_RXFLUSH ((uint8_t) 0x40)
+#define UART_CFIFO_RXOFE ((uint8_t) 0x04)
+#define UART_CFIFO_TXOFE ((uint8_t) 0x02)
+#define UART_CFIFO_RXUFE ((uint8_t) 0x01)
+
+#define UART_SFIFO_TXEMPT ((uint8_t) 0x80)
+#define UART_SFIFO_RXEMPT ((uint8_t) 0x40)
+#define UART_SFIFO_RXOF ((uint8_t) 0x04)
+#define UART_SFIFO_TXOF ((uint8_t) 0x02)
+#define UART_SFIFO_RXUF ((uint8_t) 0x01)
+
+
+/*------------------------------------------------ Interrupt controller ------------------------------------------------*/
+
+/*Enable an interrupt channel;*/
+void core_IC_enable(unsigned short channel);
+
+/*Disable an interrupt channel;*/
+void core_IC_disable(unsigned short channel);
+
+/*Set the priority of an interrupt channel;*/
+void core_IC_set_priority(unsigned short channel, unsigned char priority);
+
+/*Clear the pending state of an interrupt channel;*/
+void core_IC_clear_pending(unsigned short channel);
+
+/*Set the handler of an interrupt channel;*/
+void core_IC_set_handler(unsigned short channel, void (*handler)());
+
+
+#endif /*TRACER_HOST_KX_CHIP_H*/
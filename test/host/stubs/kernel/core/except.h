@@ -0,0 +1,36 @@
+/*
+  except.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_HOST_EXCEPT_H
+#define TRACER_HOST_EXCEPT_H
+
+/*
+ * Host critical sections. Interrupts are simulated by threads or by direct calls; A critical section is a recursive
+ * 	lock, defined in host.c;
+ */
+
+/*Enter a critical section;*/
+void critical_section_enter();
+
+/*Leave a critical section;*/
+void critical_section_leave();
+
+
+#endif /*TRACER_HOST_EXCEPT_H*/
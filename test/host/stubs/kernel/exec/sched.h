@@ -0,0 +1,46 @@
+/*
+  sched.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_HOST_SCHED_H
+#define TRACER_HOST_SCHED_H
+
+/*
+ * Host replacement of the scheduler, restricted to what kernel sources use. Processes are run by the harness, that
+ * 	defines these functions;
+ */
+
+#include <stddef.h>
+
+#include <kernel/_inc/exec/prc.h>
+
+struct sched_elmt;
+
+
+/*Create a process;*/
+void sched_create_prc(struct prc_desc *desc, struct prc_req *req);
+
+/*Set the current process in the stopped state, and return its ref;*/
+struct sched_elmt *sched_stop_prc();
+
+/*Resume a process. If its stop is still pending, it is cancelled;*/
+void sched_resume_prc(struct sched_elmt *);
+
+
+#endif /*TRACER_HOST_SCHED_H*/
@@ -0,0 +1,54 @@
+/*
+  kdmem.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_HOST_KDMEM_H
+#define TRACER_HOST_KDMEM_H
+
+#include <stdlib.h>
+
+#include <string.h>
+
+
+/*
+ * Host replacement of the kernel heap : the host's heap is used. As on target, allocations return 0 on failure;
+ */
+
+static inline void *kmalloc(const size_t size) {
+	return malloc(size ? size : 1);
+}
+
+static inline void *kcalloc(const size_t size) {
+	return calloc(1, size ? size : 1);
+}
+
+static inline void *kialloc(const size_t size, const void *const init) {
+
+	/*Allocate, and copy the initializer if it succeeded;*/
+	void *const block = kmalloc(size);
+	return (block) ? memcpy(block, init, size) : 0;
+
+}
+
+static inline void kfree(void *const ptr) {
+	free(ptr);
+}
+
+
+#endif /*TRACER_HOST_KDMEM_H*/
@@ -0,0 +1,31 @@
+/*
+  crc.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_HOST_KHAL_CRC_H
+#define TRACER_HOST_KHAL_CRC_H
+
+/*
+ * The khal CRC interface is installed as khal/crc.h on target; On host, it is included from its source directory;
+ */
+
+#include <khal/_inc/crc.h>
+
+
+#endif /*TRACER_HOST_KHAL_CRC_H*/
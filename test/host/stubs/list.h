@@ -0,0 +1,65 @@
+/*
+  list.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_HOST_LIST_H
+#define TRACER_HOST_LIST_H
+
+/*
+ * Host replacement of the nostd circular doubly linked list, restricted to what kernel sources use;
+ */
+
+struct list_head {
+
+	/*The next and previous elements of the list;*/
+	struct list_head *next;
+	struct list_head *prev;
+
+};
+
+
+/*Make @head a list of one element;*/
+static inline void list_init(struct list_head *const head) {
+	head->next = head->prev = head;
+}
+
+
+/*Append the list of @second at the end of the list of @first;*/
+static inline void list_concat(struct list_head *const first, struct list_head *const second) {
+
+	/*Cache both last elements;*/
+	struct list_head *const first_last = first->prev, *const second_last = second->prev;
+
+	/*Link the last of first to second, and the last of second to first;*/
+	first_last->next = second;
+	second->prev = first_last;
+	second_last->next = first;
+	first->prev = second_last;
+
+}
+
+
+/*Remove @head from its list. Its links are not updated;*/
+static inline void list_remove(struct list_head *const head) {
+	head->prev->next = head->next;
+	head->next->prev = head->prev;
+}
+
+
+#endif /*TRACER_HOST_LIST_H*/
@@ -0,0 +1,43 @@
+/*
+  incr_call.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_HOST_INCR_CALL_H
+#define TRACER_HOST_INCR_CALL_H
+
+/*
+ * INCR_CALL(n, m) expands to m(0) m(1) ... m(n - 1). Host builds use few channels, up to 8 are supported;
+ */
+
+#define _INCR_CALL_0(m)
+#define _INCR_CALL_1(m) _INCR_CALL_0(m) m(0)
+#define _INCR_CALL_2(m) _INCR_CALL_1(m) m(1)
+#define _INCR_CALL_3(m) _INCR_CALL_2(m) m(2)
+#define _INCR_CALL_4(m) _INCR_CALL_3(m) m(3)
+#define _INCR_CALL_5(m) _INCR_CALL_4(m) m(4)
+#define _INCR_CALL_6(m) _INCR_CALL_5(m) m(5)
+#define _INCR_CALL_7(m) _INCR_CALL_6(m) m(6)
+#define _INCR_CALL_8(m) _INCR_CALL_7(m) m(7)
+
+#define _INCR_CALL(n, m) _INCR_CALL_##n(m)
+
+#define INCR_CALL(n, m) _INCR_CALL(n, m)
+
+
+#endif /*TRACER_HOST_INCR_CALL_H*/
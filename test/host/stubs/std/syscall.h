@@ -0,0 +1,61 @@
+/*
+  syscall.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_HOST_SYSCALL_H
+#define TRACER_HOST_SYSCALL_H
+
+#include <stdio.h>
+
+#include <stdlib.h>
+
+#include <string.h>
+
+
+/*
+ * Host replacement of the nostd system calls : the heap is the host's, and errors abort the test;
+ */
+
+static inline void *kernel_malloc(const size_t size) {
+
+	/*Allocate, abort if the host is out of memory;*/
+	void *const ptr = malloc(size ? size : 1);
+	if (!ptr) {
+		abort();
+	}
+
+	return ptr;
+
+}
+
+static inline void *kernel_malloc_copy(const size_t size, const void *const init) {
+	return memcpy(kernel_malloc(size), init, size);
+}
+
+static inline void kernel_free(void *const ptr) {
+	free(ptr);
+}
+
+static inline void kernel_error(const char *const msg) {
+	fprintf(stderr, "kernel_error : %s\n", msg);
+	abort();
+}
+
+
+#endif /*TRACER_HOST_SYSCALL_H*/
@@ -0,0 +1,205 @@
+/*
+  tmpfs_bench.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Benchmark of tmpfs throughput through the vfs, with 1 KB frames : sequential writes and reads of a whole file, and
+ * 	reads and writes at random positions, for several access sizes;
+ *
+ * 	Sequential accesses are served by the extent cursor. Random accesses walk extents from the cursor, or from the
+ * 	first extent when moving backward, so their cost grows with the file size;
+ */
+
+/*api.h names the resource type FILE, as stdio does;*/
+#define FILE vfs_file
+
+#include <kernel/res/fs/api.h>
+
+#undef FILE
+
+#include "host.h"
+
+#include <string.h>
+
+#include <kernel/core/ram.h>
+
+#include <kernel/exec/mod_hook>
+
+
+/*The number of bytes of each measure;*/
+#if !defined(NB_BYTES)
+
+#define NB_BYTES 1000000000
+
+#endif
+
+/*The frame size;*/
+#define FRAME_SIZE 1024
+
+/*The maximal access size;*/
+#define MAX_ACCESS 16384
+
+
+/*File sizes, in frames, up to the mount's limit, and access sizes;*/
+static const size_t file_frames[] = {16, 256, TMPFS_MAX_FRAMES};
+static const size_t access_sizes[] = {64, 1024, MAX_ACCESS};
+
+
+/*The tmpfs module;*/
+extern const struct mod_hook tmpfs;
+
+
+/*Frames are allocated in the host's heap;*/
+size_t ram_frame_size() {
+	return FRAME_SIZE;
+}
+
+void *ram_alloc_frame_region(const enum ram_region region) {
+	return malloc(FRAME_SIZE);
+}
+
+void ram_free_frame(void *const frame) {
+	free(frame);
+}
+
+
+/*
+ * bench_sequential : writes a file of @size bytes by accesses of @access bytes, and reads it, until NB_BYTES are
+ * 	transferred in each direction. The file is recreated before each write;
+ */
+
+static void bench_sequential(const size_t size, const size_t access, uint8_t *const buffer) {
+
+	const size_t nb_passes = 1 + NB_BYTES / size / 4;
+	double write_time = 0, read_time = 0;
+
+	for (size_t pass = 0; pass < nb_passes; pass++) {
+
+		CHECK(vfs_create("/f"));
+		struct resrc *const rd = vfs_open("/f");
+
+		/*Write, frames are appended;*/
+		double start = host_time();
+		for (size_t offset = 0; offset < size; offset += access) {
+			CHECK(vfs_write(rd, buffer, access) == access);
+		}
+		write_time += host_time() - start;
+
+		/*Read;*/
+		CHECK(vfs_seek(rd, 0));
+		start = host_time();
+		for (size_t offset = 0; offset < size; offset += access) {
+			CHECK(vfs_read(rd, buffer, access) == access);
+		}
+		read_time += host_time() - start;
+
+		vfs_close(rd);
+		CHECK(vfs_delete("/f"));
+
+	}
+
+	char name[64];
+	snprintf(name, sizeof(name), "seq write %5zu KB / %5zu B", size / 1024, access);
+	host_report(name, "ops", nb_passes * (size / access), nb_passes * size, write_time);
+	snprintf(name, sizeof(name), "seq read  %5zu KB / %5zu B", size / 1024, access);
+	host_report(name, "ops", nb_passes * (size / access), nb_passes * size, read_time);
+
+}
+
+
+/*
+ * bench_random : reads and overwrites a file of @size bytes at random positions, by accesses of @access bytes;
+ */
+
+static void bench_random(const size_t size, const size_t access, uint8_t *const buffer) {
+
+	const size_t nb_accesses = NB_BYTES / access / 4;
+
+	/*Create the file;*/
+	CHECK(vfs_create("/f"));
+	struct resrc *const rd = vfs_open("/f");
+	for (size_t offset = 0; offset < size; offset += access) {
+		CHECK(vfs_write(rd, buffer, access) == access);
+	}
+
+	/*Draw positions beforehand;*/
+	size_t *const offsets = malloc(nb_accesses * sizeof(size_t));
+	for (size_t i = 0; i < nb_accesses; i++) {
+		offsets[i] = host_random((uint32_t) (size - access + 1));
+	}
+
+	double start = host_time();
+	for (size_t i = 0; i < nb_accesses; i++) {
+		CHECK(vfs_seek(rd, offsets[i]));
+		CHECK(vfs_write(rd, buffer, access) == access);
+	}
+	const double write_time = host_time() - start;
+
+	start = host_time();
+	for (size_t i = 0; i < nb_accesses; i++) {
+		CHECK(vfs_seek(rd, offsets[i]));
+		CHECK(vfs_read(rd, buffer, access) == access);
+	}
+	const double read_time = host_time() - start;
+
+	free(offsets);
+	vfs_close(rd);
+	CHECK(vfs_delete("/f"));
+
+	char name[64];
+	snprintf(name, sizeof(name), "rnd write %5zu KB / %5zu B", size / 1024, access);
+	host_report(name, "ops", nb_accesses, nb_accesses * access, write_time);
+	snprintf(name, sizeof(name), "rnd read  %5zu KB / %5zu B", size / 1024, access);
+	host_report(name, "ops", nb_accesses, nb_accesses * access, read_time);
+
+}
+
+
+int main() {
+
+	static uint8_t buffer[MAX_ACCESS];
+
+	host_seed(49);
+
+	for (size_t i = 0; i < sizeof(buffer); i++) {
+		buffer[i] = (uint8_t) host_random(256);
+	}
+
+	CHECK((*(tmpfs.init))());
+	CHECK(vfs_mount("/", "tmpfs", 0));
+
+	for (size_t f = 0; f < sizeof(file_frames) / sizeof(*file_frames); f++) {
+		for (size_t a = 0; a < sizeof(access_sizes) / sizeof(*access_sizes); a++) {
+
+			const size_t size = file_frames[f] * FRAME_SIZE;
+			if (access_sizes[a] > size) {
+				continue;
+			}
+
+			bench_sequential(size, access_sizes[a], buffer);
+			bench_random(size, access_sizes[a], buffer);
+
+		}
+	}
+
+	CHECK(vfs_unmount("/"));
+
+	return 0;
+
+}
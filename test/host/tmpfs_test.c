@@ -0,0 +1,367 @@
+/*
+  tmpfs_test.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Tests of the tmpfs through the vfs. Frames are small, and extents reference a few of them, so that accesses cross
+ * 	many frame and extent boundaries. The RAM is simulated : each region provides a given number of frames, so that
+ * 	its exhaustion can be tested apart from the mount's limit;
+ */
+
+/*api.h names the resource type FILE, as stdio does;*/
+#define FILE vfs_file
+
+#include <kernel/res/fs/api.h>
+
+#undef FILE
+
+#include "host.h"
+
+#include <string.h>
+
+#include <kernel/core/ram.h>
+
+#include <kernel/exec/mod_hook>
+
+
+/*The frame size;*/
+#define FRAME_SIZE 64
+
+/*The maximal size of a file, the mount's limit;*/
+#define MAX_SIZE (TMPFS_MAX_FRAMES * FRAME_SIZE)
+
+/*The number of random accesses;*/
+#if !defined(NB_ACCESSES)
+
+#define NB_ACCESSES 100000
+
+#endif
+
+
+/*The tmpfs module;*/
+extern const struct mod_hook tmpfs;
+
+
+/*------------------------------------------------------ RAM frames ----------------------------------------------------*/
+
+/*
+ * The simulated RAM : the number of frames each region can still provide, and the number of frames in use;
+ */
+
+static struct {
+
+	/*Free frames of the upper and lower regions;*/
+	size_t upper, lower;
+
+	/*Frames allocated in each region;*/
+	size_t nb_upper, nb_lower;
+
+	/*Frames in use;*/
+	size_t nb_used;
+
+} ram;
+
+
+size_t ram_frame_size() {
+	return FRAME_SIZE;
+}
+
+void *ram_alloc_frame_region(const enum ram_region region) {
+
+	/*Cache the region's free frames;*/
+	size_t *const free_frames = (region == RAM_REGION_UPPER) ? &ram.upper : &ram.lower;
+	if (!*free_frames) {
+		return 0;
+	}
+
+	(*free_frames)--;
+	(region == RAM_REGION_UPPER) ? ram.nb_upper++ : ram.nb_lower++;
+	ram.nb_used++;
+
+	/*Frames are not cleared;*/
+	uint8_t *const frame = malloc(FRAME_SIZE);
+	memset(frame, 0xCD, FRAME_SIZE);
+	return frame;
+
+}
+
+void ram_free_frame(void *const frame) {
+	CHECK(ram.nb_used);
+	ram.nb_used--;
+	free(frame);
+}
+
+
+/*
+ * ram_set : sets the number of free frames of both regions;
+ */
+
+static void ram_set(const size_t upper, const size_t lower) {
+	ram.upper = upper;
+	ram.lower = lower;
+	ram.nb_upper = ram.nb_lower = 0;
+}
+
+
+/*--------------------------------------------------------- Tests ------------------------------------------------------*/
+
+/*The file content, and read data;*/
+static uint8_t data[MAX_SIZE + FRAME_SIZE], out[MAX_SIZE + FRAME_SIZE];
+
+
+/*
+ * file_check : reads a whole file and compares it with @size bytes of data;
+ */
+
+static void file_check(struct resrc *const rd, const size_t size) {
+
+	CHECK(vfs_seek(rd, 0));
+	CHECK(vfs_read(rd, out, sizeof(out)) == size);
+	CHECK(!memcmp(out, data, size));
+	CHECK(!vfs_read(rd, out, 1));
+
+}
+
+
+/*
+ * test_sequential : a file is written by random chunks until the mount's limit, and read back by random chunks;
+ */
+
+static void test_sequential() {
+
+	CHECK(vfs_create("/seq"));
+	struct resrc *const rd = vfs_open("/seq");
+	CHECK(rd);
+
+	/*Write until the limit. The last write is short, the next ones write nothing;*/
+	size_t size = 0;
+	while (size < MAX_SIZE) {
+		const size_t chunk = 1 + host_random(3 * FRAME_SIZE);
+		const size_t count = vfs_write(rd, data + size, chunk);
+		CHECK(count == ((size + chunk <= MAX_SIZE) ? chunk : MAX_SIZE - size));
+		size += count;
+	}
+	CHECK(!vfs_write(rd, data, 1));
+	CHECK(ram.nb_used == TMPFS_MAX_FRAMES);
+
+	/*Read back by random chunks;*/
+	CHECK(vfs_seek(rd, 0));
+	size_t offset = 0;
+	while (offset < size) {
+		const size_t count = vfs_read(rd, out + offset, 1 + host_random(3 * FRAME_SIZE));
+		CHECK(count);
+		offset += count;
+	}
+	CHECK(offset == size);
+	CHECK(!memcmp(out, data, size));
+
+	/*Positions after the end are invalid, the end is valid;*/
+	CHECK(!vfs_seek(rd, size + 1));
+	CHECK(vfs_seek(rd, size));
+	CHECK(!vfs_read(rd, out, 1));
+
+	/*Deleting the file releases its frames;*/
+	vfs_close(rd);
+	CHECK(vfs_delete("/seq"));
+	CHECK(!ram.nb_used);
+
+}
+
+
+/*
+ * test_cursor : two resources access a file at random positions, forward and backward, in the same extent and across
+ * 	extents, while one of them overwrites and appends;
+ */
+
+static void test_cursor() {
+
+	CHECK(vfs_create("/rand"));
+	struct resrc *const rds[2] = {vfs_open("/rand"), vfs_open("/rand")};
+	CHECK((rds[0]) && (rds[1]));
+
+	/*Start with a file of a few extents;*/
+	size_t size = 5 * TMPFS_EXTENT_FRAMES * FRAME_SIZE + 17;
+	CHECK(vfs_write(rds[0], data, size) == size);
+
+	for (size_t n = 0; n < NB_ACCESSES; n++) {
+
+		struct resrc *const rd = rds[host_random(2)];
+
+		/*Move to a random position;*/
+		const size_t offset = host_random((uint32_t) size + 1);
+		CHECK(vfs_seek(rd, offset));
+
+		const size_t length = host_random(3 * TMPFS_EXTENT_FRAMES * FRAME_SIZE);
+
+		switch (host_random(8)) {
+
+			/*Overwrite, and possibly append;*/
+			case 0: {
+				/*Change the content, up to the mount's limit;*/
+				for (size_t i = 0; (i < length) && (offset + i < MAX_SIZE); i++) {
+					data[offset + i] = (uint8_t) host_random(256);
+				}
+				const size_t count = vfs_write(rd, data + offset, length);
+				CHECK(count == ((offset + length <= MAX_SIZE) ? length : MAX_SIZE - offset));
+				if (offset + count > size) {
+					size = offset + count;
+				}
+				break;
+			}
+
+			/*Read, then read the following bytes, from the cursor;*/
+			default: {
+				const size_t count = vfs_read(rd, out, length);
+				CHECK(count == ((offset + length <= size) ? length : size - offset));
+				CHECK(!memcmp(out, data + offset, count));
+				const size_t next = vfs_read(rd, out, FRAME_SIZE);
+				CHECK(next == ((offset + count + FRAME_SIZE <= size) ? FRAME_SIZE : size - offset - count));
+				CHECK(!memcmp(out, data + offset + count, next));
+				break;
+			}
+
+		}
+
+	}
+
+	/*Both resources see the whole file;*/
+	file_check(rds[0], size);
+	file_check(rds[1], size);
+
+	vfs_close(rds[0]);
+	vfs_close(rds[1]);
+	CHECK(vfs_delete("/rand"));
+	CHECK(!ram.nb_used);
+
+}
+
+
+/*
+ * test_exhaustion : when the RAM is exhausted, writes are short, and the file stays consistent. The lower region is
+ * 	used when the upper one is exhausted. The mount's limit is shared by files;
+ */
+
+static void test_exhaustion() {
+
+	CHECK(vfs_create("/a"));
+	struct resrc *const rd = vfs_open("/a");
+
+	/*Five frames, three in the upper region : the write stops at the fifth frame;*/
+	ram_set(3, 2);
+	CHECK(vfs_write(rd, data, 10 * FRAME_SIZE) == 5 * FRAME_SIZE);
+	CHECK((ram.nb_upper == 3) && (ram.nb_lower == 2));
+	CHECK(!vfs_write(rd, data + 5 * FRAME_SIZE, 1));
+	file_check(rd, 5 * FRAME_SIZE);
+
+	/*Three more frames : the extent boundary is reached, the next extent is allocated without its frame;*/
+	ram_set(3 * TMPFS_EXTENT_FRAMES - 5, 0);
+	CHECK(vfs_seek(rd, 5 * FRAME_SIZE));
+	CHECK(vfs_write(rd, data + 5 * FRAME_SIZE, MAX_SIZE) == (3 * TMPFS_EXTENT_FRAMES - 5) * FRAME_SIZE);
+	CHECK(!vfs_write(rd, data, FRAME_SIZE));
+	size_t size = 3 * TMPFS_EXTENT_FRAMES * FRAME_SIZE;
+	file_check(rd, size);
+
+	/*Once frames are released, the empty extent is used, the write resumes in the middle of a frame;*/
+	ram_set(2, 0);
+	CHECK(vfs_seek(rd, size));
+	CHECK(vfs_write(rd, data + size, FRAME_SIZE / 2) == FRAME_SIZE / 2);
+	size += FRAME_SIZE / 2;
+	CHECK(vfs_write(rd, data + size, 2 * FRAME_SIZE) == FRAME_SIZE + FRAME_SIZE / 2);
+	size += FRAME_SIZE + FRAME_SIZE / 2;
+	file_check(rd, size);
+
+	/*Overwrites don't allocate frames;*/
+	ram_set(0, 0);
+	CHECK(vfs_seek(rd, 7));
+	CHECK(vfs_write(rd, data + 7, size - 7) == size - 7);
+
+	/*With RAM available, a second file is limited by the frames of the first one;*/
+	ram_set(TMPFS_MAX_FRAMES, TMPFS_MAX_FRAMES);
+	const size_t used = ram.nb_used;
+	CHECK(vfs_create("/b"));
+	struct resrc *const rd_b = vfs_open("/b");
+	CHECK(vfs_write(rd_b, data, MAX_SIZE) == (TMPFS_MAX_FRAMES - used) * FRAME_SIZE);
+	CHECK(ram.nb_used == TMPFS_MAX_FRAMES);
+
+	/*Deleting the first file lets the second one grow;*/
+	vfs_close(rd);
+	CHECK(vfs_delete("/a"));
+	CHECK(ram.nb_used == TMPFS_MAX_FRAMES - used);
+	CHECK(vfs_write(rd_b, data + (TMPFS_MAX_FRAMES - used) * FRAME_SIZE, MAX_SIZE) == used * FRAME_SIZE);
+	file_check(rd_b, MAX_SIZE);
+
+	vfs_close(rd_b);
+	CHECK(vfs_delete("/b"));
+	CHECK(!ram.nb_used);
+
+}
+
+
+/*
+ * test_tree : directories, and unmount with files left;
+ */
+
+static void test_tree() {
+
+	CHECK(vfs_create("/d"));
+	CHECK(vfs_create("/d/f"));
+	CHECK(!vfs_create("/d/f"));
+
+	/*A node with children can't be deleted;*/
+	CHECK(!vfs_delete("/d"));
+
+	struct resrc *const rd = vfs_open("/d/f");
+	CHECK(vfs_write(rd, data, 100) == 100);
+
+	/*Opened files can't be deleted, and keep the mount busy;*/
+	CHECK(!vfs_delete("/d/f"));
+	CHECK(!vfs_unmount("/"));
+	vfs_close(rd);
+
+	/*Unmount releases all frames, of all files;*/
+	CHECK(ram.nb_used);
+	CHECK(vfs_unmount("/"));
+	CHECK(!ram.nb_used);
+
+}
+
+
+int main() {
+
+	host_seed(49);
+
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = (uint8_t) host_random(256);
+	}
+
+	CHECK((*(tmpfs.init))());
+	CHECK(vfs_mount("/", "tmpfs", 0));
+
+	ram_set(4 * TMPFS_MAX_FRAMES, 0);
+
+	test_sequential();
+	test_cursor();
+	test_exhaustion();
+	test_tree();
+
+	printf("tmpfs_test : ok\n");
+
+	return 0;
+
+}
@@ -0,0 +1,176 @@
+/*
+  uart_bench.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Simulated baud rate sweep of the K64 UART driver in interrupt mode, against the UART model. UART 1 streams frames
+ * 	to UART 0, whose core is loaded : its interrupts are masked for MASK_TIME every MASK_PERIOD, and its process side
+ * 	runs at each PROCESS_PERIOD, as a scheduler tick would;
+ *
+ * 	For each baud rate and driver configuration, reports the simulated payload throughput, the line usage, rx
+ * 	interrupts per 100 received characters, overruns, and frames lost. Times are simulated, not measured;
+ */
+
+#include "host.h"
+
+#include "uart_model.h"
+
+#include <string.h>
+
+#include <kernel/res/net/protocol.h>
+
+#include <kernel/res/net/framer/cobs_framer.h>
+
+#include <kernel/res/net/framer/crc_framer.h>
+
+
+/*The number of frames of each measure;*/
+#if !defined(NB_FRAMES)
+
+#define NB_FRAMES 100
+
+#endif
+
+/*The payload size of frames;*/
+#define PAYLOAD_SIZE 48
+
+/*The receiver's interrupts are masked for MASK_TIME seconds every MASK_PERIOD;*/
+#define MASK_TIME 10e-6
+#define MASK_PERIOD 100e-6
+
+/*The receiver's process side runs every PROCESS_PERIOD seconds;*/
+#define PROCESS_PERIOD 1e-3
+
+/*The number of bits of a character : start, 8 data bits, stop;*/
+#define CHARACTER_BITS 10
+
+
+/*No protocol is attached to benchmark interfaces;*/
+bool protocol_dispatch(struct protocol_t *protocol, struct data_block *block) {
+	(void) protocol, (void) block;
+	return false;
+}
+
+
+/*
+ * Driver configurations;
+ */
+
+enum bench_mode {
+
+	/*The rx watermark stays at 1;*/
+	FIXED_WATERMARK,
+
+	/*The rx watermark adapts to traffic;*/
+	ADAPTIVE_WATERMARK,
+
+	/*The rx watermark adapts to traffic, and RTS stops the sender when the FIFO or frames run out;*/
+	FLOW_CONTROL,
+
+};
+
+static const char *const mode_names[] = {"fixed", "adaptive", "adaptive + rts"};
+
+
+/*
+ * characters : converts a duration in seconds to character times at @baudrate, rounded down;
+ */
+
+static size_t characters(const double duration, const uint32_t baudrate) {
+	return (size_t) (duration * baudrate / CHARACTER_BITS);
+}
+
+
+/*
+ * bench_uart : streams NB_FRAMES frames from UART 1 to UART 0 at @baudrate, with the driver in @mode;
+ */
+
+static void bench_uart(const uint32_t baudrate, const enum bench_mode mode) {
+
+	struct uart_transfer transfer;
+	memset(&transfer, 0, sizeof(transfer));
+
+	for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+
+		/*A UART config is a const initializer, copy it;*/
+		const struct UART_config_t config = {
+			.nb_data_bits = 8,
+			.transmission_type = FULL_DUPLEX,
+			.baudrate = baudrate,
+			.framer = crc_framer_create(cobs_framer_create(), CRC_16),
+			.max_frame_size = 64,
+			.nb_frames = 8,
+			.adaptive_watermark = (mode != FIXED_WATERMARK),
+		};
+		memcpy(transfer.config + i, &config, sizeof(config));
+
+	}
+
+	/*With flow control, UART 0 pauses reception before its frames run out, and its RTS stops UART 1;*/
+	if (mode == FLOW_CONTROL) {
+		transfer.config[0].rts_enabled = transfer.config[1].cts_enabled = true;
+		transfer.config[0].rx_watermark = 2;
+	}
+
+	/*UART 1 streams to the loaded UART 0;*/
+	transfer.nb_frames[1] = NB_FRAMES;
+	transfer.payload_size = PAYLOAD_SIZE;
+	transfer.process_period[0] = characters(PROCESS_PERIOD, baudrate);
+	transfer.process_period[1] = 1;
+
+	/*Masks shorter than a character have no effect;*/
+	if (characters(MASK_TIME, baudrate)) {
+		transfer.mask_period[0] = characters(MASK_PERIOD, baudrate);
+		transfer.mask_length[0] = characters(MASK_TIME, baudrate);
+	}
+	transfer.max_duration = 1000 * NB_FRAMES * PAYLOAD_SIZE;
+
+	uart_model_transfer(&transfer);
+
+	/*Report;*/
+	const struct netf2_stats *const stats = transfer.stats;
+	const double duration = (double) transfer.duration * CHARACTER_BITS / baudrate;
+	const size_t nb_bytes = transfer.nb_received[0] * PAYLOAD_SIZE;
+	const size_t nb_characters = transfer.models[1].nb_transmitted - transfer.models[0].nb_lost;
+
+	char name[64];
+	snprintf(name, sizeof(name), "%u baud, %s", baudrate, mode_names[mode]);
+
+	printf("%-40s %8.1f KB/s %5.1f %% line %6.1f rx irq/100 chars %4zu overruns %4zu lost frames\n",
+		   name, (double) nb_bytes / duration / 1e3,
+		   100.0 * (double) transfer.models[1].nb_transmitted / (double) transfer.duration,
+		   (nb_characters) ? 100.0 * (double) stats->hw_rx_interrupts / (double) nb_characters : 0.0,
+		   stats->hw_overruns, transfer.nb_missing[0]);
+
+}
+
+
+int main() {
+
+	static const uint32_t baudrates[] = {115200, 460800, 1000000, 2000000, 3000000, 6000000};
+
+	for (size_t i = 0; i < sizeof(baudrates) / sizeof(*baudrates); i++) {
+		for (enum bench_mode mode = FIXED_WATERMARK; mode <= FLOW_CONTROL; mode++) {
+			bench_uart(baudrates[i], mode);
+		}
+	}
+
+	return 0;
+
+}
@@ -0,0 +1,1101 @@
+/*
+  uart_model.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#define _GNU_SOURCE
+
+#include "uart_model.h"
+
+#include "host.h"
+
+#include <signal.h>
+
+#include <string.h>
+
+#include <ucontext.h>
+
+#include <sys/mman.h>
+
+#include <kx_chip.h>
+
+#include <khal/kinetis_k/std/kx_uart_n.h>
+
+#include <kernel/core/ram.h>
+
+#include <fs/iinode.h>
+
+#include <std/syscall.h>
+
+
+#if !defined(__x86_64__) || !defined(__linux__)
+
+#error "The UART model traps register accesses, and requires x86_64 Linux;"
+
+#endif
+
+
+/*The size of a register page;*/
+#define PAGE_SIZE 4096
+
+/*The number of interrupts called in a row, above which an interrupt is considered never acknowledged;*/
+#define MAX_INTERRUPTS 1000
+
+/*The trap flag of RFLAGS, that executes a single instruction;*/
+#define TRAP_FLAG 0x100
+
+/*The offset of a register in the page;*/
+#define REG(name) offsetof(struct K64_UART_registers, name)
+
+/*The offset of an eDMA control register in its page;*/
+#define DMA_REG(name) offsetof(struct K64_eDMA_registers, name)
+
+/*The number of eDMA channels of the K64;*/
+#define NB_DMA_CHANNELS 16
+
+/*Set in the CSR of a TCD when its major loop completes, cleared by CDNE;*/
+#define EDMA_TCD_CSR_DONE ((uint16_t) (1 << 7))
+
+
+/*The simulated UARTs;*/
+struct uart_model uart_models[UART_MODEL_NB_CHANNELS];
+
+/*Channels of the eDMA whose hardware requests are enabled (ERQ), and whose interrupt is requested (INT);*/
+static uint32_t dma_erq, dma_int;
+
+
+/*---------------------------------------------------- FIFOs and flags -------------------------------------------------*/
+
+/*
+ * rts_asserted : RTS allows the peer to transmit while the rx FIFO is under its watermark, if enabled;
+ */
+
+static bool rts_asserted(const struct uart_model *const model) {
+	return (!(model->values[REG(MODEM)] & UART_MODEM_RXRTSE)) || (model->rx_count < model->values[REG(RWFIFO)]);
+}
+
+
+/*
+ * compute_s1 : computes S1 from FIFO counts, watermarks, and latched flags;
+ */
+
+static uint8_t compute_s1(const struct uart_model *const model) {
+
+	uint8_t s1 = model->s1_flags;
+
+	/*TDRE : the tx FIFO is at or under its watermark;*/
+	if (model->tx_count <= model->values[REG(TWFIFO)]) {
+		s1 |= UART_S1_TDRE;
+	}
+
+	/*TC : all characters were transmitted. The shifter is not modelled;*/
+	if (!model->tx_count) {
+		s1 |= UART_S1_TC;
+	}
+
+	/*RDRF : the rx FIFO reached its watermark;*/
+	if ((model->rx_count) && (model->rx_count >= model->values[REG(RWFIFO)])) {
+		s1 |= UART_S1_RDRF;
+	}
+
+	return s1;
+
+}
+
+
+/*
+ * publish : writes the current value of each register in the page. The page must be writable;
+ */
+
+static void publish(struct uart_model *const model) {
+
+	/*Registers keep their written values;*/
+	uint8_t image[sizeof(struct K64_UART_registers)];
+	memcpy(image, model->values, sizeof(image));
+
+	/*Flags and counts are computed;*/
+	image[REG(S1)] = compute_s1(model);
+	image[REG(D)] = (model->rx_count) ? model->rx_fifo[model->rx_head] : (uint8_t) 0;
+	image[REG(TCFIFO)] = (uint8_t) model->tx_count;
+	image[REG(RCFIFO)] = (uint8_t) model->rx_count;
+	image[REG(SFIFO)] = (uint8_t) (model->sfifo_flags | ((model->tx_count) ? 0 : UART_SFIFO_TXEMPT) |
+								   ((model->rx_count) ? 0 : UART_SFIFO_RXEMPT));
+
+	memcpy((void *) model->registers, image, sizeof(image));
+
+}
+
+
+/*
+ * read_register : applies the side effects of a read;
+ */
+
+static void read_register(struct uart_model *const model, const size_t offset) {
+
+	if (offset == REG(S1)) {
+
+		/*Flags reported now will be cleared by the next D read;*/
+		model->s1_reported = model->s1_flags;
+
+	} else if (offset == REG(D)) {
+
+		/*Pop the rx FIFO. Reading it empty misaligns its pointers on target;*/
+		if (model->rx_count) {
+			model->rx_head = (model->rx_head + 1) % UART_MODEL_FIFO_SIZE;
+			model->rx_count--;
+		} else {
+			model->sfifo_flags |= UART_SFIFO_RXUF;
+			model->nb_rx_underflows++;
+		}
+
+		/*Complete the S1 - D clearing sequence;*/
+		model->s1_flags &= (uint8_t) ~model->s1_reported;
+		model->s1_reported = 0;
+
+	}
+
+}
+
+
+/*
+ * write_register : applies the side effects of a write;
+ */
+
+static void write_register(struct uart_model *const model, const size_t offset, const uint8_t value) {
+
+	switch (offset) {
+
+		case REG(D):
+
+			/*Push the tx FIFO. Writing it full loses the character;*/
+			if (model->tx_count < UART_MODEL_FIFO_SIZE) {
+				model->tx_fifo[(model->tx_head + model->tx_count) % UART_MODEL_FIFO_SIZE] = value;
+				model->tx_count++;
+			} else {
+				model->sfifo_flags |= UART_SFIFO_TXOF;
+				model->nb_tx_overflows++;
+			}
+
+			return;
+
+		case REG(CFIFO):
+
+			/*Flush bits act once, and read as zero;*/
+			if (value & UART_CFIFO_RXFLUSH) {
+				model->rx_count = 0;
+			}
+			if (value & UART_CFIFO_TXFLUSH) {
+				model->tx_count = 0;
+			}
+			model->values[offset] = (uint8_t) (value & (UART_CFIFO_RXOFE | UART_CFIFO_TXOFE | UART_CFIFO_RXUFE));
+
+			return;
+
+		case REG(SFIFO):
+
+			/*Flags are cleared by writing ones;*/
+			model->sfifo_flags &= (uint8_t) ~value;
+
+			return;
+
+		case REG(PFIFO):
+
+			/*FIFO sizes are read only : 8 entries in each direction;*/
+			model->values[offset] = (uint8_t) ((value & (UART_PFIFO_TXFE | UART_PFIFO_RXFE)) | 0x22);
+
+			return;
+
+		case REG(S1):
+		case REG(TCFIFO):
+		case REG(RCFIFO):
+
+			/*Read only;*/
+			return;
+
+		default:
+
+			/*Configuration registers keep their value;*/
+			model->values[offset] = value;
+
+			return;
+
+	}
+
+}
+
+
+/*-------------------------------------------------------- eDMA --------------------------------------------------------*/
+
+/*
+ * The eDMA control registers are trapped like UART ones : the driver uses their byte registers (SERQ, CERQ, CINT,
+ * 	CDNE) to set and clear channel bits. TCDs, DMAMUX channels and clock gates are plain memory, as they have no side
+ * 	effect : the model reads and updates TCDs as the eDMA would;
+ */
+
+/*
+ * dma_channels : decodes the channel mask of a byte register : a channel, or all of them if bit 6 is set;
+ */
+
+static uint32_t dma_channels(const uint8_t value) {
+	return (value & 0x40) ? (uint32_t) ((1 << NB_DMA_CHANNELS) - 1) : (uint32_t) 1 << (value & 0x0F);
+}
+
+
+/*
+ * dma_publish : writes ERQ and INT in the control page. The page must be writable;
+ */
+
+static void dma_publish() {
+	K64_EDMA->ERQ = dma_erq;
+	K64_EDMA->INT = dma_int;
+}
+
+
+/*
+ * dma_write_register : applies the side effects of a write to a byte register. Other registers are not modelled;
+ */
+
+static void dma_write_register(const size_t offset, const uint8_t value) {
+
+	const uint32_t channels = dma_channels(value);
+
+	switch (offset) {
+
+		case DMA_REG(SERQ):
+			dma_erq |= channels;
+			return;
+
+		case DMA_REG(CERQ):
+			dma_erq &= ~channels;
+			return;
+
+		case DMA_REG(CINT):
+			dma_int &= ~channels;
+			return;
+
+		case DMA_REG(CDNE):
+			for (uint8_t channel = 0; channel < NB_DMA_CHANNELS; channel++) {
+				if (channels & ((uint32_t) 1 << channel)) {
+					K64_EDMA_TCD(channel)->CSR &= (uint16_t) ~EDMA_TCD_CSR_DONE;
+				}
+			}
+			return;
+
+		default:
+			return;
+
+	}
+
+}
+
+
+/*
+ * dma_requested : asserts if the eDMA serves the requests of @source on @channel : clocks are enabled, the DMAMUX
+ * 	routes the source to the channel, and the channel's requests are enabled;
+ */
+
+static bool dma_requested(const uint8_t channel, const uint8_t source) {
+
+	return (*K64_EDMA_SCGC6 & SCGC6_DMAMUX) && (*K64_EDMA_SCGC7 & SCGC7_DMA) &&
+		   (*K64_DMAMUX_CHCFG(channel) == (uint8_t) (DMAMUX_CHCFG_ENBL | source)) &&
+		   (dma_erq & ((uint32_t) 1 << channel));
+
+}
+
+
+/*
+ * dma_minor_loop : completes a minor loop of @channel : counts down its major loop, and at the end of it, adjusts
+ * 	addresses, reloads the count, and disables requests if required. Interrupts are requested as configured;
+ */
+
+static void dma_minor_loop(const uint8_t channel) {
+
+	struct K64_eDMA_TCD *const tcd = K64_EDMA_TCD(channel);
+	const uint32_t mask = (uint32_t) 1 << channel;
+
+	/*Count the minor loop down, and interrupt at the half of the major loop if required;*/
+	tcd->CITER--;
+	if ((tcd->CSR & EDMA_TCD_CSR_INTHALF) && (tcd->CITER == tcd->BITER / 2)) {
+		dma_int |= mask;
+	}
+
+	/*If the major loop is not complete, nothing more to do;*/
+	if (tcd->CITER) {
+		return;
+	}
+
+	/*Apply last adjustments, reload the count, and flag the completion;*/
+	tcd->SADDR += (uint32_t) tcd->SLAST;
+	tcd->DADDR += (uint32_t) tcd->DLASTSGA;
+	tcd->CITER = tcd->BITER;
+	tcd->CSR |= EDMA_TCD_CSR_DONE;
+
+	/*Interrupt, and stop accepting requests, if required;*/
+	if (tcd->CSR & EDMA_TCD_CSR_INTMAJOR) {
+		dma_int |= mask;
+	}
+	if (tcd->CSR & EDMA_TCD_CSR_DREQ) {
+		dma_erq &= ~mask;
+	}
+
+}
+
+
+/*
+ * dma_run : lets the eDMA serve the requests of both UARTs. It is much faster than lines : requests are served until
+ * 	they are deasserted. Each minor loop moves a byte between D and RAM;
+ */
+
+static void dma_run() {
+
+	for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+
+		struct uart_model *const model = uart_models + i;
+		const uint32_t data_register = (uint32_t) (uintptr_t) &model->registers->D;
+		const uint8_t c2 = model->values[REG(C2)], c5 = model->values[REG(C5)];
+		struct K64_eDMA_TCD *tcd = K64_EDMA_TCD(model->dma_rx_channel);
+
+		/*RDRF requests the rx channel when RIE and RDMAS are set. The eDMA reads D, that pops the rx FIFO;*/
+		while ((c2 & UART_C2_RIE) && (c5 & UART_C5_RDMAS) && (compute_s1(model) & UART_S1_RDRF) &&
+			   (dma_requested(model->dma_rx_channel, model->dma_rx_source))) {
+
+			/*The TCD must read a byte from D;*/
+			CHECK((tcd->SADDR == data_register) && (!tcd->SOFF) && (tcd->NBYTES == 1));
+
+			const uint8_t data = model->rx_fifo[model->rx_head];
+			read_register(model, REG(D));
+			*(uint8_t *) (uintptr_t) tcd->DADDR = data;
+			tcd->DADDR += (uint32_t) tcd->DOFF;
+			model->nb_dma_reads++;
+			dma_minor_loop(model->dma_rx_channel);
+
+		}
+
+		tcd = K64_EDMA_TCD(model->dma_tx_channel);
+
+		/*TDRE requests the tx channel when TIE and TDMAS are set. The eDMA writes D, that pushes the tx FIFO;*/
+		while ((c2 & UART_C2_TIE) && (c5 & UART_C5_TDMAS) && (compute_s1(model) & UART_S1_TDRE) &&
+			   (dma_requested(model->dma_tx_channel, model->dma_tx_source))) {
+
+			/*The TCD must write a byte to D;*/
+			CHECK((tcd->DADDR == data_register) && (!tcd->DOFF) && (tcd->NBYTES == 1));
+
+			const uint8_t data = *(const uint8_t *) (uintptr_t) tcd->SADDR;
+			tcd->SADDR += (uint32_t) tcd->SOFF;
+			write_register(model, REG(D), data);
+			model->nb_dma_writes++;
+			dma_minor_loop(model->dma_tx_channel);
+
+		}
+
+	}
+
+}
+
+
+/*---------------------------------------------------- Access traps ----------------------------------------------------*/
+
+/*
+ * Each access faults on the register page. The fault handler publishes registers, opens the page, and sets the trap
+ * 	flag, so that the access executes alone. The trap handler then applies the side effects of the access, and
+ * 	closes the page. Accesses of volatile registers are single loads or stores, read-modify-writes are split;
+ */
+
+/*The access in progress. Accesses of the eDMA control page have no UART;*/
+static struct uart_model *access_model;
+static uint8_t *access_page;
+static size_t access_offset;
+static bool access_write;
+
+
+/*
+ * find_model : finds the UART whose page contains @address;
+ */
+
+static struct uart_model *find_model(const uint8_t *const address) {
+
+	for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+		const uint8_t *const page = (const uint8_t *) uart_models[i].registers;
+		if ((address >= page) && (address < page + sizeof(struct K64_UART_registers))) {
+			return uart_models + i;
+		}
+	}
+
+	return 0;
+
+}
+
+
+/*
+ * is_dma : asserts if @address is an eDMA control register;
+ */
+
+static bool is_dma(const uint8_t *const address) {
+	const uint8_t *const page = (const uint8_t *) K64_EDMA;
+	return (address >= page) && (address < page + sizeof(struct K64_eDMA_registers));
+}
+
+
+/*
+ * fault_handler : starts an access of the driver;
+ */
+
+static void fault_handler(int signal, siginfo_t *const info, void *const context) {
+
+	(void) signal;
+
+	/*Find the UART, or the eDMA. Other faults are real ones : restore the default action, so that the access crashes;*/
+	struct uart_model *const model = find_model(info->si_addr);
+	if ((!model) && (!is_dma(info->si_addr))) {
+		struct sigaction action = {.sa_handler = SIG_DFL};
+		sigaction(SIGSEGV, &action, 0);
+		return;
+	}
+
+	/*Save the access. The page fault error code tells writes;*/
+	ucontext_t *const uc = context;
+	access_model = model;
+	access_page = (model) ? (uint8_t *) model->registers : (uint8_t *) K64_EDMA;
+	access_offset = (size_t) ((uint8_t *) info->si_addr - access_page);
+	access_write = (bool) (uc->uc_mcontext.gregs[REG_ERR] & 2);
+
+	/*Open the page with current values, and execute the access alone;*/
+	mprotect(access_page, PAGE_SIZE, PROT_READ | PROT_WRITE);
+	if (model) {
+		model->nb_accesses++;
+		publish(model);
+	} else {
+		dma_publish();
+	}
+	uc->uc_mcontext.gregs[REG_EFL] |= TRAP_FLAG;
+
+}
+
+
+/*
+ * trap_handler : completes an access of the driver;
+ */
+
+static void trap_handler(int signal, siginfo_t *const info, void *const context) {
+
+	(void) signal, (void) info;
+
+	/*Stop single stepping;*/
+	ucontext_t *const uc = context;
+	uc->uc_mcontext.gregs[REG_EFL] &= ~TRAP_FLAG;
+
+	/*Apply the side effects of the access. eDMA reads have none;*/
+	struct uart_model *const model = access_model;
+	const uint8_t value = ((volatile uint8_t *) access_page)[access_offset];
+	if (!model) {
+		if (access_write) {
+			dma_write_register(access_offset, value);
+		}
+	} else if (access_write) {
+		write_register(model, access_offset, value);
+	} else {
+		read_register(model, access_offset);
+	}
+
+	/*Close the page;*/
+	mprotect(access_page, PAGE_SIZE, PROT_NONE);
+
+}
+
+
+/*------------------------------------------------ Interrupt controller ------------------------------------------------*/
+
+/*The number of interrupt channels of the K64;*/
+#define NB_INTERRUPTS 256
+
+/*Handlers and enabled channels;*/
+static void (*interrupt_handlers[NB_INTERRUPTS])();
+static bool interrupt_enabled[NB_INTERRUPTS];
+
+
+void core_IC_enable(const unsigned short channel) {
+	interrupt_enabled[channel] = true;
+}
+
+void core_IC_disable(const unsigned short channel) {
+	interrupt_enabled[channel] = false;
+}
+
+void core_IC_set_priority(const unsigned short channel, const unsigned char priority) {
+	(void) channel, (void) priority;
+}
+
+void core_IC_clear_pending(const unsigned short channel) {
+	(void) channel;
+}
+
+void core_IC_set_handler(const unsigned short channel, void (*const handler)()) {
+	interrupt_handlers[channel] = handler;
+}
+
+
+/*
+ * status_pending : asserts if the status interrupt of @model is requested;
+ */
+
+static bool status_pending(const struct uart_model *const model) {
+
+	const uint8_t c2 = model->values[REG(C2)], c5 = model->values[REG(C5)], s1 = compute_s1(model);
+
+	/*TDRE and RDRF request the eDMA instead if TDMAS and RDMAS are set;*/
+	return ((c2 & UART_C2_TIE) && (s1 & UART_S1_TDRE) && (!(c5 & UART_C5_TDMAS))) ||
+		   ((c2 & UART_C2_TCIE) && (s1 & UART_S1_TC)) ||
+		   ((c2 & UART_C2_RIE) && (s1 & UART_S1_RDRF) && (!(c5 & UART_C5_RDMAS))) ||
+		   ((c2 & UART_C2_ILIE) && (s1 & UART_S1_IDLE));
+
+}
+
+
+/*
+ * error_pending : asserts if the error interrupt of @model is requested;
+ */
+
+static bool error_pending(const struct uart_model *const model) {
+
+	const uint8_t c3 = model->values[REG(C3)], cfifo = model->values[REG(CFIFO)];
+	const uint8_t s1 = model->s1_flags, sfifo = model->sfifo_flags;
+
+	return ((c3 & UART_C3_ORIE) && (s1 & UART_S1_OR)) || ((c3 & UART_C3_FEIE) && (s1 & UART_S1_FE)) ||
+		   ((c3 & UART_C3_NEIE) && (s1 & UART_S1_NF)) || ((c3 & UART_C3_PEIE) && (s1 & UART_S1_PF)) ||
+		   ((cfifo & UART_CFIFO_RXOFE) && (sfifo & UART_SFIFO_RXOF)) ||
+		   ((cfifo & UART_CFIFO_TXOFE) && (sfifo & UART_SFIFO_TXOF)) ||
+		   ((cfifo & UART_CFIFO_RXUFE) && (sfifo & UART_SFIFO_RXUF));
+
+}
+
+
+/*
+ * dma_pending : asserts if the interrupt of an eDMA channel is requested and enabled;
+ */
+
+static bool dma_pending(const uint8_t channel) {
+	return (interrupt_enabled[channel]) && (dma_int & ((uint32_t) 1 << channel));
+}
+
+
+/*
+ * Call the interrupts of a UART while they are pending and enabled. Errors have the highest priority, then eDMA
+ * 	channels, whose interrupt numbers are lower than status ones;
+ */
+
+void uart_model_service(struct uart_model *const model) {
+
+	for (size_t nb_interrupts = 0;; nb_interrupts++) {
+
+		/*An interrupt that is never acknowledged would block the core;*/
+		CHECK(nb_interrupts < MAX_INTERRUPTS);
+
+		/*The eDMA runs along the core;*/
+		dma_run();
+
+		if ((interrupt_enabled[model->error_channel]) && (error_pending(model))) {
+			model->nb_error_interrupts++;
+			(*interrupt_handlers[model->error_channel])();
+		} else if (dma_pending(model->dma_rx_channel)) {
+			model->nb_dma_interrupts++;
+			(*interrupt_handlers[model->dma_rx_channel])();
+		} else if (dma_pending(model->dma_tx_channel)) {
+			model->nb_dma_interrupts++;
+			(*interrupt_handlers[model->dma_tx_channel])();
+		} else if ((interrupt_enabled[model->status_channel]) && (status_pending(model))) {
+			model->nb_status_interrupts++;
+			(*interrupt_handlers[model->status_channel])();
+		} else {
+			return;
+		}
+
+	}
+
+}
+
+
+/*-------------------------------------------------------- Lines -------------------------------------------------------*/
+
+/*
+ * receive : receives a character from the line;
+ */
+
+static void receive(struct uart_model *const model, const uint8_t data, const bool framing_error) {
+
+	/*The line is active;*/
+	model->rx_active = true;
+
+	/*If the receiver is disabled, or locked by a framing error, the character is lost;*/
+	if ((!(model->values[REG(C2)] & UART_C2_RE)) || (model->s1_flags & UART_S1_FE)) {
+		model->nb_lost++;
+		return;
+	}
+
+	/*If the FIFO is full, the character overruns it;*/
+	if (model->rx_count == UART_MODEL_FIFO_SIZE) {
+		model->s1_flags |= UART_S1_OR;
+		model->sfifo_flags |= UART_SFIFO_RXOF;
+		model->nb_lost++;
+		return;
+	}
+
+	/*Push the character, and flag it if its stop bit was wrong;*/
+	model->rx_fifo[(model->rx_head + model->rx_count) % UART_MODEL_FIFO_SIZE] = data;
+	model->rx_count++;
+	if (framing_error) {
+		model->s1_flags |= UART_S1_FE;
+	}
+
+}
+
+
+/*
+ * transmit : transmits a character to the peer, if any, and if CTS allows it;
+ *
+ * @return true if a character was transmitted;
+ */
+
+static bool transmit(struct uart_model *const model) {
+
+	/*If the transmitter is disabled, or has nothing to send, the line stays idle;*/
+	if ((!(model->values[REG(C2)] & UART_C2_TE)) || (!model->tx_count)) {
+		return false;
+	}
+
+	/*If CTS is checked and the peer deasserts RTS, wait;*/
+	if ((model->values[REG(MODEM)] & UART_MODEM_TXCTSE) && (!rts_asserted(model->peer))) {
+		model->nb_cts_stalls++;
+		return false;
+	}
+
+	/*Pop the character;*/
+	const uint8_t data = model->tx_fifo[model->tx_head];
+	model->tx_head = (model->tx_head + 1) % UART_MODEL_FIFO_SIZE;
+	model->tx_count--;
+	model->nb_transmitted++;
+
+	/*Send it, with an injected error if required. The peer samples garbage;*/
+	const bool framing_error = model->inject_framing_error;
+	receive(model->peer, (framing_error) ? (uint8_t) ~data : data, framing_error);
+	model->inject_framing_error = false;
+
+	return true;
+
+}
+
+
+/*Let a character time elapse : each transmitter sends at most one character to its peer;*/
+void uart_model_step() {
+
+	bool received[UART_MODEL_NB_CHANNELS];
+
+	/*Each transmitter feeds the receiver of its peer;*/
+	for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+		received[(size_t) (uart_models[i].peer - uart_models)] = transmit(uart_models + i);
+	}
+
+	/*A receiver that was active and received nothing for a character time detects the idle line;*/
+	for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+		struct uart_model *const model = uart_models + i;
+		if ((!received[i]) && (model->rx_active)) {
+			model->rx_active = false;
+			model->s1_flags |= UART_S1_IDLE;
+		}
+	}
+
+	/*The eDMA serves requests, even if interrupts are masked;*/
+	dma_run();
+
+}
+
+
+/*Assert if a UART has no character left to transmit;*/
+bool uart_model_tx_idle(const struct uart_model *const model) {
+	return !model->tx_count;
+}
+
+
+/*------------------------------------------------------- Channels -----------------------------------------------------*/
+
+/*
+ * Both UARTs are channels of the UART module, as kx_uart_n.c would define them. Their pages are mapped at the
+ * 	addresses of UART0 and UART1 on target, so that their hardware specs are constant. Their eDMA channels and
+ * 	request sources are those the kinetis_k module gives them;
+ */
+
+/*The register addresses of UART0 and UART1;*/
+#define UART0_REG 0x4006A000
+#define UART1_REG 0x4006B000
+
+/*The pages of eDMA TCDs, of DMAMUX channels, and of SIM clock gates, that are plain memory;*/
+#define EDMA_TCD_PAGE 0x40009000
+#define DMAMUX_PAGE 0x40021000
+#define SIM_PAGE 0x40048000
+
+/*Drivers, created by the harness;*/
+static struct K64_UART_driver_t *drivers[UART_MODEL_NB_CHANNELS];
+
+/*A clock gating register, that no one reads;*/
+static volatile uint32_t clock_gating;
+
+
+/*Define the interrupt links, the hardware specs and the channel of a UART;*/
+#define UART_MODEL_CHANNEL(i, reg)\
+	static void status_link_##i() { K64_UART_status_interrupt(drivers[i]); }\
+	static void error_link_##i() { K64_UART_error_interrupt(drivers[i]); }\
+	static void dma_rx_link_##i() { K64_UART_dma_rx_interrupt(drivers[i]); }\
+	static void dma_tx_link_##i() { K64_UART_dma_tx_interrupt(drivers[i]); }\
+	static const struct K64_UART_hw hw_specs_##i = {\
+		.registers = (struct K64_UART_registers *) (reg),\
+		.clock_frequency = UART_MODEL_CLOCK_FREQUENCY,\
+		.clock_gating_reg = &clock_gating,\
+		.clock_gating_mask = 1 << (i),\
+		.status_int_channel = 31 + 2 * (i),\
+		.error_int_channel = 32 + 2 * (i),\
+		.status_link = &status_link_##i,\
+		.error_link = &error_link_##i,\
+		.dma_rx_channel = 2 * (i),\
+		.dma_tx_channel = 2 * (i) + 1,\
+		.dma_rx_source = 2 + 2 * (i),\
+		.dma_tx_source = 3 + 2 * (i),\
+		.dma_rx_link = &dma_rx_link_##i,\
+		.dma_tx_link = &dma_tx_link_##i,\
+	};\
+	const struct channel_specs uart_##i = {\
+		.name = "uart" #i,\
+		.hw_specs = &hw_specs_##i,\
+		.driver = &drivers[i],\
+	};
+
+UART_MODEL_CHANNEL(0, UART0_REG)
+UART_MODEL_CHANNEL(1, UART1_REG)
+
+/*Channels, by index;*/
+static const struct channel_specs *const channels[UART_MODEL_NB_CHANNELS] = {&uart_0, &uart_1};
+
+
+/*
+ * map_page : maps a page at its address on target, once;
+ */
+
+static void map_page(const uintptr_t address, const int protection) {
+
+	void *const page = mmap((void *) address, PAGE_SIZE, protection, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+							-1, 0);
+	CHECK(page == (void *) address);
+
+}
+
+
+/*Map registers, install access handlers, and reset both UARTs. Drivers are deleted first if they exist;*/
+void uart_model_init() {
+
+	static bool mapped;
+
+	/*Delete existing drivers;*/
+	for (uint8_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+		uart_model_delete_driver(i);
+	}
+
+	/*Install handlers;*/
+	struct sigaction action = {.sa_flags = SA_SIGINFO};
+	action.sa_sigaction = &fault_handler;
+	CHECK(!sigaction(SIGSEGV, &action, 0));
+	action.sa_sigaction = &trap_handler;
+	CHECK(!sigaction(SIGTRAP, &action, 0));
+
+	/*Map eDMA pages once. Control registers are trapped, the others are plain memory;*/
+	if (!mapped) {
+		map_page((uintptr_t) K64_EDMA, PROT_NONE);
+		map_page(EDMA_TCD_PAGE, PROT_READ | PROT_WRITE);
+		map_page(DMAMUX_PAGE, PROT_READ | PROT_WRITE);
+		map_page(SIM_PAGE, PROT_READ | PROT_WRITE);
+		mapped = true;
+	}
+
+	/*Reset the eDMA, the DMAMUX and clock gates;*/
+	dma_erq = dma_int = 0;
+	memset((void *) EDMA_TCD_PAGE, 0, PAGE_SIZE);
+	memset((void *) DMAMUX_PAGE, 0, PAGE_SIZE);
+	memset((void *) SIM_PAGE, 0, PAGE_SIZE);
+
+	for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+
+		struct uart_model *const model = uart_models + i;
+		const struct K64_UART_hw *const specs = channels[i]->hw_specs;
+
+		/*Map the page once, at the address of the UART;*/
+		if (!model->registers) {
+			map_page((uintptr_t) specs->registers, PROT_NONE);
+		}
+
+		/*Reset the UART, and wire it to the other one;*/
+		memset(model, 0, sizeof(*model));
+		model->registers = specs->registers;
+		model->values[REG(PFIFO)] = 0x22;
+		model->values[REG(RWFIFO)] = 1;
+		model->peer = uart_models + (i + 1) % UART_MODEL_NB_CHANNELS;
+		model->status_channel = specs->status_int_channel;
+		model->error_channel = specs->error_int_channel;
+		model->dma_rx_channel = specs->dma_rx_channel;
+		model->dma_tx_channel = specs->dma_tx_channel;
+		model->dma_rx_source = specs->dma_rx_source;
+		model->dma_tx_source = specs->dma_tx_source;
+
+	}
+
+}
+
+
+/*Create the driver of a UART, as the UART module would;*/
+struct K64_UART_driver_t *uart_model_create_driver(const uint8_t channel) {
+	return drivers[channel] = K64_UART_create(channels[channel]->hw_specs);
+}
+
+
+/*Get the hardware specs of a UART;*/
+const struct K64_UART_hw *uart_model_hw_specs(const uint8_t channel) {
+	return channels[channel]->hw_specs;
+}
+
+
+/*Delete the driver of a UART;*/
+void uart_model_delete_driver(const uint8_t channel) {
+
+	struct K64_UART_driver_t *const driver = drivers[channel];
+
+	/*If the driver exists, stop its UART, and delete it;*/
+	if (driver) {
+		if (driver->iface) {
+			K64_UART_stop(driver);
+		}
+		K64_UART_delete(driver);
+		drivers[channel] = 0;
+	}
+
+}
+
+
+/*------------------------------------------------------ Transfers -----------------------------------------------------*/
+
+/*The number of character times without transmission after which a transfer is complete, beyond periods;*/
+#define QUIET_DURATION 64
+
+
+/*
+ * fill_payload : writes the payload of the frame @sequence : the sequence number, then a pattern that depends on it,
+ * 	so that losses, reorders and corruptions are detected;
+ */
+
+static void fill_payload(uint8_t *const payload, const size_t size, const size_t sequence) {
+
+	memcpy(payload, &sequence, sizeof(size_t));
+
+	for (size_t i = sizeof(size_t); i < size; i++) {
+		payload[i] = (uint8_t) (sequence * 31 + i);
+	}
+
+}
+
+
+/*
+ * process : runs the process side of a UART : verifies and returns received frames, and sends frames;
+ */
+
+static void process(struct uart_transfer *const transfer, const size_t channel, size_t *const nb_sent) {
+
+	struct netf2 *const l2 = (struct netf2 *) drivers[channel]->iface;
+	const size_t size = transfer->payload_size;
+	uint8_t expected[size];
+	struct data_block *block;
+
+	/*Verify received frames. Missing frames are counted, others must be intact and in order;*/
+	while ((block = netf2_borrow_rx_frame(l2))) {
+
+		/*Get the sequence number, and count the frames missing before it;*/
+		size_t sequence;
+		CHECK(block->size == size);
+		memcpy(&sequence, block->address, sizeof(size_t));
+		const size_t next = transfer->nb_received[channel] + transfer->nb_missing[channel];
+		CHECK(sequence >= next);
+		transfer->nb_missing[channel] += sequence - next;
+		transfer->nb_received[channel]++;
+
+		/*Verify the content;*/
+		fill_payload(expected, size, sequence);
+		CHECK(!memcmp(block->address, expected, size));
+
+		netf2_return_rx_frame(l2, block);
+
+	}
+
+	/*Send as many frames as possible;*/
+	while ((*nb_sent < transfer->nb_frames[channel]) && (block = netf2_borrow_tx_frame(l2))) {
+		fill_payload(block->address, size, (*nb_sent)++);
+		block->size = size;
+		CHECK(netf2_commit_tx_frame(l2, block));
+	}
+
+}
+
+
+/*
+ * sample_quotas : updates the peaks of frames held by pooled interfaces;
+ */
+
+static void sample_quotas(struct uart_transfer *const transfer) {
+
+	size_t drawn = 0;
+
+	for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+
+		const struct netf2 *const l2 = (const struct netf2 *) drivers[i]->iface;
+
+		/*Private frames have no quota;*/
+		if (!l2->pooled) {
+			continue;
+		}
+
+		const size_t rx_held = l2->rx_quota.held, tx_held = l2->tx_quota.held;
+		if (rx_held > transfer->peak_rx_held[i]) {
+			transfer->peak_rx_held[i] = rx_held;
+		}
+		if (tx_held > transfer->peak_tx_held[i]) {
+			transfer->peak_tx_held[i] = tx_held;
+		}
+		drawn += rx_held - l2->rx_quota.min + tx_held - l2->tx_quota.min;
+
+	}
+
+	if (drawn > transfer->peak_drawn) {
+		transfer->peak_drawn = drawn;
+	}
+
+}
+
+
+/*Run a transfer. Aborts if a frame is received corrupted or out of order;*/
+void uart_model_transfer(struct uart_transfer *const transfer) {
+
+	size_t nb_sent[UART_MODEL_NB_CHANNELS] = {0};
+	size_t quiet = 0;
+
+	/*Lines may stay quiet until the process side or interrupts run again;*/
+	size_t quiet_duration = QUIET_DURATION;
+	for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+		quiet_duration += transfer->process_period[i] + transfer->mask_length[i];
+	}
+
+	/*Reset UARTs, and start them;*/
+	uart_model_init();
+	for (uint8_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+		CHECK(K64_UART_start(uart_model_create_driver(i), &transfer->config[i]));
+	}
+
+	for (size_t time = 0; time < transfer->max_duration; time++) {
+
+		bool complete = true;
+
+		for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+
+			struct uart_model *const model = uart_models + i;
+
+			/*Run the process side periodically;*/
+			if ((transfer->process_period[i]) && (!(time % transfer->process_period[i]))) {
+				process(transfer, i, nb_sent + i);
+			}
+
+			/*Inject framing errors periodically;*/
+			const size_t error_period = transfer->error_period[i];
+			if ((error_period) && (model->nb_transmitted % error_period == error_period - 1) &&
+				(!model->inject_framing_error) && (model->tx_count)) {
+				model->inject_framing_error = true;
+				transfer->nb_injected[i]++;
+			}
+
+			/*The transfer is complete when all frames were sent;*/
+			complete &= (nb_sent[i] == transfer->nb_frames[i]);
+
+		}
+
+		/*Sample pooled frames;*/
+		sample_quotas(transfer);
+
+		/*Let a character time elapse;*/
+		const size_t transmitted = uart_models[0].nb_transmitted + uart_models[1].nb_transmitted;
+		uart_model_step();
+
+		/*Service interrupts that are not masked;*/
+		for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+			if ((!transfer->mask_period[i]) || (time % transfer->mask_period[i] >= transfer->mask_length[i])) {
+				uart_model_service(uart_models + i);
+			}
+		}
+
+		/*Once all frames were sent, stop when lines stay quiet. The transfer ends with the last character;*/
+		if (uart_models[0].nb_transmitted + uart_models[1].nb_transmitted != transmitted) {
+			transfer->duration = time + 1;
+			quiet = 0;
+		} else if ((complete) && (++quiet == quiet_duration)) {
+			break;
+		}
+
+	}
+
+	/*Receive the last frames, and count frames that never arrived;*/
+	for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+		process(transfer, i, nb_sent + i);
+		transfer->nb_missing[i] = transfer->nb_frames[(i + 1) % UART_MODEL_NB_CHANNELS] - transfer->nb_received[i];
+	}
+
+	/*Save results, and delete drivers;*/
+	for (uint8_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+		netf21_get_stats((struct netf21 *) drivers[i]->iface, transfer->stats + i);
+		transfer->models[i] = uart_models[i];
+		uart_model_delete_driver(i);
+	}
+
+}
+
+
+/*---------------------------------------------------- Kernel stubs ----------------------------------------------------*/
+
+/*
+ * The driver allocates RAM frames in DMA mode only, and registers files from its module init, that the harness does
+ * 	not call. eDMA addresses are 32 bits : frames are mapped in the low 4GB;
+ */
+
+size_t ram_frame_size() {
+	return 1024;
+}
+
+void *ram_alloc_frame_attr(const enum ram_attr attr) {
+	(void) attr;
+	void *const frame = mmap(0, ram_frame_size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT,
+							 -1, 0);
+	CHECK(frame != MAP_FAILED);
+	return frame;
+}
+
+void ram_free_frame(void *const frame) {
+	munmap(frame, ram_frame_size());
+}
+
+void fs_create(const char *const name, struct iinode *const node) {
+	(void) name, (void) node;
+}
@@ -0,0 +1,209 @@
+/*
+  uart_model.h Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TRACER_HOST_UART_MODEL_H
+#define TRACER_HOST_UART_MODEL_H
+
+#include <stdbool.h>
+
+#include <stdint.h>
+
+#include <stddef.h>
+
+#include <khal/kinetis_k/std/kx_uart.h>
+
+
+/*
+ * Behavioural model of two K64 UARTs, wired to each other : the tx line of each one is the rx line of the other, and
+ * 	RTS of each one is CTS of the other. The unmodified kx_uart.c driver runs against them;
+ *
+ * 	Each UART's registers live in an inaccessible page. Each access of the driver faults : the model publishes the
+ * 	current register values, lets the access execute alone, and applies its side effects : reading D pops the rx
+ * 	FIFO, and clears flags reported by the previous S1 read, writing D pushes the tx FIFO, CFIFO flushes, SFIFO flags
+ * 	are cleared by writing ones. Accesses are so seen exactly as the hardware would;
+ *
+ * 	The model implements :
+ * 	- 8 entries rx and tx FIFOs, and their watermarks (RWFIFO, TWFIFO), that drive RDRF and TDRE;
+ * 	- the idle line flag, set after a character time without reception that follows a reception;
+ * 	- rx overruns (OR, RXOF), rx underflows (RXUF) and tx overflows (TXOF);
+ * 	- framing errors, injected by the harness : the faulty byte is received corrupted, and FE locks the receiver until
+ * 		cleared;
+ * 	- RTS (deasserted when the rx FIFO reaches its watermark) and CTS (checked before each transmission);
+ * 	- status and error interrupts, that are called when enabled and pending, through the interrupt controller;
+ * 	- DMA requests (RDMAS, TDMAS), served by a model of the eDMA and the DMAMUX : routed channels with enabled
+ * 		requests move a byte per minor loop between D and RAM, follow their TCD through the major loop, and raise
+ * 		their half and major interrupts, through the interrupt controller too;
+ *
+ * 	Time is counted in character times : uart_model_step transfers at most one character on each line. The harness
+ * 	decides when interrupts are serviced, and so the interrupt latency, and converts character times to seconds at
+ * 	the baud rate it simulates. The eDMA is not masked with interrupts : it serves requests at each step, and before
+ * 	each interrupt;
+ */
+
+
+/*The number of simulated UARTs;*/
+#define UART_MODEL_NB_CHANNELS 2
+
+/*The size of FIFOs, as UART0 and UART1 of the K64;*/
+#define UART_MODEL_FIFO_SIZE 8
+
+/*The clock frequency of simulated UARTs;*/
+#define UART_MODEL_CLOCK_FREQUENCY 60000000
+
+
+/*
+ * A simulated UART;
+ */
+
+struct uart_model {
+
+	/*The register page, accessed by the driver only;*/
+	struct K64_UART_registers *registers;
+
+	/*The value of each register, as written by the driver. Flags and counts are computed;*/
+	uint8_t values[sizeof(struct K64_UART_registers)];
+
+	/*The rx and tx FIFOs;*/
+	uint8_t rx_fifo[UART_MODEL_FIFO_SIZE], tx_fifo[UART_MODEL_FIFO_SIZE];
+	size_t rx_head, rx_count, tx_head, tx_count;
+
+	/*Latched S1 flags (IDLE, OR, NF, FE, PF), and those reported by the last S1 read, cleared by the next D read;*/
+	uint8_t s1_flags, s1_reported;
+
+	/*Latched SFIFO flags (RXOF, TXOF, RXUF);*/
+	uint8_t sfifo_flags;
+
+	/*Set if a character was received since the line was last detected idle;*/
+	bool rx_active;
+
+	/*Set if the next character transmitted must be received with a framing error;*/
+	bool inject_framing_error;
+
+	/*The UART at the other end of the lines;*/
+	struct uart_model *peer;
+
+	/*Interrupt channels;*/
+	uint8_t status_channel, error_channel;
+
+	/*eDMA channels, and their DMAMUX request sources;*/
+	uint8_t dma_rx_channel, dma_tx_channel, dma_rx_source, dma_tx_source;
+
+	/*Characters transmitted, characters lost by the receiver, and steps where CTS stopped the transmitter;*/
+	size_t nb_transmitted, nb_lost, nb_cts_stalls;
+
+	/*Unexpected accesses : reads of an empty rx FIFO, and writes to a full tx FIFO;*/
+	size_t nb_rx_underflows, nb_tx_overflows;
+
+	/*Register accesses, and interrupts called;*/
+	size_t nb_accesses, nb_status_interrupts, nb_error_interrupts;
+
+	/*Characters moved by the eDMA from and to D, and DMA interrupts called;*/
+	size_t nb_dma_reads, nb_dma_writes, nb_dma_interrupts;
+
+};
+
+
+/*The simulated UARTs;*/
+extern struct uart_model uart_models[UART_MODEL_NB_CHANNELS];
+
+
+/*Map registers, install access handlers, and reset both UARTs. Drivers are deleted first if they exist;*/
+void uart_model_init();
+
+/*Create the driver of a UART, as the UART module would;*/
+struct K64_UART_driver_t *uart_model_create_driver(uint8_t channel);
+
+/*Delete the driver of a UART;*/
+void uart_model_delete_driver(uint8_t channel);
+
+/*Get the hardware specs of a UART;*/
+const struct K64_UART_hw *uart_model_hw_specs(uint8_t channel);
+
+/*Let a character time elapse : each transmitter sends at most one character to its peer;*/
+void uart_model_step();
+
+/*Call the interrupts of a UART and of its eDMA channels while they are pending and enabled. Aborts if they never stop;*/
+void uart_model_service(struct uart_model *model);
+
+/*Assert if a UART has no character left to transmit;*/
+bool uart_model_tx_idle(const struct uart_model *model);
+
+
+/*
+ * A transfer : each UART is started with its configuration, and sends frames to the other one, that verifies them.
+ * 	The process side of each UART runs periodically, and its interrupts may be masked periodically, to simulate
+ * 	the interrupt latency of a loaded core;
+ *
+ * 	Fields before results are set by the caller. Periods and lengths are in character times, null periods disable;
+ */
+
+struct uart_transfer {
+
+	/*The configuration of each UART. Framers are owned by the transfer;*/
+	struct UART_config_t config[UART_MODEL_NB_CHANNELS];
+
+	/*The number of frames sent by each UART, and their payload size;*/
+	size_t nb_frames[UART_MODEL_NB_CHANNELS];
+	size_t payload_size;
+
+	/*The period of each UART's process side, that sends and receives frames;*/
+	size_t process_period[UART_MODEL_NB_CHANNELS];
+
+	/*Each UART's interrupts are masked for a length every period;*/
+	size_t mask_period[UART_MODEL_NB_CHANNELS];
+	size_t mask_length[UART_MODEL_NB_CHANNELS];
+
+	/*Each UART's transmitter sends a character with a framing error every period;*/
+	size_t error_period[UART_MODEL_NB_CHANNELS];
+
+	/*The maximal duration;*/
+	size_t max_duration;
+
+
+	/*Results : frames received in order, and missing, by each UART;*/
+	size_t nb_received[UART_MODEL_NB_CHANNELS];
+	size_t nb_missing[UART_MODEL_NB_CHANNELS];
+
+	/*Framing errors injected by each UART's transmitter;*/
+	size_t nb_injected[UART_MODEL_NB_CHANNELS];
+
+	/*The statistics of each UART's interface;*/
+	struct netf2_stats stats[UART_MODEL_NB_CHANNELS];
+
+	/*With pooled frames, the most frames held in each direction by each UART, and the most frames drawn beyond
+	 * reservations by both UARTs;*/
+	size_t peak_rx_held[UART_MODEL_NB_CHANNELS];
+	size_t peak_tx_held[UART_MODEL_NB_CHANNELS];
+	size_t peak_drawn;
+
+	/*The state of each UART's model at the end;*/
+	struct uart_model models[UART_MODEL_NB_CHANNELS];
+
+	/*The duration of the transfer, up to its last character;*/
+	size_t duration;
+
+};
+
+
+/*Run a transfer. Aborts if a frame is received corrupted or out of order;*/
+void uart_model_transfer(struct uart_transfer *transfer);
+
+
+#endif /*TRACER_HOST_UART_MODEL_H*/
@@ -0,0 +1,577 @@
+/*
+  uart_test.c Part of TRACER
+
+  Copyright (c) 2018 Raphaël Outhier
+
+  TRACER is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  TRACER is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  aint32_t with TRACER.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Tests of the K64 UART driver in interrupt and DMA modes, against the UART model. Two UARTs exchange frames in both
+ * 	directions, framed by COBS and checked by a CRC16, so that corrupted frames are dropped, not delivered;
+ *
+ * 	Each test verifies the delivery of frames, and the statistics of the driver against the events the model saw.
+ * 	Tests that do not depend on the mode run in both;
+ */
+
+#include "host.h"
+
+#include "uart_model.h"
+
+#include <string.h>
+
+#include <kernel/res/net/protocol.h>
+
+#include <kernel/res/net/framer/cobs_framer.h>
+
+#include <kernel/res/net/framer/crc_framer.h>
+
+#include <kernel/res/net/frame_pool.h>
+
+
+/*The number of frames sent by each UART in each test;*/
+#define NB_FRAMES 200
+
+/*The payload size of frames;*/
+#define PAYLOAD_SIZE 48
+
+/*The maximal duration of a test, in character times;*/
+#define MAX_DURATION 1000000
+
+/*The size of the driver's rx DMA buffer, K64_UART_DMA_RX_SIZE by default;*/
+#define DMA_RX_SIZE 512
+
+
+/*Set if transfers use DMA;*/
+static bool dma_mode;
+
+
+/*No protocol is attached to test interfaces;*/
+bool protocol_dispatch(struct protocol_t *protocol, struct data_block *block) {
+	(void) protocol, (void) block;
+	return false;
+}
+
+
+/*
+ * transfer_init : initialises a transfer of NB_FRAMES frames in each direction, with the default configuration;
+ */
+
+static void transfer_init(struct uart_transfer *const transfer) {
+
+	memset(transfer, 0, sizeof(*transfer));
+
+	for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+
+		/*A UART config is a const initializer, copy it;*/
+		const struct UART_config_t config = {
+			.nb_data_bits = 8,
+			.transmission_type = FULL_DUPLEX,
+			.baudrate = 115200,
+			.framer = crc_framer_create(cobs_framer_create(), CRC_16),
+			.max_frame_size = 64,
+			.nb_frames = 8,
+			.dma_enabled = dma_mode,
+		};
+		memcpy(transfer->config + i, &config, sizeof(config));
+
+		transfer->nb_frames[i] = NB_FRAMES;
+		transfer->process_period[i] = 16;
+
+	}
+
+	transfer->payload_size = PAYLOAD_SIZE;
+	transfer->max_duration = MAX_DURATION;
+
+}
+
+
+/*
+ * check_clean : verifies that all frames were delivered, and that no error occurred;
+ */
+
+static void check_clean(const struct uart_transfer *const transfer) {
+
+	for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+
+		const struct netf2_stats *const stats = transfer->stats + i;
+		const struct uart_model *const model = transfer->models + i;
+
+		/*All frames were received;*/
+		CHECK(transfer->nb_received[i] == NB_FRAMES);
+		CHECK(!transfer->nb_missing[i]);
+
+		/*No error occurred;*/
+		CHECK(!stats->hw_overruns);
+		CHECK(!stats->hw_framing_errors);
+		CHECK(!stats->rx_framer_drops);
+		CHECK(!stats->rx_lost_bytes);
+		CHECK(!model->nb_lost);
+
+		/*The driver never wrote a full tx FIFO;*/
+		CHECK(!model->nb_tx_overflows);
+
+	}
+
+}
+
+
+/*------------------------------------------------------- Tests --------------------------------------------------------*/
+
+/*
+ * test_fixed_watermark : the rx watermark stays at 1 : each received character raises an interrupt;
+ */
+
+static void test_fixed_watermark(struct uart_transfer *const transfer) {
+
+	transfer_init(transfer);
+	uart_model_transfer(transfer);
+	check_clean(transfer);
+
+	/*Characters are read one by one, and never read from an empty FIFO;*/
+	for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+		CHECK(transfer->stats[i].hw_rx_interrupts >= transfer->models[(i + 1) % 2].nb_transmitted / 2);
+		CHECK(!transfer->models[i].nb_rx_underflows);
+	}
+
+}
+
+
+/*
+ * test_adaptive_watermark : the rx watermark adapts to traffic. Interrupts drop, and the idle line delivers the end
+ * 	of frames that stay under the watermark;
+ */
+
+static void test_adaptive_watermark(const struct uart_transfer *const fixed) {
+
+	struct uart_transfer transfer;
+	transfer_init(&transfer);
+	transfer.config[0].adaptive_watermark = transfer.config[1].adaptive_watermark = true;
+	uart_model_transfer(&transfer);
+	check_clean(&transfer);
+
+	for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+
+		/*Characters are read by bursts;*/
+		CHECK(transfer.stats[i].hw_rx_interrupts * 3 < fixed->stats[i].hw_rx_interrupts);
+
+		/*Idle lines were processed;*/
+		CHECK(transfer.stats[i].hw_idle_interrupts);
+
+	}
+
+}
+
+
+/*
+ * test_overrun : the receiver's interrupts are masked longer than its FIFO lasts, without flow control. The overrun
+ * 	is counted, the FIFO is flushed, and reception goes on;
+ */
+
+static void test_overrun() {
+
+	struct uart_transfer transfer;
+	transfer_init(&transfer);
+
+	/*UART 1 sends, its interrupts are never masked. UART 0 misses 3 FIFOs every 400 character times;*/
+	transfer.nb_frames[0] = 0;
+	transfer.mask_period[0] = 400;
+	transfer.mask_length[0] = 3 * UART_MODEL_FIFO_SIZE;
+	uart_model_transfer(&transfer);
+
+	const struct netf2_stats *const stats = transfer.stats;
+	const struct uart_model *const model = transfer.models;
+
+	/*Overruns were detected and counted;*/
+	CHECK(model->nb_lost);
+	CHECK(stats->hw_overruns);
+	CHECK(stats->hw_overruns <= model->nb_lost);
+
+	/*Frames were lost, but reception recovered after each overrun : most frames were received;*/
+	CHECK(transfer.nb_missing[0]);
+	CHECK(transfer.nb_received[0] > NB_FRAMES / 2);
+	CHECK(stats->rx_framer_drops);
+
+}
+
+
+/*
+ * test_flow_control : same masking, with RTS and CTS enabled : the sender waits, and no character is lost;
+ */
+
+static void test_flow_control() {
+
+	struct uart_transfer transfer;
+	transfer_init(&transfer);
+
+	transfer.nb_frames[0] = 0;
+	transfer.mask_period[0] = 400;
+	transfer.mask_length[0] = 3 * UART_MODEL_FIFO_SIZE;
+	transfer.config[0].rts_enabled = transfer.config[1].cts_enabled = true;
+	transfer.config[0].adaptive_watermark = true;
+	transfer.nb_frames[0] = NB_FRAMES;
+	uart_model_transfer(&transfer);
+	check_clean(&transfer);
+
+	/*The sender waited. In DMA mode, the eDMA empties the FIFO while interrupts are masked, RTS stays asserted;*/
+	CHECK((dma_mode) || (transfer.models[1].nb_cts_stalls));
+
+}
+
+
+/*
+ * test_slow_process : the receiving process returns frames rarely. Reception is throttled before frames run out, and
+ * 	RTS stops the sender, so that no character is lost;
+ */
+
+static void test_slow_process() {
+
+	struct uart_transfer transfer;
+	transfer_init(&transfer);
+
+	transfer.process_period[0] = 2000;
+	transfer.config[0].rts_enabled = transfer.config[1].cts_enabled = true;
+	transfer.config[0].rx_watermark = 2;
+	uart_model_transfer(&transfer);
+	check_clean(&transfer);
+
+	/*Reception was throttled, and the sender waited;*/
+	CHECK(transfer.stats[0].rx_throttles);
+	CHECK(transfer.models[1].nb_cts_stalls);
+
+}
+
+
+/*
+ * test_pooled_bursts : both UARTs draw their frames from the shared pool, and their processes are slow, so that both
+ * 	directions of both interfaces burst up to their cap. Their margins are less than their caps : interfaces draw
+ * 	against each other, flow control absorbs the shortage, and no character is lost;
+ */
+
+static void test_pooled_bursts() {
+
+	struct uart_transfer transfer;
+	transfer_init(&transfer);
+
+	for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+		transfer.config[i].shared_frames = true;
+		transfer.config[i].min_frames = 2;
+		transfer.config[i].rts_enabled = transfer.config[i].cts_enabled = true;
+		transfer.config[i].rx_watermark = 2;
+		transfer.process_period[i] = 1500 + 500 * i;
+	}
+
+	uart_model_transfer(&transfer);
+	check_clean(&transfer);
+
+	/*Each interface burst above its reservation, never above its cap;*/
+	const size_t cap = transfer.config[0].nb_frames, min = transfer.config[0].min_frames;
+	for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+		CHECK(transfer.peak_rx_held[i] > min);
+		CHECK(transfer.peak_rx_held[i] <= cap);
+		CHECK(transfer.peak_tx_held[i] <= cap);
+		CHECK(transfer.stats[i].rx_throttles);
+	}
+
+	/*Frames drawn never exceeded the margins both interfaces provisioned;*/
+	CHECK(transfer.peak_drawn <= UART_MODEL_NB_CHANNELS * (cap - min));
+
+	/*Deleted interfaces withdrew their share;*/
+	CHECK(!frame_pool_available(transfer.config[0].max_frame_size));
+
+}
+
+
+/*
+ * test_pool_config : configurations that the pool can't serve fail the start, rather than the kernel;
+ */
+
+static void test_pool_config() {
+
+	struct uart_transfer transfer;
+	transfer_init(&transfer);
+	struct UART_config_t *const config = transfer.config;
+
+	uart_model_init();
+	struct K64_UART_driver_t *const driver = uart_model_create_driver(0);
+	config->shared_frames = true;
+
+	/*A reservation above the cap;*/
+	config->min_frames = config->nb_frames + 1;
+	CHECK(!K64_UART_start(driver, config));
+	CHECK(!driver->iface);
+
+	/*Frames larger than all classes;*/
+	config->min_frames = 1;
+	config->max_frame_size = (size_t) FRAME_POOL_MIN_SIZE << FRAME_POOL_NB_CLASSES;
+	CHECK(!K64_UART_start(driver, config));
+
+	/*A reservation without margin, that the pool can always serve;*/
+	config->min_frames = config->nb_frames;
+	config->max_frame_size = 64;
+	CHECK(K64_UART_start(driver, config));
+	uart_model_delete_driver(0);
+	CHECK(!frame_pool_available(64));
+
+}
+
+
+/*
+ * test_framing_errors : characters are received with framing errors. Each one is counted, its frame is dropped, and
+ * 	the receiver is unlocked;
+ */
+
+static void test_framing_errors() {
+
+	struct uart_transfer transfer;
+	transfer_init(&transfer);
+
+	/*UART 1 corrupts a character every 500;*/
+	transfer.nb_frames[0] = 0;
+	transfer.error_period[1] = 500;
+	uart_model_transfer(&transfer);
+
+	const struct netf2_stats *const stats = transfer.stats;
+	const size_t injected = transfer.nb_injected[1];
+
+	/*Each error was counted;*/
+	CHECK(injected);
+	CHECK(stats->hw_framing_errors == injected);
+
+	/*An error corrupts at most two frames. No frame was lost otherwise;*/
+	CHECK(transfer.nb_missing[0]);
+	CHECK(transfer.nb_missing[0] <= 2 * injected);
+	CHECK(!stats->hw_overruns);
+
+}
+
+
+/*
+ * test_trailer_reserve : a frame that leaves no space for the CRC trailer is rejected at commit, and its block goes
+ * 	back to the interface;
+ */
+
+static void test_trailer_reserve() {
+
+	struct uart_transfer transfer;
+	transfer_init(&transfer);
+
+	uart_model_init();
+	struct K64_UART_driver_t *const driver = uart_model_create_driver(0);
+	CHECK(K64_UART_start(driver, transfer.config));
+	struct netf2 *const l2 = &driver->iface->iface.iface;
+
+	/*The usable size excludes the CRC;*/
+	CHECK(netf2_tx_capacity(l2) == transfer.config[0].max_frame_size - 2);
+
+	/*A full frame is cancelled, all blocks can still be borrowed;*/
+	struct data_block *block = netf2_borrow_tx_frame(l2);
+	block->size = block->max_size;
+	CHECK(!netf2_commit_tx_frame(l2, block));
+	for (size_t i = 0; i < transfer.config[0].nb_frames; i++) {
+		CHECK((block = netf2_borrow_tx_frame(l2)));
+		netf2_cancel_tx_frame(l2, block);
+	}
+
+	/*A frame of the usable size is queued;*/
+	block = netf2_borrow_tx_frame(l2);
+	block->size = netf2_tx_capacity(l2);
+	CHECK(netf2_commit_tx_frame(l2, block));
+
+	uart_model_delete_driver(0);
+
+}
+
+
+/*------------------------------------------------------ DMA mode ------------------------------------------------------*/
+
+/*
+ * test_dma_requests : every character goes through the eDMA. The core is interrupted per half of the rx buffer, per
+ * 	staging buffer, and per idle line, never per character;
+ */
+
+static void test_dma_requests() {
+
+	struct uart_transfer transfer;
+	transfer_init(&transfer);
+	uart_model_transfer(&transfer);
+	check_clean(&transfer);
+
+	for (size_t i = 0; i < UART_MODEL_NB_CHANNELS; i++) {
+
+		const struct netf2_stats *const stats = transfer.stats + i;
+		const struct uart_model *const model = transfer.models + i;
+		const size_t received = transfer.models[(i + 1) % 2].nb_transmitted;
+
+		/*The eDMA moved all characters;*/
+		CHECK(model->nb_dma_reads == received);
+		CHECK(model->nb_dma_writes == model->nb_transmitted);
+
+		/*Rx interrupts are raised at each half of the buffer. Status interrupts only report idle lines;*/
+		CHECK(stats->hw_rx_interrupts == received / (DMA_RX_SIZE / 2));
+		CHECK(stats->hw_idle_interrupts);
+		CHECK(model->nb_status_interrupts == stats->hw_idle_interrupts);
+
+		/*Tx interrupts are raised per staging buffer, that contains one frame or more;*/
+		CHECK(stats->hw_tx_interrupts <= NB_FRAMES);
+		CHECK(model->nb_dma_interrupts == stats->hw_rx_interrupts + stats->hw_tx_interrupts);
+
+	}
+
+}
+
+
+/*
+ * test_dma_latency : the receiver's interrupts are masked longer than its FIFO lasts, as test_overrun does. The eDMA
+ * 	empties the FIFO meanwhile : nothing is lost;
+ */
+
+static void test_dma_latency() {
+
+	struct uart_transfer transfer;
+	transfer_init(&transfer);
+
+	transfer.mask_period[0] = 400;
+	transfer.mask_length[0] = 3 * UART_MODEL_FIFO_SIZE;
+	uart_model_transfer(&transfer);
+	check_clean(&transfer);
+
+}
+
+
+/*
+ * test_dma_overrun : the receiver's interrupts are masked for a whole rx buffer : the eDMA laps the reader. The
+ * 	overrun is detected when the half interrupt is serviced, unread bytes are dropped, and reception goes on;
+ *
+ * 	The mask does not exceed the buffer, so that the interrupt is serviced less than a buffer after its boundary, as
+ * 	the driver requires to rebuild its counts;
+ */
+
+static void test_dma_overrun() {
+
+	struct uart_transfer transfer;
+	transfer_init(&transfer);
+
+	/*UART 1 sends, its interrupts are never masked. UART 0 misses a buffer every 2000 character times;*/
+	transfer.nb_frames[0] = 0;
+	transfer.mask_period[0] = 2000;
+	transfer.mask_length[0] = DMA_RX_SIZE;
+
+	/*UART 0 has blocks for the frames of a whole buffer, so that it never pauses, and its FIFO never overruns;*/
+	transfer.config[0].nb_frames = 16;
+	uart_model_transfer(&transfer);
+
+	const struct netf2_stats *const stats = transfer.stats;
+	const struct uart_model *const model = transfer.models;
+
+	/*The FIFO never overran, the eDMA emptied it;*/
+	CHECK(!model->nb_lost);
+
+	/*Buffer overruns were detected, and their bytes dropped;*/
+	CHECK(stats->hw_overruns);
+	CHECK(stats->rx_lost_bytes > stats->hw_overruns * DMA_RX_SIZE);
+
+	/*Frames were lost, but reception recovered after each overrun;*/
+	CHECK(transfer.nb_missing[0]);
+	CHECK(transfer.nb_received[0] > NB_FRAMES / 2);
+
+}
+
+
+/*
+ * test_dma_sources : a UART without dedicated request sources fails a DMA start, before touching its hardware, and
+ * 	can still be started in interrupt mode;
+ */
+
+static void test_dma_sources() {
+
+	struct uart_transfer transfer;
+	transfer_init(&transfer);
+
+	/*The specs of UART 0, without request sources, as UART4 and UART5;*/
+	const struct K64_UART_hw *const hw = uart_model_hw_specs(0);
+	const struct K64_UART_hw specs = {
+		.registers = hw->registers,
+		.clock_frequency = hw->clock_frequency,
+		.clock_gating_reg = hw->clock_gating_reg,
+		.clock_gating_mask = hw->clock_gating_mask,
+		.status_int_channel = hw->status_int_channel,
+		.error_int_channel = hw->error_int_channel,
+		.status_link = hw->status_link,
+		.error_link = hw->error_link,
+		.dma_rx_channel = hw->dma_rx_channel,
+		.dma_tx_channel = hw->dma_tx_channel,
+		.dma_rx_link = hw->dma_rx_link,
+		.dma_tx_link = hw->dma_tx_link,
+	};
+
+	uart_model_init();
+	struct K64_UART_driver_t *const driver = K64_UART_create(&specs);
+
+	/*The DMA start fails, and leaves the UART untouched;*/
+	const size_t nb_accesses = uart_models[0].nb_accesses;
+	CHECK(!K64_UART_start(driver, transfer.config));
+	CHECK(!driver->iface);
+	CHECK(uart_models[0].nb_accesses == nb_accesses);
+
+	/*The interrupt mode works;*/
+	transfer.config[0].dma_enabled = false;
+	CHECK(K64_UART_start(driver, transfer.config));
+	K64_UART_stop(driver);
+	K64_UART_delete(driver);
+
+}
+
+
+/*
+ * test_modes : runs tests that do not depend on the mode;
+ */
+
+static void test_modes() {
+
+	test_flow_control();
+	test_slow_process();
+	test_framing_errors();
+	test_trailer_reserve();
+	test_pooled_bursts();
+	test_pool_config();
+
+}
+
+
+int main() {
+
+	/*The fixed watermark transfer is the reference of the adaptive one;*/
+	static struct uart_transfer fixed;
+
+	/*Interrupt mode;*/
+	test_fixed_watermark(&fixed);
+	test_adaptive_watermark(&fixed);
+	test_overrun();
+	test_modes();
+
+	/*DMA mode;*/
+	dma_mode = true;
+	test_dma_requests();
+	test_dma_latency();
+	test_dma_overrun();
+	test_dma_sources();
+	test_modes();
+
+	printf("uart_test : ok\n");
+
+	return 0;
+
+}